@@ -13,6 +13,9 @@
 #include <QtDebug>
 #include "user-interface/arrangeable-tabs/widget/quadgridwidget.h"
 #include "model-loaders/filedataloaders/fileextensiondatamodelmap.h"
+#include "model-loaders/filedataloaders/fileloadoperation.h"
+#include <QStatusBar>
+#include <QPointer>
 #include "user-interface/modelviews/modelviewfactory.h"
 #include "user-interface/modelviews/imodelview.h"
 #include "renderer/global/mainrendercontext.h"
@@ -324,6 +327,8 @@ namespace AppCalliper
 
     void MainWindow::fileDoubleClicked(const QString& localPath)
     {
+        using namespace ModelLoaders;
+
         if ( m_pProject.isNull() )
         {
             return;
@@ -331,47 +336,58 @@ namespace AppCalliper
 
         QString fullPath = getFullPath(localPath);
 
-        ModelLoaders::FileDataModelStore& files = m_pProject->fileStore();
-        if ( !files.isFileLoaded(fullPath) )
+        FileDataModelStore& files = m_pProject->fileStore();
+        if ( files.isFileLoading(fullPath) )
+        {
+            // The view is opened as soon as the load gets going.
+            return;
+        }
+
+        if ( files.isFileLoaded(fullPath) )
+        {
+            openFileView(fullPath);
+            return;
+        }
+
+        QString errorString;
+        FileLoadOperation* operation = files.loadFileAsync(fullPath, &errorString);
+        if ( !operation )
+        {
+            reportFileLoadResult(fullPath, BaseFileLoader::Failure, errorString);
+            return;
+        }
+
+        // The file is viewable while it loads.
+        QSharedPointer<QPointer<QWidget> > view(new QPointer<QWidget>());
+        connect(operation, &FileLoadOperation::dataModelReady, this, [this, fullPath, view]()
+        {
+            *view = openFileView(fullPath);
+        });
+
+        connect(operation, &FileLoadOperation::progressChanged, this, [this, fullPath](float progress)
         {
-            QString errorString;
-            ModelLoaders::BaseFileLoader::SuccessCode success = files.loadFile(fullPath, &errorString);
+            statusBar()->showMessage(tr("Loading %1 (%2%)").arg(QFileInfo(fullPath).fileName()).arg(static_cast<int>(progress * 100.0f)));
+        });
 
-            switch ( success )
+        connect(operation, &FileLoadOperation::finished, this, [this, operation, view](BaseFileLoader::SuccessCode result)
+        {
+            statusBar()->clearMessage();
+
+            // Don't leave a failed file on display.
+            if ( result == BaseFileLoader::Failure && !view->isNull() && ui->gridWidget->singleWidget() == view->data() )
             {
-                case ModelLoaders::BaseFileLoader::Failure:
-                {
-                    QMessageBox box(QMessageBox::Critical,
-                                    tr("Error loading file"),
-                                    tr("There was a critical error loading the file %1").arg(fullPath),
-                                    QMessageBox::Ok);
-
-                    box.setDetailedText(errorString);
-                    box.exec();
-
-                    return;
-                }
-
-                case ModelLoaders::BaseFileLoader::PartialSuccess:
-                {
-                    QMessageBox box(QMessageBox::Warning,
-                                    tr("Error loading file"),
-                                    tr("File %1 was loaded, but some errors occurred.").arg(fullPath),
-                                    QMessageBox::Ok);
-
-                    box.setInformativeText(tr("See details."));
-                    box.setDetailedText(errorString);
-                    box.exec();
-
-                    break;
-                }
-
-                default:
-                    break;
+                closeViewports();
             }
-        }
 
-        QSharedPointer<Model::BaseFileDataModel> dataModel = files.dataModel(fullPath);
+            reportFileLoadResult(operation->filePath(), result, operation->errorString());
+        });
+
+        operation->start();
+    }
+
+    QWidget* MainWindow::openFileView(const QString &fullPath)
+    {
+        QSharedPointer<Model::BaseFileDataModel> dataModel = m_pProject->fileStore().dataModel(fullPath);
         Q_ASSERT_X(!dataModel.isNull(), Q_FUNC_INFO, "Expected a valid data model!");
         if ( dataModel.isNull() )
         {
@@ -381,12 +397,12 @@ namespace AppCalliper
                             QMessageBox::Ok);
 
             box.exec();
-            return;
+            return Q_NULLPTR;
         }
 
         if ( ui->gridWidget->singleWidget() )
         {
-            return;
+            return Q_NULLPTR;
         }
 
         UserInterface::IModelView* view = UserInterface::ModelViewFactory::createView(dataModel->type());
@@ -396,6 +412,44 @@ namespace AppCalliper
         Q_ASSERT(viewWidget);
         viewWidget->setWindowTitle(QFileInfo(fullPath).fileName());
         ui->gridWidget->setSingleWidget(viewWidget);
+        return viewWidget;
+    }
+
+    void MainWindow::reportFileLoadResult(const QString &fullPath, ModelLoaders::BaseFileLoader::SuccessCode result,
+                                          const QString &errorString)
+    {
+        switch ( result )
+        {
+            case ModelLoaders::BaseFileLoader::Failure:
+            {
+                QMessageBox box(QMessageBox::Critical,
+                                tr("Error loading file"),
+                                tr("There was a critical error loading the file %1").arg(fullPath),
+                                QMessageBox::Ok);
+
+                box.setDetailedText(errorString);
+                box.exec();
+
+                break;
+            }
+
+            case ModelLoaders::BaseFileLoader::PartialSuccess:
+            {
+                QMessageBox box(QMessageBox::Warning,
+                                tr("Error loading file"),
+                                tr("File %1 was loaded, but some errors occurred.").arg(fullPath),
+                                QMessageBox::Ok);
+
+                box.setInformativeText(tr("See details."));
+                box.setDetailedText(errorString);
+                box.exec();
+
+                break;
+            }
+
+            default:
+                break;
+        }
     }
 
     QString MainWindow::getFullPath(const QString &localFilePath) const
@@ -58,6 +58,9 @@ namespace AppCalliper
         void setFileMenuItemEnabledStates();
         UserInterface::QuadGridWidget* centralGridWidget() const;
         QString getFullPath(const QString& localFilePath) const;
+        QWidget* openFileView(const QString& fullPath);
+        void reportFileLoadResult(const QString& fullPath, ModelLoaders::BaseFileLoader::SuccessCode result,
+                                  const QString& errorString);
         QStringList absoluteFilePathsToLocalFilePaths(const QStringList& filePaths) const;
 
         Ui::MainWindow *ui;
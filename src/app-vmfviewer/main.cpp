@@ -33,6 +33,10 @@ int main(int argc, char *argv[])
     QCommandLineOption opVpkPath("vpkpath", "Folder where VPK content is stored. There is no need to specify the actual VPK files.", "path");
     parser.addOption(opVpkPath);
 
+    QCommandLineOption opPreloadMaterials("preloadmaterials", "Load every material in the VPKs on startup, rather than as the map uses them. "
+                                          "Textures are packed into texture arrays where the graphics driver supports them.");
+    parser.addOption(opPreloadMaterials);
+
     parser.addPositionalArgument("file", "VMF file to read.");
 
     parser.setApplicationDescription(
@@ -71,6 +75,7 @@ int main(int argc, char *argv[])
     MainWindow* w = new MainWindow();
     w->setMapPath(filename);
     w->setVpkPath(parser.value(opVpkPath));
+    w->setPreloadMaterials(parser.isSet(opPreloadMaterials));
     w->show();
 
     int ret = a.exec();
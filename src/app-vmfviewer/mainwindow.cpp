@@ -11,9 +11,32 @@
 #include "file-formats/vpk/vpkindextreerecord.h"
 #include "model-loaders/vtf/vtfloader.h"
 #include "model/shaders/knownshaderdefs.h"
+#include "renderer/global/mainrendercontext.h"
+#include <QPainter>
+#include <QKeyEvent>
+#include <algorithm>
+
+namespace
+{
+    // Keeps frames responsive while textures stream in.
+    const int MAX_TEXTURE_UPLOADS_PER_FRAME = 16;
+
+    const quint64 TEXTURE_MEMORY_BUDGET = 512 * 1024 * 1024;
+
+    // Only this many path prefixes are listed, largest first.
+    const int MAX_OVERLAY_PREFIXES = 16;
+
+    QString formatBytes(quint64 bytes)
+    {
+        return QString("%1 MiB").arg(static_cast<double>(bytes) / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+}
 
 MainWindow::MainWindow() : UserInterface::MapViewWindow(),
-    m_iPlaceholderMaterial(0)
+    m_iPlaceholderMaterial(0),
+    m_pVtfLoader(Q_NULLPTR),
+    m_bShowTextureMemory(false),
+    m_bPreloadMaterials(false)
 {
     connect(this, SIGNAL(initialised()), this, SLOT(init()));
     resize(640, 480);
@@ -21,6 +44,7 @@ MainWindow::MainWindow() : UserInterface::MapViewWindow(),
 
 MainWindow::~MainWindow()
 {
+    delete m_pVtfLoader;
 }
 
 void MainWindow::initShaders()
@@ -31,6 +55,7 @@ void MainWindow::initTextures()
 {
     Model::TextureStore* textureStore = Model::ResourceEnvironment::globalInstance()->textureStore();
     textureStore->setDefaultTextureFromFile(":model/textures/_ERROR_");
+    textureStore->setTextureMemoryBudget(TEXTURE_MEMORY_BUDGET);
     textureStore->createTextureFromFile(":model/textures/dev/devwhite");
 }
 
@@ -82,10 +107,125 @@ void MainWindow::processBrushes()
 
 void MainWindow::importTextures()
 {
-    ModelLoaders::VTFLoader loader(Model::ResourceEnvironment::globalInstance()->materialStore(),
-                                   Model::ResourceEnvironment::globalInstance()->textureStore());
+    delete m_pVtfLoader;
+    m_pVtfLoader = new ModelLoaders::VTFLoader(Model::ResourceEnvironment::globalInstance()->materialStore(),
+                                               Model::ResourceEnvironment::globalInstance()->textureStore());
     loadVpks();
-    loader.loadMaterials(vpkFileCollection());
+
+    if ( m_bPreloadMaterials )
+    {
+        // Textures are owned by the main context.
+        doneCurrent();
+        Renderer::MainRenderContext::globalInstance()->makeCurrent();
+
+        // Materials whose textures share an array can be drawn together.
+        m_pVtfLoader->setTextureArraysEnabled(ModelLoaders::VTFLoader::textureArraysSupported());
+        m_pVtfLoader->loadMaterials(vpkFileCollection());
+
+        Renderer::MainRenderContext::globalInstance()->doneCurrent();
+        makeCurrent();
+        return;
+    }
+
+    // Only materials referenced by the map are loaded, as the map loader requests them.
+    m_pVtfLoader->loadMaterialsOnDemand(vpkFileCollection());
+}
+
+bool MainWindow::preloadMaterials() const
+{
+    return m_bPreloadMaterials;
+}
+
+void MainWindow::setPreloadMaterials(bool preload)
+{
+    m_bPreloadMaterials = preload;
+}
+
+void MainWindow::paintGL()
+{
+    Model::TextureStore* textureStore = Model::ResourceEnvironment::globalInstance()->textureStore();
+
+    if ( (m_pVtfLoader && m_pVtfLoader->hasPendingTextures()) || textureStore->hasRequestedTextures() )
+    {
+        doneCurrent();
+        Renderer::MainRenderContext::globalInstance()->makeCurrent();
+
+        int uploads = textureStore->restoreRequestedTextures(MAX_TEXTURE_UPLOADS_PER_FRAME);
+        if ( m_pVtfLoader )
+        {
+            m_pVtfLoader->uploadPendingTextures(MAX_TEXTURE_UPLOADS_PER_FRAME - uploads);
+        }
+
+        Renderer::MainRenderContext::globalInstance()->doneCurrent();
+        makeCurrent();
+
+        // Keep drawing until everything has arrived.
+        update();
+    }
+
+    UserInterface::MapViewWindow::paintGL();
+
+    // Textures are owned by the main context.
+    doneCurrent();
+    Renderer::MainRenderContext::globalInstance()->makeCurrent();
+    textureStore->endFrame();
+    Renderer::MainRenderContext::globalInstance()->doneCurrent();
+    makeCurrent();
+
+    if ( m_bShowTextureMemory )
+    {
+        drawTextureMemoryOverlay();
+    }
+}
+
+void MainWindow::keyPressEvent(QKeyEvent *e)
+{
+    if ( e->key() == Qt::Key_F3 && !e->isAutoRepeat() )
+    {
+        m_bShowTextureMemory = !m_bShowTextureMemory;
+        update();
+        return;
+    }
+
+    UserInterface::MapViewWindow::keyPressEvent(e);
+}
+
+void MainWindow::drawTextureMemoryOverlay()
+{
+    Model::TextureStore* textureStore = Model::ResourceEnvironment::globalInstance()->textureStore();
+
+    QStringList lines;
+    lines.append(QString("Textures: %1 / %2, %3 evicted")
+                 .arg(formatBytes(textureStore->totalTextureMemory()))
+                 .arg(textureStore->textureMemoryBudget() > 0
+                      ? formatBytes(textureStore->textureMemoryBudget())
+                      : QString("no budget"))
+                 .arg(textureStore->evictedTextureCount()));
+
+    typedef QPair<quint64, QString> PrefixUsage;
+    QList<PrefixUsage> prefixes;
+    QMap<QString, quint64> usage = textureStore->textureMemoryByPathPrefix();
+    for ( QMap<QString, quint64>::const_iterator it = usage.constBegin(); it != usage.constEnd(); ++it )
+    {
+        prefixes.append(qMakePair(it.value(), it.key()));
+    }
+
+    std::sort(prefixes.begin(), prefixes.end(), [](const PrefixUsage& a, const PrefixUsage& b)
+    {
+        return a.first > b.first;
+    });
+
+    for ( int i = 0; i < prefixes.count() && i < MAX_OVERLAY_PREFIXES; ++i )
+    {
+        lines.append(QString("  %1: %2")
+                     .arg(prefixes.at(i).second.isEmpty() ? QString("<root>") : prefixes.at(i).second)
+                     .arg(formatBytes(prefixes.at(i).first)));
+    }
+
+    QPainter painter(this);
+    painter.setPen(Qt::yellow);
+    painter.setFont(QFont("Monospace", 9));
+    painter.drawText(QRect(8, 8, width() - 16, height() - 16), Qt::AlignLeft | Qt::AlignTop, lines.join("\n"));
 }
 
 void MainWindow::init()
@@ -2,6 +2,7 @@
 #define MAINWINDOW_H
 
 #include "user-interface/views/mapviewwindow.h"
+#include "model-loaders/vtf/vtfloader.h"
 
 class MainWindow : public UserInterface::MapViewWindow
 {
@@ -14,6 +15,11 @@ public:
     void processBrushes();
     void importTextures();
 
+    // When set, every material is loaded up front and textures are packed into texture arrays
+    // if supported. Otherwise materials are loaded as the map requests them.
+    bool preloadMaterials() const;
+    void setPreloadMaterials(bool preload);
+
 public slots:
     void init();
 
@@ -22,9 +28,16 @@ protected:
     virtual void initTextures() override;
     virtual void initMaterials() override;
     virtual void initLocalOpenGlSettings() override;
+    virtual void paintGL() override;
+    virtual void keyPressEvent(QKeyEvent* e) override;
 
 private:
+    void drawTextureMemoryOverlay();
+
     quint32 m_iPlaceholderMaterial;
+    ModelLoaders::VTFLoader* m_pVtfLoader;
+    bool m_bShowTextureMemory;
+    bool m_bPreloadMaterials;
 };
 
 #endif // MAINWINDOW_H
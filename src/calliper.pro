@@ -11,6 +11,17 @@ SUBDIRS += \
     model-loaders \
     dep-vtflib \
     tst-keyvaluesparser \
+    tst-dxtndecoder \
+    tst-vtfresample \
+    tst-vmtmaterial \
+    tst-vmfplaneparser \
+    tst-fuzzyvertexmap \
+    tst-winding3d \
+    tst-boundingbox \
+    tst-bufferarena \
+    tst-rendermodel \
+    tst-scene \
+    tst-vmfdataloader \
     user-interface \
     app-calliper \
     app-vpkbrowser \
@@ -25,6 +36,17 @@ file-formats.depends = calliperutil
 model-loaders.depends = model renderer calliperutil file-formats dep-vtflib
 dep-qvtf.depends = dep-vtflib
 tst-keyvaluesparser.depends = file-formats calliperutil
+tst-dxtndecoder.depends = dep-vtflib
+tst-vtfresample.depends = dep-vtflib
+tst-vmtmaterial.depends = file-formats calliperutil
+tst-vmfplaneparser.depends = model-loaders model renderer calliperutil file-formats dep-vtflib
+tst-fuzzyvertexmap.depends = model renderer calliperutil file-formats dep-vtflib
+tst-winding3d.depends = model renderer calliperutil file-formats dep-vtflib
+tst-boundingbox.depends = model renderer calliperutil file-formats dep-vtflib
+tst-bufferarena.depends = renderer calliperutil
+tst-rendermodel.depends = renderer calliperutil
+tst-scene.depends = model renderer calliperutil file-formats dep-vtflib
+tst-vmfdataloader.depends = model-loaders model renderer calliperutil file-formats dep-vtflib
 user-interface.depends = renderer calliperutil model file-formats model-loaders dep-vtflib
 app-calliper.depends = calliperutil renderer model file-formats model-loaders dep-vtflib user-interface
 app-vpkbrowser.depends = calliperutil file-formats user-interface
@@ -0,0 +1,719 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2011 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include <string.h>
+
+#include "VTFLib.h"
+#include "VTFFile.h"
+#include "VTFDXTnDecoder.h"
+
+// The vectorised decoders work in two stages. First the colour (and DXT5 alpha)
+// palettes for a run of consecutive blocks are computed together, one block per
+// 16-bit lane. Then each block's pixels are selected from its palette a whole
+// row at a time. The palette arithmetic mirrors CVTFFile::DecompressDXTn()
+// exactly, including its quirks (DXT3/5 always use the four colour mode,
+// DXT1 three colour mode rounds down), so that results are bit-exact.
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#	define VTFLIB_DXTN_SIMD
+#	include <emmintrin.h>
+#	include <immintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#		define VTFLIB_TARGET_SSE2
+#		define VTFLIB_TARGET_AVX2
+#	else
+#		define VTFLIB_TARGET_SSE2 __attribute__((target("sse2")))
+#		define VTFLIB_TARGET_AVX2 __attribute__((target("avx2")))
+#	endif
+#endif
+
+using namespace VTFLib;
+
+#ifdef VTFLIB_DXTN_SIMD
+namespace
+{
+	typedef enum tagDXTnBlockFormat
+	{
+		DXTN_BLOCK_DXT1 = 0,
+		DXTN_BLOCK_DXT3,
+		DXTN_BLOCK_DXT5
+	} DXTnBlockFormat;
+
+	// Largest number of blocks whose palettes are computed together.
+	const vlUInt uiMaxBatchBlocks = 16;
+
+	// Structure-of-arrays view of a run of consecutive blocks.
+	struct SDXTnBatch
+	{
+		vlUShort Colour0[uiMaxBatchBlocks];
+		vlUShort Colour1[uiMaxBatchBlocks];
+		vlUInt ColourBits[uiMaxBatchBlocks];
+
+		vlUShort Alpha0[uiMaxBatchBlocks];
+		vlUShort Alpha1[uiMaxBatchBlocks];
+		const vlByte *Alpha[uiMaxBatchBlocks];
+
+		vlUInt Palette[4][uiMaxBatchBlocks];			// RGBA8888, alpha is zero for DXT3/5.
+		vlUShort AlphaPalette[8][uiMaxBatchBlocks];	// DXT5 only.
+	};
+
+	inline vlUShort ReadUShort(const vlByte *lpData)
+	{
+		vlUShort uiValue;
+		memcpy(&uiValue, lpData, sizeof(vlUShort));
+		return uiValue;
+	}
+
+	inline vlUInt ReadUInt(const vlByte *lpData)
+	{
+		vlUInt uiValue;
+		memcpy(&uiValue, lpData, sizeof(vlUInt));
+		return uiValue;
+	}
+
+	inline vlUInt BlockSize(DXTnBlockFormat Format)
+	{
+		return Format == DXTN_BLOCK_DXT1 ? 8 : 16;
+	}
+
+	vlVoid GatherBlocks(SDXTnBatch &Batch, const vlByte *lpSource, vlUInt uiCount, DXTnBlockFormat Format)
+	{
+		const vlUInt uiBlockSize = BlockSize(Format);
+
+		for(vlUInt i = 0; i < uiCount; i++, lpSource += uiBlockSize)
+		{
+			const vlByte *lpColour = Format == DXTN_BLOCK_DXT1 ? lpSource : lpSource + 8;
+
+			Batch.Colour0[i] = ReadUShort(lpColour);
+			Batch.Colour1[i] = ReadUShort(lpColour + 2);
+			Batch.ColourBits[i] = ReadUInt(lpColour + 4);
+
+			Batch.Alpha[i] = lpSource;
+			Batch.Alpha0[i] = lpSource[0];
+			Batch.Alpha1[i] = lpSource[1];
+		}
+	}
+
+	// Alpha values for the 16 pixels of a block, pre-shifted into the alpha byte.
+	vlVoid ExpandAlphaDXT3(const vlByte *lpAlpha, vlUInt *lpPixelAlpha)
+	{
+		for(vlUInt j = 0; j < 4; j++)
+		{
+			vlUShort uiWord = ReadUShort(lpAlpha + 2 * j);
+			for(vlUInt i = 0; i < 4; i++)
+			{
+				const vlUInt uiNibble = uiWord & 0x0F;
+				*lpPixelAlpha++ = (uiNibble | (uiNibble << 4)) << 24;
+				uiWord >>= 4;
+			}
+		}
+	}
+
+	vlVoid ExpandAlphaDXT5(const SDXTnBatch &Batch, vlUInt uiBlock, vlUInt *lpPixelAlpha)
+	{
+		// Two runs of 24 bits, each holding eight 3-bit indices.
+		const vlByte *lpBits = Batch.Alpha[uiBlock] + 2;
+		for(vlUInt j = 0; j < 2; j++, lpBits += 3)
+		{
+			vlUInt uiBits = lpBits[0] | (lpBits[1] << 8) | (lpBits[2] << 16);
+			for(vlUInt i = 0; i < 8; i++)
+			{
+				*lpPixelAlpha++ = (vlUInt)Batch.AlphaPalette[uiBits & 0x07][uiBlock] << 24;
+				uiBits >>= 3;
+			}
+		}
+	}
+
+	vlVoid CopyClippedBlock(const vlByte *lpBlock, vlByte *lpDest, vlUInt uiStride, vlUInt uiColumns, vlUInt uiRows)
+	{
+		for(vlUInt j = 0; j < uiRows; j++)
+		{
+			memcpy(lpDest + j * uiStride, lpBlock + j * 16, uiColumns * 4);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------
+	// SSE2
+	//-------------------------------------------------------------------------------------------------
+
+	// Exact for 0 <= x <= 766, the largest value the colour interpolation produces.
+	VTFLIB_TARGET_SSE2 inline __m128i Divide3SSE2(__m128i x)
+	{
+		return _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16((short)0xAAAB)), 1);
+	}
+
+	// Exact for 0 <= x <= 1788.
+	VTFLIB_TARGET_SSE2 inline __m128i Divide7SSE2(__m128i x)
+	{
+		return _mm_mulhi_epu16(x, _mm_set1_epi16(9363));
+	}
+
+	// Exact for 0 <= x <= 1277.
+	VTFLIB_TARGET_SSE2 inline __m128i Divide5SSE2(__m128i x)
+	{
+		return _mm_mulhi_epu16(x, _mm_set1_epi16(13108));
+	}
+
+	VTFLIB_TARGET_SSE2 inline __m128i SelectSSE2(__m128i Mask, __m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(Mask, a), _mm_andnot_si128(Mask, b));
+	}
+
+	VTFLIB_TARGET_SSE2 inline vlVoid StorePaletteSSE2(vlUInt *lpPalette, __m128i r, __m128i g, __m128i b, __m128i a)
+	{
+		const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+		const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+
+		_mm_storeu_si128((__m128i *)lpPalette, _mm_unpacklo_epi16(rg, ba));
+		_mm_storeu_si128((__m128i *)(lpPalette + 4), _mm_unpackhi_epi16(rg, ba));
+	}
+
+	VTFLIB_TARGET_SSE2 vlVoid ComputeColourPalettesSSE2(SDXTnBatch &Batch, vlUInt uiOffset, DXTnBlockFormat Format)
+	{
+		const __m128i c0 = _mm_loadu_si128((const __m128i *)(Batch.Colour0 + uiOffset));
+		const __m128i c1 = _mm_loadu_si128((const __m128i *)(Batch.Colour1 + uiOffset));
+		const __m128i Mask5 = _mm_set1_epi16(0x1F);
+		const __m128i Mask6 = _mm_set1_epi16(0x3F);
+		const __m128i One = _mm_set1_epi16(1);
+
+		const __m128i r0 = _mm_slli_epi16(_mm_srli_epi16(c0, 11), 3);
+		const __m128i g0 = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(c0, 5), Mask6), 2);
+		const __m128i b0 = _mm_slli_epi16(_mm_and_si128(c0, Mask5), 3);
+
+		const __m128i r1 = _mm_slli_epi16(_mm_srli_epi16(c1, 11), 3);
+		const __m128i g1 = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(c1, 5), Mask6), 2);
+		const __m128i b1 = _mm_slli_epi16(_mm_and_si128(c1, Mask5), 3);
+
+		// (2 * c0 + c1 + 1) / 3 and (c0 + 2 * c1 + 1) / 3
+		__m128i r2 = Divide3SSE2(_mm_add_epi16(_mm_add_epi16(_mm_add_epi16(r0, r0), r1), One));
+		__m128i g2 = Divide3SSE2(_mm_add_epi16(_mm_add_epi16(_mm_add_epi16(g0, g0), g1), One));
+		__m128i b2 = Divide3SSE2(_mm_add_epi16(_mm_add_epi16(_mm_add_epi16(b0, b0), b1), One));
+
+		const __m128i r3 = Divide3SSE2(_mm_add_epi16(_mm_add_epi16(_mm_add_epi16(r1, r1), r0), One));
+		const __m128i g3 = Divide3SSE2(_mm_add_epi16(_mm_add_epi16(_mm_add_epi16(g1, g1), g0), One));
+		const __m128i b3 = Divide3SSE2(_mm_add_epi16(_mm_add_epi16(_mm_add_epi16(b1, b1), b0), One));
+
+		__m128i a012 = _mm_setzero_si128();
+		__m128i a3 = _mm_setzero_si128();
+
+		if(Format == DXTN_BLOCK_DXT1)
+		{
+			// Unsigned c0 > c1 selects the four colour mode.
+			const __m128i Bias = _mm_set1_epi16((short)0x8000);
+			const __m128i FourColour = _mm_cmpgt_epi16(_mm_xor_si128(c0, Bias), _mm_xor_si128(c1, Bias));
+
+			r2 = SelectSSE2(FourColour, r2, _mm_srli_epi16(_mm_add_epi16(r0, r1), 1));
+			g2 = SelectSSE2(FourColour, g2, _mm_srli_epi16(_mm_add_epi16(g0, g1), 1));
+			b2 = SelectSSE2(FourColour, b2, _mm_srli_epi16(_mm_add_epi16(b0, b1), 1));
+
+			a012 = _mm_set1_epi16(0xFF);
+			a3 = _mm_and_si128(FourColour, a012);
+		}
+
+		StorePaletteSSE2(Batch.Palette[0] + uiOffset, r0, g0, b0, a012);
+		StorePaletteSSE2(Batch.Palette[1] + uiOffset, r1, g1, b1, a012);
+		StorePaletteSSE2(Batch.Palette[2] + uiOffset, r2, g2, b2, a012);
+		StorePaletteSSE2(Batch.Palette[3] + uiOffset, r3, g3, b3, a3);
+	}
+
+	VTFLIB_TARGET_SSE2 vlVoid ComputeAlphaPalettesSSE2(SDXTnBatch &Batch, vlUInt uiOffset)
+	{
+		const __m128i a0 = _mm_loadu_si128((const __m128i *)(Batch.Alpha0 + uiOffset));
+		const __m128i a1 = _mm_loadu_si128((const __m128i *)(Batch.Alpha1 + uiOffset));
+		const __m128i EightAlpha = _mm_cmpgt_epi16(a0, a1);
+		const __m128i Three = _mm_set1_epi16(3);
+		const __m128i Two = _mm_set1_epi16(2);
+
+		_mm_storeu_si128((__m128i *)(Batch.AlphaPalette[0] + uiOffset), a0);
+		_mm_storeu_si128((__m128i *)(Batch.AlphaPalette[1] + uiOffset), a1);
+
+		for(vlUInt i = 1; i <= 6; i++)
+		{
+			// ((7 - i) * a0 + i * a1 + 3) / 7
+			__m128i Alpha = Divide7SSE2(_mm_add_epi16(_mm_add_epi16(
+				_mm_mullo_epi16(a0, _mm_set1_epi16((short)(7 - i))),
+				_mm_mullo_epi16(a1, _mm_set1_epi16((short)i))), Three));
+
+			// ((5 - i) * a0 + i * a1 + 2) / 5, then 0 and 255.
+			__m128i SixAlpha;
+			if(i <= 4)
+			{
+				SixAlpha = Divide5SSE2(_mm_add_epi16(_mm_add_epi16(
+					_mm_mullo_epi16(a0, _mm_set1_epi16((short)(5 - i))),
+					_mm_mullo_epi16(a1, _mm_set1_epi16((short)i))), Two));
+			}
+			else
+			{
+				SixAlpha = i == 5 ? _mm_setzero_si128() : _mm_set1_epi16(0xFF);
+			}
+
+			Alpha = SelectSSE2(EightAlpha, Alpha, SixAlpha);
+			_mm_storeu_si128((__m128i *)(Batch.AlphaPalette[i + 1] + uiOffset), Alpha);
+		}
+	}
+
+	// Writes one 4x4 block with a row stride of uiStride bytes. lpPixelAlpha may be null.
+	VTFLIB_TARGET_SSE2 vlVoid EmitBlockSSE2(const SDXTnBatch &Batch, vlUInt uiBlock, const vlUInt *lpPixelAlpha, vlByte *lpDest, vlUInt uiStride)
+	{
+		const __m128i p0 = _mm_set1_epi32((int)Batch.Palette[0][uiBlock]);
+		const __m128i p1 = _mm_set1_epi32((int)Batch.Palette[1][uiBlock]);
+		const __m128i p2 = _mm_set1_epi32((int)Batch.Palette[2][uiBlock]);
+		const __m128i p3 = _mm_set1_epi32((int)Batch.Palette[3][uiBlock]);
+
+		const __m128i LowBit = _mm_setr_epi32(0x01, 0x04, 0x10, 0x40);
+		const __m128i HighBit = _mm_setr_epi32(0x02, 0x08, 0x20, 0x80);
+		const __m128i Zero = _mm_setzero_si128();
+
+		vlUInt uiBits = Batch.ColourBits[uiBlock];
+		for(vlUInt j = 0; j < 4; j++, uiBits >>= 8, lpDest += uiStride)
+		{
+			const __m128i Row = _mm_set1_epi32((int)(uiBits & 0xFF));
+			const __m128i LowClear = _mm_cmpeq_epi32(_mm_and_si128(Row, LowBit), Zero);
+			const __m128i HighClear = _mm_cmpeq_epi32(_mm_and_si128(Row, HighBit), Zero);
+
+			__m128i Pixels = SelectSSE2(HighClear, SelectSSE2(LowClear, p0, p1), SelectSSE2(LowClear, p2, p3));
+
+			if(lpPixelAlpha)
+			{
+				Pixels = _mm_or_si128(Pixels, _mm_loadu_si128((const __m128i *)(lpPixelAlpha + 4 * j)));
+			}
+
+			_mm_storeu_si128((__m128i *)lpDest, Pixels);
+		}
+	}
+
+	// Writes one block, clipping it against the image if necessary.
+	VTFLIB_TARGET_SSE2 vlVoid EmitClippedBlockSSE2(const SDXTnBatch &Batch, vlUInt uiBlock, DXTnBlockFormat Format, vlByte *lpDest, vlUInt uiX, vlUInt uiY, vlUInt uiWidth, vlUInt uiHeight)
+	{
+		vlUInt uiPixelAlpha[16];
+		const vlUInt *lpPixelAlpha = 0;
+
+		if(Format == DXTN_BLOCK_DXT3)
+		{
+			ExpandAlphaDXT3(Batch.Alpha[uiBlock], uiPixelAlpha);
+			lpPixelAlpha = uiPixelAlpha;
+		}
+		else if(Format == DXTN_BLOCK_DXT5)
+		{
+			ExpandAlphaDXT5(Batch, uiBlock, uiPixelAlpha);
+			lpPixelAlpha = uiPixelAlpha;
+		}
+
+		const vlUInt uiStride = uiWidth * 4;
+		vlByte *lpBlockDest = lpDest + uiY * uiStride + uiX * 4;
+
+		if(uiX + 4 <= uiWidth && uiY + 4 <= uiHeight)
+		{
+			EmitBlockSSE2(Batch, uiBlock, lpPixelAlpha, lpBlockDest, uiStride);
+		}
+		else
+		{
+			vlByte lpBlock[64];
+			EmitBlockSSE2(Batch, uiBlock, lpPixelAlpha, lpBlock, 16);
+			CopyClippedBlock(lpBlock, lpBlockDest, uiStride,
+							 uiWidth - uiX < 4 ? uiWidth - uiX : 4,
+							 uiHeight - uiY < 4 ? uiHeight - uiY : 4);
+		}
+	}
+
+	VTFLIB_TARGET_SSE2 vlBool DecompressSSE2(const vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, DXTnBlockFormat Format)
+	{
+		const vlUInt uiBatchBlocks = 8;
+		const vlUInt uiBlocksX = (uiWidth + 3) / 4;
+		const vlUInt uiBlockCount = uiBlocksX * ((uiHeight + 3) / 4);
+		const vlUInt uiBlockSize = BlockSize(Format);
+
+		SDXTnBatch Batch;
+		memset(&Batch, 0, sizeof(Batch));
+
+		for(vlUInt uiFirst = 0; uiFirst < uiBlockCount; uiFirst += uiBatchBlocks)
+		{
+			const vlUInt uiCount = uiBlockCount - uiFirst < uiBatchBlocks ? uiBlockCount - uiFirst : uiBatchBlocks;
+
+			GatherBlocks(Batch, lpSource + uiFirst * uiBlockSize, uiCount, Format);
+			ComputeColourPalettesSSE2(Batch, 0, Format);
+
+			if(Format == DXTN_BLOCK_DXT5)
+			{
+				ComputeAlphaPalettesSSE2(Batch, 0);
+			}
+
+			for(vlUInt i = 0; i < uiCount; i++)
+			{
+				const vlUInt uiBlock = uiFirst + i;
+				EmitClippedBlockSSE2(Batch, i, Format, lpDest, (uiBlock % uiBlocksX) * 4, (uiBlock / uiBlocksX) * 4, uiWidth, uiHeight);
+			}
+		}
+
+		return vlTrue;
+	}
+
+	//-------------------------------------------------------------------------------------------------
+	// AVX2
+	//-------------------------------------------------------------------------------------------------
+
+	VTFLIB_TARGET_AVX2 inline __m256i Divide3AVX2(__m256i x)
+	{
+		return _mm256_srli_epi16(_mm256_mulhi_epu16(x, _mm256_set1_epi16((short)0xAAAB)), 1);
+	}
+
+	VTFLIB_TARGET_AVX2 inline __m256i Divide7AVX2(__m256i x)
+	{
+		return _mm256_mulhi_epu16(x, _mm256_set1_epi16(9363));
+	}
+
+	VTFLIB_TARGET_AVX2 inline __m256i Divide5AVX2(__m256i x)
+	{
+		return _mm256_mulhi_epu16(x, _mm256_set1_epi16(13108));
+	}
+
+	VTFLIB_TARGET_AVX2 inline __m256i SelectAVX2(__m256i Mask, __m256i a, __m256i b)
+	{
+		return _mm256_blendv_epi8(b, a, Mask);
+	}
+
+	VTFLIB_TARGET_AVX2 inline vlVoid StorePaletteAVX2(vlUInt *lpPalette, __m256i r, __m256i g, __m256i b, __m256i a)
+	{
+		const __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+		const __m256i ba = _mm256_or_si256(b, _mm256_slli_epi16(a, 8));
+
+		// Unpacking works within 128-bit lanes: Low holds blocks 0-3 and 8-11, High 4-7 and 12-15.
+		const __m256i Low = _mm256_unpacklo_epi16(rg, ba);
+		const __m256i High = _mm256_unpackhi_epi16(rg, ba);
+
+		_mm256_storeu_si256((__m256i *)lpPalette, _mm256_permute2x128_si256(Low, High, 0x20));
+		_mm256_storeu_si256((__m256i *)(lpPalette + 8), _mm256_permute2x128_si256(Low, High, 0x31));
+	}
+
+	VTFLIB_TARGET_AVX2 vlVoid ComputeColourPalettesAVX2(SDXTnBatch &Batch, DXTnBlockFormat Format)
+	{
+		const __m256i c0 = _mm256_loadu_si256((const __m256i *)Batch.Colour0);
+		const __m256i c1 = _mm256_loadu_si256((const __m256i *)Batch.Colour1);
+		const __m256i Mask5 = _mm256_set1_epi16(0x1F);
+		const __m256i Mask6 = _mm256_set1_epi16(0x3F);
+		const __m256i One = _mm256_set1_epi16(1);
+
+		const __m256i r0 = _mm256_slli_epi16(_mm256_srli_epi16(c0, 11), 3);
+		const __m256i g0 = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(c0, 5), Mask6), 2);
+		const __m256i b0 = _mm256_slli_epi16(_mm256_and_si256(c0, Mask5), 3);
+
+		const __m256i r1 = _mm256_slli_epi16(_mm256_srli_epi16(c1, 11), 3);
+		const __m256i g1 = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(c1, 5), Mask6), 2);
+		const __m256i b1 = _mm256_slli_epi16(_mm256_and_si256(c1, Mask5), 3);
+
+		__m256i r2 = Divide3AVX2(_mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(r0, r0), r1), One));
+		__m256i g2 = Divide3AVX2(_mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(g0, g0), g1), One));
+		__m256i b2 = Divide3AVX2(_mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(b0, b0), b1), One));
+
+		const __m256i r3 = Divide3AVX2(_mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(r1, r1), r0), One));
+		const __m256i g3 = Divide3AVX2(_mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(g1, g1), g0), One));
+		const __m256i b3 = Divide3AVX2(_mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(b1, b1), b0), One));
+
+		__m256i a012 = _mm256_setzero_si256();
+		__m256i a3 = _mm256_setzero_si256();
+
+		if(Format == DXTN_BLOCK_DXT1)
+		{
+			const __m256i Bias = _mm256_set1_epi16((short)0x8000);
+			const __m256i FourColour = _mm256_cmpgt_epi16(_mm256_xor_si256(c0, Bias), _mm256_xor_si256(c1, Bias));
+
+			r2 = SelectAVX2(FourColour, r2, _mm256_srli_epi16(_mm256_add_epi16(r0, r1), 1));
+			g2 = SelectAVX2(FourColour, g2, _mm256_srli_epi16(_mm256_add_epi16(g0, g1), 1));
+			b2 = SelectAVX2(FourColour, b2, _mm256_srli_epi16(_mm256_add_epi16(b0, b1), 1));
+
+			a012 = _mm256_set1_epi16(0xFF);
+			a3 = _mm256_and_si256(FourColour, a012);
+		}
+
+		StorePaletteAVX2(Batch.Palette[0], r0, g0, b0, a012);
+		StorePaletteAVX2(Batch.Palette[1], r1, g1, b1, a012);
+		StorePaletteAVX2(Batch.Palette[2], r2, g2, b2, a012);
+		StorePaletteAVX2(Batch.Palette[3], r3, g3, b3, a3);
+	}
+
+	VTFLIB_TARGET_AVX2 vlVoid ComputeAlphaPalettesAVX2(SDXTnBatch &Batch)
+	{
+		const __m256i a0 = _mm256_loadu_si256((const __m256i *)Batch.Alpha0);
+		const __m256i a1 = _mm256_loadu_si256((const __m256i *)Batch.Alpha1);
+		const __m256i EightAlpha = _mm256_cmpgt_epi16(a0, a1);
+		const __m256i Three = _mm256_set1_epi16(3);
+		const __m256i Two = _mm256_set1_epi16(2);
+
+		_mm256_storeu_si256((__m256i *)Batch.AlphaPalette[0], a0);
+		_mm256_storeu_si256((__m256i *)Batch.AlphaPalette[1], a1);
+
+		for(vlUInt i = 1; i <= 6; i++)
+		{
+			__m256i Alpha = Divide7AVX2(_mm256_add_epi16(_mm256_add_epi16(
+				_mm256_mullo_epi16(a0, _mm256_set1_epi16((short)(7 - i))),
+				_mm256_mullo_epi16(a1, _mm256_set1_epi16((short)i))), Three));
+
+			__m256i SixAlpha;
+			if(i <= 4)
+			{
+				SixAlpha = Divide5AVX2(_mm256_add_epi16(_mm256_add_epi16(
+					_mm256_mullo_epi16(a0, _mm256_set1_epi16((short)(5 - i))),
+					_mm256_mullo_epi16(a1, _mm256_set1_epi16((short)i))), Two));
+			}
+			else
+			{
+				SixAlpha = i == 5 ? _mm256_setzero_si256() : _mm256_set1_epi16(0xFF);
+			}
+
+			Alpha = SelectAVX2(EightAlpha, Alpha, SixAlpha);
+			_mm256_storeu_si256((__m256i *)Batch.AlphaPalette[i + 1], Alpha);
+		}
+	}
+
+	VTFLIB_TARGET_AVX2 inline __m256i SplatPairAVX2(vlUInt uiFirst, vlUInt uiSecond)
+	{
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi32((int)uiFirst)), _mm_set1_epi32((int)uiSecond), 1);
+	}
+
+	VTFLIB_TARGET_AVX2 inline __m256i AlphaPaletteAVX2(const SDXTnBatch &Batch, vlUInt uiBlock)
+	{
+		return _mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_setr_epi16(
+			(short)Batch.AlphaPalette[0][uiBlock], (short)Batch.AlphaPalette[1][uiBlock],
+			(short)Batch.AlphaPalette[2][uiBlock], (short)Batch.AlphaPalette[3][uiBlock],
+			(short)Batch.AlphaPalette[4][uiBlock], (short)Batch.AlphaPalette[5][uiBlock],
+			(short)Batch.AlphaPalette[6][uiBlock], (short)Batch.AlphaPalette[7][uiBlock])), 24);
+	}
+
+	// Writes two horizontally adjacent, unclipped blocks: each row is a single 32 byte store.
+	VTFLIB_TARGET_AVX2 vlVoid EmitBlockPairAVX2(const SDXTnBatch &Batch, vlUInt uiBlock, DXTnBlockFormat Format, vlByte *lpDest, vlUInt uiStride)
+	{
+		const vlUInt uiNext = uiBlock + 1;
+		const __m256i Palette = _mm256_setr_epi32(
+			(int)Batch.Palette[0][uiBlock], (int)Batch.Palette[1][uiBlock], (int)Batch.Palette[2][uiBlock], (int)Batch.Palette[3][uiBlock],
+			(int)Batch.Palette[0][uiNext], (int)Batch.Palette[1][uiNext], (int)Batch.Palette[2][uiNext], (int)Batch.Palette[3][uiNext]);
+
+		const __m256i ColourBits = SplatPairAVX2(Batch.ColourBits[uiBlock], Batch.ColourBits[uiNext]);
+		const __m256i ColourShift = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+		const __m256i PaletteOffset = _mm256_setr_epi32(0, 0, 0, 0, 4, 4, 4, 4);
+		const __m256i AlphaShiftDXT3 = _mm256_setr_epi32(0, 4, 8, 12, 0, 4, 8, 12);
+		const __m256i AlphaShiftDXT5 = _mm256_setr_epi32(0, 3, 6, 9, 0, 3, 6, 9);
+
+		__m256i FirstAlphaPalette = _mm256_setzero_si256();
+		__m256i SecondAlphaPalette = _mm256_setzero_si256();
+		vlUInt uiFirstAlphaBits[2] = { 0, 0 };
+		vlUInt uiSecondAlphaBits[2] = { 0, 0 };
+
+		if(Format == DXTN_BLOCK_DXT5)
+		{
+			FirstAlphaPalette = AlphaPaletteAVX2(Batch, uiBlock);
+			SecondAlphaPalette = AlphaPaletteAVX2(Batch, uiNext);
+
+			for(vlUInt i = 0; i < 2; i++)
+			{
+				const vlByte *lpFirst = Batch.Alpha[uiBlock] + 2 + 3 * i;
+				const vlByte *lpSecond = Batch.Alpha[uiNext] + 2 + 3 * i;
+				uiFirstAlphaBits[i] = lpFirst[0] | (lpFirst[1] << 8) | (lpFirst[2] << 16);
+				uiSecondAlphaBits[i] = lpSecond[0] | (lpSecond[1] << 8) | (lpSecond[2] << 16);
+			}
+		}
+
+		for(vlUInt j = 0; j < 4; j++, lpDest += uiStride)
+		{
+			const __m256i Index = _mm256_add_epi32(_mm256_and_si256(
+				_mm256_srlv_epi32(ColourBits, _mm256_add_epi32(ColourShift, _mm256_set1_epi32((int)(8 * j)))),
+				_mm256_set1_epi32(0x03)), PaletteOffset);
+
+			__m256i Pixels = _mm256_permutevar8x32_epi32(Palette, Index);
+
+			if(Format == DXTN_BLOCK_DXT3)
+			{
+				const __m256i Words = SplatPairAVX2(ReadUShort(Batch.Alpha[uiBlock] + 2 * j), ReadUShort(Batch.Alpha[uiNext] + 2 * j));
+				const __m256i Nibbles = _mm256_and_si256(_mm256_srlv_epi32(Words, AlphaShiftDXT3), _mm256_set1_epi32(0x0F));
+				Pixels = _mm256_or_si256(Pixels, _mm256_slli_epi32(_mm256_or_si256(Nibbles, _mm256_slli_epi32(Nibbles, 4)), 24));
+			}
+			else if(Format == DXTN_BLOCK_DXT5)
+			{
+				const vlUInt uiShift = 12 * (j & 1);
+				const __m256i Bits = SplatPairAVX2(uiFirstAlphaBits[j >> 1] >> uiShift, uiSecondAlphaBits[j >> 1] >> uiShift);
+				const __m256i AlphaIndex = _mm256_and_si256(_mm256_srlv_epi32(Bits, AlphaShiftDXT5), _mm256_set1_epi32(0x07));
+				Pixels = _mm256_or_si256(Pixels, _mm256_blend_epi32(
+					_mm256_permutevar8x32_epi32(FirstAlphaPalette, AlphaIndex),
+					_mm256_permutevar8x32_epi32(SecondAlphaPalette, AlphaIndex), 0xF0));
+			}
+
+			_mm256_storeu_si256((__m256i *)lpDest, Pixels);
+		}
+	}
+
+	VTFLIB_TARGET_AVX2 vlBool DecompressAVX2(const vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, DXTnBlockFormat Format)
+	{
+		const vlUInt uiBlocksX = (uiWidth + 3) / 4;
+		const vlUInt uiBlockCount = uiBlocksX * ((uiHeight + 3) / 4);
+		const vlUInt uiBlockSize = BlockSize(Format);
+		const vlUInt uiStride = uiWidth * 4;
+
+		SDXTnBatch Batch;
+		memset(&Batch, 0, sizeof(Batch));
+
+		for(vlUInt uiFirst = 0; uiFirst < uiBlockCount; uiFirst += uiMaxBatchBlocks)
+		{
+			const vlUInt uiCount = uiBlockCount - uiFirst < uiMaxBatchBlocks ? uiBlockCount - uiFirst : uiMaxBatchBlocks;
+
+			GatherBlocks(Batch, lpSource + uiFirst * uiBlockSize, uiCount, Format);
+			ComputeColourPalettesAVX2(Batch, Format);
+
+			if(Format == DXTN_BLOCK_DXT5)
+			{
+				ComputeAlphaPalettesAVX2(Batch);
+			}
+
+			for(vlUInt i = 0; i < uiCount; )
+			{
+				const vlUInt uiBlock = uiFirst + i;
+				const vlUInt uiX = (uiBlock % uiBlocksX) * 4;
+				const vlUInt uiY = (uiBlock / uiBlocksX) * 4;
+
+				// Pair up blocks when both lie fully inside the same row of the image.
+				if(i + 1 < uiCount && uiX + 8 <= uiWidth && uiY + 4 <= uiHeight)
+				{
+					EmitBlockPairAVX2(Batch, i, Format, lpDest + uiY * uiStride + uiX * 4, uiStride);
+					i += 2;
+				}
+				else
+				{
+					EmitClippedBlockSSE2(Batch, i, Format, lpDest, uiX, uiY, uiWidth, uiHeight);
+					i++;
+				}
+			}
+		}
+
+		return vlTrue;
+	}
+
+	//-------------------------------------------------------------------------------------------------
+	// CPU feature detection
+	//-------------------------------------------------------------------------------------------------
+
+	vlBool CPUSupportsSSE2()
+	{
+#ifdef _MSC_VER
+		int iInfo[4];
+		__cpuid(iInfo, 1);
+		return (iInfo[3] & (1 << 26)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2") ? vlTrue : vlFalse;
+#endif
+	}
+
+	vlBool CPUSupportsAVX2()
+	{
+#ifdef _MSC_VER
+		int iInfo[4];
+		__cpuid(iInfo, 0);
+		if(iInfo[0] < 7)
+		{
+			return vlFalse;
+		}
+
+		// AVX2 also needs the OS to save the YMM registers.
+		__cpuid(iInfo, 1);
+		if((iInfo[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x06) != 0x06)
+		{
+			return vlFalse;
+		}
+
+		__cpuidex(iInfo, 7, 0);
+		return (iInfo[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? vlTrue : vlFalse;
+#endif
+	}
+}
+#endif // VTFLIB_DXTN_SIMD
+
+vlBool VTFLib::IsDXTnDecoderSupported(DXTnDecoder Decoder)
+{
+	switch(Decoder)
+	{
+	case DXTN_DECODER_SCALAR:
+		return vlTrue;
+#ifdef VTFLIB_DXTN_SIMD
+	case DXTN_DECODER_SSE2:
+		return CPUSupportsSSE2();
+	case DXTN_DECODER_AVX2:
+		return CPUSupportsAVX2();
+#endif
+	default:
+		return vlFalse;
+	}
+}
+
+DXTnDecoder VTFLib::GetBestDXTnDecoder()
+{
+	static const DXTnDecoder BestDecoder =
+		IsDXTnDecoderSupported(DXTN_DECODER_AVX2) ? DXTN_DECODER_AVX2 :
+		IsDXTnDecoderSupported(DXTN_DECODER_SSE2) ? DXTN_DECODER_SSE2 :
+		DXTN_DECODER_SCALAR;
+
+	return BestDecoder;
+}
+
+const vlChar *VTFLib::DXTnDecoderName(DXTnDecoder Decoder)
+{
+	switch(Decoder)
+	{
+	case DXTN_DECODER_SCALAR:
+		return "Scalar";
+	case DXTN_DECODER_SSE2:
+		return "SSE2";
+	case DXTN_DECODER_AVX2:
+		return "AVX2";
+	default:
+		return "Unknown";
+	}
+}
+
+vlBool VTFLib::DecompressDXTn(const vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, DXTnDecoder Decoder)
+{
+	if(SourceFormat != IMAGE_FORMAT_DXT1 && SourceFormat != IMAGE_FORMAT_DXT1_ONEBITALPHA &&
+	   SourceFormat != IMAGE_FORMAT_DXT3 && SourceFormat != IMAGE_FORMAT_DXT5)
+	{
+		LastError.Set("Source format is not a DXTn format.");
+		return vlFalse;
+	}
+
+	if(!IsDXTnDecoderSupported(Decoder))
+	{
+		LastError.Set("DXTn decoder is not supported by this CPU.");
+		return vlFalse;
+	}
+
+#ifdef VTFLIB_DXTN_SIMD
+	if(Decoder != DXTN_DECODER_SCALAR)
+	{
+		const DXTnBlockFormat Format = SourceFormat == IMAGE_FORMAT_DXT3 ? DXTN_BLOCK_DXT3 :
+									   SourceFormat == IMAGE_FORMAT_DXT5 ? DXTN_BLOCK_DXT5 :
+									   DXTN_BLOCK_DXT1;
+
+		return Decoder == DXTN_DECODER_AVX2
+			? DecompressAVX2(lpSource, lpDest, uiWidth, uiHeight, Format)
+			: DecompressSSE2(lpSource, lpDest, uiWidth, uiHeight, Format);
+	}
+#endif
+
+	switch(SourceFormat)
+	{
+	case IMAGE_FORMAT_DXT3:
+		return CVTFFile::DecompressDXT3(lpSource, lpDest, uiWidth, uiHeight);
+	case IMAGE_FORMAT_DXT5:
+		return CVTFFile::DecompressDXT5(lpSource, lpDest, uiWidth, uiHeight);
+	default:
+		return CVTFFile::DecompressDXT1(lpSource, lpDest, uiWidth, uiHeight);
+	}
+}
@@ -0,0 +1,65 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2011 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file VTFDXTnDecoder.h
+	\brief Vectorised DXTn decompression.
+
+	SSE2 and AVX2 implementations of the DXT1, DXT3 and DXT5 decompressors.
+	Output is bit-exact with CVTFFile::DecompressDXT1(), CVTFFile::DecompressDXT3()
+	and CVTFFile::DecompressDXT5(), which remain the reference implementations.
+*/
+
+#ifndef VTFLIB_VTFDXTNDECODER_H
+#define VTFLIB_VTFDXTNDECODER_H
+
+#include "stdafx.h"
+#include "VTFFormat.h"
+
+namespace VTFLib
+{
+	//! DXTn decoder implementations.
+	typedef enum tagDXTnDecoder
+	{
+		DXTN_DECODER_SCALAR = 0,	//!< Reference decoder, one block per iteration.
+		DXTN_DECODER_SSE2,			//!< Palettes for 8 blocks per iteration, one block per row store.
+		DXTN_DECODER_AVX2,			//!< Palettes for 16 blocks per iteration, two blocks per row store.
+		DXTN_DECODER_COUNT
+	} DXTnDecoder;
+
+	//! Returns true if the given decoder can be used on the current CPU.
+	VTFLIB_API vlBool IsDXTnDecoderSupported(DXTnDecoder Decoder);
+
+	//! Returns the fastest decoder supported by the current CPU.
+	VTFLIB_API DXTnDecoder GetBestDXTnDecoder();
+
+	//! Returns a human-readable name for the decoder.
+	VTFLIB_API const vlChar *DXTnDecoderName(DXTnDecoder Decoder);
+
+	//! Decompress DXTn data to RGBA8888.
+	/*!
+		Decompresses DXT1, DXT3 or DXT5 data using the given decoder.
+
+		\param lpSource is a pointer to the compressed image data.
+		\param lpDest is a pointer to the buffer for the RGBA8888 data.
+		\param uiWidth is the width of the image in pixels.
+		\param uiHeight is the height of the image in pixels.
+		\param SourceFormat is the DXTn format of the source data.
+		\param Decoder is the decoder implementation to use.
+		\return true on sucessful decompression, otherwise false.
+	*/
+	VTFLIB_API vlBool DecompressDXTn(const vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat SourceFormat, DXTnDecoder Decoder);
+}
+
+#endif
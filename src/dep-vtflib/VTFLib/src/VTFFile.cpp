@@ -15,7 +15,11 @@
 #include "VTFFile.h"
 #include "VTFFormat.h"
 #include "VTFDXTn.h"
+#include "VTFDXTnDecoder.h"
 #include "VTFMathlib.h"
+#include "VTFResample.h"
+
+#include <vector>
 
 // Note: VTF creation requires nvDXTLib and has been
 //       tested with version 8.31.1127.1645, availible here:
@@ -2196,11 +2200,13 @@ vlBool CVTFFile::GenerateMipmaps(VTFMipmapFilter MipmapFilter, VTFSharpenFilter
 	vlUInt uiFrameCount = this->GetFrameCount();
 	vlUInt uiFaceCount = this->GetFaceCount();
 
+#ifdef USE_NVDXT
+	// NVDXT is not re-entrant, so images are processed one at a time.
 	for(vlUInt i = 0; i < uiFrameCount; i++)
 	{
 		for(vlUInt j = 0; j < uiFaceCount; j++)
 		{
-			if(!this->GenerateMipmaps(i, j, MipmapFilter, SharpenFilter))
+			if(!this->GenerateMipmaps(j, i, MipmapFilter, SharpenFilter))
 			{
 				return vlFalse;
 			}
@@ -2208,6 +2214,9 @@ vlBool CVTFFile::GenerateMipmaps(VTFMipmapFilter MipmapFilter, VTFSharpenFilter
 	}
 
 	return vlTrue;
+#else
+	return this->GenerateMipmapsNative(0, uiFrameCount * uiFaceCount, MipmapFilter, SharpenFilter);
+#endif
 }
 
 //
@@ -2368,15 +2377,178 @@ vlBool CVTFFile::GenerateMipmaps(vlUInt uiFace, vlUInt uiFrame, VTFMipmapFilter
 
 	return vlTrue;
 #else
-	(void)uiFace;
-	(void)uiFrame;
-	(void)MipmapFilter;
-	(void)SharpenFilter;
-	LastError.Set("NVDXT support required for CVTFFile::GenerateMipmaps().");
-	return vlFalse;
+	if(uiFace >= this->GetFaceCount() || uiFrame >= this->GetFrameCount())
+	{
+		LastError.Set("Invalid face or frame index.");
+		return vlFalse;
+	}
+
+	return this->GenerateMipmapsNative(uiFrame * this->GetFaceCount() + uiFace, 1, MipmapFilter, SharpenFilter);
 #endif
 }
 
+#ifndef USE_NVDXT
+namespace
+{
+	enum EMipmapResult
+	{
+		MIPMAP_RESULT_OK = 0,
+		MIPMAP_RESULT_DECODE_FAILED,
+		MIPMAP_RESULT_RESAMPLE_FAILED,
+		MIPMAP_RESULT_ENCODE_FAILED
+	};
+
+	struct SMipmapJob
+	{
+		CVTFFile *pVTFFile;
+		vlUInt uiFirstImage;
+		VTFMipmapFilter MipmapFilter;
+		vlUInt uiTileThreads;
+		std::vector<EMipmapResult> Results;
+	};
+
+	// Generates the mip chain of one frame/face, each level reduced from the one before it.
+	// Runs on worker threads, so failures are returned rather than written to LastError.
+	// GenerateMipmapsNative() checks everything that would make the conversions below
+	// fail before starting the workers.
+	EMipmapResult GenerateImageMipmaps(const CVTFFile &VTFFile, vlUInt uiFrame, vlUInt uiFace, VTFMipmapFilter MipmapFilter, vlUInt uiTileThreads)
+	{
+		const vlUInt uiWidth = VTFFile.GetWidth();
+		const vlUInt uiHeight = VTFFile.GetHeight();
+		const VTFImageFormat ImageFormat = VTFFile.GetFormat();
+
+		std::vector<vlByte> Source(CVTFFile::ComputeImageSize(uiWidth, uiHeight, 1, IMAGE_FORMAT_RGBA8888));
+		std::vector<vlByte> Dest;
+
+		if(!CVTFFile::ConvertToRGBA8888(VTFFile.GetData(uiFrame, uiFace, 0, 0), &Source[0], uiWidth, uiHeight, ImageFormat))
+		{
+			return MIPMAP_RESULT_DECODE_FAILED;
+		}
+
+		vlUInt uiSourceWidth = uiWidth, uiSourceHeight = uiHeight;
+		for(vlUInt i = 1; i < VTFFile.GetMipmapCount(); i++)
+		{
+			vlUInt uiMipmapWidth, uiMipmapHeight, uiMipmapDepth;
+			CVTFFile::ComputeMipmapDimensions(uiWidth, uiHeight, 1, i, uiMipmapWidth, uiMipmapHeight, uiMipmapDepth);
+
+			Dest.resize(CVTFFile::ComputeImageSize(uiMipmapWidth, uiMipmapHeight, 1, IMAGE_FORMAT_RGBA8888));
+
+			if(!ResampleRGBA8888(&Source[0], &Dest[0], uiSourceWidth, uiSourceHeight, uiMipmapWidth, uiMipmapHeight, MipmapFilter, uiTileThreads))
+			{
+				return MIPMAP_RESULT_RESAMPLE_FAILED;
+			}
+
+			// Levels are resampled from the decoded level above, not from its re-encoded data,
+			// so DXTn errors don't build up down the chain.
+			if(!CVTFFile::ConvertFromRGBA8888(&Dest[0], VTFFile.GetData(uiFrame, uiFace, 0, i), uiMipmapWidth, uiMipmapHeight, ImageFormat))
+			{
+				return MIPMAP_RESULT_ENCODE_FAILED;
+			}
+
+			Source.swap(Dest);
+			uiSourceWidth = uiMipmapWidth;
+			uiSourceHeight = uiMipmapHeight;
+		}
+
+		return MIPMAP_RESULT_OK;
+	}
+
+	vlVoid GenerateImageMipmapsJob(vlUInt uiIndex, vlVoid *pUserData)
+	{
+		SMipmapJob &Job = *static_cast<SMipmapJob *>(pUserData);
+		const vlUInt uiImage = Job.uiFirstImage + uiIndex;
+		const vlUInt uiFaceCount = Job.pVTFFile->GetFaceCount();
+
+		Job.Results[uiIndex] = GenerateImageMipmaps(*Job.pVTFFile, uiImage / uiFaceCount, uiImage % uiFaceCount, Job.MipmapFilter, Job.uiTileThreads);
+	}
+}
+
+//
+// GenerateMipmapsNative()
+// Generate mipmaps without NVDXT for uiImageCount frame/face images starting at
+// uiFirstImage (frame * face count + face). Images are spread across threads first;
+// any threads left over split each mip level into tiles.
+// DXTn images are decoded, resampled and encoded again, which needs libtxc_dxtn.
+//
+vlBool CVTFFile::GenerateMipmapsNative(vlUInt uiFirstImage, vlUInt uiImageCount, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter)
+{
+	if(this->lpImageData == 0)
+	{
+		LastError.Set("No image data to generate mipmaps from.");
+		return vlFalse;
+	}
+
+	if(this->Header->Depth > 1)
+	{
+		LastError.Set("Mipmap generation for depth textures is not supported.");
+		return vlFalse;
+	}
+
+	if(SharpenFilter != SHARPEN_FILTER_NONE)
+	{
+		LastError.Set("NVDXT support required for sharpening in CVTFFile::GenerateMipmaps().");
+		return vlFalse;
+	}
+
+	if(this->Header->MipCount <= 1 || uiImageCount == 0)
+	{
+		return vlTrue;
+	}
+
+	const SVTFImageFormatInfo &FormatInfo = GetImageFormatInfo(this->Header->ImageFormat);
+	if(!FormatInfo.bIsSupported)
+	{
+		LastError.Set("Image format not supported.");
+		return vlFalse;
+	}
+
+#ifndef USE_LIBTXC_DXTN
+	if(FormatInfo.bIsCompressed)
+	{
+		LastError.Set("NVDXT or libtxc_dxtn support required to generate mipmaps for DXTn images.");
+		return vlFalse;
+	}
+#endif
+
+	const vlUInt uiThreads = GetWorkerThreadCount();
+	const vlUInt uiImageThreads = uiImageCount < uiThreads ? uiImageCount : uiThreads;
+
+	SMipmapJob Job;
+	Job.pVTFFile = this;
+	Job.uiFirstImage = uiFirstImage;
+	Job.MipmapFilter = MipmapFilter;
+	Job.uiTileThreads = uiThreads / uiImageThreads;
+	Job.Results.resize(uiImageCount, MIPMAP_RESULT_OK);
+
+	ParallelFor(uiImageCount, uiImageThreads, GenerateImageMipmapsJob, &Job);
+
+	// Only the first failure is reported, so that the error doesn't depend on thread timing.
+	for(vlUInt i = 0; i < uiImageCount; i++)
+	{
+		const vlUInt uiImage = uiFirstImage + i;
+		const vlUInt uiFrame = uiImage / this->GetFaceCount();
+		const vlUInt uiFace = uiImage % this->GetFaceCount();
+
+		switch(Job.Results[i])
+		{
+		case MIPMAP_RESULT_OK:
+			break;
+		case MIPMAP_RESULT_DECODE_FAILED:
+			LastError.SetFormatted("Failed to decode frame %u, face %u for mipmap generation.", uiFrame, uiFace);
+			return vlFalse;
+		case MIPMAP_RESULT_RESAMPLE_FAILED:
+			LastError.SetFormatted("Failed to resample mipmaps of frame %u, face %u.", uiFrame, uiFace);
+			return vlFalse;
+		case MIPMAP_RESULT_ENCODE_FAILED:
+			LastError.SetFormatted("Failed to encode mipmaps of frame %u, face %u.", uiFrame, uiFace);
+			return vlFalse;
+		}
+	}
+
+	return vlTrue;
+}
+#endif
+
 //
 // GenerateThumbnail()
 // We should have a mipmap that matches the thumbnail size.  This function finds it and
@@ -4044,15 +4216,9 @@ vlBool CVTFFile::Convert(const vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth,
 			break;
 		case IMAGE_FORMAT_DXT1:
 		case IMAGE_FORMAT_DXT1_ONEBITALPHA:
-			bResult = CVTFFile::DecompressDXT1(lpSource, lpTemp, uiWidth, uiHeight);
-			lpSourceRGBA = lpTemp;
-			break;
 		case IMAGE_FORMAT_DXT3:
-			bResult = CVTFFile::DecompressDXT3(lpSource, lpTemp, uiWidth, uiHeight);
-			lpSourceRGBA = lpTemp;
-			break;
 		case IMAGE_FORMAT_DXT5:
-			bResult = CVTFFile::DecompressDXT5(lpSource, lpTemp, uiWidth, uiHeight);
+			bResult = DecompressDXTn(lpSource, lpTemp, uiWidth, uiHeight, SourceFormat, GetBestDXTnDecoder());
 			lpSourceRGBA = lpTemp;
 			break;
 		default:
@@ -4239,17 +4405,13 @@ vlBool CVTFFile::Resize(const vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888,
 
 	return nvDXTCompressWrapper(lpSourceRGBA8888, uiSourceWidth, uiSourceHeight, &Options, NVWriteCallback);
 #else
-	(void)lpSourceRGBA8888;
-	(void)lpDestRGBA8888;
-	(void)uiSourceWidth;
-	(void)uiSourceHeight;
-	(void)uiDestWidth;
-	(void)uiDestHeight;
-	(void)ResizeFilter;
-	(void)SharpenFilter;
-
-	LastError.Set("NVDXT support required for CVTFFile::Resize().");
-	return vlFalse;
+	if(SharpenFilter != SHARPEN_FILTER_NONE)
+	{
+		LastError.Set("NVDXT support required for sharpening in CVTFFile::Resize().");
+		return vlFalse;
+	}
+
+	return ResampleRGBA8888(lpSourceRGBA8888, lpDestRGBA8888, uiSourceWidth, uiSourceHeight, uiDestWidth, uiDestHeight, ResizeFilter, GetWorkerThreadCount());
 #endif
 }
 
@@ -484,6 +484,11 @@ namespace VTFLib
 			MIP level 0 as the source. Unless otherwise specified, a standard box
 			filter with no sharpening is used during compression.
 
+			Without NVDXT, faces and frames are processed concurrently using up to
+			VTFLIB_THREAD_COUNT threads; see VTFResample.h. DXTn images are decoded,
+			resampled and encoded again, which needs libtxc_dxtn; without either
+			library, DXTn images are rejected.
+
 			\param MipmapFilter is the reduction filter to use (default Box).
 			\param SharpenFilter is the sharpening filter to use (default none).
 			\return true on sucessful creation, otherwise false.
@@ -635,6 +640,9 @@ namespace VTFLib
 		// Calculates where in the VTF image the data begins
 		vlUInt ComputeDataOffset(vlUInt uiFrame, vlUInt uiFace, vlUInt uiSlice, vlUInt uiMipmapLevel, VTFImageFormat ImageFormat) const;
 
+		// Generates mipmaps without NVDXT for a run of frame/face images.
+		vlBool GenerateMipmapsNative(vlUInt uiFirstImage, vlUInt uiImageCount, VTFMipmapFilter MipmapFilter, VTFSharpenFilter SharpenFilter);
+
 	public:
 
 		//! Convert an image to RGBA8888 format.
@@ -710,17 +718,21 @@ namespace VTFLib
 			\param uiDestHeight is the height of the destination image in pixels.
 			\param ResizeFilter is the image reduction filter to use (default triangle).
 			\param SharpenFilter is the image sharpening filter to use (default none).
+			\note Without NVDXT only point, box and triangle filtering are available
+			(other filters fall back to triangle) and sharpening is not supported.
 			\return true on sucessful re-size, otherwise false.
 		*/
 		static vlBool Resize(const vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter ResizeFilter = MIPMAP_FILTER_TRIANGLE, VTFSharpenFilter SharpenFilter = SHARPEN_FILTER_NONE);
 
-	private:
-		
-		// DXTn format decompression functions
+		// DXTn format decompression functions.
+		// These are the scalar reference implementations; Convert() uses the
+		// fastest decoder available from VTFDXTnDecoder.h.
 		static vlBool DecompressDXT1(const vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight);
 		static vlBool DecompressDXT3(const vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight);
 		static vlBool DecompressDXT5(const vlByte *src, vlByte *dst, vlUInt uiWidth, vlUInt uiHeight);
 
+	private:
+
 		// DXTn format compression function
 		static vlBool CompressDXTn(const vlByte *lpSource, vlByte *lpDest, vlUInt uiWidth, vlUInt uiHeight, VTFImageFormat DestFormat);
 
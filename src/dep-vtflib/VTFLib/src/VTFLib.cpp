@@ -52,6 +52,8 @@ namespace VTFLib
 	vlSingle sXSharpenThreshold = 255.0f;
 
 	vlUInt uiVMTParseMode = PARSE_MODE_LOOSE;
+
+	vlUInt uiThreadCount = 0;	// 0 = one per hardware thread.
 }
 
 //
@@ -170,6 +172,9 @@ VTFLIB_API vlInt vlGetInteger(VTFLibOption Option)
 	case VTFLIB_VMT_PARSE_MODE:
 		return (vlInt)uiVMTParseMode;
 
+	case VTFLIB_THREAD_COUNT:
+		return (vlInt)uiThreadCount;
+
 	default:
 		return 0;
 	}
@@ -235,6 +240,12 @@ VTFLIB_API vlVoid vlSetInteger(VTFLibOption Option, vlInt iValue)
 		uiVMTParseMode = (vlUInt)iValue;
 		break;
 
+	case VTFLIB_THREAD_COUNT:
+		if(iValue < 0)
+			iValue = 0;
+		uiThreadCount = (vlUInt)iValue;
+		break;
+
 	default:
 		break;
 	}
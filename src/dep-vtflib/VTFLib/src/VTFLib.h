@@ -148,6 +148,8 @@ namespace VTFLib
 	extern vlSingle sXSharpenThreshold;
 
 	extern vlUInt uiVMTParseMode;
+
+	extern vlUInt uiThreadCount;
 }
 #endif
 
@@ -182,7 +184,9 @@ typedef enum tagVTFLibOption
 	VTFLIB_XSHARPEN_STRENGTH,
 	VTFLIB_XSHARPEN_THRESHOLD,
 
-	VTFLIB_VMT_PARSE_MODE
+	VTFLIB_VMT_PARSE_MODE,
+
+	VTFLIB_THREAD_COUNT
 } VTFLibOption;
 
 //! Return the VTFLib version as an integer.
@@ -0,0 +1,444 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2011 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "VTFLib.h"
+#include "VTFResample.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define VTFLIB_RESAMPLE_SSE2
+#	include <emmintrin.h>
+#endif
+
+using namespace VTFLib;
+
+namespace
+{
+	// Destination rows per tile. Each tile is filtered independently.
+	const vlUInt uiTileRows = 32;
+
+	// Below this many destination pixels the cost of starting threads outweighs the work.
+	const vlUInt uiMinPixelsPerThread = 128 * 128;
+
+	//-------------------------------------------------------------------------------------------------
+	// ParallelFor
+	//-------------------------------------------------------------------------------------------------
+
+	struct SParallelForState
+	{
+		std::atomic<vlUInt> Next;
+		vlUInt uiCount;
+		PParallelForFunction pFunction;
+		vlVoid *pUserData;
+	};
+
+	vlVoid RunParallelFor(SParallelForState *pState)
+	{
+		for(;;)
+		{
+			const vlUInt uiIndex = pState->Next++;
+			if(uiIndex >= pState->uiCount)
+			{
+				break;
+			}
+
+			pState->pFunction(uiIndex, pState->pUserData);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------
+	// Filter construction
+	//-------------------------------------------------------------------------------------------------
+
+	// Source taps contributing to one destination pixel along one axis.
+	struct SContribution
+	{
+		vlUInt uiFirst;		// First source index.
+		vlUInt uiCount;		// Number of consecutive source indices.
+		vlUInt uiWeights;	// Offset of the first weight in SAxisFilter::Weights.
+	};
+
+	struct SAxisFilter
+	{
+		std::vector<SContribution> Contributions;
+		std::vector<vlSingle> Weights;
+	};
+
+	inline vlSingle EvaluateFilter(VTFMipmapFilter Filter, vlSingle x)
+	{
+		if(Filter == MIPMAP_FILTER_BOX)
+		{
+			return x >= -0.5f && x < 0.5f ? 1.0f : 0.0f;
+		}
+
+		x = fabsf(x);
+		return x < 1.0f ? 1.0f - x : 0.0f;
+	}
+
+	inline vlInt Clamp(vlInt iValue, vlInt iMax)
+	{
+		return iValue < 0 ? 0 : (iValue > iMax ? iMax : iValue);
+	}
+
+	vlVoid BuildAxisFilter(SAxisFilter &AxisFilter, vlUInt uiSource, vlUInt uiDest, VTFMipmapFilter Filter)
+	{
+		const vlSingle sScale = (vlSingle)uiDest / (vlSingle)uiSource;
+		const vlSingle sFilterScale = sScale < 1.0f ? sScale : 1.0f;
+		const vlSingle sSupport = (Filter == MIPMAP_FILTER_BOX ? 0.5f : 1.0f) / sFilterScale;
+		const vlInt iMax = (vlInt)uiSource - 1;
+
+		AxisFilter.Contributions.resize(uiDest);
+		AxisFilter.Weights.clear();
+
+		for(vlUInt i = 0; i < uiDest; i++)
+		{
+			const vlSingle sCentre = ((vlSingle)i + 0.5f) / sScale - 0.5f;
+			SContribution &Contribution = AxisFilter.Contributions[i];
+			Contribution.uiWeights = (vlUInt)AxisFilter.Weights.size();
+
+			if(Filter == MIPMAP_FILTER_POINT)
+			{
+				Contribution.uiFirst = (vlUInt)Clamp((vlInt)floorf(sCentre + 0.5f), iMax);
+				Contribution.uiCount = 1;
+				AxisFilter.Weights.push_back(1.0f);
+				continue;
+			}
+
+			// Taps outside the image are clamped to the edge pixels.
+			const vlInt iLeft = (vlInt)ceilf(sCentre - sSupport);
+			const vlInt iRight = (vlInt)floorf(sCentre + sSupport);
+			const vlInt iFirst = Clamp(iLeft, iMax);
+
+			Contribution.uiFirst = (vlUInt)iFirst;
+			Contribution.uiCount = (vlUInt)(Clamp(iRight, iMax) - iFirst + 1);
+			AxisFilter.Weights.resize(AxisFilter.Weights.size() + Contribution.uiCount, 0.0f);
+
+			vlSingle *lpWeights = &AxisFilter.Weights[Contribution.uiWeights];
+			vlSingle sTotal = 0.0f;
+
+			for(vlInt j = iLeft; j <= iRight; j++)
+			{
+				const vlSingle sWeight = EvaluateFilter(Filter, (sCentre - (vlSingle)j) * sFilterScale);
+				lpWeights[Clamp(j, iMax) - iFirst] += sWeight;
+				sTotal += sWeight;
+			}
+
+			if(sTotal > 0.0f)
+			{
+				for(vlUInt j = 0; j < Contribution.uiCount; j++)
+				{
+					lpWeights[j] /= sTotal;
+				}
+			}
+			else
+			{
+				lpWeights[Clamp((vlInt)floorf(sCentre + 0.5f), iMax) - iFirst] = 1.0f;
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------
+	// Kernels
+	//-------------------------------------------------------------------------------------------------
+
+	// Filters one source row into a row of uiDestWidth float RGBA pixels.
+	vlVoid FilterRowHorizontal(const vlByte *lpSourceRow, vlSingle *lpDestRow, const SAxisFilter &AxisFilter)
+	{
+		const vlUInt uiDestWidth = (vlUInt)AxisFilter.Contributions.size();
+
+		for(vlUInt x = 0; x < uiDestWidth; x++, lpDestRow += 4)
+		{
+			const SContribution &Contribution = AxisFilter.Contributions[x];
+			const vlSingle *lpWeights = &AxisFilter.Weights[Contribution.uiWeights];
+			const vlByte *lpPixel = lpSourceRow + Contribution.uiFirst * 4;
+
+#ifdef VTFLIB_RESAMPLE_SSE2
+			const __m128i Zero = _mm_setzero_si128();
+			__m128 Sum = _mm_setzero_ps();
+
+			for(vlUInt k = 0; k < Contribution.uiCount; k++, lpPixel += 4)
+			{
+				vlInt iPixel;
+				memcpy(&iPixel, lpPixel, sizeof(vlInt));
+				const __m128i Pixel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(iPixel), Zero), Zero);
+				Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_cvtepi32_ps(Pixel), _mm_set1_ps(lpWeights[k])));
+			}
+
+			_mm_storeu_ps(lpDestRow, Sum);
+#else
+			vlSingle sSum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for(vlUInt k = 0; k < Contribution.uiCount; k++, lpPixel += 4)
+			{
+				for(vlUInt c = 0; c < 4; c++)
+				{
+					sSum[c] += (vlSingle)lpPixel[c] * lpWeights[k];
+				}
+			}
+
+			memcpy(lpDestRow, sSum, sizeof(sSum));
+#endif
+		}
+	}
+
+	// Combines uiCount consecutive float rows into one RGBA8888 destination row.
+	vlVoid FilterRowVertical(const vlSingle *lpRows, vlUInt uiRowFloats, vlUInt uiCount, const vlSingle *lpWeights, vlByte *lpDestRow, vlUInt uiDestWidth)
+	{
+		for(vlUInt x = 0; x < uiDestWidth; x++, lpDestRow += 4)
+		{
+			const vlSingle *lpPixel = lpRows + x * 4;
+
+#ifdef VTFLIB_RESAMPLE_SSE2
+			__m128 Sum = _mm_setzero_ps();
+
+			for(vlUInt k = 0; k < uiCount; k++, lpPixel += uiRowFloats)
+			{
+				Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_loadu_ps(lpPixel), _mm_set1_ps(lpWeights[k])));
+			}
+
+			__m128i Pixel = _mm_cvttps_epi32(_mm_add_ps(Sum, _mm_set1_ps(0.5f)));
+			Pixel = _mm_packs_epi32(Pixel, Pixel);
+			Pixel = _mm_packus_epi16(Pixel, Pixel);
+
+			const vlInt iPixel = _mm_cvtsi128_si32(Pixel);
+			memcpy(lpDestRow, &iPixel, sizeof(vlInt));
+#else
+			vlSingle sSum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for(vlUInt k = 0; k < uiCount; k++, lpPixel += uiRowFloats)
+			{
+				for(vlUInt c = 0; c < 4; c++)
+				{
+					sSum[c] += lpPixel[c] * lpWeights[k];
+				}
+			}
+
+			for(vlUInt c = 0; c < 4; c++)
+			{
+				const vlSingle sValue = sSum[c] + 0.5f;
+				lpDestRow[c] = sValue <= 0.0f ? 0 : (sValue >= 255.0f ? 255 : (vlByte)sValue);
+			}
+#endif
+		}
+	}
+
+	// Exact 2:1 box reduction, equivalent to the generic box filter for this case.
+	vlVoid HalveRowBox(const vlByte *lpSourceRow0, const vlByte *lpSourceRow1, vlByte *lpDestRow, vlUInt uiDestWidth)
+	{
+		vlUInt x = 0;
+
+#ifdef VTFLIB_RESAMPLE_SSE2
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Two = _mm_set1_epi16(2);
+
+		// Four destination pixels from eight source pixels of each row.
+		for(; x + 4 <= uiDestWidth; x += 4)
+		{
+			const __m128i a0 = _mm_loadu_si128((const __m128i *)(lpSourceRow0 + x * 8));
+			const __m128i a1 = _mm_loadu_si128((const __m128i *)(lpSourceRow0 + x * 8 + 16));
+			const __m128i b0 = _mm_loadu_si128((const __m128i *)(lpSourceRow1 + x * 8));
+			const __m128i b1 = _mm_loadu_si128((const __m128i *)(lpSourceRow1 + x * 8 + 16));
+
+			// Vertical sums, two source pixels per register.
+			const __m128i v0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, Zero), _mm_unpacklo_epi8(b0, Zero));
+			const __m128i v1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, Zero), _mm_unpackhi_epi8(b0, Zero));
+			const __m128i v2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, Zero), _mm_unpacklo_epi8(b1, Zero));
+			const __m128i v3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, Zero), _mm_unpackhi_epi8(b1, Zero));
+
+			// Horizontal pair sums end up in the low 64 bits.
+			const __m128i h0 = _mm_add_epi16(v0, _mm_srli_si128(v0, 8));
+			const __m128i h1 = _mm_add_epi16(v1, _mm_srli_si128(v1, 8));
+			const __m128i h2 = _mm_add_epi16(v2, _mm_srli_si128(v2, 8));
+			const __m128i h3 = _mm_add_epi16(v3, _mm_srli_si128(v3, 8));
+
+			const __m128i Low = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(h0, h1), Two), 2);
+			const __m128i High = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(h2, h3), Two), 2);
+
+			_mm_storeu_si128((__m128i *)(lpDestRow + x * 4), _mm_packus_epi16(Low, High));
+		}
+#endif
+
+		for(; x < uiDestWidth; x++)
+		{
+			for(vlUInt c = 0; c < 4; c++)
+			{
+				lpDestRow[x * 4 + c] = (vlByte)((lpSourceRow0[x * 8 + c] + lpSourceRow0[x * 8 + 4 + c] +
+												 lpSourceRow1[x * 8 + c] + lpSourceRow1[x * 8 + 4 + c] + 2) >> 2);
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------
+	// Tiles
+	//-------------------------------------------------------------------------------------------------
+
+	struct SResampleState
+	{
+		const vlByte *lpSource;
+		vlByte *lpDest;
+		vlUInt uiSourceWidth;
+		vlUInt uiDestWidth;
+		vlUInt uiDestHeight;
+		SAxisFilter Horizontal;
+		SAxisFilter Vertical;
+	};
+
+	vlVoid ResampleTile(vlUInt uiTile, vlVoid *pUserData)
+	{
+		const SResampleState &State = *static_cast<const SResampleState *>(pUserData);
+
+		const vlUInt uiFirstRow = uiTile * uiTileRows;
+		const vlUInt uiLastRow = uiFirstRow + uiTileRows < State.uiDestHeight ? uiFirstRow + uiTileRows : State.uiDestHeight;
+		const vlUInt uiRowFloats = State.uiDestWidth * 4;
+
+		// Source rows needed by this tile.
+		vlUInt uiSourceFirst = State.Vertical.Contributions[uiFirstRow].uiFirst;
+		vlUInt uiSourceLast = uiSourceFirst;
+		for(vlUInt y = uiFirstRow; y < uiLastRow; y++)
+		{
+			const SContribution &Contribution = State.Vertical.Contributions[y];
+			if(Contribution.uiFirst < uiSourceFirst)
+				uiSourceFirst = Contribution.uiFirst;
+			if(Contribution.uiFirst + Contribution.uiCount - 1 > uiSourceLast)
+				uiSourceLast = Contribution.uiFirst + Contribution.uiCount - 1;
+		}
+
+		std::vector<vlSingle> Rows((uiSourceLast - uiSourceFirst + 1) * uiRowFloats);
+		for(vlUInt y = uiSourceFirst; y <= uiSourceLast; y++)
+		{
+			FilterRowHorizontal(State.lpSource + y * State.uiSourceWidth * 4, &Rows[(y - uiSourceFirst) * uiRowFloats], State.Horizontal);
+		}
+
+		for(vlUInt y = uiFirstRow; y < uiLastRow; y++)
+		{
+			const SContribution &Contribution = State.Vertical.Contributions[y];
+			FilterRowVertical(&Rows[(Contribution.uiFirst - uiSourceFirst) * uiRowFloats], uiRowFloats, Contribution.uiCount,
+							  &State.Vertical.Weights[Contribution.uiWeights], State.lpDest + y * uiRowFloats, State.uiDestWidth);
+		}
+	}
+
+	vlVoid HalveTileBox(vlUInt uiTile, vlVoid *pUserData)
+	{
+		const SResampleState &State = *static_cast<const SResampleState *>(pUserData);
+
+		const vlUInt uiFirstRow = uiTile * uiTileRows;
+		const vlUInt uiLastRow = uiFirstRow + uiTileRows < State.uiDestHeight ? uiFirstRow + uiTileRows : State.uiDestHeight;
+		const vlUInt uiSourceStride = State.uiSourceWidth * 4;
+
+		for(vlUInt y = uiFirstRow; y < uiLastRow; y++)
+		{
+			const vlByte *lpSourceRow = State.lpSource + 2 * y * uiSourceStride;
+			HalveRowBox(lpSourceRow, lpSourceRow + uiSourceStride, State.lpDest + y * State.uiDestWidth * 4, State.uiDestWidth);
+		}
+	}
+}
+
+vlUInt VTFLib::GetWorkerThreadCount()
+{
+	if(uiThreadCount != 0)
+	{
+		return uiThreadCount;
+	}
+
+	const vlUInt uiHardwareThreads = std::thread::hardware_concurrency();
+	return uiHardwareThreads != 0 ? uiHardwareThreads : 1;
+}
+
+vlVoid VTFLib::ParallelFor(vlUInt uiCount, vlUInt uiThreads, PParallelForFunction pFunction, vlVoid *pUserData)
+{
+	if(uiThreads > uiCount)
+	{
+		uiThreads = uiCount;
+	}
+
+	if(uiThreads <= 1)
+	{
+		for(vlUInt i = 0; i < uiCount; i++)
+		{
+			pFunction(i, pUserData);
+		}
+		return;
+	}
+
+	SParallelForState State;
+	State.Next = 0;
+	State.uiCount = uiCount;
+	State.pFunction = pFunction;
+	State.pUserData = pUserData;
+
+	std::vector<std::thread> Workers;
+	Workers.reserve(uiThreads - 1);
+	for(vlUInt i = 1; i < uiThreads; i++)
+	{
+		Workers.push_back(std::thread(RunParallelFor, &State));
+	}
+
+	RunParallelFor(&State);
+
+	for(vlUInt i = 0; i < Workers.size(); i++)
+	{
+		Workers[i].join();
+	}
+}
+
+vlBool VTFLib::ResampleRGBA8888(const vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter Filter, vlUInt uiThreads)
+{
+	if(uiSourceWidth == 0 || uiSourceHeight == 0 || uiDestWidth == 0 || uiDestHeight == 0)
+	{
+		LastError.Set("Invalid image dimensions.");
+		return vlFalse;
+	}
+
+	if(uiSourceWidth == uiDestWidth && uiSourceHeight == uiDestHeight)
+	{
+		memcpy(lpDestRGBA8888, lpSourceRGBA8888, uiSourceWidth * uiSourceHeight * 4);
+		return vlTrue;
+	}
+
+	// Only point, box and triangle are implemented natively.
+	if(Filter != MIPMAP_FILTER_POINT && Filter != MIPMAP_FILTER_BOX)
+	{
+		Filter = MIPMAP_FILTER_TRIANGLE;
+	}
+
+	const vlUInt uiUsefulThreads = (uiDestWidth * uiDestHeight) / uiMinPixelsPerThread + 1;
+	if(uiThreads > uiUsefulThreads)
+	{
+		uiThreads = uiUsefulThreads;
+	}
+
+	SResampleState State;
+	State.lpSource = lpSourceRGBA8888;
+	State.lpDest = lpDestRGBA8888;
+	State.uiSourceWidth = uiSourceWidth;
+	State.uiDestWidth = uiDestWidth;
+	State.uiDestHeight = uiDestHeight;
+
+	const vlUInt uiTileCount = (uiDestHeight + uiTileRows - 1) / uiTileRows;
+
+	if(Filter == MIPMAP_FILTER_BOX && uiSourceWidth == uiDestWidth * 2 && uiSourceHeight == uiDestHeight * 2)
+	{
+		ParallelFor(uiTileCount, uiThreads, HalveTileBox, &State);
+		return vlTrue;
+	}
+
+	BuildAxisFilter(State.Horizontal, uiSourceWidth, uiDestWidth, Filter);
+	BuildAxisFilter(State.Vertical, uiSourceHeight, uiDestHeight, Filter);
+
+	ParallelFor(uiTileCount, uiThreads, ResampleTile, &State);
+	return vlTrue;
+}
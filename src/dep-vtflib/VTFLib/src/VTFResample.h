@@ -0,0 +1,63 @@
+/*
+ * VTFLib
+ * Copyright (C) 2005-2011 Neil Jedrzejewski & Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+// ============================================================
+// NOTE: This file is commented for compatibility with Doxygen.
+// ============================================================
+/*!
+	\file VTFResample.h
+	\brief Multithreaded RGBA8888 image resampling.
+
+	Native image resampling used by CVTFFile::Resize() and CVTFFile::GenerateMipmaps()
+	when VTFLib is built without NVDXT. Point, box and triangle filters are implemented
+	directly; the remaining mipmap filters fall back to triangle.
+*/
+
+#ifndef VTFLIB_VTFRESAMPLE_H
+#define VTFLIB_VTFRESAMPLE_H
+
+#include "stdafx.h"
+#include "VTFFormat.h"
+
+namespace VTFLib
+{
+	//! Work item callback for ParallelFor().
+	typedef vlVoid (*PParallelForFunction)(vlUInt uiIndex, vlVoid *pUserData);
+
+	//! Returns the number of worker threads to use, honouring VTFLIB_THREAD_COUNT.
+	VTFLIB_API vlUInt GetWorkerThreadCount();
+
+	//! Runs pFunction for every index in [0, uiCount) using up to uiThreads threads.
+	/*!
+		The calling thread takes part in the work. Indices are handed out dynamically,
+		so the order in which they are processed is unspecified.
+	*/
+	VTFLIB_API vlVoid ParallelFor(vlUInt uiCount, vlUInt uiThreads, PParallelForFunction pFunction, vlVoid *pUserData);
+
+	//! Re-size an RGBA8888 image.
+	/*!
+		Re-sizes an image using a separable filter. The destination is split into
+		horizontal tiles which are filtered concurrently.
+
+		\param lpSourceRGBA8888 is a pointer to the source image data in RGBA8888 format.
+		\param lpDestRGBA8888 is a pointer to the buffer for the re-sized data.
+		\param uiSourceWidth is the width of the source image in pixels.
+		\param uiSourceHeight is the height of the source image in pixels.
+		\param uiDestWidth is the width of the destination image in pixels.
+		\param uiDestHeight is the height of the destination image in pixels.
+		\param Filter is the re-size filter.
+		\param uiThreads is the maximum number of threads to use.
+		\return true on sucessful re-size, otherwise false.
+	*/
+	VTFLIB_API vlBool ResampleRGBA8888(const vlByte *lpSourceRGBA8888, vlByte *lpDestRGBA8888, vlUInt uiSourceWidth, vlUInt uiSourceHeight, vlUInt uiDestWidth, vlUInt uiDestHeight, VTFMipmapFilter Filter, vlUInt uiThreads);
+}
+
+#endif
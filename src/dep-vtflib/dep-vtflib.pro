@@ -29,9 +29,11 @@ SOURCES += \
     VTFLib/src/VMTStringNode.cpp \
     VTFLib/src/VMTValueNode.cpp \
     VTFLib/src/VMTWrapper.cpp \
+    VTFLib/src/VTFDXTnDecoder.cpp \
     VTFLib/src/VTFFile.cpp \
     VTFLib/src/VTFLib.cpp \
     VTFLib/src/VTFMathlib.cpp \
+    VTFLib/src/VTFResample.cpp \
     VTFLib/src/VTFWrapper.cpp \
     VTFLib/src/unix/UnixError.cpp \
     VTFLib/src/unix/UnixFileReader.cpp \
@@ -68,10 +70,12 @@ HEADERS +=\
     VTFLib/src/VMTValueNode.h \
     VTFLib/src/VMTWrapper.h \
     VTFLib/src/VTFDXTn.h \
+    VTFLib/src/VTFDXTnDecoder.h \
     VTFLib/src/VTFFile.h \
     VTFLib/src/VTFFormat.h \
     VTFLib/src/VTFLib.h \
     VTFLib/src/VTFMathlib.h \
+    VTFLib/src/VTFResample.h \
     VTFLib/src/VTFWrapper.h \
     VTFLib/src/Writer.h \
     VTFLib/src/Writers.h
@@ -25,7 +25,9 @@ SOURCES += \
     file-formats/vpk/vpkindextreeitem.cpp \
     file-formats/vpk/vpkindextreeiterator.cpp \
     file-formats/vpk/vpkindextreerecord.cpp \
-    file-formats/vpk/vpkothermd5item.cpp
+    file-formats/vpk/vpkothermd5item.cpp \
+    file-formats/vmt/vmtmaterial.cpp \
+    file-formats/vmt/vmtmaterialcache.cpp
 
 HEADERS +=\
         file-formats_global.h \
@@ -42,7 +44,9 @@ HEADERS +=\
     file-formats/vpk/vpkindextreeitem.h \
     file-formats/vpk/vpkindextreeiterator.h \
     file-formats/vpk/vpkindextreerecord.h \
-    file-formats/vpk/vpkothermd5item.h
+    file-formats/vpk/vpkothermd5item.h \
+    file-formats/vmt/vmtmaterial.h \
+    file-formats/vmt/vmtmaterialcache.h
 
 unix {
     target.path = /usr/lib
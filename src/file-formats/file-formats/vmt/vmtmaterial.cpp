@@ -0,0 +1,275 @@
+#include "vmtmaterial.h"
+#include "calliperutil/general/generalutil.h"
+#include <QJsonArray>
+#include <QJsonValue>
+
+namespace FileFormats
+{
+    namespace
+    {
+        const char* PATCH_SHADER = "patch";
+        const char* MATERIALS_PREFIX = "materials/";
+
+        QJsonValue lowercaseKeys(const QJsonValue& value);
+
+        QJsonObject lowercaseKeys(const QJsonObject& object)
+        {
+            QJsonObject result;
+            for ( QJsonObject::const_iterator it = object.constBegin(); it != object.constEnd(); ++it )
+            {
+                result.insert(it.key().toLower(), lowercaseKeys(it.value()));
+            }
+
+            return result;
+        }
+
+        QJsonValue lowercaseKeys(const QJsonValue& value)
+        {
+            if ( value.isObject() )
+            {
+                return lowercaseKeys(value.toObject());
+            }
+
+            if ( value.isArray() )
+            {
+                QJsonArray result;
+                foreach ( const QJsonValue& item, value.toArray() )
+                {
+                    result.append(lowercaseKeys(item));
+                }
+
+                return result;
+            }
+
+            return value;
+        }
+
+        // Repeated keys are converted to arrays by the parser.
+        // As in the engine, the last occurrence wins.
+        QString stringValue(const QJsonValue& value, const QString& defaultValue)
+        {
+            if ( value.isString() )
+            {
+                return value.toString();
+            }
+
+            if ( value.isArray() )
+            {
+                QJsonArray array = value.toArray();
+                for ( int i = array.count() - 1; i >= 0; --i )
+                {
+                    if ( array.at(i).isString() )
+                    {
+                        return array.at(i).toString();
+                    }
+                }
+            }
+
+            return defaultValue;
+        }
+    }
+
+    VMTMaterial::VMTMaterial()
+        : m_strShaderName(),
+          m_Parameters()
+    {
+    }
+
+    VMTMaterial::VMTMaterial(const QString &shaderName, const QJsonObject &parameters)
+        : m_strShaderName(shaderName.toLower()),
+          m_Parameters(lowercaseKeys(parameters))
+    {
+    }
+
+    VMTMaterial VMTMaterial::fromJsonDocument(const QJsonDocument &document, QString *errorHint)
+    {
+        if ( !document.isObject() || document.object().isEmpty() )
+        {
+            if ( errorHint )
+            {
+                *errorHint = "VMT has no shader block.";
+            }
+
+            return VMTMaterial();
+        }
+
+        QJsonObject root = document.object();
+        QJsonObject::const_iterator shader = root.constBegin();
+        if ( !shader.value().isObject() )
+        {
+            if ( errorHint )
+            {
+                *errorHint = QString("Shader block '%1' is not an object.").arg(shader.key());
+            }
+
+            return VMTMaterial();
+        }
+
+        return VMTMaterial(shader.key(), shader.value().toObject());
+    }
+
+    QString VMTMaterial::normalisePath(const QString &path, const QString &extension)
+    {
+        QString normalised = CalliperUtil::General::normaliseResourcePathSeparators(path.trimmed().toLower());
+
+        while ( normalised.startsWith('/') )
+        {
+            normalised.remove(0, 1);
+        }
+
+        if ( normalised.startsWith(MATERIALS_PREFIX) )
+        {
+            normalised.remove(0, static_cast<int>(strlen(MATERIALS_PREFIX)));
+        }
+
+        if ( !extension.isEmpty() && normalised.endsWith("." + extension.toLower()) )
+        {
+            normalised.chop(extension.length() + 1);
+        }
+
+        return normalised;
+    }
+
+    bool VMTMaterial::isValid() const
+    {
+        return !m_strShaderName.isEmpty();
+    }
+
+    QString VMTMaterial::shaderName() const
+    {
+        return m_strShaderName;
+    }
+
+    const QJsonObject& VMTMaterial::parameters() const
+    {
+        return m_Parameters;
+    }
+
+    bool VMTMaterial::isPatch() const
+    {
+        return m_strShaderName == PATCH_SHADER;
+    }
+
+    QString VMTMaterial::includePath() const
+    {
+        return isPatch() ? normalisePath(stringParameter("include"), "vmt") : QString();
+    }
+
+    QJsonObject VMTMaterial::patchInsertBlock() const
+    {
+        return isPatch() ? m_Parameters.value("insert").toObject() : QJsonObject();
+    }
+
+    QJsonObject VMTMaterial::patchReplaceBlock() const
+    {
+        return isPatch() ? m_Parameters.value("replace").toObject() : QJsonObject();
+    }
+
+    VMTMaterial VMTMaterial::patched(const QJsonObject &insert, const QJsonObject &replace) const
+    {
+        VMTMaterial material(*this);
+
+        for ( QJsonObject::const_iterator it = insert.constBegin(); it != insert.constEnd(); ++it )
+        {
+            material.m_Parameters.insert(it.key().toLower(), lowercaseKeys(it.value()));
+        }
+
+        for ( QJsonObject::const_iterator it = replace.constBegin(); it != replace.constEnd(); ++it )
+        {
+            const QString key = it.key().toLower();
+            if ( material.m_Parameters.contains(key) )
+            {
+                material.m_Parameters.insert(key, lowercaseKeys(it.value()));
+            }
+        }
+
+        return material;
+    }
+
+    bool VMTMaterial::hasParameter(const QString &name) const
+    {
+        return m_Parameters.contains(name.toLower());
+    }
+
+    QString VMTMaterial::stringParameter(const QString &name, const QString &defaultValue) const
+    {
+        return stringValue(m_Parameters.value(name.toLower()), defaultValue);
+    }
+
+    int VMTMaterial::intParameter(const QString &name, int defaultValue) const
+    {
+        bool ok = false;
+        int value = stringParameter(name).trimmed().toInt(&ok);
+        return ok ? value : defaultValue;
+    }
+
+    float VMTMaterial::floatParameter(const QString &name, float defaultValue) const
+    {
+        bool ok = false;
+        float value = stringParameter(name).trimmed().toFloat(&ok);
+        return ok ? value : defaultValue;
+    }
+
+    bool VMTMaterial::boolParameter(const QString &name, bool defaultValue) const
+    {
+        const QString value = stringParameter(name).trimmed().toLower();
+        if ( value == "true" )
+        {
+            return true;
+        }
+
+        if ( value == "false" )
+        {
+            return false;
+        }
+
+        bool ok = false;
+        float number = value.toFloat(&ok);
+        return ok ? number != 0.0f : defaultValue;
+    }
+
+    QString VMTMaterial::baseTexture() const
+    {
+        return texturePath("$basetexture");
+    }
+
+    QString VMTMaterial::baseTexture2() const
+    {
+        return texturePath("$basetexture2");
+    }
+
+    QString VMTMaterial::bumpMap() const
+    {
+        return texturePath("$bumpmap");
+    }
+
+    bool VMTMaterial::isTranslucent() const
+    {
+        return boolParameter("$translucent");
+    }
+
+    bool VMTMaterial::isAlphaTest() const
+    {
+        return boolParameter("$alphatest");
+    }
+
+    float VMTMaterial::alphaTestReference() const
+    {
+        return floatParameter("$alphatestreference", 0.5f);
+    }
+
+    bool VMTMaterial::operator ==(const VMTMaterial &other) const
+    {
+        return m_strShaderName == other.m_strShaderName && m_Parameters == other.m_Parameters;
+    }
+
+    bool VMTMaterial::operator !=(const VMTMaterial &other) const
+    {
+        return !(*this == other);
+    }
+
+    QString VMTMaterial::texturePath(const QString &name) const
+    {
+        return normalisePath(stringParameter(name), "vtf");
+    }
+}
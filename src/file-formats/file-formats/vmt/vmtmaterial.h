@@ -0,0 +1,73 @@
+#ifndef VMTMATERIAL_H
+#define VMTMATERIAL_H
+
+#include "file-formats_global.h"
+#include <QString>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QSharedPointer>
+
+namespace FileFormats
+{
+    // The shader and parameters described by a VMT.
+    // Shader names and parameter names are case-insensitive in VMTs, so they are
+    // stored lowercase; parameter values are kept as they were written.
+    class FILEFORMATSSHARED_EXPORT VMTMaterial
+    {
+    public:
+        VMTMaterial();
+        VMTMaterial(const QString& shaderName, const QJsonObject& parameters);
+
+        // Builds a material from a document produced by KeyValuesParser.
+        // The first root key is taken as the shader name.
+        static VMTMaterial fromJsonDocument(const QJsonDocument& document, QString* errorHint = Q_NULLPTR);
+
+        // Normalises the separators and case of a material or texture path, and removes
+        // any leading "materials/" and the given extension.
+        static QString normalisePath(const QString& path, const QString& extension = QString());
+
+        bool isValid() const;
+        QString shaderName() const;
+        const QJsonObject& parameters() const;
+
+        // Patch materials take their shader and parameters from an included material
+        // and then modify them. These accessors are only meaningful before the patch
+        // has been resolved by VMTMaterialCache.
+        bool isPatch() const;
+        QString includePath() const;
+        QJsonObject patchInsertBlock() const;
+        QJsonObject patchReplaceBlock() const;
+
+        // Parameters in insert are added or overwritten. Parameters in
+        // replace only overwrite parameters that already exist.
+        VMTMaterial patched(const QJsonObject& insert, const QJsonObject& replace) const;
+
+        bool hasParameter(const QString& name) const;
+        QString stringParameter(const QString& name, const QString& defaultValue = QString()) const;
+        int intParameter(const QString& name, int defaultValue = 0) const;
+        float floatParameter(const QString& name, float defaultValue = 0.0f) const;
+        bool boolParameter(const QString& name, bool defaultValue = false) const;
+
+        // Texture paths are normalised in the same way as material paths.
+        QString baseTexture() const;
+        QString baseTexture2() const;
+        QString bumpMap() const;
+
+        bool isTranslucent() const;
+        bool isAlphaTest() const;
+        float alphaTestReference() const;
+
+        bool operator ==(const VMTMaterial& other) const;
+        bool operator !=(const VMTMaterial& other) const;
+
+    private:
+        QString texturePath(const QString& name) const;
+
+        QString m_strShaderName;
+        QJsonObject m_Parameters;
+    };
+
+    typedef QSharedPointer<const VMTMaterial> VMTMaterialPointer;
+}
+
+#endif // VMTMATERIAL_H
@@ -0,0 +1,143 @@
+#include "vmtmaterialcache.h"
+#include "file-formats/keyvalues/keyvaluesparser.h"
+#include <QJsonDocument>
+
+namespace FileFormats
+{
+    namespace
+    {
+        inline void setError(QString* errorHint, const QString& error)
+        {
+            if ( errorHint )
+            {
+                *errorHint = error;
+            }
+        }
+    }
+
+    VMTMaterialCache::VMTMaterialCache(const DataReader &reader)
+        : m_DataReader(reader)
+    {
+    }
+
+    void VMTMaterialCache::setDataReader(const DataReader &reader)
+    {
+        m_DataReader = reader;
+        clear();
+    }
+
+    VMTMaterialPointer VMTMaterialCache::material(const QString &path, QString *errorHint)
+    {
+        QStringList includeChain;
+        return resolve(VMTMaterial::normalisePath(path, "vmt"), includeChain, errorHint);
+    }
+
+    bool VMTMaterialCache::contains(const QString &path) const
+    {
+        return m_Materials.contains(VMTMaterial::normalisePath(path, "vmt"));
+    }
+
+    int VMTMaterialCache::count() const
+    {
+        return m_Materials.count();
+    }
+
+    int VMTMaterialCache::uniqueCount() const
+    {
+        return m_UniqueMaterials.count();
+    }
+
+    void VMTMaterialCache::clear()
+    {
+        m_Materials.clear();
+        m_UniqueMaterials.clear();
+        m_FailedPaths.clear();
+    }
+
+    VMTMaterialPointer VMTMaterialCache::resolve(const QString &path, QStringList &includeChain, QString *errorHint)
+    {
+        if ( m_Materials.contains(path) )
+        {
+            return m_Materials.value(path);
+        }
+
+        if ( m_FailedPaths.contains(path) )
+        {
+            setError(errorHint, QString("Material '%1' could not be resolved.").arg(path));
+            return VMTMaterialPointer();
+        }
+
+        if ( includeChain.contains(path) )
+        {
+            setError(errorHint, QString("Material '%1' includes itself via: %2").arg(path).arg(includeChain.join(" -> ")));
+            return VMTMaterialPointer();
+        }
+
+        if ( includeChain.count() >= MAX_INCLUDE_DEPTH )
+        {
+            setError(errorHint, QString("Material '%1' exceeds the maximum include depth of %2.").arg(path).arg(MAX_INCLUDE_DEPTH));
+            return VMTMaterialPointer();
+        }
+
+        QByteArray data = m_DataReader ? m_DataReader(path) : QByteArray();
+        if ( data.isEmpty() )
+        {
+            setError(errorHint, QString("Material '%1' does not exist or is empty.").arg(path));
+            m_FailedPaths.insert(path);
+            return VMTMaterialPointer();
+        }
+
+        KeyValuesParser parser(data);
+        QString error;
+        VMTMaterial parsed = VMTMaterial::fromJsonDocument(parser.toJsonDocument(&error), &error);
+        if ( !parsed.isValid() )
+        {
+            setError(errorHint, QString("Could not parse material '%1': %2").arg(path).arg(error));
+            m_FailedPaths.insert(path);
+            return VMTMaterialPointer();
+        }
+
+        if ( parsed.isPatch() )
+        {
+            const QString includePath = parsed.includePath();
+            if ( includePath.isEmpty() )
+            {
+                setError(errorHint, QString("Patch material '%1' does not include a material.").arg(path));
+                m_FailedPaths.insert(path);
+                return VMTMaterialPointer();
+            }
+
+            includeChain.append(path);
+            VMTMaterialPointer included = resolve(includePath, includeChain, errorHint);
+            includeChain.removeLast();
+
+            if ( !included )
+            {
+                m_FailedPaths.insert(path);
+                return VMTMaterialPointer();
+            }
+
+            parsed = included->patched(parsed.patchInsertBlock(), parsed.patchReplaceBlock());
+        }
+
+        VMTMaterialPointer material = intern(parsed);
+        m_Materials.insert(path, material);
+        return material;
+    }
+
+    VMTMaterialPointer VMTMaterialCache::intern(const VMTMaterial &material)
+    {
+        const QByteArray key = material.shaderName().toUtf8() + '\n' +
+                QJsonDocument(material.parameters()).toJson(QJsonDocument::Compact);
+
+        VMTMaterialPointer existing = m_UniqueMaterials.value(key);
+        if ( existing )
+        {
+            return existing;
+        }
+
+        VMTMaterialPointer created(new VMTMaterial(material));
+        m_UniqueMaterials.insert(key, created);
+        return created;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef VMTMATERIALCACHE_H
+#define VMTMATERIALCACHE_H
+
+#include "file-formats_global.h"
+#include "vmtmaterial.h"
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <functional>
+
+namespace FileFormats
+{
+    // Parses VMTs on request and resolves patch materials against the materials
+    // they include. Each path is only read and parsed once, so materials that are
+    // included by many patches are shared. Resolved materials with identical shaders
+    // and parameters are also shared, regardless of their path.
+    class FILEFORMATSSHARED_EXPORT VMTMaterialCache
+    {
+    public:
+        // Returns the contents of the VMT at the given normalised path
+        // (see VMTMaterial::normalisePath()), or an empty array if it does not exist.
+        typedef std::function<QByteArray (const QString& path)> DataReader;
+
+        // Patches that nest more deeply than this are treated as broken.
+        static const int MAX_INCLUDE_DEPTH = 16;
+
+        explicit VMTMaterialCache(const DataReader& reader = DataReader());
+
+        void setDataReader(const DataReader& reader);
+
+        // Returns the resolved material for the path, or a null pointer if it
+        // could not be read or resolved. Failures are also remembered.
+        VMTMaterialPointer material(const QString& path, QString* errorHint = Q_NULLPTR);
+
+        bool contains(const QString& path) const;
+
+        // Number of paths that resolved to a material.
+        int count() const;
+
+        // Number of distinct resolved materials held by the cache.
+        int uniqueCount() const;
+
+        void clear();
+
+    private:
+        VMTMaterialPointer resolve(const QString& path, QStringList& includeChain, QString* errorHint);
+        VMTMaterialPointer intern(const VMTMaterial& material);
+
+        DataReader m_DataReader;
+        QHash<QString, VMTMaterialPointer> m_Materials;
+        QHash<QByteArray, VMTMaterialPointer> m_UniqueMaterials;
+        QSet<QString> m_FailedPaths;
+    };
+}
+
+#endif // VMTMATERIALCACHE_H
@@ -289,6 +289,29 @@ namespace FileFormats
         return m_Archive.read(item->entryLength());
     }
 
+    QByteArray VPKFile::readFromCurrentArchive(const VPKIndexTreeItem *item, qint64 maxLength)
+    {
+        if ( !isArchiveOpen() || item->archiveIndex() != m_iCurrentArchive )
+            return QByteArray();
+
+        if ( !m_Archive.seek(item->entryOffset()) )
+            return QByteArray();
+
+        return m_Archive.read(qMin<qint64>(maxLength, item->entryLength()));
+    }
+
+    QByteArray VPKFile::readFromArchive(const QString &archiveFileName, const VPKIndexTreeItem *item)
+    {
+        QFile archive(archiveFileName);
+        if ( !archive.open(QIODevice::ReadOnly) )
+            return QByteArray();
+
+        if ( !archive.seek(item->entryOffset()) )
+            return QByteArray();
+
+        return archive.read(item->entryLength());
+    }
+
     int VPKFile::currentArchiveIndex() const
     {
         return m_iCurrentArchive;
@@ -43,6 +43,12 @@ namespace FileFormats
         bool isArchiveOpen() const;
         void closeArchive();
         QByteArray readFromCurrentArchive(const VPKIndexTreeItem* item);
+
+        // Reads at most maxLength bytes from the start of the item's data.
+        QByteArray readFromCurrentArchive(const VPKIndexTreeItem* item, qint64 maxLength);
+
+        // Opens the archive file itself, so may be called from any thread.
+        static QByteArray readFromArchive(const QString& archiveFileName, const VPKIndexTreeItem* item);
         int currentArchiveIndex() const;
 
         // Read from file on demand.
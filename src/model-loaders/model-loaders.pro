@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += gui
+QT       += gui concurrent
 
 TARGET = model-loaders
 TEMPLATE = lib
@@ -15,11 +15,15 @@ SOURCES += \
     model-loaders/json/jsonloaderutils.cpp \
     model-loaders/projects/calliperprojectloader.cpp \
     model-loaders/vtf/vtfloader.cpp \
+    model-loaders/vtf/vtftexturecache.cpp \
     model-loaders/filedataloaders/base/basefileloader.cpp \
     model-loaders/filedataloaders/vmf/vmfdataloader.cpp \
+    model-loaders/filedataloaders/vmf/vmfplaneparser.cpp \
+    model-loaders/filedataloaders/vmf/vmfmapcache.cpp \
     model-loaders/filedataloaders/fileextensiondatamodelmap.cpp \
     model-loaders/filedataloaders/filedataloaderfactory.cpp \
-    model-loaders/filedataloaders/filedatamodelstore.cpp
+    model-loaders/filedataloaders/filedatamodelstore.cpp \
+    model-loaders/filedataloaders/fileloadoperation.cpp
     model-loaders_global.cpp
 
 HEADERS +=\
@@ -27,11 +31,15 @@ HEADERS +=\
     model-loaders/json/jsonloaderutils.h \
     model-loaders/projects/calliperprojectloader.h \
     model-loaders/vtf/vtfloader.h \
+    model-loaders/vtf/vtftexturecache.h \
     model-loaders/filedataloaders/base/basefileloader.h \
     model-loaders/filedataloaders/vmf/vmfdataloader.h \
+    model-loaders/filedataloaders/vmf/vmfplaneparser.h \
+    model-loaders/filedataloaders/vmf/vmfmapcache.h \
     model-loaders/filedataloaders/fileextensiondatamodelmap.h \
     model-loaders/filedataloaders/filedataloaderfactory.h \
-    model-loaders/filedataloaders/filedatamodelstore.h
+    model-loaders/filedataloaders/filedatamodelstore.h \
+    model-loaders/filedataloaders/fileloadoperation.h
 
 unix {
     target.path = /usr/lib
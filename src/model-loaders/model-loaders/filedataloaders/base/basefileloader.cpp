@@ -4,7 +4,10 @@
 namespace ModelLoaders
 {
     BaseFileLoader::BaseFileLoader()
-        : m_pDataModel(Q_NULLPTR)
+        : m_pDataModel(Q_NULLPTR),
+          m_iPendingLoadResult(Failure),
+          m_bPendingLoadDone(false),
+          m_iLoadCancelled(0)
     {
     }
 
@@ -21,4 +24,70 @@ namespace ModelLoaders
     {
         return m_pDataModel != Q_NULLPTR;
     }
+
+    BaseFileLoader::SuccessCode BaseFileLoader::beginLoad(const QString &filePath, QString *errorString)
+    {
+        Q_UNUSED(errorString);
+
+        resetLoadCancelled();
+        m_strPendingLoadPath = filePath;
+        m_strPendingLoadError.clear();
+        m_iPendingLoadResult = Failure;
+        m_bPendingLoadDone = false;
+
+        return Success;
+    }
+
+    bool BaseFileLoader::continueLoad(int timeBudgetMsec)
+    {
+        Q_UNUSED(timeBudgetMsec);
+
+        if ( !m_bPendingLoadDone && !isLoadCancelled() )
+        {
+            m_iPendingLoadResult = load(m_strPendingLoadPath, &m_strPendingLoadError);
+            m_bPendingLoadDone = true;
+        }
+
+        return false;
+    }
+
+    BaseFileLoader::SuccessCode BaseFileLoader::finishLoad(QString *errorString)
+    {
+        if ( !m_bPendingLoadDone )
+        {
+            if ( errorString )
+            {
+                *errorString = "Loading was cancelled.";
+            }
+
+            return Failure;
+        }
+
+        if ( errorString )
+        {
+            *errorString = m_strPendingLoadError;
+        }
+
+        return m_iPendingLoadResult;
+    }
+
+    float BaseFileLoader::loadProgress() const
+    {
+        return m_bPendingLoadDone ? 1.0f : 0.0f;
+    }
+
+    void BaseFileLoader::cancelLoad()
+    {
+        m_iLoadCancelled.store(1);
+    }
+
+    bool BaseFileLoader::isLoadCancelled() const
+    {
+        return m_iLoadCancelled.load() != 0;
+    }
+
+    void BaseFileLoader::resetLoadCancelled()
+    {
+        m_iLoadCancelled.store(0);
+    }
 }
@@ -3,6 +3,8 @@
 
 #include "model-loaders_global.h"
 #include <QObject>
+#include <QString>
+#include <QAtomicInt>
 
 namespace Model
 {
@@ -39,10 +41,38 @@ namespace ModelLoaders
         virtual SuccessCode load(const QString& filePath, QString* errorString = Q_NULLPTR) = 0;
         virtual SuccessCode save(const QString& filePath, QString* errorString = Q_NULLPTR) = 0;
 
+        // Incremental loading, so that the data model can be used while it is populated.
+        // beginLoad() must not touch the data model, and may be called on any thread.
+        // continueLoad() is then called on the data model's thread until it returns false,
+        // doing roughly timeBudgetMsec of work each time (or as much as it can if negative).
+        // finishLoad() returns the overall result.
+        // The default implementation performs the whole of load() in continueLoad().
+        virtual SuccessCode beginLoad(const QString& filePath, QString* errorString = Q_NULLPTR);
+        virtual bool continueLoad(int timeBudgetMsec);
+        virtual SuccessCode finishLoad(QString* errorString = Q_NULLPTR);
+
+        // From 0 to 1.
+        virtual float loadProgress() const;
+
+        // May be called from any thread. Loading stops as soon as possible,
+        // and finishLoad() returns Failure.
+        void cancelLoad();
+        bool isLoadCancelled() const;
+
     protected:
         BaseFileLoader();
 
+        // Called by beginLoad() implementations.
+        void resetLoadCancelled();
+
         Model::BaseFileDataModel* m_pDataModel;
+
+    private:
+        QString m_strPendingLoadPath;
+        QString m_strPendingLoadError;
+        SuccessCode m_iPendingLoadResult;
+        bool m_bPendingLoadDone;
+        QAtomicInt m_iLoadCancelled;
     };
 }
 
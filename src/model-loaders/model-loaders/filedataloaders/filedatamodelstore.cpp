@@ -5,6 +5,7 @@
 #include "model-loaders/filedataloaders/filedataloaderfactory.h"
 #include <QPair>
 #include "calliperutil/qobject/qobjectutil.h"
+#include "model-loaders/filedataloaders/fileloadoperation.h"
 
 namespace
 {
@@ -65,6 +66,12 @@ namespace ModelLoaders
 
     }
 
+    FileDataModelStore::~FileDataModelStore()
+    {
+        // Deleting an operation cancels it.
+        qDeleteAll(m_PendingLoads.values());
+    }
+
     QSharedPointer<Model::BaseFileDataModel> FileDataModelStore::dataModel(const QString &path) const
     {
         return m_FileModels.value(path, DataModelPointer());
@@ -77,9 +84,27 @@ namespace ModelLoaders
 
     void FileDataModelStore::unloadFile(const QString &path)
     {
+        FileLoadOperation* operation = m_PendingLoads.take(path);
+        if ( operation )
+        {
+            operation->disconnect();
+            operation->cancel();
+            operation->deleteLater();
+        }
+
         m_FileModels.remove(path);
     }
 
+    FileLoadOperation* FileDataModelStore::pendingLoad(const QString &path) const
+    {
+        return m_PendingLoads.value(path, Q_NULLPTR);
+    }
+
+    bool FileDataModelStore::isFileLoading(const QString &path) const
+    {
+        return m_PendingLoads.contains(path);
+    }
+
     QStringList FileDataModelStore::loadedFiles() const
     {
         return m_FileModels.keys();
@@ -97,27 +122,102 @@ namespace ModelLoaders
 
     ModelLoaders::BaseFileLoader::SuccessCode FileDataModelStore::loadFile(const QString &path, QString *errorString)
     {
+        if ( m_PendingLoads.contains(path) )
+        {
+            setErrorString(errorString, "File is already being loaded.");
+            return BaseFileLoader::Failure;
+        }
+
         if ( m_FileModels.contains(path) )
         {
             return BaseFileLoader::Success;
         }
 
+        DataModelPointer dataModel;
+        QScopedPointer<ModelLoaders::BaseFileLoader> loader(createModelAndLoader(path, dataModel, errorString));
+        if ( loader.isNull() )
+        {
+            return BaseFileLoader::Failure;
+        }
+
+        BaseFileLoader::SuccessCode success = loader->load(path, errorString);
+        if ( success == BaseFileLoader::Failure )
+        {
+            return BaseFileLoader::Failure;
+        }
+
+        m_FileModels.insert(path, dataModel);
+        return success;
+    }
+
+    FileLoadOperation* FileDataModelStore::loadFileAsync(const QString &path, QString *errorString)
+    {
+        if ( m_PendingLoads.contains(path) )
+        {
+            return m_PendingLoads.value(path);
+        }
+
+        if ( m_FileModels.contains(path) )
+        {
+            setErrorString(errorString, "File is already loaded.");
+            return Q_NULLPTR;
+        }
+
+        DataModelPointer dataModel;
+        BaseFileLoader* loader = createModelAndLoader(path, dataModel, errorString);
+        if ( !loader )
+        {
+            return Q_NULLPTR;
+        }
+
+        FileLoadOperation* operation = new FileLoadOperation(path, loader);
+        m_PendingLoads.insert(path, operation);
+
+        // The model is held by these connections until the load is complete.
+        QObject::connect(operation, &FileLoadOperation::dataModelReady, [this, path, dataModel]()
+        {
+            m_FileModels.insert(path, dataModel);
+        });
+
+        QObject::connect(operation, &FileLoadOperation::finished, [this, operation](BaseFileLoader::SuccessCode result)
+        {
+            if ( result == BaseFileLoader::Failure )
+            {
+                m_FileModels.remove(operation->filePath());
+            }
+
+            removePendingLoad(operation);
+        });
+
+        return operation;
+    }
+
+    FileDataModelStore::FileDataModelInfo FileDataModelStore::getDataModelInfo(const QString &path) const
+    {
+        ModelLoaders::FileExtensionDataModelMap extMap;
+        QString extension = QFileInfo(path).suffix();
+        BaseFileLoader::LoaderType loaderType = extMap.loaderTypeForExtension(extension);
+        return FileDataModelInfo(extMap.modelType(loaderType), loaderType);
+    }
+
+    BaseFileLoader* FileDataModelStore::createModelAndLoader(const QString &path, DataModelPointer &dataModel, QString *errorString) const
+    {
         QString extension = QFileInfo(path).suffix();
 
         FileDataModelInfo info = getDataModelInfo(path);
         if ( info.loaderType() == BaseFileLoader::UnknownLoader )
         {
             setErrorString(errorString, QString("Unknown file format '%1'.").arg(extension));
-            return BaseFileLoader::Failure;
+            return Q_NULLPTR;
         }
 
         if ( info.modelType() == Model::BaseFileDataModel::UnknownModel )
         {
             setErrorString(errorString, QString("File format '%1' not registered to any known file type.").arg(extension));
-            return BaseFileLoader::Failure;
+            return Q_NULLPTR;
         }
 
-        DataModelPointer dataModel(Model::FileDataModelFactory::createModel(info.modelType()));
+        dataModel = DataModelPointer(Model::FileDataModelFactory::createModel(info.modelType()));
         if ( dataModel.isNull() )
         {
             setErrorString(errorString,
@@ -125,11 +225,11 @@ namespace ModelLoaders
                                 .arg(dataModelEnumString(info.modelType()))
                                 .arg(extension));
 
-            return BaseFileLoader::Failure;
+            return Q_NULLPTR;
         }
 
-        QScopedPointer<ModelLoaders::BaseFileLoader> loader(ModelLoaders::FileDataLoaderFactory::createLoader(info.loaderType(), dataModel.data()));
-        if ( loader.isNull() )
+        BaseFileLoader* loader = ModelLoaders::FileDataLoaderFactory::createLoader(info.loaderType(), dataModel.data());
+        if ( !loader )
         {
             setErrorString(errorString,
                            QString("Unable to create loader of type '%1' for file of type '%2' (from extension '%3').")
@@ -137,24 +237,21 @@ namespace ModelLoaders
                                 .arg(dataModelEnumString(info.modelType()))
                                 .arg(extension));
 
-            return BaseFileLoader::Failure;
-        }
-
-        BaseFileLoader::SuccessCode success = loader->load(path, errorString);
-        if ( success == BaseFileLoader::Failure )
-        {
-            return BaseFileLoader::Failure;
+            dataModel.clear();
+            return Q_NULLPTR;
         }
 
-        m_FileModels.insert(path, dataModel);
-        return success;
+        return loader;
     }
 
-    FileDataModelStore::FileDataModelInfo FileDataModelStore::getDataModelInfo(const QString &path) const
+    void FileDataModelStore::removePendingLoad(FileLoadOperation *operation)
     {
-        ModelLoaders::FileExtensionDataModelMap extMap;
-        QString extension = QFileInfo(path).suffix();
-        BaseFileLoader::LoaderType loaderType = extMap.loaderTypeForExtension(extension);
-        return FileDataModelInfo(extMap.modelType(loaderType), loaderType);
+        const QString path = operation->filePath();
+        if ( m_PendingLoads.value(path, Q_NULLPTR) == operation )
+        {
+            m_PendingLoads.remove(path);
+        }
+
+        operation->deleteLater();
     }
 }
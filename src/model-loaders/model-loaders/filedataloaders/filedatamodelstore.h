@@ -10,14 +10,27 @@
 
 namespace ModelLoaders
 {
+    class FileLoadOperation;
+
     class MODELLOADERSSHARED_EXPORT FileDataModelStore
     {
     public:
         typedef QHash<QString, QSharedPointer<Model::BaseFileDataModel> >::const_iterator ConstIterator;
 
         FileDataModelStore();
+        ~FileDataModelStore();
 
         ModelLoaders::BaseFileLoader::SuccessCode loadFile(const QString& path, QString* errorString = Q_NULLPTR);
+
+        // Starts loading the file in the background. The model is added to the store when
+        // the operation emits dataModelReady(), and is removed again if loading fails.
+        // The operation deletes itself once finished; call start() on it after connecting
+        // to its signals. Returns null if the file is already loaded or could not be loaded,
+        // and returns the existing operation if the file is already being loaded.
+        FileLoadOperation* loadFileAsync(const QString& path, QString* errorString = Q_NULLPTR);
+        FileLoadOperation* pendingLoad(const QString& path) const;
+        bool isFileLoading(const QString& path) const;
+
         QSharedPointer<Model::BaseFileDataModel> dataModel(const QString& path) const;
         bool isFileLoaded(const QString& path) const;
 
@@ -35,8 +48,11 @@ namespace ModelLoaders
         typedef QSharedPointer<Model::BaseFileDataModel> DataModelPointer;
 
         FileDataModelInfo getDataModelInfo(const QString& path) const;
+        BaseFileLoader* createModelAndLoader(const QString& path, DataModelPointer& dataModel, QString* errorString) const;
+        void removePendingLoad(FileLoadOperation* operation);
 
         QHash<QString, DataModelPointer> m_FileModels;
+        QHash<QString, FileLoadOperation*> m_PendingLoads;
     };
 }
 
@@ -0,0 +1,216 @@
+#include "fileloadoperation.h"
+#include <QtConcurrent>
+
+namespace
+{
+    // Leaves time between steps for the event loop to render and handle input.
+    const int CONTINUE_INTERVAL_MSEC = 10;
+    const int DEFAULT_TIME_BUDGET_MSEC = 8;
+}
+
+namespace ModelLoaders
+{
+    FileLoadOperation::FileLoadOperation(const QString &filePath, BaseFileLoader *loader, QObject *parent)
+        : QObject(parent),
+          m_strFilePath(filePath),
+          m_pLoader(loader),
+          m_iState(NotStarted),
+          m_bCancelled(false),
+          m_iTimeBudget(DEFAULT_TIME_BUDGET_MSEC),
+          m_iResult(BaseFileLoader::Failure)
+    {
+        Q_ASSERT(m_pLoader);
+
+        m_ContinueTimer.setInterval(CONTINUE_INTERVAL_MSEC);
+        connect(&m_ContinueTimer, SIGNAL(timeout()), this, SLOT(continueLoad()));
+        connect(&m_BeginWatcher, SIGNAL(finished()), this, SLOT(beginLoadFinished()));
+    }
+
+    FileLoadOperation::~FileLoadOperation()
+    {
+        if ( isRunning() )
+        {
+            m_pLoader->cancelLoad();
+        }
+
+        if ( m_iState == Beginning )
+        {
+            m_BeginWatcher.waitForFinished();
+        }
+    }
+
+    QString FileLoadOperation::filePath() const
+    {
+        return m_strFilePath;
+    }
+
+    BaseFileLoader* FileLoadOperation::loader() const
+    {
+        return m_pLoader.data();
+    }
+
+    bool FileLoadOperation::isRunning() const
+    {
+        return m_iState == Beginning || m_iState == Continuing;
+    }
+
+    bool FileLoadOperation::isFinished() const
+    {
+        return m_iState == Finished;
+    }
+
+    BaseFileLoader::SuccessCode FileLoadOperation::result() const
+    {
+        return m_iResult;
+    }
+
+    QString FileLoadOperation::errorString() const
+    {
+        return m_strErrorString;
+    }
+
+    float FileLoadOperation::progress() const
+    {
+        switch ( m_iState )
+        {
+            case Continuing:
+                return m_pLoader->loadProgress();
+
+            case Finished:
+                return 1.0f;
+
+            default:
+                // The loader is still being set up on another thread.
+                return 0.0f;
+        }
+    }
+
+    int FileLoadOperation::timeBudget() const
+    {
+        return m_iTimeBudget;
+    }
+
+    void FileLoadOperation::setTimeBudget(int msec)
+    {
+        m_iTimeBudget = qMax(1, msec);
+    }
+
+    void FileLoadOperation::start()
+    {
+        if ( m_iState != NotStarted )
+        {
+            return;
+        }
+
+        if ( m_bCancelled )
+        {
+            m_strErrorString = "Loading was cancelled.";
+            finish(BaseFileLoader::Failure);
+            return;
+        }
+
+        m_iState = Beginning;
+
+        BaseFileLoader* loader = m_pLoader.data();
+        QString* beginError = &m_strBeginError;
+        const QString filePath = m_strFilePath;
+
+        m_BeginWatcher.setFuture(QtConcurrent::run([loader, filePath, beginError]()
+        {
+            return loader->beginLoad(filePath, beginError);
+        }));
+    }
+
+    void FileLoadOperation::cancel()
+    {
+        m_bCancelled = true;
+
+        switch ( m_iState )
+        {
+            case Beginning:
+            {
+                // beginLoad() clears the flag when it starts, so it's set again once it returns.
+                m_pLoader->cancelLoad();
+                break;
+            }
+
+            case Continuing:
+            {
+                m_pLoader->cancelLoad();
+                m_ContinueTimer.stop();
+
+                BaseFileLoader::SuccessCode result = m_pLoader->finishLoad(&m_strErrorString);
+                finish(result);
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    void FileLoadOperation::beginLoadFinished()
+    {
+        if ( m_iState != Beginning )
+        {
+            return;
+        }
+
+        if ( m_BeginWatcher.result() == BaseFileLoader::Failure )
+        {
+            m_strErrorString = m_strBeginError;
+            finish(BaseFileLoader::Failure);
+            return;
+        }
+
+        if ( m_bCancelled )
+        {
+            m_pLoader->cancelLoad();
+            finish(m_pLoader->finishLoad(&m_strErrorString));
+            return;
+        }
+
+        m_iState = Continuing;
+        emit dataModelReady();
+
+        // Slots connected to dataModelReady() may have cancelled the load.
+        if ( m_iState == Continuing )
+        {
+            continueLoad();
+            if ( m_iState == Continuing )
+            {
+                m_ContinueTimer.start();
+            }
+        }
+    }
+
+    void FileLoadOperation::continueLoad()
+    {
+        if ( m_iState != Continuing )
+        {
+            return;
+        }
+
+        const bool moreToDo = m_pLoader->continueLoad(m_iTimeBudget);
+        emit progressChanged(m_pLoader->loadProgress());
+
+        if ( moreToDo || m_iState != Continuing )
+        {
+            return;
+        }
+
+        m_ContinueTimer.stop();
+        BaseFileLoader::SuccessCode result = m_pLoader->finishLoad(&m_strErrorString);
+        finish(result);
+    }
+
+    void FileLoadOperation::finish(BaseFileLoader::SuccessCode result)
+    {
+        m_iState = Finished;
+        m_iResult = result;
+        emit progressChanged(1.0f);
+        emit finished(m_iResult);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef FILELOADOPERATION_H
+#define FILELOADOPERATION_H
+
+#include "model-loaders_global.h"
+#include "model-loaders/filedataloaders/base/basefileloader.h"
+#include <QObject>
+#include <QString>
+#include <QScopedPointer>
+#include <QFutureWatcher>
+#include <QTimer>
+
+namespace ModelLoaders
+{
+    // Runs a loader incrementally without blocking the thread it lives on.
+    // The file is read and parsed on a worker thread, after which the loader's
+    // continueLoad() is called from a timer on this object's thread, so that the
+    // data model can be viewed while it is populated.
+    class MODELLOADERSSHARED_EXPORT FileLoadOperation : public QObject
+    {
+        Q_OBJECT
+    public:
+        // Takes ownership of the loader.
+        FileLoadOperation(const QString& filePath, BaseFileLoader* loader, QObject* parent = Q_NULLPTR);
+        ~FileLoadOperation();
+
+        QString filePath() const;
+        BaseFileLoader* loader() const;
+
+        bool isRunning() const;
+        bool isFinished() const;
+
+        // Only valid once finished() has been emitted.
+        BaseFileLoader::SuccessCode result() const;
+        QString errorString() const;
+
+        float progress() const;
+
+        // Approximate time spent in each call to continueLoad().
+        int timeBudget() const;
+        void setTimeBudget(int msec);
+
+    public slots:
+        void start();
+        void cancel();
+
+    signals:
+        // The file has been parsed and the data model is about to be populated.
+        void dataModelReady();
+        void progressChanged(float progress);
+        void finished(ModelLoaders::BaseFileLoader::SuccessCode result);
+
+    private slots:
+        void beginLoadFinished();
+        void continueLoad();
+
+    private:
+        enum State
+        {
+            NotStarted = 0,
+            Beginning,
+            Continuing,
+            Finished
+        };
+
+        void finish(BaseFileLoader::SuccessCode result);
+
+        QString m_strFilePath;
+        QScopedPointer<BaseFileLoader> m_pLoader;
+        State m_iState;
+        bool m_bCancelled;
+        int m_iTimeBudget;
+        BaseFileLoader::SuccessCode m_iResult;
+        QString m_strErrorString;
+        QString m_strBeginError;
+        QFutureWatcher<BaseFileLoader::SuccessCode> m_BeginWatcher;
+        QTimer m_ContinueTimer;
+    };
+}
+
+#endif // FILELOADOPERATION_H
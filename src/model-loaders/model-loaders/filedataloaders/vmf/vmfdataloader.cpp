@@ -1,111 +1,428 @@
 #include "vmfdataloader.h"
 #include "model/filedatamodels/map/mapfiledatamodel.h"
-#include "calliperutil/exceptions/calliperexception.h"
 #include "model/math/texturedwinding.h"
 #include "calliperutil/json/jsonarraywrapper.h"
 #include "model/genericbrush/genericbrush.h"
 #include "model/factories/genericbrushfactory.h"
+#include "model/sceneobjects/mapentity.h"
+#include "model/sceneobjects/mapgroup.h"
+#include "model/sceneobjects/displacement.h"
 #include <QJsonObject>
 #include "calliperutil/general/generalutil.h"
 #include "model/global/resourceenvironment.h"
 #include <QTextStream>
 #include "file-formats/keyvalues/keyvaluesparser.h"
 #include <QFile>
+#include "vmfplaneparser.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QColor>
+#include <algorithm>
 
 namespace
 {
-    class InvalidCoordSyntaxException : public CalliperUtil::CalliperException
+    inline void setErrorString(QString* string, const QString& error)
+    {
+        if ( string )
+        {
+            *string = error;
+        }
+    }
+
+    // Reads "x y z", optionally surrounded by square brackets as in "[x y z]".
+    bool parseVector(const QString& string, QVector3D& vec)
     {
-    public:
-        void raise() const override
+        QString trimmed = string.trimmed();
+        if ( trimmed.startsWith('[') && trimmed.endsWith(']') )
         {
-            throw *this;
+            trimmed = trimmed.mid(1, trimmed.length() - 2);
+        }
+
+        QVector<QStringRef> components = trimmed.splitRef(' ', QString::SkipEmptyParts);
+        if ( components.count() != 3 )
+            return false;
+
+        bool okX = false, okY = false, okZ = false;
+        vec = QVector3D(components.at(0).toFloat(&okX), components.at(1).toFloat(&okY), components.at(2).toFloat(&okZ));
+        return okX && okY && okZ;
+    }
+
+    bool parseColor(const QString& string, QColor& color)
+    {
+        QVector<QStringRef> components = string.splitRef(' ', QString::SkipEmptyParts);
+        if ( components.count() != 3 )
+            return false;
+
+        bool okR = false, okG = false, okB = false;
+        color = QColor(components.at(0).toInt(&okR), components.at(1).toInt(&okG), components.at(2).toInt(&okB));
+        return okR && okG && okB && color.isValid();
+    }
+
+    // Reads rows "row0" to "rowN" from a displacement block, each containing
+    // valuesPerRow numbers, into a flat array.
+    bool readDisplacementRows(const QJsonObject& block, int rows, int valuesPerRow, QVector<float>& values)
+    {
+        values.resize(rows * valuesPerRow);
+        float* out = values.data();
+
+        for ( int row = 0; row < rows; ++row )
+        {
+            const QString rowString = block.value(QString("row%1").arg(row)).toString();
+            QVector<QStringRef> rowValues = rowString.splitRef(' ', QString::SkipEmptyParts);
+            if ( rowValues.count() != valuesPerRow )
+                return false;
+
+            for ( int i = 0; i < valuesPerRow; ++i )
+            {
+                bool ok = false;
+                *out++ = rowValues.at(i).toFloat(&ok);
+                if ( !ok )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Keys in an entity block that are not keyvalues.
+    bool isEntitySubBlock(const QString& key)
+    {
+        return key == "solid" || key == "editor" || key == "connections" || key == "hidden";
+    }
+
+    // Returns every block with the given key, whether there are several or just one.
+    QList<QJsonObject> childBlocks(const QJsonObject& parent, const QString& key)
+    {
+        QList<QJsonObject> blocks;
+        if ( !parent.contains(key) )
+            return blocks;
 
+        CalliperUtil::Json::JsonArrayWrapper values = parent.value(key);
+        for ( int i = 0; i < values.count(); ++i )
+        {
+            blocks.append(values.at(i).toObject());
         }
-        InvalidCoordSyntaxException* clone() const override
+
+        return blocks;
+    }
+
+    // Objects hidden in Hammer are written inside "hidden" blocks, eg. "hidden { solid { ... } }",
+    // rather than alongside the visible objects. Returns the objects of the given kind in them.
+    QList<QJsonObject> hiddenBlocks(const QJsonObject& parent, const QString& key)
+    {
+        QList<QJsonObject> blocks;
+        foreach ( const QJsonObject& hiddenBlock, childBlocks(parent, "hidden") )
         {
-            return new InvalidCoordSyntaxException(*this);
+            blocks.append(childBlocks(hiddenBlock, key));
         }
 
-        InvalidCoordSyntaxException(const QString &coord, const QString &err)
-            : CalliperUtil::CalliperException(QString("'%1' %2").arg(coord).arg(err))
+        return blocks;
+    }
+}
+
+namespace ModelLoaders
+{
+    Q_LOGGING_CATEGORY(lcVmfDataLoader, "ModelLoaders.VmfDataLoader")
+
+    struct VmfDataLoader::EditorInfo
+    {
+        QColor color;
+        int groupId;
+        QList<int> visGroupIds;
+
+        EditorInfo() : groupId(0) {}
+
+        explicit EditorInfo(const QJsonObject& editor)
+            : groupId(editor.value("groupid").toString().toInt())
         {
+            parseColor(editor.value("color").toString(), color);
+
+            if ( editor.contains("visgroupid") )
+            {
+                CalliperUtil::Json::JsonArrayWrapper ids = editor.value("visgroupid");
+                for ( int i = 0; i < ids.count(); ++i )
+                {
+                    const int id = ids.at(i).toString().toInt();
+                    if ( id > 0 )
+                    {
+                        visGroupIds.append(id);
+                    }
+                }
+            }
         }
     };
 
-    QVector3D vectorFromVmfCoord_x(const QString &coord)
+    struct VmfDataLoader::PreparedDisplacement
     {
-        QString s = coord.trimmed();
-        if ( s.startsWith("(") )
+        // Input
+        int sideIndex;
+        QJsonObject dispInfo;
+
+        // Output
+        int power;
+        QVector<QVector3D> basePositions;
+        QVector<QVector3D> positions;
+        QVector<float> alphas;
+        QVector3D faceNormal;
+        QString error;
+
+        PreparedDisplacement() : sideIndex(-1), power(0) {}
+
+        // Takes the corners of the face once the solid has been clipped.
+        // Touches no shared state, so may be called from worker threads.
+        bool build(const QVector<QVector3D>& faceVertices, const QVector3D& normal)
         {
-            if ( s.length() < 2 )
-                throw InvalidCoordSyntaxException(coord, "Co-ordinate not long enough.");
+            bool ok = false;
+            power = dispInfo.value("power").toString().toInt(&ok);
+            if ( !ok || power < 1 || power > Model::Displacement::maxPower() )
+            {
+                error = QString("Unsupported displacement power '%1'.").arg(dispInfo.value("power").toString());
+                return false;
+            }
 
-            s = s.right(s.length()-1);
+            if ( faceVertices.count() != 4 )
+            {
+                error = QString("Displacement face has %1 vertices, expected 4.").arg(faceVertices.count());
+                return false;
+            }
+
+            QVector3D startPosition;
+            if ( !parseVector(dispInfo.value("startposition").toString(), startPosition) )
+            {
+                error = "Displacement has an invalid start position.";
+                return false;
+            }
+
+            const float elevation = dispInfo.value("elevation").toString().toFloat();
+            faceNormal = normal.normalized();
+
+            // The engine expects corners clockwise when looking at the front of the face,
+            // beginning at the corner nearest the start position.
+            QVector<QVector3D> corners = faceVertices;
+            if ( QVector3D::dotProduct(QVector3D::crossProduct(corners.at(1) - corners.at(0), corners.at(2) - corners.at(0)), faceNormal) > 0 )
+            {
+                std::reverse(corners.begin(), corners.end());
+            }
+
+            int startCorner = 0;
+            for ( int i = 1; i < corners.count(); ++i )
+            {
+                if ( (corners.at(i) - startPosition).lengthSquared() < (corners.at(startCorner) - startPosition).lengthSquared() )
+                {
+                    startCorner = i;
+                }
+            }
+
+            QVector3D c[4];
+            for ( int i = 0; i < 4; ++i )
+            {
+                c[i] = corners.at((startCorner + i) % 4);
+            }
+
+            const int side = Model::Displacement::verticesPerSide(power);
+            const int count = side * side;
+
+            QVector<float> normals;
+            QVector<float> distances;
+            if ( !readDisplacementRows(dispInfo.value("normals").toObject(), side, side * 3, normals) ||
+                 !readDisplacementRows(dispInfo.value("distances").toObject(), side, side, distances) )
+            {
+                error = "Displacement normals or distances are missing or malformed.";
+                return false;
+            }
+
+            // Offsets and alphas may legitimately be absent.
+            QVector<float> offsets;
+            if ( !readDisplacementRows(dispInfo.value("offsets").toObject(), side, side * 3, offsets) )
+            {
+                offsets.fill(0.0f, count * 3);
+            }
+
+            if ( !readDisplacementRows(dispInfo.value("alphas").toObject(), side, side, alphas) )
+            {
+                alphas.clear();
+            }
+
+            basePositions.resize(count);
+            positions.resize(count);
+
+            for ( int row = 0; row < side; ++row )
+            {
+                const float t = static_cast<float>(row) / static_cast<float>(side - 1);
+                const QVector3D edgeStart = c[0] + ((c[1] - c[0]) * t);
+                const QVector3D edgeEnd = c[3] + ((c[2] - c[3]) * t);
+
+                for ( int column = 0; column < side; ++column )
+                {
+                    const float s = static_cast<float>(column) / static_cast<float>(side - 1);
+                    const int index = (row * side) + column;
+
+                    const QVector3D base = edgeStart + ((edgeEnd - edgeStart) * s);
+                    const QVector3D normal(normals.at(index * 3), normals.at((index * 3) + 1), normals.at((index * 3) + 2));
+                    const QVector3D offset(offsets.at(index * 3), offsets.at((index * 3) + 1), offsets.at((index * 3) + 2));
+
+                    basePositions[index] = base;
+                    positions[index] = base + (normal * distances.at(index)) + offset + (faceNormal * elevation);
+                }
+            }
+
+            return true;
         }
+    };
+
+    struct VmfDataLoader::PreparedSolid
+    {
+        // Input
+        QJsonObject solid;
+        int entityIndex;
 
-        if ( s.endsWith(")") )
+        // Output
+        int solidId;
+        bool valid;
+        QString error;
+        EditorInfo editor;
+        QList<Model::TexturedWinding*> windings;
+        QStringList materialPaths;
+        Model::PreparedBrushGeometry geometry;
+        int geometrySource;
+        QVector<PreparedDisplacement> displacements;
+        bool hidden;
+
+        PreparedSolid() : entityIndex(-1), solidId(0), valid(false), geometrySource(-1), hidden(false) {}
+    };
+
+    struct VmfDataLoader::PreparedEntity
+    {
+        int entityId;
+        QJsonObject entity;
+        EditorInfo editor;
+        bool hasSolids;
+        bool hidden;
+
+        PreparedEntity() : entityId(0), hasSolids(false), hidden(false) {}
+    };
+
+    // State for a load in progress. Worker tasks only ever touch the solids
+    // in their own batch, which the loader's thread doesn't read until the
+    // batch's future has finished.
+    struct VmfDataLoader::LoadState
+    {
+        struct SolidBatch
         {
-            if ( s.length() < 2 )
-                throw InvalidCoordSyntaxException(coord, "Co-ordinate not long enough.");
+            int begin;
+            int end;
+            QFuture<void> future;
+        };
 
-            s = s.left(s.length()-1);
+        QJsonObject root;
+        QJsonObject world;
+        QVector<PreparedSolid> solids;
+        QVector<PreparedEntity> entities;
+        QVector<SolidBatch> batches;
+        QHash<int, Model::MapGroup*> groups;
+        QVector<Model::MapEntity*> entityObjects;
+
+        // Shared by the workers, so that copies of a brush are only clipped once.
+        Model::BrushGeometryCache brushGeometryCache;
+
+        // Either the scene is restored from the cache, or it's built from the
+        // file and recorded so that it can be cached once loading succeeds.
+        QString filePath;
+        QByteArray sourceHash;
+        quint64 sourceSize;
+        quint32 buildOptions;
+        QScopedPointer<VmfMapCacheReader> cacheReader;
+        QScopedPointer<VmfMapCacheWriter> cacheWriter;
+
+        bool sceneStarted;
+        int nextBatch;
+        int nextSolid;
+        int nextEntity;
+        int nextCachedObject;
+
+        LoadState()
+            : sourceSize(0),
+              buildOptions(0),
+              sceneStarted(false),
+              nextBatch(0),
+              nextSolid(0),
+              nextEntity(0),
+              nextCachedObject(0)
+        {
         }
 
-        QStringList list = s.split(" ");
-        if ( list.count() < 3 )
-            throw InvalidCoordSyntaxException(coord, "Co-ordinate has too few components.");
+        bool isComplete() const
+        {
+            if ( cacheReader )
+            {
+                return sceneStarted && nextCachedObject >= cacheReader->objectCount();
+            }
 
-        bool success;
-        float x, y, z;
+            return sceneStarted && nextBatch >= batches.count() && nextEntity >= entities.count();
+        }
+    };
 
-        success = false;
-        x = list.at(0).toFloat(&success);
-        if ( !success )
-            throw InvalidCoordSyntaxException(coord, QString("First co-ordinate component %1 could not be converted to a number.").arg(list.at(0)));
+    VmfDataLoader::VmfDataLoader()
+        : BaseFileLoader(),
+          m_iSuccess(Success),
+          m_iBrushBatchSize(256),
+          m_iBrushClipPrecision(Model::ArrayWinding3D::DoublePrecision),
+          m_MapCache(VmfMapCache::defaultDirectory())
+    {
+        m_BrushPool.setMaxThreadCount(QThread::idealThreadCount());
+    }
 
-        success = false;
-        y = list.at(1).toFloat(&success);
-        if ( !success )
-            throw InvalidCoordSyntaxException(coord, QString("Second co-ordinate component %1 could not be converted to a number.").arg(list.at(1)));
+    VmfDataLoader::~VmfDataLoader()
+    {
+        cancelLoad();
+        abandonLoad();
+    }
 
-        success = false;
-        z = list.at(2).toFloat(&success);
-        if ( !success )
-            throw InvalidCoordSyntaxException(coord, QString("Third co-ordinate component %1 could not be converted to a number.").arg(list.at(2)));
+    int VmfDataLoader::brushThreadCount() const
+    {
+        return m_BrushPool.maxThreadCount();
+    }
 
-        return QVector3D(x,y,z);
+    void VmfDataLoader::setBrushThreadCount(int count)
+    {
+        m_BrushPool.setMaxThreadCount(qMax(1, count));
     }
 
-    void vectorsFromVmfCoords_x(const QString &coords, QVector3D &v0, QVector3D &v1, QVector3D &v2)
+    int VmfDataLoader::brushBatchSize() const
     {
-        QStringList fragments = coords.split(" ");
-        if ( fragments.count() != 9 )
-            throw InvalidCoordSyntaxException(coords, "Unable to determine co-ordinate triple.");
+        return m_iBrushBatchSize;
+    }
 
-        v0 = vectorFromVmfCoord_x(fragments.at(0) + " " + fragments.at(1) + " " + fragments.at(2));
-        v1 = vectorFromVmfCoord_x(fragments.at(3) + " " + fragments.at(4) + " " + fragments.at(5));
-        v2 = vectorFromVmfCoord_x(fragments.at(6) + " " + fragments.at(7) + " " + fragments.at(8));
+    void VmfDataLoader::setBrushBatchSize(int size)
+    {
+        m_iBrushBatchSize = qMax(1, size);
     }
 
-    inline void setErrorString(QString* string, const QString& error)
+    Model::ArrayWinding3D::Precision VmfDataLoader::brushClipPrecision() const
     {
-        if ( string )
-        {
-            *string = error;
-        }
+        return m_iBrushClipPrecision;
     }
-}
 
-namespace ModelLoaders
-{
-    Q_LOGGING_CATEGORY(lcVmfDataLoader, "ModelLoaders.VmfDataLoader")
+    void VmfDataLoader::setBrushClipPrecision(Model::ArrayWinding3D::Precision precision)
+    {
+        m_iBrushClipPrecision = precision;
+    }
 
-    VmfDataLoader::VmfDataLoader()
-        : BaseFileLoader(),
-          m_iSuccess(Success)
+    quint32 VmfDataLoader::cacheBuildOptions() const
     {
+        // Everything else that affects the scene is fixed, or, like the thread count
+        // and batch size, doesn't change the result.
+        return static_cast<quint32>(m_iBrushClipPrecision);
+    }
 
+    QString VmfDataLoader::mapCacheDirectory() const
+    {
+        return m_MapCache.directory();
+    }
+
+    void VmfDataLoader::setMapCacheDirectory(const QString &directory)
+    {
+        m_MapCache.setDirectory(directory);
     }
 
     BaseFileLoader::LoaderType VmfDataLoader::type() const
@@ -131,7 +448,37 @@ namespace ModelLoaders
 
     BaseFileLoader::SuccessCode VmfDataLoader::load(const QString &filePath, QString *errorString)
     {
+        if ( beginLoad(filePath, errorString) == Failure )
+        {
+            return Failure;
+        }
+
+        while ( continueLoad(-1) )
+        {
+            waitForNextBatch();
+        }
+
+        return finishLoad(errorString);
+    }
+
+    BaseFileLoader::SuccessCode VmfDataLoader::save(const QString &filePath, QString *errorString)
+    {
+        clearInternalState();
+
+        // TODO: We can't write VMFs yet.
+        Q_UNUSED(filePath);
+        Q_UNUSED(errorString);
+        Q_ASSERT_X(false, Q_FUNC_INFO, "Can't save VMFs yet.");
+        return Failure;
+    }
+
+    BaseFileLoader::SuccessCode VmfDataLoader::beginLoad(const QString &filePath, QString *errorString)
+    {
+        using namespace CalliperUtil;
+
+        abandonLoad();
         clearInternalState();
+        resetLoadCancelled();
 
         QFile file(filePath);
         if ( !file.open(QIODevice::ReadOnly) )
@@ -143,31 +490,241 @@ namespace ModelLoaders
         QByteArray fileData = file.readAll();
         file.close();
 
+        m_pLoadState.reset(new LoadState());
+        LoadState& state = *m_pLoadState;
+        state.filePath = filePath;
+        state.buildOptions = cacheBuildOptions();
+
+        if ( m_MapCache.isEnabled() )
+        {
+            state.sourceHash = VmfMapCache::hashSource(fileData);
+            state.sourceSize = fileData.size();
+
+            QString cacheError;
+            state.cacheReader.reset(new VmfMapCacheReader());
+            if ( state.cacheReader->open(m_MapCache.entryPath(filePath), state.sourceHash, state.sourceSize,
+                                         state.buildOptions, &cacheError) )
+            {
+                qCDebug(lcVmfDataLoader) << "Restoring" << state.cacheReader->objectCount() << "objects from cache for" << filePath;
+                return Success;
+            }
+
+            qCDebug(lcVmfDataLoader) << "Not using cache for" << filePath << "-" << cacheError;
+            state.cacheReader.reset();
+            state.cacheWriter.reset(new VmfMapCacheWriter());
+        }
+
+        if ( !prepareFromFile(fileData, errorString) )
+        {
+            m_pLoadState.reset();
+            return Failure;
+        }
+
+        return Success;
+    }
+
+    bool VmfDataLoader::prepareFromFile(const QByteArray &fileData, QString *errorString)
+    {
+        LoadState& state = *m_pLoadState;
+
         QJsonDocument document = createDocument(fileData, errorString);
         if ( document.isNull() )
         {
-            return Failure;
+            return false;
         }
 
-        createBrushes(document);
+        state.root = document.object();
+        state.world = state.root.value("world").toObject();
+
+        // World solids come first, followed by each entity's solids, as in the file.
+        // Hidden objects follow the visible ones at the same level.
+        appendSolids(childBlocks(state.world, "solid"), -1, false);
+        appendSolids(hiddenBlocks(state.world, "solid"), -1, true);
+
+        foreach ( const QJsonObject& entity, childBlocks(state.root, "entity") )
+        {
+            appendEntity(entity, false);
+        }
 
-        if ( m_iSuccess != Success && errorString )
+        foreach ( const QJsonObject& entity, hiddenBlocks(state.root, "entity") )
         {
-            *errorString = m_Errors.join('\n');
+            appendEntity(entity, true);
+        }
+
+        qCDebug(lcVmfDataLoader) << "Map contains" << state.solids.count() << "solids and"
+                                 << state.entities.count() << "entities";
+
+        queueSolidBatches();
+        return true;
+    }
+
+    void VmfDataLoader::appendSolids(const QList<QJsonObject> &solids, int entityIndex, bool hidden)
+    {
+        LoadState& state = *m_pLoadState;
+
+        foreach ( const QJsonObject& solid, solids )
+        {
+            PreparedSolid prepared;
+            prepared.solid = solid;
+            prepared.entityIndex = entityIndex;
+            prepared.hidden = hidden;
+            state.solids.append(prepared);
+        }
+    }
+
+    void VmfDataLoader::appendEntity(const QJsonObject &entity, bool hidden)
+    {
+        LoadState& state = *m_pLoadState;
+
+        PreparedEntity prepared;
+        prepared.entity = entity;
+        prepared.entityId = entity.value("id").toString().toInt();
+        prepared.editor = EditorInfo(entity.value("editor").toObject());
+        prepared.hidden = hidden;
+
+        const QList<QJsonObject> solids = childBlocks(entity, "solid");
+        const QList<QJsonObject> hiddenSolids = hiddenBlocks(entity, "solid");
+        prepared.hasSolids = !solids.isEmpty() || !hiddenSolids.isEmpty();
+
+        const int entityIndex = state.entities.count();
+        state.entities.append(prepared);
+
+        // Everything in a hidden entity is hidden too.
+        appendSolids(solids, entityIndex, hidden);
+        appendSolids(hiddenSolids, entityIndex, true);
+    }
+
+    bool VmfDataLoader::continueLoad(int timeBudgetMsec)
+    {
+        if ( !m_pLoadState || isLoadCancelled() )
+        {
+            return false;
+        }
+
+        LoadState& state = *m_pLoadState;
+        QElapsedTimer timer;
+        timer.start();
+
+        if ( !state.sceneStarted )
+        {
+            if ( state.cacheReader )
+            {
+                Model::MapScene* scene = vmfDataModel()->scene();
+                scene->clearVisGroups();
+                state.cacheReader->restoreVisGroups(scene);
+            }
+            else
+            {
+                createInitialSceneObjects();
+            }
+
+            state.sceneStarted = true;
+        }
+
+        if ( state.cacheReader )
+        {
+            return restoreCachedObjects(timer, timeBudgetMsec);
+        }
+
+        while ( state.nextBatch < state.batches.count() )
+        {
+            const LoadState::SolidBatch& batch = state.batches.at(state.nextBatch);
+            if ( !batch.future.isFinished() )
+            {
+                return true;
+            }
+
+            if ( state.nextSolid < batch.begin )
+            {
+                state.nextSolid = batch.begin;
+            }
+
+            while ( state.nextSolid < batch.end )
+            {
+                if ( isLoadCancelled() )
+                {
+                    return false;
+                }
+
+                const int solidIndex = state.nextSolid++;
+                PreparedSolid& prepared = state.solids[solidIndex];
+                resolveSharedGeometry(prepared, solidIndex);
+                createEntitiesUpTo(prepared.entityIndex);
+                createSolidObjects(prepared);
+
+                if ( timeBudgetMsec >= 0 && timer.elapsed() >= timeBudgetMsec )
+                {
+                    if ( state.nextSolid >= batch.end )
+                    {
+                        ++state.nextBatch;
+                    }
+
+                    return !state.isComplete();
+                }
+            }
+
+            ++state.nextBatch;
+        }
+
+        // Any point entities after the last solid.
+        createEntitiesUpTo(state.entities.count() - 1);
+        return false;
+    }
+
+    BaseFileLoader::SuccessCode VmfDataLoader::finishLoad(QString *errorString)
+    {
+        const bool complete = m_pLoadState && m_pLoadState->isComplete();
+
+        if ( complete && !m_pLoadState->cacheReader )
+        {
+            const Model::BrushGeometryCache& geometryCache = m_pLoadState->brushGeometryCache;
+            qCDebug(lcVmfDataLoader) << "Reused geometry for" << geometryCache.hitCount() << "of"
+                                     << (geometryCache.hitCount() + geometryCache.missCount()) << "solids";
+        }
+
+        if ( complete && m_iSuccess == Success && m_pLoadState->cacheWriter )
+        {
+            m_MapCache.store(m_pLoadState->filePath,
+                             m_pLoadState->cacheWriter->serialise(m_pLoadState->sourceHash, m_pLoadState->sourceSize,
+                                                                  m_pLoadState->buildOptions));
+        }
+
+        abandonLoad();
+
+        if ( !complete )
+        {
+            setErrorString(errorString, isLoadCancelled() ? "Loading was cancelled." : "Loading did not complete.");
+            return Failure;
+        }
+
+        if ( m_iSuccess != Success )
+        {
+            setErrorString(errorString, m_Errors.join('\n'));
         }
 
         return m_iSuccess;
     }
 
-    BaseFileLoader::SuccessCode VmfDataLoader::save(const QString &filePath, QString *errorString)
+    float VmfDataLoader::loadProgress() const
     {
-        clearInternalState();
+        if ( !m_pLoadState )
+        {
+            return 0.0f;
+        }
 
-        // TODO: We can't write VMFs yet.
-        Q_UNUSED(filePath);
-        Q_UNUSED(errorString);
-        Q_ASSERT_X(false, Q_FUNC_INFO, "Can't save VMFs yet.");
-        return Failure;
+        if ( m_pLoadState->cacheReader )
+        {
+            const int count = m_pLoadState->cacheReader->objectCount();
+            return count > 0 ? static_cast<float>(m_pLoadState->nextCachedObject) / static_cast<float>(count) : 1.0f;
+        }
+
+        const int total = m_pLoadState->solids.count() + m_pLoadState->entities.count();
+        if ( total < 1 )
+        {
+            return m_pLoadState->isComplete() ? 1.0f : 0.0f;
+        }
+
+        return static_cast<float>(m_pLoadState->nextSolid + m_pLoadState->nextEntity) / static_cast<float>(total);
     }
 
     void VmfDataLoader::clearInternalState()
@@ -181,90 +738,574 @@ namespace ModelLoaders
         return FileFormats::KeyValuesParser(vmfData).toJsonDocument(errorString);
     }
 
-    void VmfDataLoader::createBrushes(const QJsonDocument &doc)
+    void VmfDataLoader::queueSolidBatches()
+    {
+        LoadState& state = *m_pLoadState;
+        const int solidCount = state.solids.count();
+
+        // Batches are queued in file order, so the earliest are built first and can
+        // be added to the scene while later ones are still being worked on.
+        PreparedSolid* data = state.solids.data();
+        for ( int begin = 0; begin < solidCount; begin += m_iBrushBatchSize )
+        {
+            LoadState::SolidBatch batch;
+            batch.begin = begin;
+            batch.end = qMin(begin + m_iBrushBatchSize, solidCount);
+
+            const int end = batch.end;
+            const Model::ArrayWinding3D::Precision precision = m_iBrushClipPrecision;
+            Model::BrushGeometryCache* cache = &state.brushGeometryCache;
+            batch.future = QtConcurrent::run(&m_BrushPool, [this, data, begin, end, precision, cache]()
+            {
+                for ( int i = begin; i < end && !isLoadCancelled(); ++i )
+                {
+                    prepareSolid(data[i], i, precision, cache);
+                }
+            });
+
+            state.batches.append(batch);
+        }
+    }
+
+    void VmfDataLoader::waitForNextBatch()
     {
-        QJsonObject world = doc.object().value("world").toObject();
-        CalliperUtil::Json::JsonArrayWrapper solids = world.value("solid");
+        if ( !m_pLoadState || m_pLoadState->nextBatch >= m_pLoadState->batches.count() )
+        {
+            return;
+        }
+
+        m_pLoadState->batches[m_pLoadState->nextBatch].future.waitForFinished();
+    }
+
+    void VmfDataLoader::abandonLoad()
+    {
+        if ( !m_pLoadState )
+        {
+            return;
+        }
 
-        qCDebug(lcVmfDataLoader) << "World contains" << solids.count() << "solids";
+        // Workers may still be using the prepared solids.
+        for ( int i = 0; i < m_pLoadState->batches.count(); ++i )
+        {
+            m_pLoadState->batches[i].future.waitForFinished();
+        }
 
-        for ( int i = 0; i < solids.count(); i++ )
+        for ( int i = 0; i < m_pLoadState->solids.count(); ++i )
         {
-            createBrushForSolid(solids.at(i).toObject());
+            qDeleteAll(m_pLoadState->solids[i].windings);
         }
+
+        m_pLoadState.reset();
     }
 
-    void VmfDataLoader::createBrushForSolid(const QJsonObject &solid)
+    void VmfDataLoader::prepareSolid(PreparedSolid &prepared, int solidIndex, Model::ArrayWinding3D::Precision precision,
+                                     Model::BrushGeometryCache* cache)
     {
         using namespace Model;
-        using namespace CalliperUtil;
-
-        QList<TexturedWinding*> polygons;
-        QJsonArray sides = solid.value("side").toArray();
 
         bool bGotId = false;
-        int solidId = solid.value("id").toString().toInt(&bGotId);
+        prepared.solidId = prepared.solid.value("id").toString().toInt(&bGotId);
         if ( !bGotId )
         {
-            qCWarning(lcVmfDataLoader) << "Solid encountered with invalid ID";
-            m_iSuccess = PartialSuccess;
+            prepared.error = "Solid encountered with invalid ID";
             return;
         }
 
+        prepared.editor = EditorInfo(prepared.solid.value("editor").toObject());
+
+        CalliperUtil::Json::JsonArrayWrapper sides = prepared.solid.value("side");
         for ( int j = 0; j < sides.count(); j++ )
         {
-            TexturedWinding* winding = createSide(sides.at(j).toObject(), solidId);
-            if ( winding )
+            const QJsonObject side = sides.at(j).toObject();
+
+            QString materialPath;
+            QString error;
+            TexturedWinding* winding = createSide(side, precision, materialPath, &error);
+            if ( !winding )
             {
-                polygons.append(winding);
+                prepared.error = QString("Unable to create side %1: %2").arg(j).arg(error);
+                qDeleteAll(prepared.windings);
+                prepared.windings.clear();
+                prepared.materialPaths.clear();
+                prepared.displacements.clear();
+                return;
             }
-            else
+
+            prepared.windings.append(winding);
+            prepared.materialPaths.append(materialPath);
+
+            if ( side.contains("dispinfo") )
             {
-                qCWarning(lcVmfDataLoader) << "Unable to create side" << j << "for solid with ID" << solidId;
-                qDeleteAll(polygons);
-                m_iSuccess = PartialSuccess;
-                return;
+                PreparedDisplacement displacement;
+                displacement.sideIndex = prepared.windings.count() - 1;
+                displacement.dispInfo = side.value("dispinfo").toObject();
+                prepared.displacements.append(displacement);
             }
         }
 
-        GenericBrush* planeBrush = GenericBrushFactory::createBrushFromWindingGroup(vmfDataModel()->scene()->rootObject(), polygons);
-        planeBrush->setObjectName(QString("planeBrush%0").arg(solidId));
+        prepared.geometry = GenericBrushFactory::prepareBrushGeometry(prepared.windings, cache, solidIndex, &prepared.geometrySource);
+        buildDisplacements(prepared);
 
-        qDeleteAll(polygons);
+        // Release the JSON now that it's no longer needed.
+        prepared.solid = QJsonObject();
+        prepared.valid = true;
     }
 
-    Model::TexturedWinding* VmfDataLoader::createSide(const QJsonObject& side, int brushId)
+    void VmfDataLoader::buildDisplacements(PreparedSolid &prepared)
+    {
+        // The windings aren't clipped if the geometry came from the cache,
+        // so displacements take their corners from the geometry instead.
+        for ( int i = 0; i < prepared.displacements.count(); ++i )
+        {
+            PreparedDisplacement& displacement = prepared.displacements[i];
+            const QVector<int>& indices = prepared.geometry.faceIndices.at(displacement.sideIndex);
+
+            QVector<QVector3D> faceVertices;
+            faceVertices.reserve(indices.count());
+            for ( int j = 0; j < indices.count(); ++j )
+            {
+                faceVertices.append(prepared.geometry.vertices.at(indices.at(j)));
+            }
+
+            displacement.error.clear();
+            displacement.build(faceVertices, prepared.windings.at(displacement.sideIndex)->plane().normal());
+        }
+    }
+
+    void VmfDataLoader::resolveSharedGeometry(PreparedSolid &prepared, int solidIndex)
+    {
+        if ( !prepared.valid )
+        {
+            return;
+        }
+
+        // Batches run concurrently, so a worker may have found a later copy of this solid
+        // than the first one in the file, or not found a copy at all. Every solid before
+        // this one has been prepared by now, so the cache holds the first copy, and taking
+        // the geometry from it makes the scene the same whatever the thread count.
+        Model::PreparedBrushGeometry geometry;
+        int source = solidIndex;
+        const Model::BrushGeometryCache::Key key = Model::BrushGeometryCache::keyFor(prepared.windings);
+        if ( !m_pLoadState->brushGeometryCache.findFirst(key, geometry, solidIndex, &source) ||
+             source == prepared.geometrySource )
+        {
+            return;
+        }
+
+        prepared.geometry = geometry;
+        prepared.geometrySource = source;
+        buildDisplacements(prepared);
+    }
+
+    void VmfDataLoader::createInitialSceneObjects()
     {
         using namespace Model;
-        using namespace CalliperUtil;
 
-        QString materialPath = CalliperUtil::General::normaliseResourcePathSeparators(side.value("material").toString().toLower());
-        QString plane = side.value("plane").toString();
+        LoadState& state = *m_pLoadState;
+        MapScene* scene = vmfDataModel()->scene();
+
+        scene->clearVisGroups();
+        createVisGroups(state.root.value("visgroups").toObject().value("visgroup"), 0);
+        createGroups(state.world);
 
-        QVector3D v0, v1, v2;
+        // The worldspawn keyvalues are kept on their own entity.
+        PreparedEntity worldspawn;
+        worldspawn.entity = state.world;
+        worldspawn.entity.remove("solid");
+        worldspawn.entityId = state.world.value("id").toString().toInt();
+        worldspawn.hasSolids = true;
+        createEntity(worldspawn, scene->rootObject());
 
-        try
+        state.entityObjects.resize(state.entities.count());
+    }
+
+    bool VmfDataLoader::restoreCachedObjects(const QElapsedTimer &timer, int timeBudgetMsec)
+    {
+        LoadState& state = *m_pLoadState;
+        Model::MapScene* scene = vmfDataModel()->scene();
+        const int count = state.cacheReader->objectCount();
+
+        while ( state.nextCachedObject < count )
         {
-            vectorsFromVmfCoords_x(plane, v0, v1, v2);
+            if ( isLoadCancelled() )
+            {
+                return false;
+            }
+
+            if ( !state.cacheReader->restoreObject(scene, state.nextCachedObject++) )
+            {
+                qCWarning(lcVmfDataLoader) << "Cache entry for" << state.filePath << "is corrupt, loading the map from the file instead";
+                return loadFromFileInstead();
+            }
+
+            if ( timeBudgetMsec >= 0 && timer.elapsed() >= timeBudgetMsec )
+            {
+                break;
+            }
         }
-        catch ( CalliperUtil::CalliperException& exception )
+
+        return state.nextCachedObject < count;
+    }
+
+    bool VmfDataLoader::loadFromFileInstead()
+    {
+        LoadState& state = *m_pLoadState;
+
+        state.cacheReader->destroyRestoredObjects(vmfDataModel()->scene());
+        state.cacheReader.reset();
+        m_MapCache.remove(state.filePath);
+
+        // The entry is rebuilt once loading from the file succeeds.
+        state.cacheWriter.reset(new VmfMapCacheWriter());
+        state.sceneStarted = false;
+        state.nextCachedObject = 0;
+
+        QFile file(state.filePath);
+        if ( !file.open(QIODevice::ReadOnly) )
         {
-            QString error = QString("Error parsing plane co-ordinates for side %1: '%2'").arg(side.value("id").toInt()).arg(exception.errorHint());
-            addError(brushId, error);
-            return Q_NULLPTR;
+            qCWarning(lcVmfDataLoader) << "Unable to open" << state.filePath << "for reading.";
+            return false;
         }
-        catch (...)
+
+        QString error;
+        if ( !prepareFromFile(file.readAll(), &error) )
         {
-            QString error = QString("Unexpected exception occurred when parsing plane co-ordinates for side %1.").arg(side.value("id").toInt());
-            addError(brushId, error);
-            return Q_NULLPTR;
+            qCWarning(lcVmfDataLoader) << "Failed to parse" << state.filePath << "-" << error;
+            return false;
+        }
+
+        // The scene is started on the next call.
+        return true;
+    }
+
+    VmfMapCacheWriter* VmfDataLoader::cacheWriter() const
+    {
+        return m_pLoadState ? m_pLoadState->cacheWriter.data() : Q_NULLPTR;
+    }
+
+    void VmfDataLoader::createEntitiesUpTo(int entityIndex)
+    {
+        LoadState& state = *m_pLoadState;
+
+        for ( ; state.nextEntity <= entityIndex && state.nextEntity < state.entities.count(); ++state.nextEntity )
+        {
+            const PreparedEntity& prepared = state.entities.at(state.nextEntity);
+            state.entityObjects[state.nextEntity] = createEntity(prepared, editorParent(prepared.editor));
         }
+    }
 
+    void VmfDataLoader::createVisGroups(const QJsonValue &visGroups, int parentId)
+    {
+        using namespace Model;
+
+        if ( visGroups.isUndefined() )
+            return;
+
+        CalliperUtil::Json::JsonArrayWrapper visGroupArray = visGroups;
+        for ( int i = 0; i < visGroupArray.count(); ++i )
+        {
+            const QJsonObject visGroup = visGroupArray.at(i).toObject();
+
+            bool bGotId = false;
+            const int id = visGroup.value("visgroupid").toString().toInt(&bGotId);
+            if ( !bGotId || id < 1 )
+            {
+                qCWarning(lcVmfDataLoader) << "Visgroup encountered with invalid ID";
+                m_iSuccess = PartialSuccess;
+                continue;
+            }
+
+            QColor color;
+            parseColor(visGroup.value("color").toString(), color);
+
+            const MapVisGroup mapVisGroup(id, parentId, visGroup.value("name").toString(), color);
+            vmfDataModel()->scene()->addVisGroup(mapVisGroup);
+            if ( cacheWriter() )
+            {
+                cacheWriter()->addVisGroup(mapVisGroup);
+            }
+
+            createVisGroups(visGroup.value("visgroup"), id);
+        }
+    }
+
+    void VmfDataLoader::createGroups(const QJsonObject &world)
+    {
+        using namespace Model;
+
+        QHash<int, MapGroup*>& groups = m_pLoadState->groups;
+        if ( !world.contains("group") )
+            return;
+
+        Scene* scene = vmfDataModel()->scene();
+        CalliperUtil::Json::JsonArrayWrapper groupArray = world.value("group");
+        QVector<EditorInfo> editorInfo;
+        QVector<MapGroup*> created;
+
+        for ( int i = 0; i < groupArray.count(); ++i )
+        {
+            const QJsonObject group = groupArray.at(i).toObject();
+
+            bool bGotId = false;
+            const int id = group.value("id").toString().toInt(&bGotId);
+            if ( !bGotId || groups.contains(id) )
+            {
+                qCWarning(lcVmfDataLoader) << "Group encountered with invalid or duplicate ID";
+                m_iSuccess = PartialSuccess;
+                continue;
+            }
+
+            MapGroup* mapGroup = scene->createSceneObject<MapGroup>(scene->rootObject());
+            mapGroup->setGroupId(id);
+            mapGroup->setObjectName(QString("group%1").arg(id));
+
+            groups.insert(id, mapGroup);
+            created.append(mapGroup);
+            editorInfo.append(EditorInfo(group.value("editor").toObject()));
+        }
+
+        // Groups can be nested, and may refer to groups later in the file.
+        for ( int i = 0; i < created.count(); ++i )
+        {
+            applyEditorInfo(created.at(i), editorInfo.at(i));
+
+            MapGroup* parent = groups.value(editorInfo.at(i).groupId, Q_NULLPTR);
+            if ( !parent || parent == created.at(i) )
+                continue;
+
+            // Don't introduce cycles from malformed files.
+            bool cycle = false;
+            for ( SceneObject* ancestor = parent; ancestor; ancestor = ancestor->parentObject() )
+            {
+                if ( ancestor == created.at(i) )
+                {
+                    cycle = true;
+                    break;
+                }
+            }
+
+            if ( !cycle )
+            {
+                created.at(i)->setParentObject(parent);
+            }
+        }
+
+        if ( cacheWriter() )
+        {
+            // Parents must be recorded before their children.
+            QList<MapGroup*> remaining = created.toList();
+            while ( !remaining.isEmpty() )
+            {
+                for ( int i = 0; i < remaining.count(); )
+                {
+                    if ( remaining.contains(qobject_cast<MapGroup*>(remaining.at(i)->parentObject())) )
+                    {
+                        ++i;
+                        continue;
+                    }
+
+                    cacheWriter()->addGroup(remaining.takeAt(i));
+                }
+            }
+        }
+    }
+
+    Model::SceneObject* VmfDataLoader::editorParent(const EditorInfo &editor) const
+    {
+        Model::MapGroup* group = m_pLoadState->groups.value(editor.groupId, Q_NULLPTR);
+        return group ? group : vmfDataModel()->scene()->rootObject();
+    }
+
+    void VmfDataLoader::applyEditorInfo(Model::SceneObject *object, const EditorInfo &editor)
+    {
+        Model::MapScene* scene = vmfDataModel()->scene();
+        foreach ( int visGroupId, editor.visGroupIds )
+        {
+            scene->addObjectToVisGroup(object, visGroupId);
+        }
+    }
+
+    void VmfDataLoader::createSolidObjects(PreparedSolid &prepared)
+    {
+        using namespace Model;
+
+        if ( !prepared.valid )
+        {
+            qCWarning(lcVmfDataLoader) << "Unable to create solid" << prepared.solidId << "-" << prepared.error;
+            addError(prepared.solidId, prepared.error);
+            m_iSuccess = PartialSuccess;
+            return;
+        }
+
+        Scene* scene = vmfDataModel()->scene();
+        SceneObject* parent = prepared.entityIndex >= 0
+                ? m_pLoadState->entityObjects.at(prepared.entityIndex)
+                : editorParent(prepared.editor);
+
+        // Materials are resolved here rather than on the workers, as the store isn't thread-safe.
         MaterialStore* materialStore = ResourceEnvironment::globalInstance()->materialStore();
+        for ( int i = 0; i < prepared.windings.count(); ++i )
+        {
+            prepared.windings.at(i)->setMaterialId(materialStore->getMaterialId(prepared.materialPaths.at(i)));
+        }
+
+        if ( prepared.displacements.isEmpty() )
+        {
+            GenericBrush* planeBrush = GenericBrushFactory::createBrushFromPreparedGeometry(parent, prepared.windings, prepared.geometry);
+            planeBrush->setObjectName(QString("planeBrush%0").arg(prepared.solidId));
+            planeBrush->setHidden(prepared.hidden);
+            applyEditorInfo(planeBrush, prepared.editor);
+
+            if ( cacheWriter() )
+            {
+                // Empty windings don't become faces.
+                QStringList faceMaterialPaths;
+                for ( int i = 0; i < prepared.windings.count(); ++i )
+                {
+                    if ( !prepared.geometry.faceIndices.at(i).isEmpty() )
+                    {
+                        faceMaterialPaths.append(prepared.materialPaths.at(i));
+                    }
+                }
+
+                cacheWriter()->addBrush(planeBrush, faceMaterialPaths);
+            }
+        }
+        else
+        {
+            // As in the engine, only the displaced faces of a solid are drawn.
+            for ( int i = 0; i < prepared.displacements.count(); ++i )
+            {
+                const PreparedDisplacement& displacement = prepared.displacements.at(i);
+                if ( !displacement.error.isEmpty() )
+                {
+                    addError(prepared.solidId, displacement.error);
+                    m_iSuccess = PartialSuccess;
+                    continue;
+                }
+
+                Displacement* surface = scene->createSceneObject<Displacement>(parent);
+                surface->setObjectName(QString("displacement%1_%2").arg(prepared.solidId).arg(displacement.sideIndex));
+                surface->setSurface(displacement.power, displacement.basePositions, displacement.positions, displacement.faceNormal);
+                surface->setAlphas(displacement.alphas);
+                surface->texturePlane()->setMaterialId(prepared.windings.at(displacement.sideIndex)->materialId());
+                surface->setHidden(prepared.hidden);
+                applyEditorInfo(surface, prepared.editor);
+
+                if ( cacheWriter() )
+                {
+                    cacheWriter()->addDisplacement(surface, prepared.materialPaths.at(displacement.sideIndex));
+                }
+            }
+        }
+
+        qDeleteAll(prepared.windings);
+        prepared.windings.clear();
+        prepared.geometry = Model::PreparedBrushGeometry();
+        prepared.displacements.clear();
+    }
+
+    Model::MapEntity* VmfDataLoader::createEntity(const PreparedEntity &prepared, Model::SceneObject *parent)
+    {
+        using namespace Model;
+
+        Scene* scene = vmfDataModel()->scene();
+        MapEntity* entity = scene->createSceneObject<MapEntity>(parent);
+        entity->setEntityId(prepared.entityId);
+
+        for ( QJsonObject::const_iterator it = prepared.entity.constBegin(); it != prepared.entity.constEnd(); ++it )
+        {
+            if ( it.key() == "id" || isEntitySubBlock(it.key()) )
+                continue;
+
+            // Duplicate keys are not meaningful for entities; the last one wins, as in the engine.
+            const QJsonValue value = it.value().isArray() ? it.value().toArray().last() : it.value();
+            if ( value.isString() )
+            {
+                entity->setKeyValue(it.key(), value.toString());
+            }
+        }
+
+        if ( prepared.entity.contains("connections") )
+        {
+            QList<MapEntity::Output> outputs;
+            const QJsonObject connections = prepared.entity.value("connections").toObject();
+
+            for ( QJsonObject::const_iterator it = connections.constBegin(); it != connections.constEnd(); ++it )
+            {
+                CalliperUtil::Json::JsonArrayWrapper targets = it.value();
+                for ( int i = 0; i < targets.count(); ++i )
+                {
+                    outputs.append(MapEntity::Output(it.key(), targets.at(i).toString()));
+                }
+            }
+
+            entity->setOutputs(outputs);
+        }
+
+        entity->setBrushEntity(prepared.hasSolids);
+
+        const QString className = entity->className();
+        entity->setObjectName(prepared.entityId > 0
+                              ? QString("%1%2").arg(className).arg(prepared.entityId)
+                              : className);
+
+        if ( !prepared.hasSolids )
+        {
+            // Brush entities keep their origin as a keyvalue only, since their brushes are in world space.
+            QVector3D origin;
+            if ( parseVector(entity->keyValue("origin"), origin) )
+            {
+                entity->hierarchy().setPosition(origin);
+            }
+
+            QVector3D angles;
+            if ( parseVector(entity->keyValue("angles"), angles) )
+            {
+                entity->hierarchy().setRotation(EulerAngle(angles.x(), angles.y(), angles.z()));
+            }
+
+            if ( prepared.editor.color.isValid() )
+            {
+                entity->setColor(prepared.editor.color);
+            }
+        }
+
+        entity->setHidden(prepared.hidden);
+        applyEditorInfo(entity, prepared.editor);
+
+        if ( cacheWriter() )
+        {
+            cacheWriter()->addEntity(entity);
+        }
+
+        return entity;
+    }
+
+    Model::TexturedWinding* VmfDataLoader::createSide(const QJsonObject& side, Model::ArrayWinding3D::Precision precision,
+                                                      QString& materialPath, QString* errorHint)
+    {
+        using namespace Model;
+
+        materialPath = CalliperUtil::General::normaliseResourcePathSeparators(side.value("material").toString().toLower());
+        QString plane = side.value("plane").toString();
+
+        DoubleVector3D v0, v1, v2;
+
+        QString parseError;
+        if ( !VmfPlaneParser::parse(plane, v0, v1, v2, &parseError) )
+        {
+            setErrorString(errorHint, QString("Error parsing plane co-ordinates for side %1: '%2' %3")
+                           .arg(side.value("id").toString()).arg(plane).arg(parseError));
+            return Q_NULLPTR;
+        }
 
-        quint32 materialId = materialStore->getMaterialId(materialPath);
-        TexturedWinding* winding = new TexturedWinding(Plane3D(v0, v2, v1), materialId);
-        Q_ASSERT(!QVector3D::crossProduct(v1 - v0, v2 - v0).isNull());
+        // The material ID is filled in when the brush is added to the scene.
+        // The points are parsed and the plane is built in double precision, so that
+        // off-grid points don't lose precision before the winding is clipped.
+        const DoublePlane3D windingPlane(v0, v2, v1);
+        TexturedWinding* winding = new TexturedWinding(windingPlane, 0, precision);
+        Q_ASSERT(!DoubleVector3D::crossProduct(v1 - v0, v2 - v0).isNull());
 
         return winding;
     }
@@ -3,17 +3,29 @@
 
 #include "model-loaders_global.h"
 #include "model-loaders/filedataloaders/base/basefileloader.h"
+#include "vmfmapcache.h"
+#include "model/math/arraywinding3d.h"
+#include "model/factories/brushgeometrycache.h"
 #include <QJsonDocument>
 #include <QVector>
 #include <QString>
 #include <QLoggingCategory>
+#include <QThreadPool>
+#include <QJsonValue>
+#include <QJsonObject>
+#include <QScopedPointer>
 
 namespace Model
 {
     class MapFileDataModel;
     class TexturedWinding;
+    class SceneObject;
+    class MapGroup;
+    class MapEntity;
 }
 
+class QElapsedTimer;
+
 namespace ModelLoaders
 {
     Q_DECLARE_LOGGING_CATEGORY(lcVmfDataLoader)
@@ -22,6 +34,7 @@ namespace ModelLoaders
     {
     public:
         VmfDataLoader();
+        virtual ~VmfDataLoader();
 
         virtual LoaderType type() const override;
 
@@ -31,16 +44,83 @@ namespace ModelLoaders
         virtual SuccessCode load(const QString &filePath, QString *errorString) override;
         virtual SuccessCode save(const QString &filePath, QString *errorString) override;
 
+        // beginLoad() parses the file and queues brush geometry to be built in batches
+        // on worker threads. continueLoad() adds finished batches to the scene.
+        virtual SuccessCode beginLoad(const QString &filePath, QString *errorString) override;
+        virtual bool continueLoad(int timeBudgetMsec) override;
+        virtual SuccessCode finishLoad(QString *errorString) override;
+        virtual float loadProgress() const override;
+
+        // Brush and displacement geometry is built on this many threads.
+        // Objects are always added to the scene in file order, so the
+        // resulting scene does not depend on the thread count.
+        int brushThreadCount() const;
+        void setBrushThreadCount(int count);
+
+        // Number of solids built by each worker task, and so the granularity
+        // at which brushes appear in the scene during an incremental load.
+        int brushBatchSize() const;
+        void setBrushBatchSize(int size);
+
+        // Directory used to cache the scene built from each map, so that an unchanged
+        // map can be re-opened without parsing or clipping anything. Defaults to
+        // VmfMapCache::defaultDirectory(); an empty path disables caching.
+        QString mapCacheDirectory() const;
+        void setMapCacheDirectory(const QString& directory);
+
+        // Precision used to clip brush faces. Defaults to double precision, which
+        // avoids slivers and welding failures on large maps with off-grid planes.
+        Model::ArrayWinding3D::Precision brushClipPrecision() const;
+        void setBrushClipPrecision(Model::ArrayWinding3D::Precision precision);
+
     private:
-        void createBrushes(const QJsonDocument &doc);
-        void createBrushForSolid(const QJsonObject& solid);
-        Model::TexturedWinding* createSide(const QJsonObject& side, int brushId);
+        struct EditorInfo;
+        struct PreparedDisplacement;
+        struct PreparedSolid;
+        struct PreparedEntity;
+        struct LoadState;
+
+        static void prepareSolid(PreparedSolid& prepared, int solidIndex, Model::ArrayWinding3D::Precision precision,
+                                 Model::BrushGeometryCache* cache);
+        static void buildDisplacements(PreparedSolid& prepared);
+        void resolveSharedGeometry(PreparedSolid& prepared, int solidIndex);
+        static Model::TexturedWinding* createSide(const QJsonObject& side, Model::ArrayWinding3D::Precision precision,
+                                                  QString& materialPath, QString* errorHint);
+
+        // Options recorded in map cache entries, so that an entry built with other options isn't used.
+        quint32 cacheBuildOptions() const;
+
+        void appendSolids(const QList<QJsonObject>& solids, int entityIndex, bool hidden);
+        void appendEntity(const QJsonObject& entity, bool hidden);
+        void queueSolidBatches();
+        void waitForNextBatch();
+        void abandonLoad();
+        void createInitialSceneObjects();
+        bool restoreCachedObjects(const QElapsedTimer& timer, int timeBudgetMsec);
+
+        // For when a cache entry turns out to be corrupt part way through restoring it.
+        // Removes what was restored and the entry, and prepares to load from the file.
+        bool loadFromFileInstead();
+        bool prepareFromFile(const QByteArray& fileData, QString* errorString);
+        VmfMapCacheWriter* cacheWriter() const;
+        void createVisGroups(const QJsonValue& visGroups, int parentId);
+        void createGroups(const QJsonObject& world);
+        void createEntitiesUpTo(int entityIndex);
+        void createSolidObjects(PreparedSolid& prepared);
+        Model::MapEntity* createEntity(const PreparedEntity& prepared, Model::SceneObject* parent);
+        Model::SceneObject* editorParent(const EditorInfo& editor) const;
+        void applyEditorInfo(Model::SceneObject* object, const EditorInfo& editor);
         void addError(int brushId, const QString& error);
         void clearInternalState();
         QJsonDocument createDocument(const QByteArray& vmfData, QString* errorString);
 
         SuccessCode m_iSuccess;
         QStringList m_Errors;
+        QThreadPool m_BrushPool;
+        int m_iBrushBatchSize;
+        Model::ArrayWinding3D::Precision m_iBrushClipPrecision;
+        VmfMapCache m_MapCache;
+        QScopedPointer<LoadState> m_pLoadState;
     };
 }
 
@@ -0,0 +1,1044 @@
+#include "vmfmapcache.h"
+#include "model/scene/mapscene.h"
+#include "model/sceneobjects/mapgroup.h"
+#include "model/sceneobjects/mapentity.h"
+#include "model/sceneobjects/displacement.h"
+#include "model/genericbrush/genericbrush.h"
+#include "model/global/resourceenvironment.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QColor>
+#include <QVector2D>
+#include <cstring>
+
+namespace ModelLoaders
+{
+    Q_LOGGING_CATEGORY(lcVmfMapCache, "ModelLoaders.VmfMapCache")
+
+    namespace
+    {
+        // Bump this whenever the entry layout, or the way the loader builds the scene, changes.
+        // Loader options that change the scene are recorded in each entry instead.
+        const quint32 CACHE_VERSION = 4;
+        const char CACHE_MAGIC[4] = { 'C', 'M', 'A', 'P' };
+        const int HASH_LENGTH = 20;
+        const quint32 SECTION_ALIGNMENT = 16;
+
+        enum Section
+        {
+            SectionStrings = 0,
+            SectionStringData,
+            SectionVisGroups,
+            SectionObjects,
+            SectionObjectVisGroups,
+            SectionGroups,
+            SectionEntities,
+            SectionStringPairs,
+            SectionBrushes,
+            SectionFaces,
+            SectionIndices,
+            SectionVertices,
+            SectionDisplacements,
+            SectionAlphas,
+
+            SectionCount
+        };
+
+        enum ObjectType
+        {
+            GroupObject = 1,
+            EntityObject,
+            BrushObject,
+            DisplacementObject
+        };
+
+        enum ObjectFlag
+        {
+            HiddenObject = (1<<0)
+        };
+
+        // All fields are stored in native byte order, so that a mapped entry
+        // can be read in place. Entries are local to the machine that wrote them.
+        struct SectionEntry
+        {
+            quint32 offset;
+            quint32 count;
+        };
+
+        struct EntryHeader
+        {
+            char magic[4];
+            quint32 version;
+            quint64 sourceSize;
+            char sourceHash[HASH_LENGTH];
+            quint32 buildOptions;
+            SectionEntry sections[SectionCount];
+        };
+
+        struct StringEntry
+        {
+            quint32 offset;
+            quint32 length;
+        };
+
+        struct VisGroupRecord
+        {
+            qint32 id;
+            qint32 parentId;
+            quint32 name;
+            quint32 color;
+            quint32 hasColor;
+        };
+
+        struct ObjectRecord
+        {
+            quint32 type;
+            qint32 parent;
+            quint32 name;
+            quint32 color;
+            float position[3];
+            float rotation[3];
+            quint32 visGroupBegin;
+            quint32 visGroupCount;
+            quint32 dataIndex;
+            quint32 flags;
+        };
+
+        struct GroupRecord
+        {
+            qint32 groupId;
+        };
+
+        struct EntityRecord
+        {
+            qint32 entityId;
+            quint32 brushEntity;
+            quint32 keyValueBegin;
+            quint32 keyValueCount;
+            quint32 outputBegin;
+            quint32 outputCount;
+        };
+
+        struct StringPairRecord
+        {
+            quint32 first;
+            quint32 second;
+        };
+
+        struct TexturePlaneRecord
+        {
+            quint32 material;
+            float scale[2];
+            float translation[2];
+            float rotation;
+        };
+
+        struct BrushRecord
+        {
+            quint32 vertexBegin;
+            quint32 vertexCount;
+            quint32 faceBegin;
+            quint32 faceCount;
+        };
+
+        struct FaceRecord
+        {
+            quint32 indexBegin;
+            quint32 indexCount;
+            TexturePlaneRecord plane;
+        };
+
+        struct VertexRecord
+        {
+            float x;
+            float y;
+            float z;
+        };
+
+        // Base positions are followed by displaced positions.
+        struct DisplacementRecord
+        {
+            qint32 power;
+            quint32 vertexBegin;
+            quint32 vertexCount;
+            float faceNormal[3];
+            quint32 alphaBegin;
+            quint32 alphaCount;
+            TexturePlaneRecord plane;
+        };
+
+        const quint32 SECTION_ELEMENT_SIZES[SectionCount] =
+        {
+            sizeof(StringEntry),
+            sizeof(char),
+            sizeof(VisGroupRecord),
+            sizeof(ObjectRecord),
+            sizeof(qint32),
+            sizeof(GroupRecord),
+            sizeof(EntityRecord),
+            sizeof(StringPairRecord),
+            sizeof(BrushRecord),
+            sizeof(FaceRecord),
+            sizeof(qint32),
+            sizeof(VertexRecord),
+            sizeof(DisplacementRecord),
+            sizeof(float),
+        };
+
+        inline quint32 align(quint32 value)
+        {
+            return (value + (SECTION_ALIGNMENT - 1)) & ~(SECTION_ALIGNMENT - 1);
+        }
+
+        inline void setError(QString* errorHint, const QString& error)
+        {
+            if ( errorHint )
+            {
+                *errorHint = error;
+            }
+        }
+
+        template<typename T>
+        inline quint32 append(QByteArray& section, const T& record)
+        {
+            const quint32 index = section.size() / sizeof(T);
+            section.append(reinterpret_cast<const char*>(&record), sizeof(T));
+            return index;
+        }
+
+        inline quint32 elementCount(const QByteArray& section, int sectionIndex)
+        {
+            return section.size() / SECTION_ELEMENT_SIZES[sectionIndex];
+        }
+
+        template<typename T>
+        inline const T* records(const uchar* data)
+        {
+            return reinterpret_cast<const T*>(data);
+        }
+
+        TexturePlaneRecord texturePlaneRecord(const Model::TexturePlane* plane, quint32 material)
+        {
+            TexturePlaneRecord record;
+            record.material = material;
+            record.scale[0] = plane->scale().x();
+            record.scale[1] = plane->scale().y();
+            record.translation[0] = plane->translation().x();
+            record.translation[1] = plane->translation().y();
+            record.rotation = plane->rotation();
+            return record;
+        }
+
+        // Checks that [begin, begin + count) lies within a section of the given size.
+        inline bool inRange(quint32 begin, quint32 count, quint32 size)
+        {
+            return begin <= size && count <= size - begin;
+        }
+    }
+
+    VmfMapCache::VmfMapCache(const QString &directory)
+        : m_strDirectory(directory)
+    {
+    }
+
+    QString VmfMapCache::defaultDirectory()
+    {
+        QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if ( base.isEmpty() )
+        {
+            return QString();
+        }
+
+        return base + QString("/maps/v%1").arg(CACHE_VERSION);
+    }
+
+    QString VmfMapCache::directory() const
+    {
+        return m_strDirectory;
+    }
+
+    void VmfMapCache::setDirectory(const QString &directory)
+    {
+        m_strDirectory = directory;
+    }
+
+    bool VmfMapCache::isEnabled() const
+    {
+        return !m_strDirectory.isEmpty();
+    }
+
+    QString VmfMapCache::entryPath(const QString &mapPath) const
+    {
+        if ( !isEnabled() || mapPath.isEmpty() )
+        {
+            return QString();
+        }
+
+        QString canonicalPath = QFileInfo(mapPath).canonicalFilePath();
+        if ( canonicalPath.isEmpty() )
+        {
+            canonicalPath = QFileInfo(mapPath).absoluteFilePath();
+        }
+
+        const QByteArray pathHash = QCryptographicHash::hash(canonicalPath.toUtf8(), QCryptographicHash::Sha1);
+        return QString("%1/%2.cmap").arg(m_strDirectory).arg(QString::fromLatin1(pathHash.toHex()));
+    }
+
+    QByteArray VmfMapCache::hashSource(const QByteArray &mapData)
+    {
+        return QCryptographicHash::hash(mapData, QCryptographicHash::Sha1);
+    }
+
+    bool VmfMapCache::store(const QString &mapPath, const QByteArray &entry) const
+    {
+        if ( !isEnabled() || entry.isEmpty() )
+        {
+            return false;
+        }
+
+        const QString path = entryPath(mapPath);
+        if ( !QDir().mkpath(m_strDirectory) )
+        {
+            qCWarning(lcVmfMapCache) << "Could not create cache directory" << m_strDirectory;
+            return false;
+        }
+
+        // Write to a temporary file first so that a partially written entry is never picked up.
+        QSaveFile file(path);
+        if ( !file.open(QIODevice::WriteOnly) ||
+             file.write(entry) != entry.length() ||
+             !file.commit() )
+        {
+            qCWarning(lcVmfMapCache) << "Could not write cache entry" << path << "-" << file.errorString();
+            return false;
+        }
+
+        return true;
+    }
+
+    void VmfMapCache::remove(const QString &mapPath) const
+    {
+        if ( isEnabled() )
+        {
+            QFile::remove(entryPath(mapPath));
+        }
+    }
+
+    VmfMapCacheWriter::VmfMapCacheWriter()
+        : m_Sections(SectionCount)
+    {
+    }
+
+    int VmfMapCacheWriter::objectCount() const
+    {
+        return elementCount(m_Sections.at(SectionObjects), SectionObjects);
+    }
+
+    quint32 VmfMapCacheWriter::addString(const QString &string)
+    {
+        QHash<QString, quint32>::const_iterator it = m_StringIndices.constFind(string);
+        if ( it != m_StringIndices.constEnd() )
+        {
+            return it.value();
+        }
+
+        QByteArray& data = m_Sections[SectionStringData];
+        const QByteArray utf8 = string.toUtf8();
+
+        StringEntry entry;
+        entry.offset = data.size();
+        entry.length = utf8.size();
+        data.append(utf8);
+
+        const quint32 index = append(m_Sections[SectionStrings], entry);
+        m_StringIndices.insert(string, index);
+        return index;
+    }
+
+    void VmfMapCacheWriter::addVisGroup(const Model::MapVisGroup &visGroup)
+    {
+        VisGroupRecord record;
+        record.id = visGroup.id;
+        record.parentId = visGroup.parentId;
+        record.name = addString(visGroup.name);
+        record.color = visGroup.color.rgba();
+        record.hasColor = visGroup.color.isValid() ? 1 : 0;
+
+        append(m_Sections[SectionVisGroups], record);
+    }
+
+    void VmfMapCacheWriter::addObject(const Model::SceneObject *object, quint32 type, quint32 dataIndex)
+    {
+        const Model::HierarchyState& hierarchy = object->hierarchy();
+        const QVector3D position = hierarchy.position();
+        const Model::EulerAngle rotation = hierarchy.rotation();
+
+        ObjectRecord record;
+        record.type = type;
+        record.parent = m_ObjectIndices.value(object->parentObject(), -1);
+        record.name = addString(object->objectName());
+        record.color = object->color().rgba();
+        record.position[0] = position.x();
+        record.position[1] = position.y();
+        record.position[2] = position.z();
+        record.rotation[0] = rotation.pitch();
+        record.rotation[1] = rotation.yaw();
+        record.rotation[2] = rotation.roll();
+        record.dataIndex = dataIndex;
+        record.flags = object->isHidden() ? HiddenObject : 0;
+
+        QList<int> visGroupIds;
+        const Model::MapScene* scene = qobject_cast<const Model::MapScene*>(object->parentScene());
+        if ( scene )
+        {
+            visGroupIds = scene->objectVisGroups(object);
+        }
+
+        QByteArray& visGroups = m_Sections[SectionObjectVisGroups];
+        record.visGroupBegin = elementCount(visGroups, SectionObjectVisGroups);
+        record.visGroupCount = visGroupIds.count();
+        foreach ( int id, visGroupIds )
+        {
+            append(visGroups, static_cast<qint32>(id));
+        }
+
+        m_ObjectIndices.insert(object, append(m_Sections[SectionObjects], record));
+    }
+
+    void VmfMapCacheWriter::addGroup(const Model::MapGroup *group)
+    {
+        GroupRecord record;
+        record.groupId = group->groupId();
+
+        addObject(group, GroupObject, append(m_Sections[SectionGroups], record));
+    }
+
+    void VmfMapCacheWriter::addEntity(const Model::MapEntity *entity)
+    {
+        QByteArray& pairs = m_Sections[SectionStringPairs];
+
+        EntityRecord record;
+        record.entityId = entity->entityId();
+        record.brushEntity = entity->isBrushEntity() ? 1 : 0;
+
+        const QMap<QString, QString> keyValues = entity->keyValues();
+        record.keyValueBegin = elementCount(pairs, SectionStringPairs);
+        record.keyValueCount = keyValues.count();
+        for ( QMap<QString, QString>::const_iterator it = keyValues.constBegin(); it != keyValues.constEnd(); ++it )
+        {
+            StringPairRecord pair;
+            pair.first = addString(it.key());
+            pair.second = addString(it.value());
+            append(pairs, pair);
+        }
+
+        const QList<Model::MapEntity::Output> outputs = entity->outputs();
+        record.outputBegin = elementCount(pairs, SectionStringPairs);
+        record.outputCount = outputs.count();
+        foreach ( const Model::MapEntity::Output& output, outputs )
+        {
+            StringPairRecord pair;
+            pair.first = addString(output.first);
+            pair.second = addString(output.second);
+            append(pairs, pair);
+        }
+
+        addObject(entity, EntityObject, append(m_Sections[SectionEntities], record));
+    }
+
+    void VmfMapCacheWriter::addBrush(const Model::GenericBrush *brush, const QStringList &faceMaterialPaths)
+    {
+        QByteArray& vertices = m_Sections[SectionVertices];
+        QByteArray& faces = m_Sections[SectionFaces];
+        QByteArray& indices = m_Sections[SectionIndices];
+
+        BrushRecord record;
+        record.vertexBegin = elementCount(vertices, SectionVertices);
+        record.vertexCount = brush->brushVertexCount();
+        record.faceBegin = elementCount(faces, SectionFaces);
+        record.faceCount = brush->brushFaceCount();
+
+        foreach ( const QVector3D& vertex, brush->brushVertexList() )
+        {
+            VertexRecord v = { vertex.x(), vertex.y(), vertex.z() };
+            append(vertices, v);
+        }
+
+        for ( int i = 0; i < brush->brushFaceCount(); ++i )
+        {
+            const Model::GenericBrushFace* face = brush->brushFaceAt(i);
+            const QVector<int> faceIndices = face->indexList();
+
+            FaceRecord faceRecord;
+            faceRecord.indexBegin = elementCount(indices, SectionIndices);
+            faceRecord.indexCount = faceIndices.count();
+            faceRecord.plane = texturePlaneRecord(face->texturePlane(), addString(faceMaterialPaths.value(i)));
+            append(faces, faceRecord);
+
+            foreach ( int index, faceIndices )
+            {
+                append(indices, static_cast<qint32>(index));
+            }
+        }
+
+        addObject(brush, BrushObject, append(m_Sections[SectionBrushes], record));
+    }
+
+    void VmfMapCacheWriter::addDisplacement(const Model::Displacement *displacement, const QString &materialPath)
+    {
+        QByteArray& vertices = m_Sections[SectionVertices];
+        QByteArray& alphas = m_Sections[SectionAlphas];
+        QByteArray& displacements = m_Sections[SectionDisplacements];
+
+        const QVector3D normal = displacement->faceNormal();
+
+        DisplacementRecord record;
+        record.power = displacement->power();
+        record.vertexBegin = elementCount(vertices, SectionVertices);
+        record.vertexCount = displacement->positions().count();
+        record.faceNormal[0] = normal.x();
+        record.faceNormal[1] = normal.y();
+        record.faceNormal[2] = normal.z();
+        record.alphaBegin = elementCount(alphas, SectionAlphas);
+        record.alphaCount = displacement->alphas().count();
+        record.plane = texturePlaneRecord(displacement->texturePlane(), addString(materialPath));
+
+        foreach ( const QVector3D& vertex, displacement->basePositions() )
+        {
+            VertexRecord v = { vertex.x(), vertex.y(), vertex.z() };
+            append(vertices, v);
+        }
+
+        foreach ( const QVector3D& vertex, displacement->positions() )
+        {
+            VertexRecord v = { vertex.x(), vertex.y(), vertex.z() };
+            append(vertices, v);
+        }
+
+        foreach ( float alpha, displacement->alphas() )
+        {
+            append(alphas, alpha);
+        }
+
+        addObject(displacement, DisplacementObject, append(displacements, record));
+    }
+
+    QByteArray VmfMapCacheWriter::serialise(const QByteArray &sourceHash, quint64 sourceSize, quint32 buildOptions) const
+    {
+        Q_ASSERT(sourceHash.size() == HASH_LENGTH);
+
+        EntryHeader header;
+        memset(&header, 0, sizeof(EntryHeader));
+        memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+        header.version = CACHE_VERSION;
+        header.sourceSize = sourceSize;
+        memcpy(header.sourceHash, sourceHash.constData(), qMin(sourceHash.size(), HASH_LENGTH));
+        header.buildOptions = buildOptions;
+
+        quint32 offset = align(sizeof(EntryHeader));
+        for ( int i = 0; i < SectionCount; ++i )
+        {
+            header.sections[i].offset = offset;
+            header.sections[i].count = elementCount(m_Sections.at(i), i);
+            offset = align(offset + m_Sections.at(i).size());
+        }
+
+        QByteArray entry(static_cast<int>(offset), '\0');
+        char* base = entry.data();
+
+        memcpy(base, &header, sizeof(EntryHeader));
+        for ( int i = 0; i < SectionCount; ++i )
+        {
+            memcpy(base + header.sections[i].offset, m_Sections.at(i).constData(), m_Sections.at(i).size());
+        }
+
+        return entry;
+    }
+
+    VmfMapCacheReader::VmfMapCacheReader()
+        : m_pData(Q_NULLPTR),
+          m_iLength(0)
+    {
+    }
+
+    VmfMapCacheReader::~VmfMapCacheReader()
+    {
+        close();
+    }
+
+    bool VmfMapCacheReader::open(const QString &entryPath, const QByteArray &sourceHash, quint64 sourceSize,
+                                 quint32 buildOptions, QString *errorHint)
+    {
+        close();
+
+        m_File.setFileName(entryPath);
+        if ( entryPath.isEmpty() || !m_File.exists() || !m_File.open(QIODevice::ReadOnly) )
+        {
+            setError(errorHint, "No cache entry.");
+            return false;
+        }
+
+        m_iLength = m_File.size();
+        m_pData = m_File.map(0, m_iLength);
+        if ( !m_pData )
+        {
+            setError(errorHint, QString("Could not map cache entry: %1").arg(m_File.errorString()));
+            m_File.close();
+            return false;
+        }
+
+        QString error;
+        EntryHeader header;
+        if ( m_iLength < static_cast<qint64>(sizeof(EntryHeader)) )
+        {
+            error = "Entry is truncated.";
+        }
+        else
+        {
+            memcpy(&header, m_pData, sizeof(EntryHeader));
+            if ( memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION )
+            {
+                error = "Entry has an unrecognised header.";
+            }
+            else if ( header.sourceSize != sourceSize || sourceHash.size() != HASH_LENGTH ||
+                      memcmp(header.sourceHash, sourceHash.constData(), HASH_LENGTH) != 0 )
+            {
+                // Not corrupt, just stale; it'll be replaced when the map is next loaded.
+                setError(errorHint, "Entry does not match the map file.");
+                close();
+                return false;
+            }
+            else
+            {
+                validate(buildOptions, &error);
+            }
+        }
+
+        if ( !error.isEmpty() )
+        {
+            qCWarning(lcVmfMapCache) << "Removing invalid cache entry" << entryPath << "-" << error;
+            setError(errorHint, error);
+            close();
+            QFile::remove(entryPath);
+            return false;
+        }
+
+        m_Objects.resize(objectCount());
+        return true;
+    }
+
+    void VmfMapCacheReader::close()
+    {
+        if ( m_pData )
+        {
+            m_File.unmap(m_pData);
+            m_pData = Q_NULLPTR;
+        }
+
+        m_File.close();
+        m_iLength = 0;
+        m_Objects.clear();
+        m_MaterialIds.clear();
+    }
+
+    bool VmfMapCacheReader::isOpen() const
+    {
+        return m_pData != Q_NULLPTR;
+    }
+
+    const uchar* VmfMapCacheReader::section(int section, quint32 *count) const
+    {
+        const EntryHeader* header = reinterpret_cast<const EntryHeader*>(m_pData);
+        if ( count )
+        {
+            *count = header->sections[section].count;
+        }
+
+        return m_pData + header->sections[section].offset;
+    }
+
+    bool VmfMapCacheReader::validate(quint32 buildOptions, QString *errorHint) const
+    {
+        const EntryHeader* header = reinterpret_cast<const EntryHeader*>(m_pData);
+
+        // Eg. brushes clipped at a different precision have different vertices.
+        if ( header->buildOptions != buildOptions )
+        {
+            setError(errorHint, "Entry was built with different loader options.");
+            return false;
+        }
+
+        for ( int i = 0; i < SectionCount; ++i )
+        {
+            const SectionEntry& entry = header->sections[i];
+            if ( entry.offset % SECTION_ALIGNMENT != 0 || entry.offset < sizeof(EntryHeader) ||
+                 static_cast<qint64>(entry.offset) + (static_cast<qint64>(entry.count) * SECTION_ELEMENT_SIZES[i]) > m_iLength )
+            {
+                setError(errorHint, QString("Section %1 is out of range.").arg(i));
+                return false;
+            }
+        }
+
+        quint32 stringCount = 0, stringDataSize = 0;
+        const StringEntry* strings = records<StringEntry>(section(SectionStrings, &stringCount));
+        section(SectionStringData, &stringDataSize);
+        for ( quint32 i = 0; i < stringCount; ++i )
+        {
+            if ( !inRange(strings[i].offset, strings[i].length, stringDataSize) )
+            {
+                setError(errorHint, QString("String %1 is out of range.").arg(i));
+                return false;
+            }
+        }
+
+        quint32 visGroupCount = 0;
+        const VisGroupRecord* visGroups = records<VisGroupRecord>(section(SectionVisGroups, &visGroupCount));
+        for ( quint32 i = 0; i < visGroupCount; ++i )
+        {
+            if ( visGroups[i].name >= stringCount )
+            {
+                setError(errorHint, QString("Visgroup %1 is invalid.").arg(i));
+                return false;
+            }
+        }
+
+        quint32 pairCount = 0, indexCount = 0, vertexCount = 0, alphaCount = 0, faceCount = 0, objectVisGroupCount = 0;
+        const StringPairRecord* pairs = records<StringPairRecord>(section(SectionStringPairs, &pairCount));
+        const qint32* indices = records<qint32>(section(SectionIndices, &indexCount));
+        const FaceRecord* faces = records<FaceRecord>(section(SectionFaces, &faceCount));
+        section(SectionVertices, &vertexCount);
+        section(SectionAlphas, &alphaCount);
+        section(SectionObjectVisGroups, &objectVisGroupCount);
+
+        for ( quint32 i = 0; i < pairCount; ++i )
+        {
+            if ( pairs[i].first >= stringCount || pairs[i].second >= stringCount )
+            {
+                setError(errorHint, QString("String pair %1 is invalid.").arg(i));
+                return false;
+            }
+        }
+
+        quint32 groupCount = 0, entityCount = 0, brushCount = 0, displacementCount = 0, objectCount = 0;
+        section(SectionGroups, &groupCount);
+        const EntityRecord* entities = records<EntityRecord>(section(SectionEntities, &entityCount));
+        const BrushRecord* brushes = records<BrushRecord>(section(SectionBrushes, &brushCount));
+        const DisplacementRecord* displacements = records<DisplacementRecord>(section(SectionDisplacements, &displacementCount));
+        const ObjectRecord* objects = records<ObjectRecord>(section(SectionObjects, &objectCount));
+
+        for ( quint32 i = 0; i < objectCount; ++i )
+        {
+            const ObjectRecord& object = objects[i];
+            bool valid = object.parent < static_cast<qint32>(i) && object.parent >= -1 &&
+                    object.name < stringCount &&
+                    inRange(object.visGroupBegin, object.visGroupCount, objectVisGroupCount);
+
+            if ( valid )
+            {
+                switch ( object.type )
+                {
+                    case GroupObject:
+                    {
+                        valid = object.dataIndex < groupCount;
+                        break;
+                    }
+
+                    case EntityObject:
+                    {
+                        valid = object.dataIndex < entityCount;
+                        if ( !valid )
+                            break;
+
+                        const EntityRecord& entity = entities[object.dataIndex];
+                        valid = inRange(entity.keyValueBegin, entity.keyValueCount, pairCount) &&
+                                inRange(entity.outputBegin, entity.outputCount, pairCount);
+                        break;
+                    }
+
+                    case BrushObject:
+                    {
+                        valid = object.dataIndex < brushCount;
+                        if ( !valid )
+                            break;
+
+                        const BrushRecord& brush = brushes[object.dataIndex];
+                        valid = inRange(brush.vertexBegin, brush.vertexCount, vertexCount) &&
+                                inRange(brush.faceBegin, brush.faceCount, faceCount);
+
+                        for ( quint32 f = brush.faceBegin; valid && f < brush.faceBegin + brush.faceCount; ++f )
+                        {
+                            valid = faces[f].plane.material < stringCount &&
+                                    inRange(faces[f].indexBegin, faces[f].indexCount, indexCount);
+
+                            for ( quint32 n = faces[f].indexBegin; valid && n < faces[f].indexBegin + faces[f].indexCount; ++n )
+                            {
+                                valid = indices[n] >= 0 && static_cast<quint32>(indices[n]) < brush.vertexCount;
+                            }
+                        }
+
+                        break;
+                    }
+
+                    case DisplacementObject:
+                    {
+                        valid = object.dataIndex < displacementCount;
+                        if ( !valid )
+                            break;
+
+                        const DisplacementRecord& displacement = displacements[object.dataIndex];
+                        valid = displacement.power >= 1 && displacement.power <= Model::Displacement::maxPower();
+                        if ( !valid )
+                            break;
+
+                        // Base positions are followed by the displaced positions. Alphas are optional.
+                        const quint32 side = static_cast<quint32>(Model::Displacement::verticesPerSide(displacement.power));
+                        valid = displacement.plane.material < stringCount &&
+                                displacement.vertexCount == side * side &&
+                                displacement.vertexCount <= vertexCount / 2 &&
+                                inRange(displacement.vertexBegin, displacement.vertexCount * 2, vertexCount) &&
+                                (displacement.alphaCount == 0 || displacement.alphaCount == displacement.vertexCount) &&
+                                inRange(displacement.alphaBegin, displacement.alphaCount, alphaCount);
+                        break;
+                    }
+
+                    default:
+                    {
+                        valid = false;
+                        break;
+                    }
+                }
+            }
+
+            if ( !valid )
+            {
+                setError(errorHint, QString("Object %1 is invalid.").arg(i));
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    int VmfMapCacheReader::objectCount() const
+    {
+        if ( !m_pData )
+        {
+            return 0;
+        }
+
+        quint32 count = 0;
+        section(SectionObjects, &count);
+        return static_cast<int>(count);
+    }
+
+    QString VmfMapCacheReader::string(quint32 index) const
+    {
+        const StringEntry& entry = records<StringEntry>(section(SectionStrings))[index];
+        const char* data = reinterpret_cast<const char*>(section(SectionStringData));
+        return QString::fromUtf8(data + entry.offset, entry.length);
+    }
+
+    quint32 VmfMapCacheReader::materialId(quint32 stringIndex)
+    {
+        QHash<quint32, quint32>::const_iterator it = m_MaterialIds.constFind(stringIndex);
+        if ( it != m_MaterialIds.constEnd() )
+        {
+            return it.value();
+        }
+
+        Model::MaterialStore* materialStore = Model::ResourceEnvironment::globalInstance()->materialStore();
+        const quint32 id = materialStore->getMaterialId(string(stringIndex));
+        m_MaterialIds.insert(stringIndex, id);
+        return id;
+    }
+
+    void VmfMapCacheReader::restoreTexturePlane(const void *record, Model::TexturePlane *plane)
+    {
+        TexturePlaneRecord planeRecord;
+        memcpy(&planeRecord, record, sizeof(TexturePlaneRecord));
+
+        plane->setMaterialId(materialId(planeRecord.material));
+        plane->setScale(QVector2D(planeRecord.scale[0], planeRecord.scale[1]));
+        plane->setTranslation(QVector2D(planeRecord.translation[0], planeRecord.translation[1]));
+        plane->setRotation(planeRecord.rotation);
+    }
+
+    void VmfMapCacheReader::restoreVisGroups(Model::MapScene *scene) const
+    {
+        quint32 count = 0;
+        const VisGroupRecord* visGroups = records<VisGroupRecord>(section(SectionVisGroups, &count));
+
+        for ( quint32 i = 0; i < count; ++i )
+        {
+            const VisGroupRecord& record = visGroups[i];
+            const QColor color = record.hasColor ? QColor::fromRgba(record.color) : QColor();
+            scene->addVisGroup(Model::MapVisGroup(record.id, record.parentId, string(record.name), color));
+        }
+    }
+
+    Model::SceneObject* VmfMapCacheReader::restoreObject(Model::MapScene *scene, int index)
+    {
+        using namespace Model;
+
+        Q_ASSERT(index >= 0 && index < m_Objects.count());
+
+        const ObjectRecord& record = records<ObjectRecord>(section(SectionObjects))[index];
+        SceneObject* parent = record.parent >= 0 ? m_Objects.at(record.parent) : Q_NULLPTR;
+        if ( !parent )
+        {
+            parent = scene->rootObject();
+        }
+
+        SceneObject* object = Q_NULLPTR;
+
+        switch ( record.type )
+        {
+            case GroupObject:
+            {
+                const GroupRecord& group = records<GroupRecord>(section(SectionGroups))[record.dataIndex];
+
+                MapGroup* mapGroup = scene->createSceneObject<MapGroup>(parent);
+                mapGroup->setGroupId(group.groupId);
+                object = mapGroup;
+                break;
+            }
+
+            case EntityObject:
+            {
+                const EntityRecord& entity = records<EntityRecord>(section(SectionEntities))[record.dataIndex];
+                const StringPairRecord* pairs = records<StringPairRecord>(section(SectionStringPairs));
+
+                MapEntity* mapEntity = scene->createSceneObject<MapEntity>(parent);
+                mapEntity->setEntityId(entity.entityId);
+                mapEntity->setBrushEntity(entity.brushEntity != 0);
+
+                for ( quint32 i = entity.keyValueBegin; i < entity.keyValueBegin + entity.keyValueCount; ++i )
+                {
+                    mapEntity->setKeyValue(string(pairs[i].first), string(pairs[i].second));
+                }
+
+                QList<MapEntity::Output> outputs;
+                for ( quint32 i = entity.outputBegin; i < entity.outputBegin + entity.outputCount; ++i )
+                {
+                    outputs.append(MapEntity::Output(string(pairs[i].first), string(pairs[i].second)));
+                }
+
+                mapEntity->setOutputs(outputs);
+                object = mapEntity;
+                break;
+            }
+
+            case BrushObject:
+            {
+                const BrushRecord& brush = records<BrushRecord>(section(SectionBrushes))[record.dataIndex];
+                const VertexRecord* vertices = records<VertexRecord>(section(SectionVertices)) + brush.vertexBegin;
+                const FaceRecord* faces = records<FaceRecord>(section(SectionFaces)) + brush.faceBegin;
+                const qint32* indices = records<qint32>(section(SectionIndices));
+
+                GenericBrush* genericBrush = scene->createSceneObject<GenericBrush>(parent);
+
+                QVector<QVector3D> brushVertices(brush.vertexCount);
+                for ( quint32 i = 0; i < brush.vertexCount; ++i )
+                {
+                    brushVertices[i] = QVector3D(vertices[i].x, vertices[i].y, vertices[i].z);
+                }
+
+                genericBrush->appendBrushVertices(brushVertices);
+
+                for ( quint32 i = 0; i < brush.faceCount; ++i )
+                {
+                    GenericBrushFace* face = genericBrush->createAndObtainBrushFace();
+                    restoreTexturePlane(&faces[i].plane, face->texturePlane());
+
+                    QVector<int> faceIndices(faces[i].indexCount);
+                    for ( quint32 n = 0; n < faces[i].indexCount; ++n )
+                    {
+                        faceIndices[n] = indices[faces[i].indexBegin + n];
+                    }
+
+                    face->appendIndices(faceIndices);
+                }
+
+                object = genericBrush;
+                break;
+            }
+
+            case DisplacementObject:
+            {
+                const DisplacementRecord& displacement = records<DisplacementRecord>(section(SectionDisplacements))[record.dataIndex];
+                const VertexRecord* vertices = records<VertexRecord>(section(SectionVertices)) + displacement.vertexBegin;
+                const float* alphas = records<float>(section(SectionAlphas)) + displacement.alphaBegin;
+
+                QVector<QVector3D> basePositions(displacement.vertexCount);
+                QVector<QVector3D> positions(displacement.vertexCount);
+                for ( quint32 i = 0; i < displacement.vertexCount; ++i )
+                {
+                    const VertexRecord& base = vertices[i];
+                    const VertexRecord& displaced = vertices[displacement.vertexCount + i];
+                    basePositions[i] = QVector3D(base.x, base.y, base.z);
+                    positions[i] = QVector3D(displaced.x, displaced.y, displaced.z);
+                }
+
+                QVector<float> alphaValues(displacement.alphaCount);
+                for ( quint32 i = 0; i < displacement.alphaCount; ++i )
+                {
+                    alphaValues[i] = alphas[i];
+                }
+
+                Displacement* surface = scene->createSceneObject<Displacement>(parent);
+                if ( !surface->setSurface(displacement.power, basePositions, positions,
+                                          QVector3D(displacement.faceNormal[0], displacement.faceNormal[1], displacement.faceNormal[2])) )
+                {
+                    scene->destroySceneObject(surface);
+                    return Q_NULLPTR;
+                }
+
+                surface->setAlphas(alphaValues);
+                restoreTexturePlane(&displacement.plane, surface->texturePlane());
+                object = surface;
+                break;
+            }
+
+            default:
+            {
+                // Ruled out by validate().
+                Q_ASSERT(false);
+                return Q_NULLPTR;
+            }
+        }
+
+        object->setObjectName(string(record.name));
+        object->setColor(QColor::fromRgba(record.color));
+        object->setHidden((record.flags & HiddenObject) == HiddenObject);
+        object->hierarchy().setPosition(QVector3D(record.position[0], record.position[1], record.position[2]));
+        object->hierarchy().setRotation(EulerAngle(record.rotation[0], record.rotation[1], record.rotation[2]));
+
+        const qint32* visGroupIds = records<qint32>(section(SectionObjectVisGroups)) + record.visGroupBegin;
+        for ( quint32 i = 0; i < record.visGroupCount; ++i )
+        {
+            scene->addObjectToVisGroup(object, visGroupIds[i]);
+        }
+
+        m_Objects[index] = object;
+        return object;
+    }
+
+    void VmfMapCacheReader::destroyRestoredObjects(Model::MapScene *scene)
+    {
+        const ObjectRecord* objects = m_Objects.isEmpty() ? Q_NULLPTR : records<ObjectRecord>(section(SectionObjects));
+
+        // Children are destroyed along with their parents.
+        for ( int i = 0; i < m_Objects.count(); ++i )
+        {
+            if ( m_Objects.at(i) && objects[i].parent < 0 )
+            {
+                scene->destroySceneObject(m_Objects.at(i));
+            }
+        }
+
+        m_Objects.fill(Q_NULLPTR);
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef VMFMAPCACHE_H
+#define VMFMAPCACHE_H
+
+#include "model-loaders_global.h"
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Model
+{
+    class MapScene;
+    class SceneObject;
+    class MapGroup;
+    class MapEntity;
+    class GenericBrush;
+    class Displacement;
+    class TexturePlane;
+    struct MapVisGroup;
+}
+
+namespace ModelLoaders
+{
+    Q_DECLARE_LOGGING_CATEGORY(lcVmfMapCache)
+
+    // On-disk snapshot of the scene built from a VMF, so that re-opening an unchanged map
+    // needs neither the keyvalues parser nor any brush clipping. Clipped brush vertices,
+    // face indices, texture planes and material paths are held in flat arrays, which are
+    // read in place from the mapped entry. Entries are found by the map's path, and are
+    // only used if the SHA-1 and size of the map recorded in them match the map on disk,
+    // and they were built with the same loader options.
+    class MODELLOADERSSHARED_EXPORT VmfMapCache
+    {
+    public:
+        // An empty directory disables the cache.
+        explicit VmfMapCache(const QString& directory = QString());
+
+        static QString defaultDirectory();
+
+        QString directory() const;
+        void setDirectory(const QString& directory);
+        bool isEnabled() const;
+
+        QString entryPath(const QString& mapPath) const;
+
+        static QByteArray hashSource(const QByteArray& mapData);
+
+        // Writes an entry produced by VmfMapCacheWriter for this map.
+        // Failing to write the entry is not an error.
+        bool store(const QString& mapPath, const QByteArray& entry) const;
+
+        // Removes the entry for this map, if there is one.
+        void remove(const QString& mapPath) const;
+
+    private:
+        QString m_strDirectory;
+    };
+
+    // Records objects as they are added to the scene, to build a cache entry.
+    // Objects must be added after their parents, once their properties are final.
+    // Objects whose parents were not added are restored under the root object.
+    class MODELLOADERSSHARED_EXPORT VmfMapCacheWriter
+    {
+    public:
+        VmfMapCacheWriter();
+
+        void addVisGroup(const Model::MapVisGroup& visGroup);
+        void addGroup(const Model::MapGroup* group);
+        void addEntity(const Model::MapEntity* entity);
+
+        // One material path for each face of the brush; missing paths are left empty.
+        void addBrush(const Model::GenericBrush* brush, const QStringList& faceMaterialPaths);
+        void addDisplacement(const Model::Displacement* displacement, const QString& materialPath);
+
+        int objectCount() const;
+
+        // Build options are the loader settings that affect the scene built from a map,
+        // such as the brush clipping precision, packed into a single value by the loader.
+        QByteArray serialise(const QByteArray& sourceHash, quint64 sourceSize, quint32 buildOptions) const;
+
+    private:
+        quint32 addString(const QString& string);
+        void addObject(const Model::SceneObject* object, quint32 type, quint32 dataIndex);
+
+        QVector<QByteArray> m_Sections;
+        QHash<QString, quint32> m_StringIndices;
+        QHash<const Model::SceneObject*, qint32> m_ObjectIndices;
+    };
+
+    // Restores the scene recorded in a cache entry, one object at a time.
+    class MODELLOADERSSHARED_EXPORT VmfMapCacheReader
+    {
+    public:
+        VmfMapCacheReader();
+        ~VmfMapCacheReader();
+
+        // Maps the entry and checks that it is well formed and was written for a map
+        // with this hash and size, with the same build options. Invalid entries are removed.
+        bool open(const QString& entryPath, const QByteArray& sourceHash, quint64 sourceSize,
+                  quint32 buildOptions, QString* errorHint = Q_NULLPTR);
+        void close();
+        bool isOpen() const;
+
+        int objectCount() const;
+
+        void restoreVisGroups(Model::MapScene* scene) const;
+
+        // Objects must be restored in order, starting from 0.
+        // Returns null if the object's data turns out to be corrupt.
+        Model::SceneObject* restoreObject(Model::MapScene* scene, int index);
+
+        // Removes every object restored so far from the scene.
+        void destroyRestoredObjects(Model::MapScene* scene);
+
+    private:
+        bool validate(quint32 buildOptions, QString* errorHint) const;
+        const uchar* section(int section, quint32* count = Q_NULLPTR) const;
+        QString string(quint32 index) const;
+        quint32 materialId(quint32 stringIndex);
+        void restoreTexturePlane(const void* record, Model::TexturePlane* plane);
+
+        QFile m_File;
+        uchar* m_pData;
+        qint64 m_iLength;
+        QVector<Model::SceneObject*> m_Objects;
+        QHash<quint32, quint32> m_MaterialIds;
+    };
+}
+
+#endif // VMFMAPCACHE_H
@@ -0,0 +1,365 @@
+#include "vmfplaneparser.h"
+#include <cfloat>
+#include <QtMath>
+
+namespace ModelLoaders
+{
+    namespace
+    {
+        // Integers up to 2^53 and powers of ten up to 10^22 are exact in a double,
+        // so a single multiply or divide gives a correctly rounded result.
+        const quint64 MAX_EXACT_MANTISSA = Q_UINT64_C(1) << 53;
+        const int MAX_EXACT_EXPONENT = 22;
+        const int MAX_MANTISSA_DIGITS = 19;
+
+        // Longest number handed to the slow path.
+        const int MAX_NUMBER_LENGTH = 63;
+
+        const double POWERS_OF_TEN[MAX_EXACT_EXPONENT + 1] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+            1e21, 1e22
+        };
+
+        // Non-ASCII characters are never valid, so map them to 0.
+        inline char toAscii(char ch)
+        {
+            return ch;
+        }
+
+        inline char toAscii(QChar ch)
+        {
+            return ch.unicode() < 0x80 ? static_cast<char>(ch.unicode()) : '\0';
+        }
+
+        inline bool isDigit(char ch)
+        {
+            return ch >= '0' && ch <= '9';
+        }
+
+        inline bool isWhitespace(char ch)
+        {
+            return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+        }
+
+        template<typename CharT>
+        class PlaneReader
+        {
+        public:
+            PlaneReader(const CharT* begin, const CharT* end, QString* errorHint)
+                : m_pBegin(begin), m_pCursor(begin), m_pEnd(end), m_pErrorHint(errorHint)
+            {
+            }
+
+            bool readPoint(QVector3D& point)
+            {
+                float x = 0, y = 0, z = 0;
+
+                if ( !readOpeningBracket() || !readFloat(x) || !readFloat(y) || !readFloat(z) || !readClosingBracket() )
+                    return false;
+
+                point = QVector3D(x, y, z);
+                return true;
+            }
+
+            bool readPoint(Model::DoubleVector3D& point)
+            {
+                double x = 0, y = 0, z = 0;
+
+                if ( !readOpeningBracket() || !readDouble(x) || !readDouble(y) || !readDouble(z) || !readClosingBracket() )
+                    return false;
+
+                point = Model::DoubleVector3D(x, y, z);
+                return true;
+            }
+
+            bool atEnd()
+            {
+                skipWhitespace();
+                if ( m_pCursor != m_pEnd )
+                {
+                    return fail("Unexpected characters after the third point");
+                }
+
+                return true;
+            }
+
+        private:
+            char current() const
+            {
+                return m_pCursor < m_pEnd ? toAscii(*m_pCursor) : '\0';
+            }
+
+            void skipWhitespace()
+            {
+                while ( m_pCursor < m_pEnd && isWhitespace(toAscii(*m_pCursor)) )
+                {
+                    ++m_pCursor;
+                }
+            }
+
+            bool expect(char ch)
+            {
+                if ( current() != ch )
+                {
+                    return fail(QString("Expected '%1'").arg(ch));
+                }
+
+                ++m_pCursor;
+                return true;
+            }
+
+            bool readOpeningBracket()
+            {
+                skipWhitespace();
+                return expect('(');
+            }
+
+            bool readClosingBracket()
+            {
+                skipWhitespace();
+                return expect(')');
+            }
+
+            bool readFloat(float& value)
+            {
+                double result = 0.0;
+                if ( !readDouble(result) )
+                    return false;
+
+                if ( result > FLT_MAX || result < -FLT_MAX )
+                {
+                    return fail("Number is out of range");
+                }
+
+                value = static_cast<float>(result);
+                return true;
+            }
+
+            bool readDouble(double& value)
+            {
+                skipWhitespace();
+
+                const CharT* start = m_pCursor;
+                bool negative = false;
+
+                if ( current() == '-' || current() == '+' )
+                {
+                    negative = current() == '-';
+                    ++m_pCursor;
+                }
+
+                quint64 mantissa = 0;
+                int mantissaDigits = 0;
+                int exponent = 0;
+                bool anyDigits = false;
+                bool exact = true;
+
+                for ( ; isDigit(current()); ++m_pCursor )
+                {
+                    anyDigits = true;
+                    accumulateDigit(current() - '0', mantissa, mantissaDigits, exact, exponent, false);
+                }
+
+                if ( current() == '.' )
+                {
+                    ++m_pCursor;
+                    for ( ; isDigit(current()); ++m_pCursor )
+                    {
+                        anyDigits = true;
+                        accumulateDigit(current() - '0', mantissa, mantissaDigits, exact, exponent, true);
+                    }
+                }
+
+                if ( !anyDigits )
+                {
+                    m_pCursor = start;
+                    return fail("Expected a number");
+                }
+
+                if ( current() == 'e' || current() == 'E' )
+                {
+                    ++m_pCursor;
+
+                    bool negativeExponent = false;
+                    if ( current() == '-' || current() == '+' )
+                    {
+                        negativeExponent = current() == '-';
+                        ++m_pCursor;
+                    }
+
+                    if ( !isDigit(current()) )
+                    {
+                        return fail("Expected an exponent");
+                    }
+
+                    int explicitExponent = 0;
+                    for ( ; isDigit(current()); ++m_pCursor )
+                    {
+                        // Anything this large is out of range anyway.
+                        if ( explicitExponent < 10000 )
+                        {
+                            explicitExponent = (explicitExponent * 10) + (current() - '0');
+                        }
+                    }
+
+                    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+                }
+
+                // Numbers must be separated from what follows.
+                if ( m_pCursor < m_pEnd && !isWhitespace(current()) && current() != ')' )
+                {
+                    return fail("Unexpected character in number");
+                }
+
+                double result = 0.0;
+                if ( exact && mantissa <= MAX_EXACT_MANTISSA &&
+                     exponent >= -MAX_EXACT_EXPONENT && exponent <= MAX_EXACT_EXPONENT )
+                {
+                    result = static_cast<double>(mantissa);
+                    result = exponent < 0 ? result / POWERS_OF_TEN[-exponent] : result * POWERS_OF_TEN[exponent];
+                    if ( negative )
+                    {
+                        result = -result;
+                    }
+                }
+                else if ( !slowParse(start, m_pCursor, result) )
+                {
+                    return fail("Number could not be converted");
+                }
+
+                if ( !qIsFinite(result) )
+                {
+                    return fail("Number is out of range");
+                }
+
+                value = result;
+                return true;
+            }
+
+            static void accumulateDigit(int digit, quint64& mantissa, int& mantissaDigits,
+                                        bool& exact, int& exponent, bool fractional)
+            {
+                // Leading zeroes don't count towards the precision.
+                if ( mantissa == 0 && digit == 0 )
+                {
+                    if ( fractional )
+                    {
+                        --exponent;
+                    }
+
+                    return;
+                }
+
+                if ( mantissaDigits < MAX_MANTISSA_DIGITS )
+                {
+                    mantissa = (mantissa * 10) + digit;
+                    ++mantissaDigits;
+
+                    if ( fractional )
+                    {
+                        --exponent;
+                    }
+
+                    return;
+                }
+
+                // Digits beyond what the mantissa holds are handled by the slow path.
+                exact = false;
+                if ( !fractional )
+                {
+                    ++exponent;
+                }
+            }
+
+            // For numbers with too many digits or a large exponent.
+            static bool slowParse(const CharT* begin, const CharT* end, double& result)
+            {
+                const int length = static_cast<int>(end - begin);
+                if ( length > MAX_NUMBER_LENGTH )
+                {
+                    return false;
+                }
+
+                char buffer[MAX_NUMBER_LENGTH + 1];
+                for ( int i = 0; i < length; ++i )
+                {
+                    buffer[i] = toAscii(begin[i]);
+                }
+
+                buffer[length] = '\0';
+
+                bool ok = false;
+                result = QByteArray::fromRawData(buffer, length).toDouble(&ok);
+                return ok;
+            }
+
+            bool fail(const QString& error)
+            {
+                if ( m_pErrorHint )
+                {
+                    *m_pErrorHint = QString("%1 at position %2.").arg(error).arg(m_pCursor - m_pBegin);
+                }
+
+                return false;
+            }
+
+            const CharT* m_pBegin;
+            const CharT* m_pCursor;
+            const CharT* m_pEnd;
+            QString* m_pErrorHint;
+        };
+
+        template<typename CharT, typename VectorT>
+        bool parsePlane(const CharT* begin, const CharT* end, VectorT& v0, VectorT& v1, VectorT& v2, QString* errorHint)
+        {
+            PlaneReader<CharT> reader(begin, end, errorHint);
+            return reader.readPoint(v0) && reader.readPoint(v1) && reader.readPoint(v2) && reader.atEnd();
+        }
+    }
+
+    bool VmfPlaneParser::parse(const char *begin, const char *end, QVector3D &v0, QVector3D &v1, QVector3D &v2, QString *errorHint)
+    {
+        return parsePlane(begin, end, v0, v1, v2, errorHint);
+    }
+
+    bool VmfPlaneParser::parse(const QChar *begin, const QChar *end, QVector3D &v0, QVector3D &v1, QVector3D &v2, QString *errorHint)
+    {
+        return parsePlane(begin, end, v0, v1, v2, errorHint);
+    }
+
+    bool VmfPlaneParser::parse(const QByteArray &plane, QVector3D &v0, QVector3D &v1, QVector3D &v2, QString *errorHint)
+    {
+        return parsePlane(plane.constData(), plane.constData() + plane.size(), v0, v1, v2, errorHint);
+    }
+
+    bool VmfPlaneParser::parse(const QString &plane, QVector3D &v0, QVector3D &v1, QVector3D &v2, QString *errorHint)
+    {
+        return parsePlane(plane.constData(), plane.constData() + plane.size(), v0, v1, v2, errorHint);
+    }
+
+    bool VmfPlaneParser::parse(const char *begin, const char *end, Model::DoubleVector3D &v0, Model::DoubleVector3D &v1,
+                               Model::DoubleVector3D &v2, QString *errorHint)
+    {
+        return parsePlane(begin, end, v0, v1, v2, errorHint);
+    }
+
+    bool VmfPlaneParser::parse(const QChar *begin, const QChar *end, Model::DoubleVector3D &v0, Model::DoubleVector3D &v1,
+                               Model::DoubleVector3D &v2, QString *errorHint)
+    {
+        return parsePlane(begin, end, v0, v1, v2, errorHint);
+    }
+
+    bool VmfPlaneParser::parse(const QByteArray &plane, Model::DoubleVector3D &v0, Model::DoubleVector3D &v1,
+                               Model::DoubleVector3D &v2, QString *errorHint)
+    {
+        return parsePlane(plane.constData(), plane.constData() + plane.size(), v0, v1, v2, errorHint);
+    }
+
+    bool VmfPlaneParser::parse(const QString &plane, Model::DoubleVector3D &v0, Model::DoubleVector3D &v1,
+                               Model::DoubleVector3D &v2, QString *errorHint)
+    {
+        return parsePlane(plane.constData(), plane.constData() + plane.size(), v0, v1, v2, errorHint);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef VMFPLANEPARSER_H
+#define VMFPLANEPARSER_H
+
+#include "model-loaders_global.h"
+#include <QVector3D>
+#include <QString>
+#include <QByteArray>
+#include "model/math/doublevector3d.h"
+
+namespace ModelLoaders
+{
+    // Parses the three points in the "plane" value of a VMF side, which has the form
+    // "(x y z) (x y z) (x y z)". Numbers are read straight from the characters, in the
+    // C locale, without building intermediate strings. Any amount of whitespace is
+    // accepted between tokens.
+    class MODELLOADERSSHARED_EXPORT VmfPlaneParser
+    {
+    public:
+        // On failure the output vectors are left in an unspecified state.
+        static bool parse(const char* begin, const char* end,
+                          QVector3D& v0, QVector3D& v1, QVector3D& v2, QString* errorHint = Q_NULLPTR);
+        static bool parse(const QChar* begin, const QChar* end,
+                          QVector3D& v0, QVector3D& v1, QVector3D& v2, QString* errorHint = Q_NULLPTR);
+
+        static bool parse(const QByteArray& plane, QVector3D& v0, QVector3D& v1, QVector3D& v2, QString* errorHint = Q_NULLPTR);
+        static bool parse(const QString& plane, QVector3D& v0, QVector3D& v1, QVector3D& v2, QString* errorHint = Q_NULLPTR);
+
+        // As above, but without narrowing to float, so that off-grid points keep all of their precision.
+        static bool parse(const char* begin, const char* end, Model::DoubleVector3D& v0, Model::DoubleVector3D& v1,
+                          Model::DoubleVector3D& v2, QString* errorHint = Q_NULLPTR);
+        static bool parse(const QChar* begin, const QChar* end, Model::DoubleVector3D& v0, Model::DoubleVector3D& v1,
+                          Model::DoubleVector3D& v2, QString* errorHint = Q_NULLPTR);
+
+        static bool parse(const QByteArray& plane, Model::DoubleVector3D& v0, Model::DoubleVector3D& v1,
+                          Model::DoubleVector3D& v2, QString* errorHint = Q_NULLPTR);
+        static bool parse(const QString& plane, Model::DoubleVector3D& v0, Model::DoubleVector3D& v1,
+                          Model::DoubleVector3D& v2, QString* errorHint = Q_NULLPTR);
+
+    private:
+        VmfPlaneParser() = delete;
+    };
+}
+
+#endif // VMFPLANEPARSER_H
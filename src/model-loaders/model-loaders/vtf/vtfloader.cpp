@@ -11,19 +11,18 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include "file-formats/keyvalues/keyvaluesparser.h"
-#include "VTFLib/src/VTFFile.h"
-#include <QOpenGLPixelTransferOptions>
-#include "VTFLib/src/VTFLib.h"
+#include <QtConcurrent>
+#include <QMap>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <algorithm>
 
 namespace ModelLoaders
 {
+    Q_LOGGING_CATEGORY(lcVTFLoader, "ModelLoaders.VTFLoader")
+
     namespace
     {
-        inline bool noCaseCompare(const QString& a, const QString& b)
-        {
-            return a.compare(b, Qt::CaseInsensitive) == 0;
-        }
-
         QString materialPath(const FileFormats::VPKIndexTreeRecordPointer& record)
         {
             QString matPath = (record->path() + "/" + record->fileName()).toLower();
@@ -35,82 +34,77 @@ namespace ModelLoaders
             return matPath;
         }
 
-        bool setTextureFormat(Renderer::OpenGLTexturePointer& texture, VTFImageFormat format)
-        {
-            switch (format)
-            {
-                case IMAGE_FORMAT_DXT1:
-                texture->setFormat(QOpenGLTexture::RGBA_DXT1);
-                break;
-
-                case IMAGE_FORMAT_DXT3:
-                texture->setFormat(QOpenGLTexture::RGBA_DXT3);
-                break;
-
-                case IMAGE_FORMAT_DXT5:
-                texture->setFormat(QOpenGLTexture::RGBA_DXT5);
-                break;
-
-//                case IMAGE_FORMAT_RGBA8888:
-//                texture->setFormat(QOpenGLTexture::QOpenGLTexture::RGBA32U);
-//                break;
-
-            default:
-                return false;
-            }
-
-            return true;
-        }
-
-        bool loadVtf(const QByteArray& vtfData, Renderer::OpenGLTexturePointer& texture)
+        // Textures can only share an array if all of these match.
+        struct TextureArrayKey
         {
-            VTFLib::CVTFFile vtfFile;
-            if ( !vtfFile.Load(static_cast<const vlVoid*>(vtfData.constData()), vtfData.length(), false) )
+            explicit TextureArrayKey(const VTFTextureCache::EntryDescription& desc)
+                : format(desc.format), width(desc.width), height(desc.height), mipCount(desc.mipCount)
             {
-                return false;
             }
 
-            if ( !setTextureFormat(texture, vtfFile.GetFormat()) )
+            bool operator <(const TextureArrayKey& other) const
             {
-                qWarning() << "Currently unsupported format" << VTFLib::CVTFFile::ImageFormatName(vtfFile.GetFormat())
-                           << "for texture" << texture->path();
-                return false;
-            }
+                if ( format != other.format )
+                    return format < other.format;
 
-            if ( !vtfFile.GetData(0,0,0,0) )
-            {
-                qWarning() << "VTF for texture" << texture->path()
-                           << "has no data.";
-                return false;
-            }
+                if ( width != other.width )
+                    return width < other.width;
 
-            texture->setSize(vtfFile.GetWidth(), vtfFile.GetHeight());
-            texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt32);
+                if ( height != other.height )
+                    return height < other.height;
 
-            if ( vtfFile.GetFormat() == IMAGE_FORMAT_RGBA8888 )
-            {
-                texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt32, vtfFile.GetData(0, 0, 0, 0));
-            }
-            else
-            {
-                int size = static_cast<int>(VTFLib::CVTFFile::ComputeImageSize(vtfFile.GetWidth(), vtfFile.GetHeight(),
-                                                              1,1,
-                                                              vtfFile.GetFormat()));
-                texture->setCompressedData(size, vtfFile.GetData(0,0,0,0));
+                return mipCount < other.mipCount;
             }
 
-            texture->create();
+            quint32 format;
+            quint32 width;
+            quint32 height;
+            quint32 mipCount;
+        };
 
-            return true;
+        // Layers per array in the current context. OpenGL 3.3 guarantees at least 256.
+        int maxTextureArrayLayers()
+        {
+            GLint maxLayers = 0;
+            QOpenGLContext::currentContext()->functions()->glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+            return maxLayers;
         }
     }
 
     VTFLoader::VTFLoader(Model::MaterialStore *materialStore, Model::TextureStore *textureStore)
         : m_pMaterialStore(materialStore),
-          m_pTextureStore(textureStore)
+          m_pTextureStore(textureStore),
+          m_TextureCache(VTFTextureCache::defaultDirectory()),
+          m_bTextureArrays(false),
+          m_iTextureArrayCount(0),
+          m_VmtCache([this](const QString& path) { return readVmt(path); })
     {
         Q_ASSERT_X(m_pMaterialStore, Q_FUNC_INFO, "Material store cannot be null!");
         Q_ASSERT_X(m_pTextureStore, Q_FUNC_INFO, "Texture store cannot be null!");
+
+        // VTFLib keeps its error state in a global, so only transcode one texture at a time.
+        m_TranscodePool.setMaxThreadCount(1);
+    }
+
+    VTFLoader::~VTFLoader()
+    {
+        if ( m_pMaterialStore->materialResolver() == this )
+        {
+            m_pMaterialStore->setMaterialResolver(Q_NULLPTR);
+        }
+
+        if ( m_pTextureStore->textureResolver() == this )
+        {
+            m_pTextureStore->setTextureResolver(Q_NULLPTR);
+        }
+
+        m_TranscodePool.waitForDone();
+
+        // Textures that were never uploaded would otherwise be left empty in the store.
+        foreach ( quint32 textureId, m_PendingTextures.keys() )
+        {
+            m_pTextureStore->destroyTexture(textureId);
+        }
     }
 
     void VTFLoader::loadMaterials(const FileFormats::VPKFileCollection &vpkFiles)
@@ -123,51 +117,58 @@ namespace ModelLoaders
             return;
         }
 
+        m_VmtEntries.clear();
+        m_VtfEntries.clear();
+        indexEntries(vpkFiles, "vmt", m_VmtEntries);
+        indexEntries(vpkFiles, "vtf", m_VtfEntries);
+        m_VmtCache.clear();
+        m_pTextureStore->setTextureResolver(this);
+
         findReferencedVtfs();
         loadReferencedVtfs();
 
+        if ( m_bTextureArrays )
+        {
+            packTextureArrays();
+        }
+
         // Clean up any remaining VTFs - the files could have referenced some that don't actually exist.
         foreach ( quint32 textureId, m_ReferencedVtfs.values() )
         {
-            qDebug() << "Cleaning up unused texture" << textureId << m_pTextureStore->getTexture(textureId)->path();
+            qCDebug(lcVTFLoader) << "Cleaning up unused texture" << textureId << m_pTextureStore->getTexture(textureId)->path();
             m_pTextureStore->destroyTexture(textureId);
         }
 
         m_ReferencedVtfs.clear();
+        m_TextureMaterials.clear();
+        m_UnpackableTextures.clear();
     }
 
     void VTFLoader::findReferencedVtfs()
     {
         m_ReferencedVtfs.clear();
+        m_TextureMaterials.clear();
+        m_UnpackableTextures.clear();
 
         foreach ( const FileFormats::VPKFilePointer& vpk, m_VmtFileSet )
         {
             // These are ordered by archive number.
+            // Any materials included by patches are read out of order by the cache.
             m_CurrentRecordSet = vpk->index().recordsForExtension("vmt");
-            m_iCurrentArchiveIndex = ~0;
 
             foreach ( const FileFormats::VPKIndexTreeRecordPointer& record, m_CurrentRecordSet )
             {
-                QByteArray vmtData = getData(vpk, record);
-                if ( vmtData.isEmpty() )
-                {
-                    qDebug() << "VMT data is empty";
-                    continue;
-                }
-
-                FileFormats::KeyValuesParser parser(vmtData);
+                QString matPath = materialPath(record);
                 QString error;
-                QJsonDocument doc = parser.toJsonDocument(&error);
-                if ( doc.isNull() )
+                FileFormats::VMTMaterialPointer vmt = m_VmtCache.material(matPath, &error);
+                if ( !vmt )
                 {
-                    qDebug() << "Error parsing" << record->fullPath() << "-" << error;
+                    qCWarning(lcVTFLoader) << "Error loading" << record->fullPath() << "-" << error;
                     continue;
                 }
 
-                QString matPath = materialPath(record);
-
                 Renderer::RenderMaterialPointer material = m_pMaterialStore->createMaterial(matPath);
-                populateMaterial(material, doc);
+                populateMaterial(material, *vmt, ReferenceTextures);
             }
 
             vpk->closeArchive();
@@ -192,27 +193,54 @@ namespace ModelLoaders
 
                 quint32 textureId = m_ReferencedVtfs.value(fullPath);
 
-                QByteArray vtfData = getData(vpk, record);
-                if ( vtfData.isEmpty() )
+                Renderer::OpenGLTexturePointer texture = m_pTextureStore->getTexture(textureId);
+                if ( texture->textureStoreId() != textureId )
                 {
-                    qDebug() << "VTF data is empty";
-                    m_ReferencedVtfs.remove(fullPath);
+                    Q_ASSERT_X(false, Q_FUNC_INFO, "Texture ID mismatch, should never happen!");
                     m_pTextureStore->destroyTexture(textureId);
+                    m_ReferencedVtfs.remove(fullPath);
                     continue;
                 }
 
-                Renderer::OpenGLTexturePointer texture = m_pTextureStore->getTexture(textureId);
-                if ( texture->textureStoreId() != textureId )
+                // Textures that may be packed are held until every texture has been read.
+                if ( m_bTextureArrays )
                 {
-                    Q_ASSERT_X(false, Q_FUNC_INFO, "Texture ID mismatch, should never happen!");
-                    m_pTextureStore->destroyTexture(textureId);
+                    QString error;
+                    QByteArray transcoded = readTranscodedVtf(vpk, record, &error);
+                    if ( transcoded.isEmpty() )
+                    {
+                        qCWarning(lcVTFLoader) << "Failed to read" << fullPath << "-" << error;
+                        m_pTextureStore->destroyTexture(textureId);
+                    }
+                    else
+                    {
+                        m_TranscodedVtfs.insert(textureId, transcoded);
+                    }
+
+                    m_ReferencedVtfs.remove(fullPath);
+                    continue;
+                }
+
+                // A cache hit means the archive never needs to be read.
+                if ( m_TextureCache.loadCached(record->item(), texture) )
+                {
+                    m_ReferencedVtfs.remove(fullPath);
+                    continue;
+                }
+
+                QByteArray vtfData = getData(vpk, record);
+                if ( vtfData.isEmpty() )
+                {
+                    qCWarning(lcVTFLoader) << "VTF data is empty for" << fullPath;
                     m_ReferencedVtfs.remove(fullPath);
+                    m_pTextureStore->destroyTexture(textureId);
                     continue;
                 }
 
-                if ( !loadVtf(vtfData, texture) )
+                QString error;
+                if ( !m_TextureCache.loadAndStore(record->item(), vtfData, texture, &error) )
                 {
-                    qDebug().nospace() << "Failed to read " << fullPath << ": " << VTFLib::LastError.Get();
+                    qCWarning(lcVTFLoader) << "Failed to read" << fullPath << "-" << error;
                     m_pTextureStore->destroyTexture(textureId);
                     m_ReferencedVtfs.remove(fullPath);
                     continue;
@@ -225,6 +253,153 @@ namespace ModelLoaders
         }
     }
 
+    QByteArray VTFLoader::readTranscodedVtf(const FileFormats::VPKFilePointer &vpk,
+                                            const FileFormats::VPKIndexTreeRecordPointer &record,
+                                            QString *errorHint)
+    {
+        const FileFormats::VPKIndexTreeItem* item = record->item();
+
+        QByteArray transcoded = m_TextureCache.readCached(item);
+        if ( !transcoded.isEmpty() )
+        {
+            return transcoded;
+        }
+
+        QByteArray vtfData = getData(vpk, record);
+        if ( vtfData.isEmpty() )
+        {
+            if ( errorHint )
+            {
+                *errorHint = "VTF data is empty.";
+            }
+
+            return QByteArray();
+        }
+
+        transcoded = VTFTextureCache::transcode(vtfData, item->crc(), item->fileSize(), errorHint);
+        m_TextureCache.store(item, transcoded);
+        return transcoded;
+    }
+
+    void VTFLoader::packTextureArrays()
+    {
+        // Group textures by image description. Texture IDs are sorted so that
+        // layer assignment doesn't depend on hash ordering.
+        QList<quint32> textureIds = m_TranscodedVtfs.keys();
+        std::sort(textureIds.begin(), textureIds.end());
+
+        // Without array support every texture is uploaded on its own.
+        const int maxLayers = qMax(maxTextureArrayLayers(), 1);
+
+        QMap<TextureArrayKey, QList<quint32> > groups;
+        foreach ( quint32 textureId, textureIds )
+        {
+            const QByteArray& transcoded = m_TranscodedVtfs[textureId];
+
+            // Textures used outside the main texture unit must stay standalone.
+            if ( m_UnpackableTextures.contains(textureId) )
+            {
+                uploadTextureArray(QList<quint32>() << textureId);
+                continue;
+            }
+
+            groups[TextureArrayKey(VTFTextureCache::describe(reinterpret_cast<const uchar*>(transcoded.constData())))]
+                    .append(textureId);
+        }
+
+        for ( QMap<TextureArrayKey, QList<quint32> >::const_iterator it = groups.constBegin(); it != groups.constEnd(); ++it )
+        {
+            const QList<quint32>& group = it.value();
+            for ( int first = 0; first < group.count(); first += maxLayers )
+            {
+                uploadTextureArray(group.mid(first, maxLayers));
+            }
+        }
+
+        m_TranscodedVtfs.clear();
+    }
+
+    void VTFLoader::uploadTextureArray(const QList<quint32> &textureIds)
+    {
+        // Nothing is gained by putting a single texture into an array.
+        if ( textureIds.count() < 2 )
+        {
+            foreach ( quint32 textureId, textureIds )
+            {
+                Renderer::OpenGLTexturePointer texture = m_pTextureStore->getTexture(textureId);
+                VTFTextureCache::upload(reinterpret_cast<const uchar*>(m_TranscodedVtfs[textureId].constData()), texture);
+            }
+
+            return;
+        }
+
+        const QString arrayPath = QString("_texturearrays/%1").arg(m_iTextureArrayCount++);
+
+        Renderer::OpenGLTexturePointer arrayTexture = m_pTextureStore->createEmptyTexture(arrayPath, QOpenGLTexture::Target2DArray);
+        VTFTextureCache::allocateArray(reinterpret_cast<const uchar*>(m_TranscodedVtfs[textureIds.first()].constData()),
+                                       arrayTexture, textureIds.count());
+
+        Renderer::RenderMaterialPointer arrayMaterial = m_pMaterialStore->createMaterial(arrayPath);
+        arrayMaterial->setShaderTechnique(Renderer::ShaderDefs::LitTextureArray3D);
+        arrayMaterial->addTexture(Renderer::ShaderDefs::MainTexture, arrayTexture->textureStoreId());
+
+        for ( int layer = 0; layer < textureIds.count(); ++layer )
+        {
+            const quint32 textureId = textureIds.at(layer);
+            VTFTextureCache::uploadLayer(reinterpret_cast<const uchar*>(m_TranscodedVtfs[textureId].constData()),
+                                         arrayTexture, layer);
+
+            foreach ( quint32 materialId, m_TextureMaterials.value(textureId) )
+            {
+                Renderer::RenderMaterialPointer material = m_pMaterialStore->getMaterial(materialId);
+                material->setShaderTechnique(Renderer::ShaderDefs::LitTextureArray3D);
+                material->addTexture(Renderer::ShaderDefs::MainTexture, arrayTexture->textureStoreId());
+                material->setTextureArrayLayer(layer);
+                material->setBatchMaterialId(arrayMaterial->materialStoreId());
+            }
+
+            // The layer replaces the standalone texture.
+            m_pTextureStore->destroyTexture(textureId);
+        }
+    }
+
+    bool VTFLoader::textureArraysSupported()
+    {
+        QOpenGLContext* context = QOpenGLContext::currentContext();
+        if ( !context )
+        {
+            return false;
+        }
+
+        // Array textures need OpenGL 3.0, and the array shader reads its matrices from a buffer texture, which needs 3.1.
+        if ( context->format().version() < qMakePair(3, 1) )
+        {
+            return false;
+        }
+
+        return maxTextureArrayLayers() > 1;
+    }
+
+    bool VTFLoader::textureArraysEnabled() const
+    {
+        return m_bTextureArrays;
+    }
+
+    void VTFLoader::setTextureArraysEnabled(bool enabled)
+    {
+        m_bTextureArrays = enabled;
+    }
+
+    QString VTFLoader::cacheDirectory() const
+    {
+        return m_TextureCache.directory();
+    }
+
+    void VTFLoader::setCacheDirectory(const QString &directory)
+    {
+        m_TextureCache.setDirectory(directory);
+    }
+
     QByteArray VTFLoader::getData(const FileFormats::VPKFilePointer &vpk, const FileFormats::VPKIndexTreeRecordPointer &record)
     {
         if ( record->item()->archiveIndex() != m_iCurrentArchiveIndex )
@@ -236,50 +411,256 @@ namespace ModelLoaders
         return vpk->readFromCurrentArchive(record->item());
     }
 
-    void VTFLoader::populateMaterial(Renderer::RenderMaterialPointer &material, const QJsonDocument &vmt)
+    void VTFLoader::populateMaterial(Renderer::RenderMaterialPointer &material, const FileFormats::VMTMaterial &vmt,
+                                     TextureLookup lookup)
+    {
+        material->setTranslucent(vmt.isTranslucent());
+        material->setAlphaTest(vmt.isAlphaTest(), vmt.alphaTestReference());
+
+        addVmtTexture(material, Renderer::ShaderDefs::MainTexture, vmt.baseTexture(), lookup);
+
+        // Blend texture for WorldVertexTransition displacements.
+        addVmtTexture(material, Renderer::ShaderDefs::SecondaryTexture, vmt.baseTexture2(), lookup);
+    }
+
+    void VTFLoader::addVmtTexture(Renderer::RenderMaterialPointer &material, Renderer::ShaderDefs::TextureUnit unit,
+                                  const QString &vtfPath, TextureLookup lookup)
     {
-        if ( !vmt.isObject() )
+        if ( vtfPath.isEmpty() )
             return;
 
-        QJsonObject root = vmt.object();
-        QJsonObject::const_iterator rootKey = root.constBegin();
-        if ( rootKey == root.constEnd() )
+        if ( lookup == ReferenceTextures )
+        {
+            referenceVtf(material, unit, vtfPath);
             return;
+        }
 
-        QString shaderType = rootKey.key();
+        material->addTexture(unit, resolveTexture(vtfPath));
+    }
 
-        if ( !noCaseCompare(shaderType, "UnlitGeneric") &&
-             !noCaseCompare(shaderType, "LightmappedGeneric") &&
-             !noCaseCompare(shaderType, "WorldVertexTransition"))
+    void VTFLoader::referenceVtf(Renderer::RenderMaterialPointer &material, Renderer::ShaderDefs::TextureUnit unit, const QString &vtfPath)
+    {
+        if ( !m_ReferencedVtfs.contains(vtfPath) )
         {
-            return;
+            quint32 textureId = m_pTextureStore->createEmptyTexture(vtfPath)->textureStoreId();
+            m_ReferencedVtfs.insert(vtfPath, textureId);
         }
 
-        QJsonValue vProperties = rootKey.value();
-        if ( !vProperties.isObject() )
-            return;
+        const quint32 textureId = m_ReferencedVtfs.value(vtfPath, 0);
+        material->addTexture(unit, textureId);
 
-        // Annoyingly we can't just index by key because of non-case-sensitivity.
-        QJsonObject properties = vProperties.toObject();
-        for ( QJsonObject::const_iterator it = properties.constBegin(); it != properties.constEnd(); ++it )
+        // Only base textures can be moved into texture arrays.
+        if ( unit == Renderer::ShaderDefs::MainTexture )
         {
-            if ( !noCaseCompare(it.key(), "$basetexture") )
-                continue;
+            m_TextureMaterials[textureId].append(material->materialStoreId());
+        }
+        else
+        {
+            m_UnpackableTextures.insert(textureId);
+        }
+    }
+
+    void VTFLoader::loadMaterialsOnDemand(const FileFormats::VPKFileCollection &vpkFiles)
+    {
+        m_VmtEntries.clear();
+        m_VtfEntries.clear();
+        m_VmtCache.clear();
+
+        indexEntries(vpkFiles, "vmt", m_VmtEntries);
+        indexEntries(vpkFiles, "vtf", m_VtfEntries);
+
+        m_pMaterialStore->setMaterialResolver(this);
+        m_pTextureStore->setTextureResolver(this);
+    }
+
+    void VTFLoader::indexEntries(const FileFormats::VPKFileCollection &vpkFiles, const QString &extension, EntryTable &table)
+    {
+        foreach ( const FileFormats::VPKFilePointer& vpk, vpkFiles.filesContainingExtension(extension) )
+        {
+            foreach ( const FileFormats::VPKIndexTreeRecordPointer& record, vpk->index().recordsForExtension(extension) )
+            {
+                // The first VPK to provide a path wins.
+                QString path = materialPath(record);
+                if ( !table.contains(path) )
+                {
+                    table.insert(path, VpkEntry(vpk, record));
+                }
+            }
+        }
+    }
+
+    Renderer::RenderMaterialPointer VTFLoader::resolveMaterial(const QString &path)
+    {
+        QString error;
+        FileFormats::VMTMaterialPointer vmt = m_VmtCache.material(path, &error);
+        if ( !vmt )
+        {
+            qCWarning(lcVTFLoader) << "Error loading" << path << "-" << error;
+            return Renderer::RenderMaterialPointer();
+        }
+
+        Renderer::RenderMaterialPointer material = m_pMaterialStore->createMaterial(path);
+        populateMaterial(material, *vmt, ResolveTextures);
+        return material;
+    }
+
+    quint32 VTFLoader::resolveTexture(const QString &vtfPath)
+    {
+        quint32 textureId = m_pTextureStore->getTextureId(vtfPath);
+        if ( textureId != 0 )
+        {
+            return textureId;
+        }
+
+        if ( !m_VtfEntries.contains(vtfPath) )
+        {
+            return 0;
+        }
 
-            QJsonValue val = it.value();
-            if ( !val.isString() )
+        const VpkEntry entry = m_VtfEntries.value(vtfPath);
+        Renderer::OpenGLTexturePointer texture = m_pTextureStore->createEmptyTexture(vtfPath);
+        textureId = texture->textureStoreId();
+
+        // The material refers to the texture straight away, so the texture must report
+        // the size it will have once uploaded for texture co-ordinates to be right.
+        PendingTexture pending;
+        pending.entry = entry;
+
+        QSize imageSize = m_TextureCache.cachedImageSize(entry.record->item());
+        pending.fromCache = imageSize.isValid();
+
+        if ( !pending.fromCache )
+        {
+            // Only the header is read here. The rest of the file is read by the worker.
+            imageSize = VTFTextureCache::vtfImageSize(readEntry(entry, VTFTextureCache::vtfImageSizeBytes()));
+            if ( !imageSize.isValid() )
+            {
+                qCWarning(lcVTFLoader) << "Failed to read" << vtfPath << "- VTF header is invalid.";
+                m_pTextureStore->destroyTexture(textureId);
+                return 0;
+            }
+
+            const VTFTextureCache cache = m_TextureCache;
+            const FileFormats::VPKIndexTreeRecordPointer record = entry.record;
+            const QString archiveFileName = entry.vpk->siblingArchives().value(record->item()->archiveIndex());
+
+            pending.transcoded = QtConcurrent::run(&m_TranscodePool, [cache, record, archiveFileName]
+            {
+                const FileFormats::VPKIndexTreeItem* item = record->item();
+                const QByteArray vtfData = FileFormats::VPKFile::readFromArchive(archiveFileName, item);
+                if ( vtfData.isEmpty() )
+                {
+                    return QByteArray();
+                }
+
+                QByteArray transcoded = VTFTextureCache::transcode(vtfData, item->crc(), item->fileSize());
+                cache.store(item, transcoded);
+                return transcoded;
+            });
+        }
+
+        texture->setImageSize(imageSize);
+        m_PendingTextures.insert(textureId, pending);
+        return textureId;
+    }
+
+    bool VTFLoader::reloadTexture(Renderer::OpenGLTexturePointer &texture)
+    {
+        const QString vtfPath = texture->path();
+        if ( !m_VtfEntries.contains(vtfPath) )
+        {
+            return false;
+        }
+
+        // Anything loaded before will normally be in the on-disk cache.
+        const VpkEntry entry = m_VtfEntries.value(vtfPath);
+        if ( m_TextureCache.loadCached(entry.record->item(), texture) )
+        {
+            return true;
+        }
+
+        QString error;
+        QByteArray vtfData = readEntry(entry);
+        if ( vtfData.isEmpty() || !m_TextureCache.loadAndStore(entry.record->item(), vtfData, texture, &error) )
+        {
+            qCWarning(lcVTFLoader) << "Failed to reload" << vtfPath << "-" << error;
+            return false;
+        }
+
+        return true;
+    }
+
+    QByteArray VTFLoader::readVmt(const QString &path)
+    {
+        return m_VmtEntries.contains(path) ? readEntry(m_VmtEntries.value(path)) : QByteArray();
+    }
+
+    QByteArray VTFLoader::readEntry(const VpkEntry &entry)
+    {
+        return readEntry(entry, entry.record->item()->entryLength());
+    }
+
+    QByteArray VTFLoader::readEntry(const VpkEntry &entry, qint64 maxLength)
+    {
+        int archiveIndex = entry.record->item()->archiveIndex();
+        if ( entry.vpk->currentArchiveIndex() != archiveIndex && !entry.vpk->openArchive(archiveIndex) )
+        {
+            return QByteArray();
+        }
+
+        return entry.vpk->readFromCurrentArchive(entry.record->item(), maxLength);
+    }
+
+    bool VTFLoader::hasPendingTextures() const
+    {
+        return !m_PendingTextures.isEmpty();
+    }
+
+    int VTFLoader::uploadPendingTextures(int maxUploads)
+    {
+        int uploaded = 0;
+
+        QHash<quint32, PendingTexture>::iterator it = m_PendingTextures.begin();
+        while ( it != m_PendingTextures.end() && (maxUploads < 0 || uploaded < maxUploads) )
+        {
+            PendingTexture& pending = it.value();
+            if ( pending.transcoded.isRunning() )
+            {
+                ++it;
                 continue;
+            }
 
-            QString vtfPath = CalliperUtil::General::normaliseResourcePathSeparators(val.toString().toLower());
+            const quint32 textureId = it.key();
+            Renderer::OpenGLTexturePointer texture = m_pTextureStore->getTexture(textureId);
+            bool success = false;
 
-            if ( !m_ReferencedVtfs.contains(vtfPath) )
+            if ( !pending.fromCache )
+            {
+                QByteArray transcoded = pending.transcoded.result();
+                if ( !transcoded.isEmpty() )
+                {
+                    VTFTextureCache::upload(reinterpret_cast<const uchar*>(transcoded.constData()), texture);
+                    success = true;
+                }
+            }
+            else
             {
-                quint32 textureId = m_pTextureStore->createEmptyTexture(vtfPath)->textureStoreId();
-                m_ReferencedVtfs.insert(vtfPath, textureId);
+                success = m_TextureCache.loadCached(pending.entry.record->item(), texture);
             }
 
-            material->addTexture(Renderer::ShaderDefs::MainTexture, m_ReferencedVtfs.value(vtfPath, 0));
-            return;
+            if ( success )
+            {
+                ++uploaded;
+            }
+            else
+            {
+                qCWarning(lcVTFLoader) << "Failed to load texture" << texture->path();
+                m_pTextureStore->destroyTexture(textureId);
+            }
+
+            it = m_PendingTextures.erase(it);
         }
+
+        return uploaded;
     }
 }
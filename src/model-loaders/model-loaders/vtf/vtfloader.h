@@ -5,34 +5,139 @@
 #include "file-formats/vpk/vpkfilecollection.h"
 #include "model/stores/materialstore.h"
 #include "model/stores/texturestore.h"
+#include "model/stores/imaterialresolver.h"
+#include "model/stores/itextureresolver.h"
+#include "vtftexturecache.h"
+#include "file-formats/vmt/vmtmaterialcache.h"
 #include <QSet>
 #include <QHash>
 #include <QString>
+#include <QFuture>
+#include <QThreadPool>
+#include <QLoggingCategory>
 
 namespace ModelLoaders
 {
-    class MODELLOADERSSHARED_EXPORT VTFLoader
+    Q_DECLARE_LOGGING_CATEGORY(lcVTFLoader)
+
+    class MODELLOADERSSHARED_EXPORT VTFLoader : public Model::IMaterialResolver,
+                                                public Model::ITextureResolver
     {
     public:
         VTFLoader(Model::MaterialStore* materialStore, Model::TextureStore* textureStore);
+        ~VTFLoader();
 
+        // Parses every VMT in the VPKs and loads every VTF they reference.
+        // The loader registers itself as the texture store's resolver, so that
+        // textures evicted from the store can be reloaded.
         void loadMaterials(const FileFormats::VPKFileCollection& vpkFiles);
 
+        // Indexes the VMTs and VTFs in the VPKs and registers this loader as the
+        // material store's resolver, so that a material and its textures are only
+        // loaded the first time the material is requested from the store.
+        // The loader also registers itself as the texture store's resolver.
+        // The loader unregisters itself from both stores when it is destroyed.
+        // Materials are usually requested while building geometry, when there may be no
+        // current OpenGL context, so their textures are transcoded on a worker thread and
+        // drawn with the default texture until uploadPendingTextures() is called.
+        // The textures report their real size from the start, so geometry doesn't need rebuilding.
+        void loadMaterialsOnDemand(const FileFormats::VPKFileCollection& vpkFiles);
+
+        virtual Renderer::RenderMaterialPointer resolveMaterial(const QString& path) override;
+        virtual bool reloadTexture(Renderer::OpenGLTexturePointer& texture) override;
+
+        // Uploads textures whose transcoding has finished.
+        // Requires a current OpenGL context. A negative maxUploads means no limit.
+        // Returns the number of textures uploaded.
+        int uploadPendingTextures(int maxUploads = -1);
+        bool hasPendingTextures() const;
+
+        // When enabled, loadMaterials() packs textures that share a format, size and mip count
+        // into layers of 2D array textures. Materials using the same array share a batch material,
+        // so that the renderer can draw them together. Materials loaded on demand are not packed.
+        bool textureArraysEnabled() const;
+        void setTextureArraysEnabled(bool enabled);
+
+        // Whether the current OpenGL context can draw the texture arrays packed by loadMaterials().
+        // Requires a current OpenGL context.
+        static bool textureArraysSupported();
+
+        // Directory used to cache transcoded textures between runs.
+        // Defaults to VTFTextureCache::defaultDirectory(); an empty path disables caching.
+        QString cacheDirectory() const;
+        void setCacheDirectory(const QString& directory);
+
     private:
+        struct VpkEntry
+        {
+            VpkEntry() {}
+            VpkEntry(const FileFormats::VPKFilePointer& v, const FileFormats::VPKIndexTreeRecordPointer& r)
+                : vpk(v), record(r)
+            {
+            }
+
+            FileFormats::VPKFilePointer vpk;
+            FileFormats::VPKIndexTreeRecordPointer record;
+        };
+
+        struct PendingTexture
+        {
+            PendingTexture() : fromCache(false) {}
+
+            VpkEntry entry;
+            bool fromCache;
+            QFuture<QByteArray> transcoded;
+        };
+
+        typedef QHash<QString, VpkEntry> EntryTable;
+
+        // How a material's textures are found when it is populated from its VMT.
+        enum TextureLookup
+        {
+            ReferenceTextures,  // Created empty, and loaded by loadReferencedVtfs().
+            ResolveTextures     // Loaded straight away by resolveTexture().
+        };
+
+        void indexEntries(const FileFormats::VPKFileCollection& vpkFiles, const QString& extension, EntryTable& table);
+        quint32 resolveTexture(const QString& vtfPath);
+        QByteArray readEntry(const VpkEntry& entry);
+        QByteArray readEntry(const VpkEntry& entry, qint64 maxLength);
+        QByteArray readVmt(const QString& path);
+
         void findReferencedVtfs();
         void loadReferencedVtfs();
+        QByteArray readTranscodedVtf(const FileFormats::VPKFilePointer& vpk, const FileFormats::VPKIndexTreeRecordPointer& record,
+                                     QString* errorHint);
+        void packTextureArrays();
+        void uploadTextureArray(const QList<quint32>& textureIds);
         QByteArray getData(const FileFormats::VPKFilePointer& vpk, const FileFormats::VPKIndexTreeRecordPointer& record);
-        void populateMaterial(Renderer::RenderMaterialPointer& material, const QJsonDocument& vmt);
+        void populateMaterial(Renderer::RenderMaterialPointer& material, const FileFormats::VMTMaterial& vmt,
+                              TextureLookup lookup);
+        void addVmtTexture(Renderer::RenderMaterialPointer& material, Renderer::ShaderDefs::TextureUnit unit,
+                           const QString& vtfPath, TextureLookup lookup);
+        void referenceVtf(Renderer::RenderMaterialPointer& material, Renderer::ShaderDefs::TextureUnit unit, const QString& vtfPath);
 
         Model::MaterialStore* m_pMaterialStore;
         Model::TextureStore* m_pTextureStore;
+        VTFTextureCache m_TextureCache;
 
         QSet<FileFormats::VPKFilePointer> m_VmtFileSet;
         QSet<FileFormats::VPKFilePointer> m_VtfFileSet;
         QHash<QString, quint32> m_ReferencedVtfs;
+        QHash<quint32, QList<quint32> > m_TextureMaterials;
+        QSet<quint32> m_UnpackableTextures;
+        QHash<quint32, QByteArray> m_TranscodedVtfs;
+        bool m_bTextureArrays;
+        quint32 m_iTextureArrayCount;
 
         QList<FileFormats::VPKIndexTreeRecordPointer> m_CurrentRecordSet;
         quint16 m_iCurrentArchiveIndex;
+
+        EntryTable m_VmtEntries;
+        EntryTable m_VtfEntries;
+        FileFormats::VMTMaterialCache m_VmtCache;
+        QThreadPool m_TranscodePool;
+        QHash<quint32, PendingTexture> m_PendingTextures;
     };
 }
 
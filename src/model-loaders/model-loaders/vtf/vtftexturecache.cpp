@@ -0,0 +1,542 @@
+#include "vtftexturecache.h"
+#include "VTFLib/src/VTFFile.h"
+#include "VTFLib/src/VTFLib.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <QtDebug>
+
+namespace ModelLoaders
+{
+    Q_LOGGING_CATEGORY(lcVTFTextureCache, "ModelLoaders.VTFTextureCache")
+
+    namespace
+    {
+        // Bump this whenever the entry layout or the transcoding rules change.
+        const quint32 CACHE_VERSION = 1;
+        const char CACHE_MAGIC[4] = { 'C', 'T', 'E', 'X' };
+        const quint32 MAX_MIP_LEVELS = 16;
+        const quint32 DATA_ALIGNMENT = 16;
+
+        // Offsets into the VTF file header, which is little endian.
+        const char VTF_MAGIC[4] = { 'V', 'T', 'F', '\0' };
+        const int VTF_WIDTH_OFFSET = 16;
+        const int VTF_HEIGHT_OFFSET = 18;
+
+        // All fields are stored in native byte order, so that a mapped entry
+        // can be read in place. Entries are local to the machine that wrote them.
+        struct EntryHeader
+        {
+            char magic[4];
+            quint32 version;
+            quint32 crc;
+            quint32 sourceSize;
+            quint32 format;
+            quint32 width;
+            quint32 height;
+            quint32 mipCount;
+        };
+
+        struct MipEntry
+        {
+            quint32 offset;
+            quint32 size;
+            quint32 width;
+            quint32 height;
+        };
+
+        inline quint32 align(quint32 value)
+        {
+            return (value + (DATA_ALIGNMENT - 1)) & ~(DATA_ALIGNMENT - 1);
+        }
+
+        VTFTextureCache::CacheFormat cacheFormatFor(VTFImageFormat format)
+        {
+            switch (format)
+            {
+                case IMAGE_FORMAT_DXT1:
+                    return VTFTextureCache::FormatDXT1;
+
+                case IMAGE_FORMAT_DXT3:
+                    return VTFTextureCache::FormatDXT3;
+
+                case IMAGE_FORMAT_DXT5:
+                    return VTFTextureCache::FormatDXT5;
+
+                default:
+                    return VTFTextureCache::FormatRGBA8888;
+            }
+        }
+
+        VTFImageFormat imageFormatFor(VTFTextureCache::CacheFormat format)
+        {
+            switch (format)
+            {
+                case VTFTextureCache::FormatDXT1:
+                    return IMAGE_FORMAT_DXT1;
+
+                case VTFTextureCache::FormatDXT3:
+                    return IMAGE_FORMAT_DXT3;
+
+                case VTFTextureCache::FormatDXT5:
+                    return IMAGE_FORMAT_DXT5;
+
+                case VTFTextureCache::FormatRGBA8888:
+                    return IMAGE_FORMAT_RGBA8888;
+
+                default:
+                    return IMAGE_FORMAT_NONE;
+            }
+        }
+
+        QOpenGLTexture::TextureFormat textureFormatFor(VTFTextureCache::CacheFormat format)
+        {
+            switch (format)
+            {
+                case VTFTextureCache::FormatDXT1:
+                    return QOpenGLTexture::RGBA_DXT1;
+
+                case VTFTextureCache::FormatDXT3:
+                    return QOpenGLTexture::RGBA_DXT3;
+
+                case VTFTextureCache::FormatDXT5:
+                    return QOpenGLTexture::RGBA_DXT5;
+
+                default:
+                    return QOpenGLTexture::RGBA8_UNorm;
+            }
+        }
+
+        inline void setError(QString* errorHint, const QString& error)
+        {
+            if ( errorHint )
+            {
+                *errorHint = error;
+            }
+        }
+    }
+
+    VTFTextureCache::VTFTextureCache(const QString &directory)
+        : m_szDirectory(directory)
+    {
+    }
+
+    QString VTFTextureCache::defaultDirectory()
+    {
+        QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if ( base.isEmpty() )
+        {
+            return QString();
+        }
+
+        return base + QString("/textures/v%1").arg(CACHE_VERSION);
+    }
+
+    QString VTFTextureCache::directory() const
+    {
+        return m_szDirectory;
+    }
+
+    void VTFTextureCache::setDirectory(const QString &directory)
+    {
+        m_szDirectory = directory;
+    }
+
+    bool VTFTextureCache::isEnabled() const
+    {
+        return !m_szDirectory.isEmpty();
+    }
+
+    QString VTFTextureCache::entryPath(const FileFormats::VPKIndexTreeItem *item) const
+    {
+        if ( !isEnabled() || !item )
+        {
+            return QString();
+        }
+
+        return QString("%1/%2-%3.ctex").arg(m_szDirectory)
+                .arg(item->crc(), 8, 16, QChar('0'))
+                .arg(item->fileSize(), 8, 16, QChar('0'));
+    }
+
+    bool VTFTextureCache::contains(const FileFormats::VPKIndexTreeItem *item) const
+    {
+        return isEnabled() && QFileInfo::exists(entryPath(item));
+    }
+
+    bool VTFTextureCache::loadCached(const FileFormats::VPKIndexTreeItem *item, Renderer::OpenGLTexturePointer &texture) const
+    {
+        if ( !isEnabled() || !item )
+        {
+            return false;
+        }
+
+        QFile file(entryPath(item));
+        if ( !file.exists() || !file.open(QIODevice::ReadOnly) )
+        {
+            return false;
+        }
+
+        const qint64 length = file.size();
+        uchar* data = file.map(0, length);
+        if ( !data )
+        {
+            qCWarning(lcVTFTextureCache) << "Could not map cache entry" << file.fileName() << "-" << file.errorString();
+            return false;
+        }
+
+        QString error;
+        if ( !validate(data, length, item->crc(), item->fileSize(), &error) )
+        {
+            qCWarning(lcVTFTextureCache) << "Removing invalid cache entry" << file.fileName() << "-" << error;
+            file.unmap(data);
+            file.close();
+            file.remove();
+            return false;
+        }
+
+        upload(data, texture);
+        file.unmap(data);
+        return true;
+    }
+
+    QByteArray VTFTextureCache::readCached(const FileFormats::VPKIndexTreeItem *item) const
+    {
+        if ( !isEnabled() || !item )
+        {
+            return QByteArray();
+        }
+
+        QFile file(entryPath(item));
+        if ( !file.exists() || !file.open(QIODevice::ReadOnly) )
+        {
+            return QByteArray();
+        }
+
+        QByteArray entry = file.readAll();
+
+        QString error;
+        if ( !validate(reinterpret_cast<const uchar*>(entry.constData()), entry.length(), item->crc(), item->fileSize(), &error) )
+        {
+            qCWarning(lcVTFTextureCache) << "Removing invalid cache entry" << file.fileName() << "-" << error;
+            file.close();
+            file.remove();
+            return QByteArray();
+        }
+
+        return entry;
+    }
+
+    QSize VTFTextureCache::cachedImageSize(const FileFormats::VPKIndexTreeItem *item) const
+    {
+        if ( !isEnabled() || !item )
+        {
+            return QSize();
+        }
+
+        QFile file(entryPath(item));
+        if ( !file.exists() || !file.open(QIODevice::ReadOnly) )
+        {
+            return QSize();
+        }
+
+        EntryHeader header;
+        if ( file.read(reinterpret_cast<char*>(&header), sizeof(EntryHeader)) != static_cast<qint64>(sizeof(EntryHeader)) )
+        {
+            return QSize();
+        }
+
+        if ( memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION ||
+             header.crc != item->crc() || header.sourceSize != item->fileSize() )
+        {
+            return QSize();
+        }
+
+        return QSize(static_cast<int>(header.width), static_cast<int>(header.height));
+    }
+
+    bool VTFTextureCache::loadAndStore(const FileFormats::VPKIndexTreeItem *item, const QByteArray &vtfData,
+                                       Renderer::OpenGLTexturePointer &texture, QString *errorHint) const
+    {
+        QByteArray entry = transcode(vtfData, item ? item->crc() : 0, item ? item->fileSize() : 0, errorHint);
+        if ( entry.isEmpty() )
+        {
+            return false;
+        }
+
+        upload(reinterpret_cast<const uchar*>(entry.constData()), texture);
+
+        store(item, entry);
+
+        return true;
+    }
+
+    QByteArray VTFTextureCache::transcode(const QByteArray &vtfData, quint32 crc, quint32 size, QString *errorHint)
+    {
+        VTFLib::CVTFFile vtfFile;
+        if ( !vtfFile.Load(static_cast<const vlVoid*>(vtfData.constData()), vtfData.length(), false) )
+        {
+            setError(errorHint, VTFLib::LastError.Get());
+            return QByteArray();
+        }
+
+        if ( !vtfFile.GetData(0, 0, 0, 0) )
+        {
+            setError(errorHint, "VTF has no image data.");
+            return QByteArray();
+        }
+
+        const VTFImageFormat sourceFormat = vtfFile.GetFormat();
+        const CacheFormat format = cacheFormatFor(sourceFormat);
+        const VTFImageFormat destFormat = imageFormatFor(format);
+        const quint32 width = vtfFile.GetWidth();
+        const quint32 height = vtfFile.GetHeight();
+        const quint32 mipCount = qBound<quint32>(1, vtfFile.GetMipmapCount(), MAX_MIP_LEVELS);
+
+        // Lay out the header, the mip table and then each level on an aligned boundary.
+        MipEntry mips[MAX_MIP_LEVELS];
+        quint32 offset = align(sizeof(EntryHeader) + (mipCount * sizeof(MipEntry)));
+
+        for ( quint32 mip = 0; mip < mipCount; ++mip )
+        {
+            vlUInt mipWidth = 0, mipHeight = 0, mipDepth = 0;
+            VTFLib::CVTFFile::ComputeMipmapDimensions(width, height, 1, mip, mipWidth, mipHeight, mipDepth);
+
+            mips[mip].offset = offset;
+            mips[mip].size = VTFLib::CVTFFile::ComputeImageSize(mipWidth, mipHeight, 1, destFormat);
+            mips[mip].width = mipWidth;
+            mips[mip].height = mipHeight;
+
+            offset = align(offset + mips[mip].size);
+        }
+
+        QByteArray entry(static_cast<int>(offset), '\0');
+        uchar* base = reinterpret_cast<uchar*>(entry.data());
+
+        EntryHeader header;
+        memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+        header.version = CACHE_VERSION;
+        header.crc = crc;
+        header.sourceSize = size;
+        header.format = format;
+        header.width = width;
+        header.height = height;
+        header.mipCount = mipCount;
+
+        memcpy(base, &header, sizeof(EntryHeader));
+        memcpy(base + sizeof(EntryHeader), mips, mipCount * sizeof(MipEntry));
+
+        for ( quint32 mip = 0; mip < mipCount; ++mip )
+        {
+            const vlByte* source = vtfFile.GetData(0, 0, 0, mip);
+
+            if ( sourceFormat == destFormat )
+            {
+                memcpy(base + mips[mip].offset, source, mips[mip].size);
+            }
+            else if ( !VTFLib::CVTFFile::ConvertToRGBA8888(source, base + mips[mip].offset,
+                                                           mips[mip].width, mips[mip].height, sourceFormat) )
+            {
+                setError(errorHint, QString("Could not transcode %1: %2")
+                         .arg(VTFLib::CVTFFile::ImageFormatName(sourceFormat))
+                         .arg(VTFLib::LastError.Get()));
+                return QByteArray();
+            }
+        }
+
+        return entry;
+    }
+
+    QSize VTFTextureCache::vtfImageSize(const QByteArray &vtfData)
+    {
+        if ( vtfData.length() < vtfImageSizeBytes() || memcmp(vtfData.constData(), VTF_MAGIC, sizeof(VTF_MAGIC)) != 0 )
+        {
+            return QSize();
+        }
+
+        const uchar* data = reinterpret_cast<const uchar*>(vtfData.constData());
+        return QSize(qFromLittleEndian<quint16>(data + VTF_WIDTH_OFFSET),
+                     qFromLittleEndian<quint16>(data + VTF_HEIGHT_OFFSET));
+    }
+
+    int VTFTextureCache::vtfImageSizeBytes()
+    {
+        return VTF_HEIGHT_OFFSET + static_cast<int>(sizeof(quint16));
+    }
+
+    bool VTFTextureCache::validate(const uchar *data, qint64 length, quint32 crc, quint32 size, QString *errorHint)
+    {
+        if ( !data || length < static_cast<qint64>(sizeof(EntryHeader)) )
+        {
+            setError(errorHint, "Entry is truncated.");
+            return false;
+        }
+
+        EntryHeader header;
+        memcpy(&header, data, sizeof(EntryHeader));
+
+        if ( memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION )
+        {
+            setError(errorHint, "Entry has an unrecognised header.");
+            return false;
+        }
+
+        if ( header.crc != crc || header.sourceSize != size )
+        {
+            setError(errorHint, "Entry does not match the source file.");
+            return false;
+        }
+
+        const VTFImageFormat format = imageFormatFor(static_cast<CacheFormat>(header.format));
+        if ( format == IMAGE_FORMAT_NONE || header.width < 1 || header.height < 1 ||
+             header.mipCount < 1 || header.mipCount > MAX_MIP_LEVELS )
+        {
+            setError(errorHint, "Entry has an invalid image description.");
+            return false;
+        }
+
+        const qint64 tableEnd = sizeof(EntryHeader) + (header.mipCount * sizeof(MipEntry));
+        if ( length < tableEnd )
+        {
+            setError(errorHint, "Entry is truncated.");
+            return false;
+        }
+
+        for ( quint32 mip = 0; mip < header.mipCount; ++mip )
+        {
+            MipEntry entry;
+            memcpy(&entry, data + sizeof(EntryHeader) + (mip * sizeof(MipEntry)), sizeof(MipEntry));
+
+            vlUInt mipWidth = 0, mipHeight = 0, mipDepth = 0;
+            VTFLib::CVTFFile::ComputeMipmapDimensions(header.width, header.height, 1, mip, mipWidth, mipHeight, mipDepth);
+
+            if ( entry.width != mipWidth || entry.height != mipHeight ||
+                 entry.size != VTFLib::CVTFFile::ComputeImageSize(mipWidth, mipHeight, 1, format) ||
+                 entry.offset < tableEnd ||
+                 static_cast<qint64>(entry.offset) + entry.size > length )
+            {
+                setError(errorHint, QString("Mip level %1 is invalid.").arg(mip));
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    VTFTextureCache::EntryDescription VTFTextureCache::describe(const uchar *data)
+    {
+        EntryHeader header;
+        memcpy(&header, data, sizeof(EntryHeader));
+
+        EntryDescription description;
+        description.format = static_cast<CacheFormat>(header.format);
+        description.width = header.width;
+        description.height = header.height;
+        description.mipCount = header.mipCount;
+        return description;
+    }
+
+    void VTFTextureCache::upload(const uchar *data, Renderer::OpenGLTexturePointer &texture)
+    {
+        EntryHeader header;
+        memcpy(&header, data, sizeof(EntryHeader));
+
+        const CacheFormat format = static_cast<CacheFormat>(header.format);
+
+        texture->setFormat(textureFormatFor(format));
+        texture->setSize(header.width, header.height);
+        texture->setMipLevels(header.mipCount);
+        texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+        for ( quint32 mip = 0; mip < header.mipCount; ++mip )
+        {
+            MipEntry entry;
+            memcpy(&entry, data + sizeof(EntryHeader) + (mip * sizeof(MipEntry)), sizeof(MipEntry));
+
+            if ( format == FormatRGBA8888 )
+            {
+                texture->setData(mip, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, data + entry.offset);
+            }
+            else
+            {
+                texture->setCompressedData(mip, static_cast<int>(entry.size), data + entry.offset);
+            }
+        }
+
+        if ( header.mipCount > 1 )
+        {
+            texture->setMinMagFilters(QOpenGLTexture::LinearMipMapLinear, QOpenGLTexture::Linear);
+        }
+
+        texture->create();
+    }
+
+    void VTFTextureCache::allocateArray(const uchar *data, Renderer::OpenGLTexturePointer &texture, int layers)
+    {
+        const EntryDescription description = describe(data);
+
+        texture->setFormat(textureFormatFor(description.format));
+        texture->setSize(description.width, description.height);
+        texture->setLayers(layers);
+        texture->setMipLevels(description.mipCount);
+        texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+        if ( description.mipCount > 1 )
+        {
+            texture->setMinMagFilters(QOpenGLTexture::LinearMipMapLinear, QOpenGLTexture::Linear);
+        }
+    }
+
+    void VTFTextureCache::uploadLayer(const uchar *data, Renderer::OpenGLTexturePointer &texture, int layer)
+    {
+        EntryHeader header;
+        memcpy(&header, data, sizeof(EntryHeader));
+
+        const CacheFormat format = static_cast<CacheFormat>(header.format);
+
+        for ( quint32 mip = 0; mip < header.mipCount; ++mip )
+        {
+            MipEntry entry;
+            memcpy(&entry, data + sizeof(EntryHeader) + (mip * sizeof(MipEntry)), sizeof(MipEntry));
+
+            if ( format == FormatRGBA8888 )
+            {
+                texture->setData(mip, layer, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, data + entry.offset);
+            }
+            else
+            {
+                texture->setCompressedData(mip, layer, static_cast<int>(entry.size), data + entry.offset);
+            }
+        }
+    }
+
+    bool VTFTextureCache::store(const FileFormats::VPKIndexTreeItem *item, const QByteArray &entry) const
+    {
+        if ( !isEnabled() || !item || entry.isEmpty() )
+        {
+            return false;
+        }
+
+        const QString path = entryPath(item);
+        if ( !QDir().mkpath(m_szDirectory) )
+        {
+            qCWarning(lcVTFTextureCache) << "Could not create cache directory" << m_szDirectory;
+            return false;
+        }
+
+        // Write to a temporary file first so that a partially written entry is never picked up.
+        QSaveFile file(path);
+        if ( !file.open(QIODevice::WriteOnly) ||
+             file.write(entry) != entry.length() ||
+             !file.commit() )
+        {
+            qCWarning(lcVTFTextureCache) << "Could not write cache entry" << path << "-" << file.errorString();
+            return false;
+        }
+
+        return true;
+    }
+}
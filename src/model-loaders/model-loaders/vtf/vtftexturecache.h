@@ -0,0 +1,109 @@
+#ifndef VTFTEXTURECACHE_H
+#define VTFTEXTURECACHE_H
+
+#include "model-loaders_global.h"
+#include "file-formats/vpk/vpkindextreeitem.h"
+#include "renderer/functors/itextureretrievalfunctor.h"
+#include <QByteArray>
+#include <QLoggingCategory>
+#include <QSize>
+#include <QString>
+
+namespace ModelLoaders
+{
+    Q_DECLARE_LOGGING_CATEGORY(lcVTFTextureCache)
+
+    // On-disk cache of GPU-ready mip chains for textures held in VPKs.
+    // Entries are content-addressed by the CRC and size recorded in the VPK index,
+    // so a texture found in the cache is uploaded without touching the VPK archive
+    // or parsing the VTF. Each entry is laid out so that it can be mapped and the
+    // mip levels handed straight to OpenGL.
+    class MODELLOADERSSHARED_EXPORT VTFTextureCache
+    {
+    public:
+        // Formats a cached mip chain can be stored in.
+        // Block compressed VTFs are stored as-is, everything else is transcoded to RGBA8888.
+        enum CacheFormat
+        {
+            FormatInvalid = 0,
+            FormatDXT1,
+            FormatDXT3,
+            FormatDXT5,
+            FormatRGBA8888
+        };
+
+        // Image stored in an entry.
+        struct EntryDescription
+        {
+            CacheFormat format;
+            quint32 width;
+            quint32 height;
+            quint32 mipCount;
+        };
+
+        // An empty directory disables the cache.
+        explicit VTFTextureCache(const QString& directory = QString());
+
+        static QString defaultDirectory();
+
+        QString directory() const;
+        void setDirectory(const QString& directory);
+        bool isEnabled() const;
+
+        QString entryPath(const FileFormats::VPKIndexTreeItem* item) const;
+        bool contains(const FileFormats::VPKIndexTreeItem* item) const;
+
+        // Maps the cached entry for this item and uploads it to the texture.
+        // Returns false if there is no usable entry; invalid entries are removed.
+        bool loadCached(const FileFormats::VPKIndexTreeItem* item, Renderer::OpenGLTexturePointer& texture) const;
+
+        // Reads the cached entry for this item into memory without uploading it.
+        // Returns an empty array if there is no usable entry; invalid entries are removed.
+        QByteArray readCached(const FileFormats::VPKIndexTreeItem* item) const;
+
+        // Reads the image size from the header of the cached entry for this item, without reading the image data.
+        // Returns an invalid size if there is no entry or its header doesn't match the item.
+        QSize cachedImageSize(const FileFormats::VPKIndexTreeItem* item) const;
+
+        // Transcodes the VTF data, uploads it to the texture and writes it to the cache.
+        // Failing to write the cache entry is not an error.
+        bool loadAndStore(const FileFormats::VPKIndexTreeItem* item, const QByteArray& vtfData,
+                          Renderer::OpenGLTexturePointer& texture, QString* errorHint = Q_NULLPTR) const;
+
+        // Writes an entry produced by transcode() for this item.
+        // This only touches the file system, so it may be called from any thread.
+        bool store(const FileFormats::VPKIndexTreeItem* item, const QByteArray& entry) const;
+
+        // Builds a cache entry from VTF data.
+        // crc and size identify the source and are recorded in the entry.
+        static QByteArray transcode(const QByteArray& vtfData, quint32 crc, quint32 size, QString* errorHint = Q_NULLPTR);
+
+        // Reads the image size from the header of VTF data.
+        // Returns an invalid size if the data doesn't start with a VTF header.
+        static QSize vtfImageSize(const QByteArray& vtfData);
+
+        // Number of bytes from the start of the VTF data that vtfImageSize() reads.
+        static int vtfImageSizeBytes();
+
+        // Checks that an entry is well formed and describes the given source.
+        static bool validate(const uchar* data, qint64 length, quint32 crc, quint32 size, QString* errorHint = Q_NULLPTR);
+
+        static EntryDescription describe(const uchar* data);
+
+        // Uploads a validated entry.
+        static void upload(const uchar* data, Renderer::OpenGLTexturePointer& texture);
+
+        // Allocates storage for a 2D array texture with the given number of layers,
+        // each with the same image description as the entry.
+        static void allocateArray(const uchar* data, Renderer::OpenGLTexturePointer& texture, int layers);
+
+        // Uploads a validated entry into one layer of a texture allocated by allocateArray().
+        // The entry must have the same image description that the array was allocated with.
+        static void uploadLayer(const uchar* data, Renderer::OpenGLTexturePointer& texture, int layer);
+
+    private:
+        QString m_szDirectory;
+    };
+}
+
+#endif // VTFTEXTURECACHE_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += opengl
+QT       += opengl concurrent
 
 TARGET = model
 TEMPLATE = lib
@@ -21,11 +21,15 @@ SOURCES += \
     model/controller-adapters/mouseeventmap.cpp \
     model/core/datachangenotifier.cpp \
     model/events/spatialconfigurationchange.cpp \
+    model/factories/brushgeometrycache.cpp \
     model/factories/genericbrushfactory.cpp \
     model/factories/geometryfactory.cpp \
     model/genericbrush/genericbrush.cpp \
     model/genericbrush/genericbrushface.cpp \
     model/genericbrush/textureplane.cpp \
+    model/math/arraywinding3d.cpp \
+    model/math/boundingbox.cpp \
+    model/math/doubleplane3d.cpp \
     model/math/eulerangle.cpp \
     model/math/fuzzyvertexmap.cpp \
     model/math/modelmath.cpp \
@@ -43,9 +47,13 @@ SOURCES += \
     model/sceneobjects/debugcube.cpp \
     model/sceneobjects/debugtriangle.cpp \
     model/sceneobjects/originmarker.cpp \
+    model/sceneobjects/mapentity.cpp \
+    model/sceneobjects/mapgroup.cpp \
+    model/sceneobjects/displacement.cpp \
     model/scenerenderer/scenerenderer.cpp \
     model/shaders/simplelitshader.cpp \
     model/shaders/unlitpervertexcolorshader.cpp \
+    model/shaders/simplelittexturearrayshader.cpp \
     model/stores/materialstore.cpp \
     model/stores/shaderstore.cpp \
     model/stores/texturestore.cpp \
@@ -72,11 +80,16 @@ HEADERS += \
     model/core/datachangenotifier.h \
     model/events/modeleventtypes.h \
     model/events/spatialconfigurationchange.h \
+    model/factories/brushgeometrycache.h \
     model/factories/genericbrushfactory.h \
     model/factories/geometryfactory.h \
     model/genericbrush/genericbrush.h \
     model/genericbrush/genericbrushface.h \
     model/genericbrush/textureplane.h \
+    model/math/arraywinding3d.h \
+    model/math/boundingbox.h \
+    model/math/doubleplane3d.h \
+    model/math/doublevector3d.h \
     model/math/eulerangle.h \
     model/math/fuzzyvertexmap.h \
     model/math/modelmath.h \
@@ -94,15 +107,22 @@ HEADERS += \
     model/sceneobjects/debugcube.h \
     model/sceneobjects/debugtriangle.h \
     model/sceneobjects/originmarker.h \
+    model/sceneobjects/mapentity.h \
+    model/sceneobjects/mapgroup.h \
+    model/sceneobjects/displacement.h \
     model/scenerenderer/irenderpassclassifier.h \
     model/scenerenderer/scenerenderer.h \
     model/shaders/simplelitshader.h \
     model/shaders/unlitpervertexcolorshader.h \
+    model/shaders/simplelittexturearrayshader.h \
     model/stores/materialstore.h \
+    model/stores/imaterialresolver.h \
+    model/stores/itextureresolver.h \
     model/stores/shaderstore.h \
     model/stores/texturestore.h \
     model/global/resourceenvironment.h \
     model/scene/mapscene.h \
+    model/scene/mapvisgroup.h \
     model/scenerenderer/simplerenderpassclassifier.h \
     model/filedatamodels/base/basefiledatamodel.h \
     model/filedatamodels/map/mapfiledatamodel.h \
@@ -0,0 +1,210 @@
+#include "brushgeometrycache.h"
+#include <QMutexLocker>
+
+namespace Model
+{
+    namespace
+    {
+        // Below these, planes are treated as the same. Normals of copied brushes are usually
+        // bitwise identical, but distances pick up rounding error when they are made relative.
+        const double NORMAL_QUANTUM = 1e-9;
+        const double DISTANCE_QUANTUM = 1e-6;
+
+        // How far from parallel the planes used for the anchor must be.
+        const double MIN_ANCHOR_SIN_SQUARED = 0.1;
+        const double MIN_ANCHOR_DETERMINANT = 0.1;
+
+        inline void appendInteger(QByteArray &data, qint64 value)
+        {
+            data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        inline void appendQuantized(QByteArray &data, double value, double quantum)
+        {
+            appendInteger(data, qRound64(value / quantum));
+        }
+
+        // The point where three well conditioned planes meet, if there are any.
+        bool findAnchor(const QList<DoublePlane3D> &planes, DoubleVector3D &anchor)
+        {
+            if ( planes.count() < 3 )
+                return false;
+
+            const DoublePlane3D &p0 = planes.at(0);
+
+            for ( int i = 1; i < planes.count(); i++ )
+            {
+                const DoublePlane3D &p1 = planes.at(i);
+                const DoubleVector3D n0xn1 = DoubleVector3D::crossProduct(p0.normal(), p1.normal());
+                if ( DoubleVector3D::dotProduct(n0xn1, n0xn1) < MIN_ANCHOR_SIN_SQUARED )
+                    continue;
+
+                for ( int j = i + 1; j < planes.count(); j++ )
+                {
+                    const DoublePlane3D &p2 = planes.at(j);
+                    const double determinant = DoubleVector3D::dotProduct(n0xn1, p2.normal());
+                    if ( qAbs(determinant) < MIN_ANCHOR_DETERMINANT )
+                        continue;
+
+                    anchor = ((p0.distance() * DoubleVector3D::crossProduct(p1.normal(), p2.normal())) +
+                              (p1.distance() * DoubleVector3D::crossProduct(p2.normal(), p0.normal())) +
+                              (p2.distance() * n0xn1)) * (1.0 / determinant);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    }
+
+    BrushGeometryCache::BrushGeometryCache()
+        : m_iHits(0), m_iMisses(0)
+    {
+    }
+
+    BrushGeometryCache::Key BrushGeometryCache::keyFor(const QList<TexturedWinding*> &windings)
+    {
+        Key key;
+        if ( windings.isEmpty() )
+            return key;
+
+        QList<DoublePlane3D> planes;
+        planes.reserve(windings.count());
+        for ( int i = 0; i < windings.count(); i++ )
+        {
+            planes.append(windings.at(i)->clipPlane());
+        }
+
+        if ( !findAnchor(planes, key.m_vecAnchor) )
+            return key;
+
+        QByteArray data;
+        data.reserve((2 + (planes.count() * 4)) * static_cast<int>(sizeof(qint64)));
+
+        // Windings clipped at different precisions may not produce the same geometry.
+        appendInteger(data, windings.at(0)->precision());
+        appendInteger(data, planes.count());
+
+        foreach ( const DoublePlane3D &plane, planes )
+        {
+            const DoubleVector3D normal = plane.normal();
+            appendQuantized(data, normal.x(), NORMAL_QUANTUM);
+            appendQuantized(data, normal.y(), NORMAL_QUANTUM);
+            appendQuantized(data, normal.z(), NORMAL_QUANTUM);
+            appendQuantized(data, plane.distance() - DoubleVector3D::dotProduct(normal, key.m_vecAnchor), DISTANCE_QUANTUM);
+        }
+
+        key.m_Data = data;
+        return key;
+    }
+
+    bool BrushGeometryCache::find(const Key &key, PreparedBrushGeometry &geometry, int order, int* source)
+    {
+        if ( !key.isValid() )
+            return false;
+
+        QMutexLocker locker(&m_Mutex);
+
+        if ( !lookUp(key, geometry, order, source) )
+        {
+            m_iMisses++;
+            return false;
+        }
+
+        m_iHits++;
+        return true;
+    }
+
+    bool BrushGeometryCache::findFirst(const Key &key, PreparedBrushGeometry &geometry, int order, int* source) const
+    {
+        if ( !key.isValid() )
+            return false;
+
+        QMutexLocker locker(&m_Mutex);
+        return lookUp(key, geometry, order, source);
+    }
+
+    bool BrushGeometryCache::lookUp(const Key &key, PreparedBrushGeometry &geometry, int order, int* source) const
+    {
+        QHash<QByteArray, Entry>::const_iterator it = m_Entries.constFind(key.m_Data);
+        if ( it == m_Entries.constEnd() || it.value().order > order )
+            return false;
+
+        const Entry &entry = it.value();
+        geometry.faceIndices = entry.faceIndices;
+
+        if ( source )
+        {
+            *source = entry.order;
+        }
+
+        // A brush in exactly the same place can share the vertices too.
+        if ( key.m_vecAnchor == entry.anchor )
+        {
+            geometry.vertices = entry.vertices;
+            return true;
+        }
+
+        geometry.vertices.resize(entry.relativeVertices.count());
+        for ( int i = 0; i < entry.relativeVertices.count(); i++ )
+        {
+            geometry.vertices[i] = (entry.relativeVertices.at(i) + key.m_vecAnchor).toVector3D();
+        }
+
+        return true;
+    }
+
+    void BrushGeometryCache::insert(const Key &key, const PreparedBrushGeometry &geometry, int order)
+    {
+        if ( !key.isValid() )
+            return;
+
+        Entry entry;
+        entry.order = order;
+        entry.anchor = key.m_vecAnchor;
+        entry.vertices = geometry.vertices;
+        entry.faceIndices = geometry.faceIndices;
+
+        entry.relativeVertices.resize(geometry.vertices.count());
+        for ( int i = 0; i < geometry.vertices.count(); i++ )
+        {
+            entry.relativeVertices[i] = DoubleVector3D(geometry.vertices.at(i)) - key.m_vecAnchor;
+        }
+
+        QMutexLocker locker(&m_Mutex);
+
+        // Keep whichever entry came from the earliest brush, so that the
+        // entries don't depend on the order in which brushes were inserted.
+        QHash<QByteArray, Entry>::const_iterator it = m_Entries.constFind(key.m_Data);
+        if ( it == m_Entries.constEnd() || order < it.value().order )
+        {
+            m_Entries.insert(key.m_Data, entry);
+        }
+    }
+
+    int BrushGeometryCache::count() const
+    {
+        QMutexLocker locker(&m_Mutex);
+        return m_Entries.count();
+    }
+
+    int BrushGeometryCache::hitCount() const
+    {
+        QMutexLocker locker(&m_Mutex);
+        return m_iHits;
+    }
+
+    int BrushGeometryCache::missCount() const
+    {
+        QMutexLocker locker(&m_Mutex);
+        return m_iMisses;
+    }
+
+    void BrushGeometryCache::clear()
+    {
+        QMutexLocker locker(&m_Mutex);
+        m_Entries.clear();
+        m_iHits = 0;
+        m_iMisses = 0;
+    }
+}
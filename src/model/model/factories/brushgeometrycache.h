@@ -0,0 +1,94 @@
+#ifndef BRUSHGEOMETRYCACHE_H
+#define BRUSHGEOMETRYCACHE_H
+
+#include "model_global.h"
+#include "model/math/texturedwinding.h"
+#include "model/math/doublevector3d.h"
+#include <QVector>
+#include <QVector3D>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <climits>
+
+namespace Model
+{
+    // Clipped brush geometry, ready to be turned into a GenericBrush.
+    // There is one entry in faceIndices per winding, which is empty
+    // if the winding was clipped away entirely.
+    struct PreparedBrushGeometry
+    {
+        QVector<QVector3D> vertices;
+        QVector<QVector<int> > faceIndices;
+    };
+
+    // Remembers the clipped geometry of brushes by their set of planes, so that brushes
+    // which are copies of each other only need to be clipped once. Planes are keyed
+    // relative to a point fixed by the brush's own planes, so a brush that has only been
+    // moved still matches; only its vertices then need offsetting. The face topology is
+    // implicitly shared between every brush built from the same entry.
+    //
+    // Texture axes and materials are not part of the key, and must be applied separately.
+    // The cache may be used from multiple threads at once.
+    //
+    // Entries are ordered, eg. by each brush's position in a file. find() only returns
+    // entries from brushes at or before the given position, and insert() keeps the entry
+    // from the earliest brush. So once every brush up to a position has been looked up,
+    // in whatever order, findFirst() gives the geometry of the first of those brushes
+    // with the key, regardless of which entry was found while the brushes were prepared.
+    class MODELSHARED_EXPORT BrushGeometryCache
+    {
+    public:
+        class Key
+        {
+            friend class BrushGeometryCache;
+        public:
+            // Invalid keys are never found, and inserting them does nothing.
+            inline bool isValid() const
+            {
+                return !m_Data.isEmpty();
+            }
+
+        private:
+            QByteArray      m_Data;
+            DoubleVector3D  m_vecAnchor;
+        };
+
+        BrushGeometryCache();
+
+        // Brushes that don't have three planes meeting at a well defined point
+        // are given invalid keys.
+        static Key keyFor(const QList<TexturedWinding*> &windings);
+
+        // If source is given, it receives the order of the brush the geometry came from.
+        bool find(const Key &key, PreparedBrushGeometry &geometry, int order = INT_MAX, int* source = Q_NULLPTR);
+        void insert(const Key &key, const PreparedBrushGeometry &geometry, int order = INT_MAX);
+
+        // As find(), but not counted as a hit or a miss.
+        bool findFirst(const Key &key, PreparedBrushGeometry &geometry, int order, int* source = Q_NULLPTR) const;
+
+        int count() const;
+        int hitCount() const;
+        int missCount() const;
+        void clear();
+
+    private:
+        struct Entry
+        {
+            int                         order;
+            DoubleVector3D              anchor;
+            QVector<QVector3D>          vertices;
+            QVector<DoubleVector3D>     relativeVertices;
+            QVector<QVector<int> >      faceIndices;
+        };
+
+        bool lookUp(const Key &key, PreparedBrushGeometry &geometry, int order, int* source) const;
+
+        mutable QMutex              m_Mutex;
+        QHash<QByteArray, Entry>    m_Entries;
+        int                         m_iHits;
+        int                         m_iMisses;
+    };
+}
+
+#endif // BRUSHGEOMETRYCACHE_H
@@ -6,31 +6,73 @@ namespace Model
 {
     namespace GenericBrushFactory
     {
-        GenericBrush* createBrushFromWindingGroup(SceneObject* parent, QList<TexturedWinding*>& windings)
+        GenericBrush* createBrushFromWindingGroup(SceneObject* parent, QList<TexturedWinding*>& windings,
+                                                  BrushGeometryCache* cache)
+        {
+            return createBrushFromPreparedGeometry(parent, windings, prepareBrushGeometry(windings, cache));
+        }
+
+        PreparedBrushGeometry prepareBrushGeometry(QList<TexturedWinding*>& windings, BrushGeometryCache* cache,
+                                                   int order, int* source)
+        {
+            PreparedBrushGeometry geometry;
+
+            BrushGeometryCache::Key key;
+            if ( cache )
+            {
+                key = BrushGeometryCache::keyFor(windings);
+                if ( cache->find(key, geometry, order, source) )
+                    return geometry;
+            }
+
+            if ( source )
+            {
+                *source = order;
+            }
+
+            ModelMath::clipWindingsWithEachOther<TexturedWinding>(windings);
+            geometry.vertices = ModelMath::windingsToVertices<TexturedWinding>(windings).toVector();
+
+            geometry.faceIndices.reserve(windings.count());
+            for ( int i = 0; i < windings.count(); i++ )
+            {
+                geometry.faceIndices.append(windings.at(i)->vertexIndices().toVector());
+            }
+
+            if ( cache )
+            {
+                cache->insert(key, geometry, order);
+            }
+
+            return geometry;
+        }
+
+        GenericBrush* createBrushFromPreparedGeometry(SceneObject* parent,
+                                                      const QList<TexturedWinding*>& windings,
+                                                      const PreparedBrushGeometry& geometry)
         {
             Q_ASSERT_X(parent, Q_FUNC_INFO, "Parent object must be provided!");
+            Q_ASSERT_X(windings.count() == geometry.faceIndices.count(), Q_FUNC_INFO, "Geometry must have one face per winding!");
 
             Scene* scene = parent->parentScene();
             Q_ASSERT_X(scene, Q_FUNC_INFO, "Scene must be valid!");
 
-            ModelMath::clipWindingsWithEachOther<TexturedWinding>(windings);
-            QList<QVector3D> vertices = ModelMath::windingsToVertices<TexturedWinding>(windings);
-
             GenericBrush* brush = scene->createSceneObject<GenericBrush>(parent);
-            if ( vertices.count() < 1 )
+            if ( geometry.vertices.count() < 1 )
                 return brush;
 
-            brush->appendBrushVertices(vertices.toVector());
+            // Shared with the geometry, and so with any other brushes built from it.
+            brush->setBrushVertices(geometry.vertices);
 
-            for ( int i = 0; i < windings.count(); i++ )
+            for ( int i = 0; i < geometry.faceIndices.count(); i++ )
             {
-                TexturedWinding* windingFace = windings.at(i);
-                if ( windingFace->vertexCount() < 1 )
+                const QVector<int>& indices = geometry.faceIndices.at(i);
+                if ( indices.isEmpty() )
                     continue;
 
                 GenericBrushFace* face = brush->createAndObtainBrushFace();
-                face->texturePlane()->setMaterialId(windingFace->materialId());
-                face->appendIndices(windingFace->vertexIndices().toVector());
+                face->texturePlane()->setMaterialId(windings.at(i)->materialId());
+                face->setIndices(indices);
             }
 
             return brush;
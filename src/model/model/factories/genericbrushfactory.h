@@ -4,13 +4,30 @@
 #include "model_global.h"
 #include "model/genericbrush/genericbrush.h"
 #include "model/math/texturedwinding.h"
+#include "brushgeometrycache.h"
 #include <QVector>
 
 namespace Model
 {
     namespace GenericBrushFactory
     {
-        MODELSHARED_EXPORT GenericBrush* createBrushFromWindingGroup(SceneObject* parent, QList<TexturedWinding*>& windings);
+        // If a cache is given, brushes with the same planes as one already built reuse its geometry.
+        MODELSHARED_EXPORT GenericBrush* createBrushFromWindingGroup(SceneObject* parent, QList<TexturedWinding*>& windings,
+                                                                     BrushGeometryCache* cache = Q_NULLPTR);
+
+        // The two halves of createBrushFromWindingGroup(). Preparing clips the windings against
+        // each other and welds their vertices, unless the geometry is found in the cache, in
+        // which case the windings are left unclipped. It does not touch the scene, so different
+        // winding groups may be prepared concurrently. The order and source are as for
+        // BrushGeometryCache::find(); if the geometry isn't found, the source is the given order.
+        MODELSHARED_EXPORT PreparedBrushGeometry prepareBrushGeometry(QList<TexturedWinding*>& windings,
+                                                                      BrushGeometryCache* cache = Q_NULLPTR,
+                                                                      int order = INT_MAX, int* source = Q_NULLPTR);
+
+        // Only the materials are taken from the windings.
+        MODELSHARED_EXPORT GenericBrush* createBrushFromPreparedGeometry(SceneObject* parent,
+                                                                         const QList<TexturedWinding*>& windings,
+                                                                         const PreparedBrushGeometry& geometry);
         MODELSHARED_EXPORT GenericBrush* createBrushFromMinMaxVectors(SceneObject* parent, const QVector3D& min, const QVector3D& max);
     }
 }
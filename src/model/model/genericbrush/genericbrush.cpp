@@ -27,6 +27,11 @@ namespace Model
         }
     }
 
+    BoundingBox GenericBrush::computeLocalBounds() const
+    {
+        return BoundingBox::fromPoints(m_BrushVertices);
+    }
+
     void GenericBrush::commonInit()
     {
 
@@ -46,12 +51,21 @@ namespace Model
     int GenericBrush::appendBrushVertex(const QVector3D &v)
     {
         m_BrushVertices.append(v);
+        flagNeedsRendererUpdate();
         return m_BrushVertices.count() - 1;
     }
 
     void GenericBrush::appendBrushVertices(const QVector<QVector3D> &verts)
     {
         m_BrushVertices.append(verts);
+        flagNeedsRendererUpdate();
+    }
+
+    void GenericBrush::setBrushVertices(const QVector<QVector3D> &verts)
+    {
+        // Implicitly shared until one or the other is modified.
+        m_BrushVertices = verts;
+        flagNeedsRendererUpdate();
     }
 
     int GenericBrush::brushVertexCount() const
@@ -68,6 +82,7 @@ namespace Model
         }
 
         m_BrushVertices.removeAt(index);
+        flagNeedsRendererUpdate();
     }
 
     const QVector<QVector3D>& GenericBrush::brushVertexList() const
@@ -78,6 +93,7 @@ namespace Model
     void GenericBrush::clearBrushVertices()
     {
         m_BrushVertices.clear();
+        flagNeedsRendererUpdate();
     }
 
     QVector<QVector3D> GenericBrush::brushVertexList(const QVector<int> &indices) const
@@ -101,6 +117,7 @@ namespace Model
         }
 
         m_BrushVertices.replace(index, v);
+        flagNeedsRendererUpdate();
     }
 
     GenericBrushFace* GenericBrush::brushFaceAt(int index) const
@@ -20,6 +20,7 @@ namespace Model
         QVector3D brushVertexAt(int index) const;
         int appendBrushVertex(const QVector3D &v);
         void appendBrushVertices(const QVector<QVector3D> &verts);
+        void setBrushVertices(const QVector<QVector3D> &verts);
         int brushVertexCount() const;
         void removeBrushVertex(int index);
         const QVector<QVector3D>& brushVertexList() const;
@@ -41,6 +42,7 @@ namespace Model
         virtual ~GenericBrush();
 
         virtual void bakeGeometry(Renderer::GeometryBuilder &builder) const override;
+        virtual BoundingBox computeLocalBounds() const override;
 
     private slots:
         void brushFaceUpdated();
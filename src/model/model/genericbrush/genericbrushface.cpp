@@ -47,6 +47,13 @@ namespace Model
         emit dataChanged();
     }
 
+    void GenericBrushFace::setIndices(const QVector<int> &indices)
+    {
+        // Implicitly shared until one or the other is modified.
+        m_BrushVertexIndices = indices;
+        emit dataChanged();
+    }
+
     int GenericBrushFace::indexCount() const
     {
         return m_BrushVertexIndices.count();
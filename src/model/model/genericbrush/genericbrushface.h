@@ -24,6 +24,7 @@ namespace Model
         int indexAt(int index) const;
         void appendIndex(int i);
         void appendIndices(const QVector<int>& indices);
+        void setIndices(const QVector<int>& indices);
         int indexCount() const;
         void removeIndex(int index);
         QVector<int> indexList() const;
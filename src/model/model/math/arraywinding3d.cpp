@@ -0,0 +1,390 @@
+#include "arraywinding3d.h"
+#include "calliperutil/math/math.h"
+
+using namespace CalliperUtil;
+
+namespace Model
+{
+    namespace
+    {
+        inline QVector3D toVector3D(const QVector3D &vec)
+        {
+            return vec;
+        }
+
+        inline QVector3D toVector3D(const DoubleVector3D &vec)
+        {
+            return vec.toVector3D();
+        }
+
+        // Same tolerance as Plane3D::getPointLocation(), whatever the precision.
+        template<typename REAL>
+        inline Plane3D::PointLocation pointLocation(REAL distance)
+        {
+            if ( qAbs(distance) <= static_cast<REAL>(0.00001) )
+                return Plane3D::OnPlane;
+
+            return distance > 0 ? Plane3D::InFrontOfPlane : Plane3D::BehindPlane;
+        }
+
+        // Four corners of a square in the plane, large enough to cover the whole world.
+        template<typename VECTOR, typename REAL>
+        void blankWindingCorners(const VECTOR &normal, REAL distance, VECTOR *corners)
+        {
+            // Pick an axis that isn't close to the normal and make it lie in the plane.
+            VECTOR basisY = qAbs(normal.z()) > qAbs(normal.x()) && qAbs(normal.z()) > qAbs(normal.y())
+                    ? VECTOR(1,0,0)
+                    : VECTOR(0,0,1);
+
+            basisY = (basisY - (VECTOR::dotProduct(basisY, normal) * normal)).normalized();
+            VECTOR basisX = VECTOR::crossProduct(normal, basisY);
+
+            const REAL extent = static_cast<REAL>(Math::CoordinateSystem::diagonal());
+            basisX = extent * basisX;
+            basisY = extent * basisY;
+
+            const VECTOR org = distance * normal;
+            corners[0] = org - basisX + basisY;
+            corners[1] = org + basisX + basisY;
+            corners[2] = org + basisX - basisY;
+            corners[3] = org - basisX - basisY;
+        }
+
+        // One Sutherland-Hodgman pass, at the precision of the given positions. If nothing
+        // is in front of the plane, vertices lying on it are touched in place and false is
+        // returned. Otherwise the clipped winding is written to the output arrays.
+        template<typename VECTOR, typename REAL, int PREALLOC>
+        bool clipVertices(QVarLengthArray<WindingVertex, PREALLOC> &input,
+                          const VECTOR *positions,
+                          const VECTOR &normal,
+                          REAL distance,
+                          QVarLengthArray<WindingVertex, PREALLOC> &output,
+                          QVarLengthArray<VECTOR, PREALLOC> *outputPositions)
+        {
+            const int count = input.count();
+
+            // Signed distances first, in a loop with no branches so that it can be vectorised.
+            const REAL nx = normal.x();
+            const REAL ny = normal.y();
+            const REAL nz = normal.z();
+
+            QVarLengthArray<REAL, PREALLOC> distances(count);
+            REAL* distanceData = distances.data();
+
+            for ( int i = 0; i < count; i++ )
+            {
+                const VECTOR &pos = positions[i];
+                distanceData[i] = (nx * pos.x()) + (ny * pos.y()) + (nz * pos.z()) - distance;
+            }
+
+            QVarLengthArray<Plane3D::PointLocation, PREALLOC> locations(count);
+            bool anyInFront = false;
+            bool anyOnPlane = false;
+
+            for ( int i = 0; i < count; i++ )
+            {
+                locations[i] = pointLocation(distanceData[i]);
+                anyInFront = anyInFront || locations[i] == Plane3D::InFrontOfPlane;
+                anyOnPlane = anyOnPlane || locations[i] == Plane3D::OnPlane;
+            }
+
+            // Nothing to remove, so only the vertices lying on the plane need touching.
+            if ( !anyInFront )
+            {
+                if ( anyOnPlane )
+                {
+                    for ( int i = 0; i < count; i++ )
+                    {
+                        if ( locations.at(i) == Plane3D::OnPlane )
+                        {
+                            input[i].setPreviousEdgeOriginal(false);
+                            input[i].setNextEdgeOriginal(false);
+                        }
+                    }
+                }
+
+                return false;
+            }
+
+            output.clear();
+            if ( outputPositions )
+            {
+                outputPositions->clear();
+            }
+
+            for ( int i = 0; i < count; i++ )
+            {
+                const int next = (i + 1) % count;
+                const WindingVertex &v0 = input.at(i);
+                const Plane3D::PointLocation plV0 = locations.at(i);
+                const Plane3D::PointLocation plV1 = locations.at(next);
+
+                // Vertices on the plane are kept, but their edges are no longer original.
+                // Vertices behind the plane are kept as they are.
+                if ( plV0 == Plane3D::OnPlane )
+                {
+                    WindingVertex touched(v0);
+                    touched.setPreviousEdgeOriginal(false);
+                    touched.setNextEdgeOriginal(false);
+                    output.append(touched);
+                }
+                else if ( plV0 == Plane3D::BehindPlane )
+                {
+                    output.append(v0);
+                }
+
+                if ( plV0 != Plane3D::InFrontOfPlane && outputPositions )
+                {
+                    outputPositions->append(positions[i]);
+                }
+
+                // Split edges that cross the plane. The part of the edge that is kept is still
+                // original if the edge was; the edge along the plane is not.
+                if ( (plV0 == Plane3D::InFrontOfPlane && plV1 == Plane3D::BehindPlane) ||
+                     (plV0 == Plane3D::BehindPlane && plV1 == Plane3D::InFrontOfPlane) )
+                {
+                    const REAL d0 = distanceData[i];
+                    const REAL d1 = distanceData[next];
+                    const VECTOR &p0 = positions[i];
+                    const VECTOR &p1 = positions[next];
+                    const VECTOR intersection = p0 + ((d0 / (d0 - d1)) * (p1 - p0));
+
+                    if ( plV0 == Plane3D::InFrontOfPlane )
+                    {
+                        output.append(WindingVertex(toVector3D(intersection), false, v0.isNextEdgeOriginal()));
+                    }
+                    else
+                    {
+                        output.append(WindingVertex(toVector3D(intersection), v0.isNextEdgeOriginal(), false));
+                    }
+
+                    if ( outputPositions )
+                    {
+                        outputPositions->append(intersection);
+                    }
+                }
+            }
+
+            return true;
+        }
+    }
+
+    ArrayWinding3D::ArrayWinding3D(const Plane3D &plane) :
+        m_Plane(plane), m_PrecisePlane(plane), m_iPrecision(SinglePrecision), m_iCurrent(0)
+    {
+        createBlankWinding();
+    }
+
+    ArrayWinding3D::ArrayWinding3D(const DoublePlane3D &plane, Precision precision) :
+        m_Plane(plane.toPlane3D()), m_PrecisePlane(plane), m_iPrecision(precision), m_iCurrent(0)
+    {
+        // Behave exactly as if we were given the float plane.
+        if ( m_iPrecision == SinglePrecision )
+        {
+            m_PrecisePlane = DoublePlane3D(m_Plane);
+        }
+
+        createBlankWinding();
+    }
+
+    bool ArrayWinding3D::isNull() const
+    {
+        return m_Plane.isNull();
+    }
+
+    // To be closed, we must have no original vertices left,
+    // but we must not be empty.
+    bool ArrayWinding3D::isClosed() const
+    {
+        const VertexArray& current = vertices();
+        if ( current.count() < 1 )
+            return false;
+
+        for ( int i = 0; i < current.count(); i++ )
+        {
+            if ( current.at(i).isNextEdgeOriginal() )
+                return false;
+        }
+
+        return true;
+    }
+
+    ArrayWinding3D::Precision ArrayWinding3D::precision() const
+    {
+        return m_iPrecision;
+    }
+
+    void ArrayWinding3D::createBlankWinding()
+    {
+        m_iCurrent = 0;
+        m_Vertices[0].clear();
+        m_Vertices[1].clear();
+        m_Positions[0].clear();
+        m_Positions[1].clear();
+
+        if ( isNull() )
+        {
+            return;
+        }
+
+        VertexArray& current = vertices();
+
+        if ( m_iPrecision == DoublePrecision )
+        {
+            DoubleVector3D corners[4];
+            blankWindingCorners(m_PrecisePlane.normal(), m_PrecisePlane.distance(), corners);
+
+            for ( int i = 0; i < 4; i++ )
+            {
+                current.append(WindingVertex(corners[i].toVector3D(), true, true));
+                m_Positions[m_iCurrent].append(corners[i]);
+            }
+        }
+        else
+        {
+            QVector3D corners[4];
+            blankWindingCorners(m_Plane.normal(), m_Plane.distance(), corners);
+
+            for ( int i = 0; i < 4; i++ )
+            {
+                current.append(WindingVertex(corners[i], true, true));
+            }
+        }
+    }
+
+    ArrayWinding3D& ArrayWinding3D::clip(const Plane3D &clipPlane)
+    {
+        return clip(DoublePlane3D(clipPlane));
+    }
+
+    ArrayWinding3D& ArrayWinding3D::clip(const DoublePlane3D &clipPlane)
+    {
+        VertexArray& input = vertices();
+        const int count = input.count();
+
+        if ( clipPlane.isNull() || count < 1 )
+            return *this;
+
+        const int other = 1 - m_iCurrent;
+        bool clipped = false;
+
+        if ( m_iPrecision == DoublePrecision )
+        {
+            clipped = clipVertices<DoubleVector3D, double, PREALLOCATED_VERTICES>(
+                        input, m_Positions[m_iCurrent].constData(),
+                        clipPlane.normal(), clipPlane.distance(),
+                        m_Vertices[other], &m_Positions[other]);
+        }
+        else
+        {
+            QVarLengthArray<QVector3D, PREALLOCATED_VERTICES> positions(count);
+            for ( int i = 0; i < count; i++ )
+            {
+                positions[i] = input.at(i).position();
+            }
+
+            const Plane3D plane = clipPlane.toPlane3D();
+            clipped = clipVertices<QVector3D, float, PREALLOCATED_VERTICES>(
+                        input, positions.constData(),
+                        plane.normal(), plane.distance(),
+                        m_Vertices[other], Q_NULLPTR);
+        }
+
+        if ( clipped )
+        {
+            m_iCurrent = other;
+        }
+
+        return *this;
+    }
+
+    ArrayWinding3D& ArrayWinding3D::clip(const QList<Plane3D> &clipPlanes)
+    {
+        foreach ( const Plane3D &clipPlane, clipPlanes )
+        {
+            // Once it's gone, there's nothing left to clip.
+            if ( vertices().isEmpty() )
+                break;
+
+            clip(clipPlane);
+        }
+
+        return *this;
+    }
+
+    ArrayWinding3D& ArrayWinding3D::clip(const QList<DoublePlane3D> &clipPlanes)
+    {
+        foreach ( const DoublePlane3D &clipPlane, clipPlanes )
+        {
+            if ( vertices().isEmpty() )
+                break;
+
+            clip(clipPlane);
+        }
+
+        return *this;
+    }
+
+    QList<QVector3D> ArrayWinding3D::vertexList() const
+    {
+        const VertexArray& current = vertices();
+
+        QList<QVector3D> list;
+        list.reserve(current.count());
+        for ( int i = 0; i < current.count(); i++ )
+        {
+            list.append(current.at(i).position());
+        }
+        return list;
+    }
+
+    QList<int> ArrayWinding3D::vertexIndices() const
+    {
+        const VertexArray& current = vertices();
+
+        QList<int> indices;
+        indices.reserve(current.count());
+        for ( int i = 0; i < current.count(); i++ )
+        {
+            indices.append(current.at(i).index());
+        }
+        return indices;
+    }
+
+    int ArrayWinding3D::vertexCount() const
+    {
+        return vertices().count();
+    }
+
+    ArrayWinding3D::VertexIterator ArrayWinding3D::verticesBegin()
+    {
+        return vertices().data();
+    }
+
+    ArrayWinding3D::ConstVertexIterator ArrayWinding3D::verticesBegin() const
+    {
+        return vertices().constData();
+    }
+
+    ArrayWinding3D::VertexIterator ArrayWinding3D::verticesEnd()
+    {
+        VertexArray& current = vertices();
+        return current.data() + current.count();
+    }
+
+    ArrayWinding3D::ConstVertexIterator ArrayWinding3D::verticesEnd() const
+    {
+        const VertexArray& current = vertices();
+        return current.constData() + current.count();
+    }
+
+    Plane3D ArrayWinding3D::plane() const
+    {
+        return m_Plane;
+    }
+
+    DoublePlane3D ArrayWinding3D::clipPlane() const
+    {
+        return m_PrecisePlane;
+    }
+}
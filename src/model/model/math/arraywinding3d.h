@@ -0,0 +1,98 @@
+#ifndef ARRAYWINDING3D_H
+#define ARRAYWINDING3D_H
+
+#include "model_global.h"
+#include <QVarLengthArray>
+#include <QVector3D>
+#include <QList>
+#include "plane3d.h"
+#include "doubleplane3d.h"
+#include "windingvertex.h"
+
+namespace Model
+{
+    // A convex winding with the same behaviour as Winding3D, but with its vertices held
+    // in a contiguous array. Clipping is a single Sutherland-Hodgman pass from one array
+    // into the other, so most windings clip without touching the heap at all.
+    //
+    // In double precision mode the winding keeps double precision positions and planes
+    // alongside its vertices, and only rounds to float when writing vertex positions.
+    // This avoids the slivers that float clipping produces on large maps with off-grid
+    // planes, at some cost in speed.
+    class MODELSHARED_EXPORT ArrayWinding3D
+    {
+    public:
+        typedef WindingVertex* VertexIterator;
+        typedef const WindingVertex* ConstVertexIterator;
+        typedef DoublePlane3D ClipPlane;
+
+        enum Precision
+        {
+            SinglePrecision,
+            DoublePrecision
+        };
+
+        explicit ArrayWinding3D(const Plane3D &plane);
+        ArrayWinding3D(const DoublePlane3D &plane, Precision precision);
+
+        bool isNull() const;
+        bool isClosed() const;
+        Precision precision() const;
+
+        QList<QVector3D> vertexList() const;
+        QList<int> vertexIndices() const;
+
+        ArrayWinding3D& clip(const Plane3D &clipPlane);
+        ArrayWinding3D& clip(const QList<Plane3D> &clipPlanes);
+
+        // In single precision mode the plane is rounded to float first.
+        ArrayWinding3D& clip(const DoublePlane3D &clipPlane);
+        ArrayWinding3D& clip(const QList<DoublePlane3D> &clipPlanes);
+
+        int vertexCount() const;
+
+        VertexIterator verticesBegin();
+        ConstVertexIterator verticesBegin() const;
+        VertexIterator verticesEnd();
+        ConstVertexIterator verticesEnd() const;
+
+        Plane3D plane() const;
+
+        // The plane at the winding's precision, for clipping other windings.
+        DoublePlane3D clipPlane() const;
+
+    private:
+        // Enough for all but the most finely clipped faces.
+        enum
+        {
+            PREALLOCATED_VERTICES = 16
+        };
+
+        typedef QVarLengthArray<WindingVertex, PREALLOCATED_VERTICES> VertexArray;
+        typedef QVarLengthArray<DoubleVector3D, PREALLOCATED_VERTICES> PositionArray;
+
+        void createBlankWinding();
+
+        inline VertexArray& vertices()
+        {
+            return m_Vertices[m_iCurrent];
+        }
+
+        inline const VertexArray& vertices() const
+        {
+            return m_Vertices[m_iCurrent];
+        }
+
+        Plane3D         m_Plane;
+        DoublePlane3D   m_PrecisePlane;
+        Precision       m_iPrecision;
+
+        // Clipping reads from the current arrays and writes to the others.
+        // Positions are only kept in double precision mode.
+        VertexArray     m_Vertices[2];
+        PositionArray   m_Positions[2];
+        int             m_iCurrent;
+    };
+}
+
+#endif // ARRAYWINDING3D_H
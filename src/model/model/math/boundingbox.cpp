@@ -0,0 +1,182 @@
+#include "boundingbox.h"
+#include "ray3d.h"
+#include <limits>
+
+namespace Model
+{
+    QDebug operator <<(QDebug debug, const BoundingBox &box)
+    {
+        if ( box.isNull() )
+        {
+            debug.nospace() << "BoundingBox()";
+        }
+        else
+        {
+            debug.nospace() << "BoundingBox(" << box.min() << ", " << box.max() << ")";
+        }
+
+        return debug.space();
+    }
+
+    // Min is greater than max, so that any point united with the box becomes both.
+    BoundingBox::BoundingBox() :
+        m_vecMin(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
+        m_vecMax(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max())
+    {
+    }
+
+    BoundingBox::BoundingBox(const QVector3D &min, const QVector3D &max) :
+        m_vecMin(qMin(min.x(), max.x()), qMin(min.y(), max.y()), qMin(min.z(), max.z())),
+        m_vecMax(qMax(min.x(), max.x()), qMax(min.y(), max.y()), qMax(min.z(), max.z()))
+    {
+    }
+
+    BoundingBox BoundingBox::fromPoints(const QVector<QVector3D> &points)
+    {
+        BoundingBox box;
+        for ( int i = 0; i < points.count(); i++ )
+        {
+            box.unite(points.at(i));
+        }
+
+        return box;
+    }
+
+    bool BoundingBox::isNull() const
+    {
+        return m_vecMin.x() > m_vecMax.x();
+    }
+
+    QVector3D BoundingBox::min() const
+    {
+        return m_vecMin;
+    }
+
+    QVector3D BoundingBox::max() const
+    {
+        return m_vecMax;
+    }
+
+    QVector3D BoundingBox::centre() const
+    {
+        return isNull() ? QVector3D() : (m_vecMin + m_vecMax) / 2.0f;
+    }
+
+    QVector3D BoundingBox::extent() const
+    {
+        return isNull() ? QVector3D() : m_vecMax - m_vecMin;
+    }
+
+    BoundingBox& BoundingBox::unite(const QVector3D &point)
+    {
+        m_vecMin = QVector3D(qMin(m_vecMin.x(), point.x()), qMin(m_vecMin.y(), point.y()), qMin(m_vecMin.z(), point.z()));
+        m_vecMax = QVector3D(qMax(m_vecMax.x(), point.x()), qMax(m_vecMax.y(), point.y()), qMax(m_vecMax.z(), point.z()));
+        return *this;
+    }
+
+    BoundingBox& BoundingBox::unite(const BoundingBox &other)
+    {
+        if ( other.isNull() )
+            return *this;
+
+        unite(other.m_vecMin);
+        unite(other.m_vecMax);
+        return *this;
+    }
+
+    BoundingBox BoundingBox::united(const BoundingBox &other) const
+    {
+        BoundingBox box(*this);
+        return box.unite(other);
+    }
+
+    bool BoundingBox::contains(const QVector3D &point) const
+    {
+        return point.x() >= m_vecMin.x() && point.x() <= m_vecMax.x() &&
+               point.y() >= m_vecMin.y() && point.y() <= m_vecMax.y() &&
+               point.z() >= m_vecMin.z() && point.z() <= m_vecMax.z();
+    }
+
+    bool BoundingBox::intersects(const BoundingBox &other) const
+    {
+        if ( isNull() || other.isNull() )
+            return false;
+
+        return m_vecMin.x() <= other.m_vecMax.x() && m_vecMax.x() >= other.m_vecMin.x() &&
+               m_vecMin.y() <= other.m_vecMax.y() && m_vecMax.y() >= other.m_vecMin.y() &&
+               m_vecMin.z() <= other.m_vecMax.z() && m_vecMax.z() >= other.m_vecMin.z();
+    }
+
+    bool BoundingBox::intersects(const Ray3D &ray, float *distance) const
+    {
+        if ( isNull() || ray.isNull() )
+            return false;
+
+        const QVector3D origin = ray.origin();
+        const QVector3D direction = ray.direction();
+
+        // Clip the ray against the slab between each pair of faces in turn.
+        float tNear = 0.0f;
+        float tFar = std::numeric_limits<float>::max();
+
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            if ( qFuzzyIsNull(direction[axis]) )
+            {
+                if ( origin[axis] < m_vecMin[axis] || origin[axis] > m_vecMax[axis] )
+                    return false;
+
+                continue;
+            }
+
+            float t0 = (m_vecMin[axis] - origin[axis]) / direction[axis];
+            float t1 = (m_vecMax[axis] - origin[axis]) / direction[axis];
+            if ( t0 > t1 )
+            {
+                qSwap(t0, t1);
+            }
+
+            tNear = qMax(tNear, t0);
+            tFar = qMin(tFar, t1);
+
+            if ( tNear > tFar )
+                return false;
+        }
+
+        if ( distance )
+        {
+            *distance = tNear;
+        }
+
+        return true;
+    }
+
+    BoundingBox BoundingBox::transformed(const QMatrix4x4 &mat) const
+    {
+        if ( isNull() )
+            return BoundingBox();
+
+        BoundingBox box;
+        for ( int i = 0; i < 8; i++ )
+        {
+            box.unite(mat.map(QVector3D(i & 1 ? m_vecMax.x() : m_vecMin.x(),
+                                        i & 2 ? m_vecMax.y() : m_vecMin.y(),
+                                        i & 4 ? m_vecMax.z() : m_vecMin.z())));
+        }
+
+        return box;
+    }
+
+    bool BoundingBox::operator ==(const BoundingBox &other) const
+    {
+        if ( isNull() || other.isNull() )
+            return isNull() == other.isNull();
+
+        return m_vecMin == other.m_vecMin && m_vecMax == other.m_vecMax;
+    }
+
+    bool BoundingBox::operator !=(const BoundingBox &other) const
+    {
+        return !(*this == other);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef BOUNDINGBOX_H
+#define BOUNDINGBOX_H
+
+#include "model_global.h"
+#include <QVector3D>
+#include <QVector>
+#include <QMatrix4x4>
+#include <QtDebug>
+
+namespace Model
+{
+    class Ray3D;
+
+    // An axis-aligned bounding box.
+    class MODELSHARED_EXPORT BoundingBox
+    {
+    public:
+        // Constructs a null box, which contains nothing.
+        BoundingBox();
+        BoundingBox(const QVector3D &min, const QVector3D &max);
+
+        static BoundingBox fromPoints(const QVector<QVector3D> &points);
+
+        // A null box contains nothing, and uniting with it has no effect.
+        bool isNull() const;
+
+        QVector3D min() const;
+        QVector3D max() const;
+        QVector3D centre() const;
+        QVector3D extent() const;
+
+        BoundingBox& unite(const QVector3D &point);
+        BoundingBox& unite(const BoundingBox &other);
+        BoundingBox united(const BoundingBox &other) const;
+
+        bool contains(const QVector3D &point) const;
+        bool intersects(const BoundingBox &other) const;
+
+        // If the ray hits the box, distance is set to how far along the ray it enters the box,
+        // or to zero if the origin is already inside.
+        bool intersects(const Ray3D &ray, float* distance = Q_NULLPTR) const;
+
+        // The box containing this box once transformed, which may be larger than the box itself.
+        BoundingBox transformed(const QMatrix4x4 &mat) const;
+
+        bool operator ==(const BoundingBox &other) const;
+        bool operator !=(const BoundingBox &other) const;
+
+    private:
+        QVector3D   m_vecMin;
+        QVector3D   m_vecMax;
+    };
+
+    QDebug operator <<(QDebug debug, const BoundingBox &box);
+}
+
+#endif // BOUNDINGBOX_H
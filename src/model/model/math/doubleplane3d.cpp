@@ -0,0 +1,54 @@
+#include "doubleplane3d.h"
+
+namespace Model
+{
+    DoublePlane3D::DoublePlane3D() : m_vecNormal(), m_dDistance(0.0)
+    {
+    }
+
+    DoublePlane3D::DoublePlane3D(const DoubleVector3D &normal, double distance) :
+        m_vecNormal(normal.normalized()), m_dDistance(distance)
+    {
+    }
+
+    DoublePlane3D::DoublePlane3D(const DoubleVector3D &v0, const DoubleVector3D &v1, const DoubleVector3D &v2)
+    {
+        m_vecNormal = DoubleVector3D::crossProduct(v1-v0, v2-v0).normalized();
+        m_dDistance = DoubleVector3D::dotProduct(m_vecNormal, v0);
+    }
+
+    DoublePlane3D::DoublePlane3D(const Plane3D &plane) :
+        m_vecNormal(plane.normal()), m_dDistance(plane.distance())
+    {
+    }
+
+    bool DoublePlane3D::isNull() const
+    {
+        return m_vecNormal.isNull();
+    }
+
+    DoubleVector3D DoublePlane3D::normal() const
+    {
+        return m_vecNormal;
+    }
+
+    double DoublePlane3D::distance() const
+    {
+        return m_dDistance;
+    }
+
+    DoubleVector3D DoublePlane3D::origin() const
+    {
+        return m_dDistance * m_vecNormal;
+    }
+
+    double DoublePlane3D::signedDistance(const DoubleVector3D &point) const
+    {
+        return DoubleVector3D::dotProduct(m_vecNormal, point) - m_dDistance;
+    }
+
+    Plane3D DoublePlane3D::toPlane3D() const
+    {
+        return Plane3D(m_vecNormal.toVector3D(), static_cast<float>(m_dDistance));
+    }
+}
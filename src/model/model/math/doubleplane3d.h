@@ -0,0 +1,39 @@
+#ifndef DOUBLEPLANE3D_H
+#define DOUBLEPLANE3D_H
+
+#include "model_global.h"
+#include "doublevector3d.h"
+#include "plane3d.h"
+
+namespace Model
+{
+    // A double precision counterpart to Plane3D. Planes built from three points
+    // keep all of the precision of the points, which Plane3D does not.
+    class MODELSHARED_EXPORT DoublePlane3D
+    {
+    public:
+        // Constructs a null plane with no normal.
+        DoublePlane3D();
+        DoublePlane3D(const DoubleVector3D &normal, double distance);
+        DoublePlane3D(const DoubleVector3D &v0, const DoubleVector3D &v1, const DoubleVector3D &v2);
+        explicit DoublePlane3D(const Plane3D &plane);
+
+        // A null plane has no normal.
+        bool isNull() const;
+
+        DoubleVector3D normal() const;
+        double distance() const;
+        DoubleVector3D origin() const;
+
+        // Positive in front of the plane, negative behind it.
+        double signedDistance(const DoubleVector3D &point) const;
+
+        Plane3D toPlane3D() const;
+
+    private:
+        DoubleVector3D  m_vecNormal;
+        double          m_dDistance;
+    };
+}
+
+#endif // DOUBLEPLANE3D_H
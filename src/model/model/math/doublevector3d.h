@@ -0,0 +1,119 @@
+#ifndef DOUBLEVECTOR3D_H
+#define DOUBLEVECTOR3D_H
+
+#include "model_global.h"
+#include <QVector3D>
+#include <QtMath>
+
+namespace Model
+{
+    // A double precision counterpart to QVector3D, for geometry that needs more precision
+    // than float gives while it is being built. Results are converted back to QVector3D.
+    class DoubleVector3D
+    {
+    public:
+        inline DoubleVector3D() : m_dX(0.0), m_dY(0.0), m_dZ(0.0)
+        {
+        }
+
+        inline DoubleVector3D(double x, double y, double z) : m_dX(x), m_dY(y), m_dZ(z)
+        {
+        }
+
+        inline explicit DoubleVector3D(const QVector3D &vec) : m_dX(vec.x()), m_dY(vec.y()), m_dZ(vec.z())
+        {
+        }
+
+        inline double x() const
+        {
+            return m_dX;
+        }
+
+        inline double y() const
+        {
+            return m_dY;
+        }
+
+        inline double z() const
+        {
+            return m_dZ;
+        }
+
+        inline bool isNull() const
+        {
+            return m_dX == 0.0 && m_dY == 0.0 && m_dZ == 0.0;
+        }
+
+        inline double length() const
+        {
+            return qSqrt(dotProduct(*this, *this));
+        }
+
+        inline DoubleVector3D normalized() const
+        {
+            const double len = length();
+            return len > 0.0 ? DoubleVector3D(m_dX / len, m_dY / len, m_dZ / len) : DoubleVector3D();
+        }
+
+        inline QVector3D toVector3D() const
+        {
+            return QVector3D(static_cast<float>(m_dX), static_cast<float>(m_dY), static_cast<float>(m_dZ));
+        }
+
+        inline DoubleVector3D operator +(const DoubleVector3D &other) const
+        {
+            return DoubleVector3D(m_dX + other.m_dX, m_dY + other.m_dY, m_dZ + other.m_dZ);
+        }
+
+        inline DoubleVector3D operator -(const DoubleVector3D &other) const
+        {
+            return DoubleVector3D(m_dX - other.m_dX, m_dY - other.m_dY, m_dZ - other.m_dZ);
+        }
+
+        inline DoubleVector3D operator -() const
+        {
+            return DoubleVector3D(-m_dX, -m_dY, -m_dZ);
+        }
+
+        inline DoubleVector3D operator *(double factor) const
+        {
+            return DoubleVector3D(m_dX * factor, m_dY * factor, m_dZ * factor);
+        }
+
+        inline friend DoubleVector3D operator *(double factor, const DoubleVector3D &vec)
+        {
+            return vec * factor;
+        }
+
+        inline bool operator ==(const DoubleVector3D &other) const
+        {
+            return m_dX == other.m_dX && m_dY == other.m_dY && m_dZ == other.m_dZ;
+        }
+
+        inline bool operator !=(const DoubleVector3D &other) const
+        {
+            return !(*this == other);
+        }
+
+        static inline double dotProduct(const DoubleVector3D &a, const DoubleVector3D &b)
+        {
+            return (a.m_dX * b.m_dX) + (a.m_dY * b.m_dY) + (a.m_dZ * b.m_dZ);
+        }
+
+        static inline DoubleVector3D crossProduct(const DoubleVector3D &a, const DoubleVector3D &b)
+        {
+            return DoubleVector3D((a.m_dY * b.m_dZ) - (a.m_dZ * b.m_dY),
+                                  (a.m_dZ * b.m_dX) - (a.m_dX * b.m_dZ),
+                                  (a.m_dX * b.m_dY) - (a.m_dY * b.m_dX));
+        }
+
+    private:
+        double  m_dX;
+        double  m_dY;
+        double  m_dZ;
+    };
+}
+
+Q_DECLARE_TYPEINFO(Model::DoubleVector3D, Q_MOVABLE_TYPE);
+
+#endif // DOUBLEVECTOR3D_H
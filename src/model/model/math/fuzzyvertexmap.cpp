@@ -1,11 +1,15 @@
 #include "fuzzyvertexmap.h"
 #include "calliperutil/math/math.h"
 #include <QtMath>
+#include <cmath>
 
 namespace Model
 {
     namespace
     {
+        // Leaves room to step one cell either side without overflowing.
+        const double MAX_CELL_COORDINATE = 2147483646.0;
+
         inline bool floatsCloseEnough(float f1, float f2, float tolerance)
         {
             return qFabs(f1-f2) < tolerance;
@@ -17,53 +21,132 @@ namespace Model
                     floatsCloseEnough(vec1.y(), vec2.y(), tolerance) &&
                     floatsCloseEnough(vec1.z(), vec2.z(), tolerance);
         }
+
+        inline qint32 cellCoordinate(float value, double cellSize)
+        {
+            return static_cast<qint32>(qBound(-MAX_CELL_COORDINATE, std::floor(value / cellSize), MAX_CELL_COORDINATE));
+        }
     }
 
     FuzzyVertexMap::FuzzyVertexMap()
     {
-        m_iNextIndex = 0;
         m_flTolerance = 0.01f;
     }
 
     int FuzzyVertexMap::count() const
     {
-        return m_Map.count();
+        return m_Vertices.count();
     }
 
     void FuzzyVertexMap::clear()
     {
-        m_Map.clear();
-        m_iNextIndex = 0;
+        m_Vertices.clear();
+        m_NextInCell.clear();
+        m_Grid.clear();
     }
 
-    int FuzzyVertexMap::mapToIndex(const QVector3D &vec)
+    void FuzzyVertexMap::reserve(int vertexCount)
     {
-        for ( VertexMap::const_iterator it = m_Map.cbegin(); it != m_Map.cend(); ++it )
+        m_Vertices.reserve(vertexCount);
+        m_NextInCell.reserve(vertexCount);
+        m_Grid.reserve(vertexCount);
+    }
+
+    FuzzyVertexMap::Cell FuzzyVertexMap::cellFor(const QVector3D &vec) const
+    {
+        // Cells are one tolerance wide, so any vertex close enough to this one
+        // is at most one cell away on each axis.
+        const double cellSize = m_flTolerance;
+
+        Cell cell;
+        cell.x = cellCoordinate(vec.x(), cellSize);
+        cell.y = cellCoordinate(vec.y(), cellSize);
+        cell.z = cellCoordinate(vec.z(), cellSize);
+        return cell;
+    }
+
+    void FuzzyVertexMap::insertIntoGrid(int index)
+    {
+        const Cell cell = cellFor(m_Vertices.at(index));
+
+        QHash<Cell, int>::iterator it = m_Grid.find(cell);
+        if ( it == m_Grid.end() )
         {
-            if ( vectorsCloseEnough(vec, it.key(), m_flTolerance) )
-                return it.value();
+            m_NextInCell[index] = -1;
+            m_Grid.insert(cell, index);
         }
+        else
+        {
+            m_NextInCell[index] = it.value();
+            it.value() = index;
+        }
+    }
 
-        m_Map.insert(vec, m_iNextIndex);
-        m_iNextIndex++;
-        return m_iNextIndex - 1;
+    void FuzzyVertexMap::rebuildGrid()
+    {
+        m_Grid.clear();
+        if ( m_flTolerance <= 0.0f )
+        {
+            return;
+        }
+
+        for ( int i = 0; i < m_Vertices.count(); ++i )
+        {
+            insertIntoGrid(i);
+        }
     }
 
-    QList<QVector3D> FuzzyVertexMap::vertexList() const
+    int FuzzyVertexMap::mapToIndex(const QVector3D &vec)
     {
-        QList<QVector3D> list;
-        list.reserve(m_Map.count());
-        for ( int i = 0; i < m_Map.count(); i++ )
+        // Nothing is ever close enough with no tolerance.
+        if ( m_flTolerance > 0.0f )
         {
-            list.append(QVector3D());
+            const Cell centre = cellFor(vec);
+            int match = -1;
+
+            Cell cell;
+            for ( cell.x = centre.x - 1; cell.x <= centre.x + 1; ++cell.x )
+            {
+                for ( cell.y = centre.y - 1; cell.y <= centre.y + 1; ++cell.y )
+                {
+                    for ( cell.z = centre.z - 1; cell.z <= centre.z + 1; ++cell.z )
+                    {
+                        QHash<Cell, int>::const_iterator it = m_Grid.constFind(cell);
+                        if ( it == m_Grid.constEnd() )
+                            continue;
+
+                        for ( int index = it.value(); index >= 0; index = m_NextInCell.at(index) )
+                        {
+                            if ( (match < 0 || index < match) && vectorsCloseEnough(vec, m_Vertices.at(index), m_flTolerance) )
+                            {
+                                match = index;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if ( match >= 0 )
+            {
+                return match;
+            }
         }
 
-        for ( VertexMap::const_iterator it = m_Map.cbegin(); it != m_Map.cend(); ++it )
+        const int index = m_Vertices.count();
+        m_Vertices.append(vec);
+        m_NextInCell.append(-1);
+
+        if ( m_flTolerance > 0.0f )
         {
-            list[it.value()] = it.key();
+            insertIntoGrid(index);
         }
 
-        return list;
+        return index;
+    }
+
+    QList<QVector3D> FuzzyVertexMap::vertexList() const
+    {
+        return m_Vertices.toList();
     }
 
     float FuzzyVertexMap::tolerance() const
@@ -73,6 +156,10 @@ namespace Model
 
     void FuzzyVertexMap::setTolerance(float t)
     {
+        if ( m_flTolerance == t )
+            return;
+
         m_flTolerance = t;
+        rebuildGrid();
     }
 }
@@ -3,12 +3,18 @@
 
 #include "model_global.h"
 #include <QVector3D>
+#include <QVector>
 #include <QHash>
-#include "calliperutil/general/hashfunctions.h"
+#include <QList>
 
 namespace Model
 {
-    class FuzzyVertexMap
+    // Assigns indices to vertices, treating vertices that are closer than the tolerance
+    // on every axis as the same vertex. Vertices are bucketed into a grid of cells one
+    // tolerance wide, so each lookup only needs to check the 27 cells around the vertex.
+    // Where a vertex is close enough to more than one existing vertex, the one added
+    // first is used.
+    class MODELSHARED_EXPORT FuzzyVertexMap
     {
     public:
         FuzzyVertexMap();
@@ -17,16 +23,44 @@ namespace Model
         void clear();
         int count() const;
 
+        // Changing the tolerance doesn't merge vertices that have already been added.
         float tolerance() const;
         void setTolerance(float t);
 
+        void reserve(int vertexCount);
+
         QList<QVector3D> vertexList() const;
 
     private:
-        typedef QHash<QVector3D, int> VertexMap;
+        struct Cell
+        {
+            qint32 x;
+            qint32 y;
+            qint32 z;
+
+            inline bool operator ==(const Cell& other) const
+            {
+                return x == other.x && y == other.y && z == other.z;
+            }
+
+            friend inline uint qHash(const Cell& cell, uint seed = 0)
+            {
+                return ((static_cast<uint>(cell.x) * 73856093u) ^
+                        (static_cast<uint>(cell.y) * 19349663u) ^
+                        (static_cast<uint>(cell.z) * 83492791u)) ^ seed;
+            }
+        };
+
+        Cell cellFor(const QVector3D &vec) const;
+        void insertIntoGrid(int index);
+        void rebuildGrid();
+
+        QVector<QVector3D>  m_Vertices;
+
+        // The first vertex in each cell; the rest are chained through m_NextInCell.
+        QHash<Cell, int>    m_Grid;
+        QVector<int>        m_NextInCell;
 
-        VertexMap   m_Map;
-        int         m_iNextIndex;
         float       m_flTolerance;
     };
 }
@@ -5,6 +5,7 @@
 #include <QMatrix4x4>
 #include "eulerangle.h"
 #include "winding3d.h"
+#include "arraywinding3d.h"
 #include "texturedwinding.h"
 #include <QLinkedList>
 #include "fuzzyvertexmap.h"
@@ -29,13 +30,22 @@ namespace Model
         template<typename T>
         QList<QVector3D> windingsToVertices(const QList<T*>& windings)
         {
-            typedef QLinkedList<WindingVertex> WindingVertexList;
+            typedef typename T::VertexIterator VertexIterator;
             FuzzyVertexMap vertexMap;
 
+            int vertexCount = 0;
             for ( int i = 0; i < windings.count(); i++ )
             {
-                Winding3D* winding = windings.at(i);
-                for ( WindingVertexList::iterator it = winding->verticesBegin(); it != winding->verticesEnd(); ++it )
+                vertexCount += windings.at(i)->vertexCount();
+            }
+
+            // Most vertices are shared by three faces.
+            vertexMap.reserve(vertexCount / 3);
+
+            for ( int i = 0; i < windings.count(); i++ )
+            {
+                T* winding = windings.at(i);
+                for ( VertexIterator it = winding->verticesBegin(); it != winding->verticesEnd(); ++it )
                 {
                     int index = vertexMap.mapToIndex(it->position());
                     it->setIndex(index);
@@ -45,20 +55,23 @@ namespace Model
             return vertexMap.vertexList();
         }
 
+        // Clips with each winding's clip plane, so that windings keep their own precision.
         template<typename T>
         void clipWindingsWithEachOther(const QList<T*>& windings)
         {
-            QList<Plane3D> planes;
+            typedef typename T::ClipPlane ClipPlane;
+
+            QList<ClipPlane> planes;
             for ( int i = 0; i < windings.count(); i++ )
             {
-                planes.append(windings.at(i)->plane());
+                planes.append(windings.at(i)->clipPlane());
             }
 
             for ( int i = 0; i < windings.count(); i++ )
             {
                 // Cache our plane so we can set it to null in the list.
-                Plane3D tempPlane = planes.at(i);
-                planes[i] = Plane3D();
+                ClipPlane tempPlane = planes.at(i);
+                planes[i] = ClipPlane();
 
                 // Clip the winding by the remaining planes.
                 windings.at(i)->clip(planes);
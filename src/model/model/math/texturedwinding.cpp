@@ -3,7 +3,13 @@
 namespace Model
 {
     TexturedWinding::TexturedWinding(const Plane3D &plane, quint32 materialId) :
-        Winding3D(plane), m_iMaterialId(materialId)
+        ArrayWinding3D(plane), m_iMaterialId(materialId)
+    {
+
+    }
+
+    TexturedWinding::TexturedWinding(const DoublePlane3D &plane, quint32 materialId, Precision precision) :
+        ArrayWinding3D(plane, precision), m_iMaterialId(materialId)
     {
 
     }
@@ -2,14 +2,15 @@
 #define TEXTUREDWINDING_H
 
 #include "model_global.h"
-#include "winding3d.h"
+#include "arraywinding3d.h"
 
 namespace Model
 {
-    class MODELSHARED_EXPORT TexturedWinding : public Winding3D
+    class MODELSHARED_EXPORT TexturedWinding : public ArrayWinding3D
     {
     public:
         TexturedWinding(const Plane3D &plane, quint32 materialId);
+        TexturedWinding(const DoublePlane3D &plane, quint32 materialId, Precision precision);
 
         quint32 materialId() const;
         void setMaterialId(quint32 id);
@@ -12,9 +12,13 @@
 
 namespace Model
 {
-    class Winding3D
+    class MODELSHARED_EXPORT Winding3D
     {
     public:
+        typedef QLinkedList<WindingVertex>::iterator VertexIterator;
+        typedef QLinkedList<WindingVertex>::const_iterator ConstVertexIterator;
+        typedef Plane3D ClipPlane;
+
         explicit Winding3D(const Plane3D &plane);
 
         bool isNull() const;
@@ -37,6 +41,11 @@ namespace Model
 
         Plane3D plane() const;
 
+        inline Plane3D clipPlane() const
+        {
+            return plane();
+        }
+
     private:
         typedef QLinkedList<WindingVertex> VertexList;
         typedef QPair<VertexList::iterator, WindingVertex> VertexInsert;
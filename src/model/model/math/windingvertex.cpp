@@ -3,6 +3,13 @@
 
 namespace Model
 {
+    WindingVertex::WindingVertex() :
+        m_vecPosition(), m_bShouldDiscard(false), m_bPrevEdgeOriginal(false),
+        m_bNextEdgeOriginal(false), m_iIndex(-1)
+    {
+
+    }
+
     WindingVertex::WindingVertex(const QVector3D &vec, bool prevEdgeOriginal, bool nextEdgeOriginal) :
         m_vecPosition(vec), m_bShouldDiscard(false), m_bPrevEdgeOriginal(prevEdgeOriginal),
         m_bNextEdgeOriginal(nextEdgeOriginal), m_iIndex(-1)
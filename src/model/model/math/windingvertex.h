@@ -6,9 +6,10 @@
 
 namespace Model
 {
-    class WindingVertex
+    class MODELSHARED_EXPORT WindingVertex
     {
     public:
+        WindingVertex();
         WindingVertex(const QVector3D &vec, bool prevEdgeOriginal, bool nextEdgeOriginal);
 
         QVector3D position() const;
@@ -5,12 +5,20 @@ layout (location=0) in vec4 vPosition;
 layout (location=1) in vec3 vNormal;
 layout (location=2) in vec4 vColour;
 layout (location=3) in vec2 vTexCoord;
+layout (location=4) in uint vObjectId;
+layout (location=5) in vec4 vInstanceColour;
 
-// Local uniforms
-layout (std140) uniform LocalUniformBlock
+// Local matrices, one per column in consecutive texels.
+uniform samplerBuffer modelToWorldMatrices;
+
+mat4 modelToWorldMatrix(uint id)
 {
-   mat4 modelToWorldMatrices[8];
-};
+        int base = int(id) * 4;
+        return mat4(texelFetch(modelToWorldMatrices, base),
+                    texelFetch(modelToWorldMatrices, base + 1),
+                    texelFetch(modelToWorldMatrices, base + 2),
+                    texelFetch(modelToWorldMatrices, base + 3));
+}
 
 // Outputs to fragment shaders
 out vec4 fColour;
@@ -19,20 +27,19 @@ out vec2 fTexCoord;
 
 void main()
 {
-        // Pull the object ID out of w.
-        uint id = uint(vPosition.w);
+        mat4 modelToWorld = modelToWorldMatrix(vObjectId);
 
         // Position gets the entire transform.
         gl_Position = projectionMatrix * COORD_TRANSFORM_HAMMER_OPENGL * worldToCameraMatrix
-        	* modelToWorldMatrices[id] * vec4(vPosition.xyz, 1);
+        	* modelToWorld * vec4(vPosition.xyz, 1);
 
         // Normals stay in world co-ords.
-        fNormal = normalize( (modelToWorldMatrices[id] * vec4(vNormal, 0)).xyz );
+        fNormal = normalize( (modelToWorld * vec4(vNormal, 0)).xyz );
         if ( length(fNormal) != 0.0 )
         {
         	fNormal = normalize(fNormal);
         }
 
-        fColour = vColour;
+        fColour = vColour * vInstanceColour;
         fTexCoord = vTexCoord;
 }
\ No newline at end of file
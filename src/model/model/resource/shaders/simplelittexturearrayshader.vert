@@ -0,0 +1,46 @@
+// Global uniforms etc. are imported in common headers
+
+// Input attributes
+layout (location=0) in vec4 vPosition;
+layout (location=1) in vec3 vNormal;
+layout (location=2) in vec4 vColour;
+layout (location=3) in vec3 vTexCoord;
+layout (location=4) in uint vObjectId;
+layout (location=5) in vec4 vInstanceColour;
+
+// Local matrices, one per column in consecutive texels.
+uniform samplerBuffer modelToWorldMatrices;
+
+mat4 modelToWorldMatrix(uint id)
+{
+        int base = int(id) * 4;
+        return mat4(texelFetch(modelToWorldMatrices, base),
+                    texelFetch(modelToWorldMatrices, base + 1),
+                    texelFetch(modelToWorldMatrices, base + 2),
+                    texelFetch(modelToWorldMatrices, base + 3));
+}
+
+// Outputs to fragment shaders
+out vec4 fColour;
+out vec3 fNormal;
+out vec3 fTexCoord;
+
+void main()
+{
+        mat4 modelToWorld = modelToWorldMatrix(vObjectId);
+
+        // Position gets the entire transform.
+        gl_Position = projectionMatrix * COORD_TRANSFORM_HAMMER_OPENGL * worldToCameraMatrix
+        	* modelToWorld * vec4(vPosition.xyz, 1);
+
+        // Normals stay in world co-ords.
+        fNormal = normalize( (modelToWorld * vec4(vNormal, 0)).xyz );
+        if ( length(fNormal) != 0.0 )
+        {
+        	fNormal = normalize(fNormal);
+        }
+
+        fColour = vColour * vInstanceColour;
+        // Layer within the texture array is passed through in z.
+        fTexCoord = vTexCoord;
+}
\ No newline at end of file
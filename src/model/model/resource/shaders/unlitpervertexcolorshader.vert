@@ -3,23 +3,28 @@
 // Input attributes
 layout (location=0) in vec4 vPosition;
 layout (location=2) in vec4 vColour;
+layout (location=4) in uint vObjectId;
+layout (location=5) in vec4 vInstanceColour;
 
-// Local uniforms
-layout (std140) uniform LocalUniformBlock
+// Local matrices, one per column in consecutive texels.
+uniform samplerBuffer modelToWorldMatrices;
+
+mat4 modelToWorldMatrix(uint id)
 {
-   mat4 modelToWorldMatrices[8];
-};
+        int base = int(id) * 4;
+        return mat4(texelFetch(modelToWorldMatrices, base),
+                    texelFetch(modelToWorldMatrices, base + 1),
+                    texelFetch(modelToWorldMatrices, base + 2),
+                    texelFetch(modelToWorldMatrices, base + 3));
+}
 
 // Outputs to fragment shaders
 out vec4 fColour;
 
 void main()
 {
-        // Pull the object ID out of w.
-        uint id = uint(vPosition.w);
-
         gl_Position = projectionMatrix * COORD_TRANSFORM_HAMMER_OPENGL
-                *  worldToCameraMatrix * modelToWorldMatrices[id] * vec4(vPosition.xyz, 1);
+                *  worldToCameraMatrix * modelToWorldMatrix(vObjectId) * vec4(vPosition.xyz, 1);
 
-        fColour = vColour;
+        fColour = vColour * vInstanceColour;
 }
\ No newline at end of file
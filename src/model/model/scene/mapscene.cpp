@@ -13,6 +13,8 @@ namespace Model
 
         m_pOriginMarker = createSceneObject<OriginMarker>(rootObject());
         m_pOriginMarker->setObjectName("_originMarker");
+
+        connect(this, &Scene::objectDestroyed, this, &MapScene::onObjectDestroyed);
     }
 
     SceneCamera* MapScene::defaultCamera() const
@@ -24,4 +26,71 @@ namespace Model
     {
         return rootObject()->findChildren<SceneCamera*>();
     }
+
+    void MapScene::addVisGroup(const MapVisGroup &visGroup)
+    {
+        if ( !visGroup.isValid() )
+            return;
+
+        m_VisGroups.insert(visGroup.id, visGroup);
+    }
+
+    MapVisGroup MapScene::visGroup(int id) const
+    {
+        return m_VisGroups.value(id);
+    }
+
+    QList<MapVisGroup> MapScene::visGroups() const
+    {
+        return m_VisGroups.values();
+    }
+
+    void MapScene::clearVisGroups()
+    {
+        m_VisGroups.clear();
+        m_ObjectVisGroups.clear();
+    }
+
+    void MapScene::addObjectToVisGroup(const SceneObject *object, int visGroupId)
+    {
+        if ( !object || !m_VisGroups.contains(visGroupId) )
+            return;
+
+        QList<int>& memberships = m_ObjectVisGroups[object->objectId()];
+        if ( !memberships.contains(visGroupId) )
+        {
+            memberships.append(visGroupId);
+        }
+    }
+
+    QList<int> MapScene::objectVisGroups(const SceneObject *object) const
+    {
+        return object ? m_ObjectVisGroups.value(object->objectId()) : QList<int>();
+    }
+
+    QList<SceneObject*> MapScene::visGroupObjects(int visGroupId) const
+    {
+        QList<SceneObject*> objects;
+
+        for ( QHash<quint32, QList<int>>::const_iterator it = m_ObjectVisGroups.constBegin();
+              it != m_ObjectVisGroups.constEnd();
+              ++it )
+        {
+            if ( !it.value().contains(visGroupId) )
+                continue;
+
+            SceneObject* object = sceneObject(it.key());
+            if ( object )
+            {
+                objects.append(object);
+            }
+        }
+
+        return objects;
+    }
+
+    void MapScene::onObjectDestroyed(SceneObject *object)
+    {
+        m_ObjectVisGroups.remove(object->objectId());
+    }
 }
@@ -3,6 +3,10 @@
 
 #include "model_global.h"
 #include "scene.h"
+#include "mapvisgroup.h"
+#include <QMap>
+#include <QHash>
+#include <QList>
 
 namespace Model
 {
@@ -18,9 +22,26 @@ namespace Model
         SceneCamera* defaultCamera() const;
         QList<SceneCamera*> cameras() const;
 
+        // Visgroups are ordered by ID.
+        void addVisGroup(const MapVisGroup& visGroup);
+        MapVisGroup visGroup(int id) const;
+        QList<MapVisGroup> visGroups() const;
+        void clearVisGroups();
+
+        // An object may belong to any number of visgroups. Memberships are
+        // removed when the object is destroyed.
+        void addObjectToVisGroup(const SceneObject* object, int visGroupId);
+        QList<int> objectVisGroups(const SceneObject* object) const;
+        QList<SceneObject*> visGroupObjects(int visGroupId) const;
+
+    private slots:
+        void onObjectDestroyed(SceneObject* object);
+
     private:
         SceneCamera*    m_pDefaultCamera;
         OriginMarker*   m_pOriginMarker;
+        QMap<int, MapVisGroup> m_VisGroups;
+        QHash<quint32, QList<int>> m_ObjectVisGroups;
     };
 }
 
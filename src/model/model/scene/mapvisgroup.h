@@ -0,0 +1,36 @@
+#ifndef MAPVISGROUP_H
+#define MAPVISGROUP_H
+
+#include "model_global.h"
+#include <QString>
+#include <QColor>
+
+namespace Model
+{
+    // A visgroup as specified in a map file. Visgroups can be nested;
+    // top-level visgroups have a parent ID of 0.
+    struct MapVisGroup
+    {
+        int id;
+        int parentId;
+        QString name;
+        QColor color;
+
+        MapVisGroup()
+            : id(0), parentId(0)
+        {
+        }
+
+        MapVisGroup(int visGroupId, int parentVisGroupId, const QString& visGroupName, const QColor& visGroupColor)
+            : id(visGroupId), parentId(parentVisGroupId), name(visGroupName), color(visGroupColor)
+        {
+        }
+
+        bool isValid() const
+        {
+            return id > 0;
+        }
+    };
+}
+
+#endif // MAPVISGROUP_H
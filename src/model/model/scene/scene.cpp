@@ -4,6 +4,8 @@ namespace Model
 {
     Scene::Scene(QObject* parent)
         : QObject(parent),
+          m_ObjectsNeedingRendererUpdate(),
+          m_DestroyedObjects(),
           m_iObjectIdCounter(0),
           m_pRootObject(new SceneObject(SceneObjectInitParams(this, acquireNextObjectId()), Q_NULLPTR))
     {
@@ -82,6 +84,11 @@ namespace Model
         return m_pRootObject;
     }
 
+    SceneObject* Scene::sceneObject(quint32 objectId) const
+    {
+        return m_ObjectTable.value(objectId, Q_NULLPTR);
+    }
+
     quint32 Scene::acquireNextObjectId()
     {
         Q_ASSERT_X(m_iObjectIdCounter + 1 > 0, Q_FUNC_INFO, "How on earth did you manage to overflow this??");
@@ -93,12 +100,36 @@ namespace Model
         Q_ASSERT_X(object->objectId() > 0, Q_FUNC_INFO, "Object cannot have an ID of zero!");
         Q_ASSERT_X(!m_ObjectTable.contains(object->objectId()), Q_FUNC_INFO, "Object already exists!");
         m_ObjectTable.insert(object->objectId(), object);
+
+        // New objects have never been sent to the renderer.
+        flagObjectNeedsRendererUpdate(object->objectId());
     }
 
     void Scene::removeObjectFromTable(SceneObject *object)
     {
         Q_ASSERT_X(object->objectId() > 0, Q_FUNC_INFO, "Object cannot have an ID of zero!");
         m_ObjectTable.remove(object->objectId());
+        m_ObjectsNeedingRendererUpdate.remove(object->objectId());
+        m_DestroyedObjects.insert(object->objectId());
+    }
+
+    void Scene::flagObjectNeedsRendererUpdate(quint32 objectId)
+    {
+        m_ObjectsNeedingRendererUpdate.insert(objectId);
+    }
+
+    QSet<quint32> Scene::takeObjectsNeedingRendererUpdate()
+    {
+        QSet<quint32> objects;
+        objects.swap(m_ObjectsNeedingRendererUpdate);
+        return objects;
+    }
+
+    QSet<quint32> Scene::takeDestroyedObjects()
+    {
+        QSet<quint32> objects;
+        objects.swap(m_DestroyedObjects);
+        return objects;
     }
 
     int Scene::classify(quint32 objectId) const
@@ -4,6 +4,7 @@
 #include "model_global.h"
 #include "model/scene/sceneobject.h"
 #include <QHash>
+#include <QSet>
 #include "sceneobjectinitparams.h"
 #include "model/stores/texturestore.h"
 #include "model/stores/shaderstore.h"
@@ -15,6 +16,7 @@ namespace Model
     class MODELSHARED_EXPORT Scene : public QObject,
                                      public IRenderPassClassifier
     {
+        friend class SceneObject;
         Q_OBJECT
     public:
         explicit Scene(QObject* parent = 0);
@@ -42,9 +44,19 @@ namespace Model
         int sceneObjectCount() const;
 
         SceneObject* rootObject() const;
+        SceneObject* sceneObject(quint32 objectId) const;
 
         virtual int classify(quint32 objectId) const override;
 
+        // IDs of objects that have needed a renderer update since these were last
+        // taken, so that only they have to be visited when rendering. New objects
+        // are always included. Some IDs may belong to objects which have since
+        // been destroyed.
+        QSet<quint32> takeObjectsNeedingRendererUpdate();
+
+        // IDs of objects destroyed since these were last taken.
+        QSet<quint32> takeDestroyedObjects();
+
     signals:
         void objectCreated(SceneObject*);
         void objectDestroyed(SceneObject*);
@@ -56,6 +68,10 @@ namespace Model
         void addObjectToTable(SceneObject* object);
         void removeObjectFromTable(SceneObject* object);
         void deleteObjectsRecursive(SceneObject* object);
+        void flagObjectNeedsRendererUpdate(quint32 objectId);
+
+        QSet<quint32> m_ObjectsNeedingRendererUpdate;
+        QSet<quint32> m_DestroyedObjects;
 
         quint32 m_iObjectIdCounter;
         SceneObject* m_pRootObject;
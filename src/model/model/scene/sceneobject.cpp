@@ -1,5 +1,6 @@
 #include "sceneobject.h"
 #include <QCoreApplication>
+#include <QChildEvent>
 #include "model/events/modeleventtypes.h"
 #include <QtDebug>
 #include "calliperutil/math/math.h"
@@ -21,6 +22,7 @@ namespace Model
 
         m_pHierarchy->cloneFrom(cloneFrom->hierarchy());
         m_bNeedsRendererUpdate = cloneFrom->m_bNeedsRendererUpdate;
+        m_bHidden = cloneFrom->m_bHidden;
     }
 
     SceneObject::~SceneObject()
@@ -31,8 +33,16 @@ namespace Model
     void SceneObject::commonInit()
     {
         Q_ASSERT_X(m_pParentScene, Q_FUNC_INFO, "Must have a valid parent scene!");
+
+        // Set before any children are created, as they notify us.
+        m_bLocalBoundsStale = true;
+        m_bWorldBoundsStale = true;
+        m_bHierarchyBoundsStale = true;
+        m_bRendererMatrixStale = true;
+
         m_pHierarchy = initHierarchyState(true);
         m_colColor = QColor::fromRgb(0xffffffff);
+        m_bHidden = false;
         m_bNeedsRendererUpdate = true;
     }
 
@@ -46,6 +56,16 @@ namespace Model
         return hs;
     }
 
+    void SceneObject::childEvent(QChildEvent *event)
+    {
+        if ( event->added() || event->removed() )
+        {
+            invalidateHierarchyBounds();
+        }
+
+        QObject::childEvent(event);
+    }
+
     void SceneObject::customEvent(QEvent *event)
     {
         switch(event->type())
@@ -101,7 +121,9 @@ namespace Model
     void SceneObject::handleSpatialConfigurationChange(SpatialConfigurationChange *event)
     {
         Q_UNUSED(event);
-        flagNeedsRendererUpdate();
+
+        // The geometry itself hasn't changed, so the local bounds still hold.
+        invalidateWorldState();
     }
 
     bool SceneObject::needsRendererUpdate() const
@@ -110,8 +132,91 @@ namespace Model
     }
 
     void SceneObject::flagNeedsRendererUpdate()
+    {
+        setNeedsRendererUpdate();
+        m_bLocalBoundsStale = true;
+        m_bWorldBoundsStale = true;
+        invalidateHierarchyBounds();
+    }
+
+    BoundingBox SceneObject::localBounds() const
+    {
+        if ( m_bLocalBoundsStale )
+        {
+            m_LocalBounds = computeLocalBounds();
+            m_bLocalBoundsStale = false;
+        }
+
+        return m_LocalBounds;
+    }
+
+    BoundingBox SceneObject::worldBounds() const
+    {
+        if ( m_bWorldBoundsStale )
+        {
+            m_WorldBounds = localBounds().transformed(localToRootMatrix());
+            m_bWorldBoundsStale = false;
+        }
+
+        return m_WorldBounds;
+    }
+
+    BoundingBox SceneObject::hierarchyBounds() const
+    {
+        if ( m_bHierarchyBoundsStale )
+        {
+            BoundingBox bounds = worldBounds();
+            foreach ( SceneObject* child, childSceneObjects() )
+            {
+                bounds.unite(child->hierarchyBounds());
+            }
+
+            m_HierarchyBounds = bounds;
+            m_bHierarchyBoundsStale = false;
+        }
+
+        return m_HierarchyBounds;
+    }
+
+    BoundingBox SceneObject::computeLocalBounds() const
+    {
+        return BoundingBox();
+    }
+
+    void SceneObject::setNeedsRendererUpdate()
     {
         m_bNeedsRendererUpdate = true;
+        m_pParentScene->flagObjectNeedsRendererUpdate(m_iObjectId);
+    }
+
+    void SceneObject::invalidateWorldState()
+    {
+        QList<SceneObject*> objects;
+        objects.append(this);
+
+        while ( !objects.isEmpty() )
+        {
+            SceneObject* object = objects.takeLast();
+            object->m_bWorldBoundsStale = true;
+            object->m_bHierarchyBoundsStale = true;
+            object->m_bRendererMatrixStale = true;
+            object->setNeedsRendererUpdate();
+            objects.append(object->childSceneObjects());
+        }
+
+        invalidateHierarchyBounds();
+    }
+
+    void SceneObject::invalidateHierarchyBounds()
+    {
+        m_bHierarchyBoundsStale = true;
+
+        // Hierarchy bounds are only ever computed along with those of every descendant,
+        // so once a parent is found to be stale, so are all of the parents above it.
+        for ( SceneObject* object = parentObject(); object && !object->m_bHierarchyBoundsStale; object = object->parentObject() )
+        {
+            object->m_bHierarchyBoundsStale = true;
+        }
     }
 
     void SceneObject::rendererUpdate(Renderer::GeometryBuilder &builder) const
@@ -121,12 +226,33 @@ namespace Model
 
         if ( !customVertexColours() )
         {
-            updateGeometryColours(builder);
+            updateGeometryColours(builder, m_colColor);
         }
 
         m_bNeedsRendererUpdate = false;
     }
 
+    QString SceneObject::sharedMeshKey() const
+    {
+        return QString();
+    }
+
+    void SceneObject::bakeSharedMesh(Renderer::GeometryBuilder &builder) const
+    {
+        bakeGeometry(builder);
+
+        if ( !customVertexColours() )
+        {
+            updateGeometryColours(builder, QColor(Qt::white));
+        }
+    }
+
+    QColor SceneObject::rendererInstanceUpdate() const
+    {
+        m_bNeedsRendererUpdate = false;
+        return customVertexColours() ? QColor(Qt::white) : m_colColor;
+    }
+
     void SceneObject::bakeGeometry(Renderer::GeometryBuilder &builder) const
     {
         Q_UNUSED(builder);
@@ -166,6 +292,20 @@ namespace Model
         return localToRootMatrix().inverted();
     }
 
+    QMatrix4x4 SceneObject::rendererMatrix() const
+    {
+        if ( m_bRendererMatrixStale )
+        {
+            const SceneObject* parent = parentObject();
+            m_matRenderer = parent
+                    ? hierarchy().parentToLocal() * parent->rendererMatrix()
+                    : hierarchy().parentToLocal();
+            m_bRendererMatrixStale = false;
+        }
+
+        return m_matRenderer;
+    }
+
     QList<SceneObject*> SceneObject::childSceneObjects() const
     {
         return findChildren<SceneObject*>(QString(), Qt::FindDirectChildrenOnly);
@@ -186,17 +326,17 @@ namespace Model
         return false;
     }
 
-    void SceneObject::updateGeometryColours(Renderer::GeometryBuilder &builder) const
+    void SceneObject::updateGeometryColours(Renderer::GeometryBuilder &builder, const QColor &col) const
     {
         using namespace Renderer;
 
         for ( int i = 0; i < builder.sectionCount(); i++ )
         {
-            updateGeometryColours(builder.section(i));
+            updateGeometryColours(builder.section(i), col);
         }
     }
 
-    void SceneObject::updateGeometryColours(Renderer::GeometrySection *section) const
+    void SceneObject::updateGeometryColours(Renderer::GeometrySection *section, const QColor &col) const
     {
         using namespace Renderer;
 
@@ -206,7 +346,7 @@ namespace Model
 
         while ( section->attributeCount(GeometrySection::ColorAttribute) < section->attributeCount(GeometrySection::PositionAttribute) )
         {
-            section->addColor(m_colColor);
+            section->addColor(col);
         }
     }
 
@@ -234,6 +374,20 @@ namespace Model
         m_bMustExist = mustExist;
     }
 
+    bool SceneObject::isHidden() const
+    {
+        return m_bHidden;
+    }
+
+    void SceneObject::setHidden(bool hidden)
+    {
+        if ( hidden == m_bHidden )
+            return;
+
+        m_bHidden = hidden;
+        setNeedsRendererUpdate();
+    }
+
     void SceneObject::setParentObject(SceneObject *newParent)
     {
         if ( newParent == this )
@@ -263,6 +417,11 @@ namespace Model
         QVector3D newScale = CalliperUtil::Math::transformVectorDirection(hierarchy().scale(), oldParentToNewParent);
 
         setParent(newParent);
+
+        // QObject only tells widgets about parent changes, so the moved subtree is invalidated here.
+        // The old and new parents' hierarchy bounds are invalidated through childEvent().
+        invalidateWorldState();
+
         hierarchy().setPosition(newPosition);
         hierarchy().setRotation(newAngles);
         hierarchy().setScale(newScale);
@@ -8,8 +8,11 @@
 #include "renderer/geometry/geometrybuilder.h"
 #include "sceneobjectinitparams.h"
 #include "renderer/shaders/baseshaderpalette.h"
+#include "model/math/boundingbox.h"
 #include <QColor>
 
+class QChildEvent;
+
 namespace Model
 {
     class Scene;
@@ -37,18 +40,53 @@ namespace Model
         bool needsRendererUpdate() const;
         void rendererUpdate(Renderer::GeometryBuilder &builder) const;
 
+        // Objects whose geometry is the same as that of others can return a key naming it.
+        // The geometry is then baked once with bakeSharedMesh(), and each object with that
+        // key is drawn as an instance of it. Empty by default, so that every object bakes
+        // its own geometry.
+        virtual QString sharedMeshKey() const;
+
+        // Vertex colours are left white unless the subclass has custom vertex colours,
+        // since each instance's colour is applied when it's drawn.
+        void bakeSharedMesh(Renderer::GeometryBuilder &builder) const;
+
+        // Called instead of rendererUpdate() for objects with a shared mesh.
+        // Returns the colour to multiply the mesh's vertex colours by.
+        QColor rendererInstanceUpdate() const;
+
         // Not cached, so could be expensive if called a lot.
         QMatrix4x4 rootToLocalMatrix() const;
         QMatrix4x4 localToRootMatrix() const;
 
+        // Model-to-world matrix given to the renderer for this object's geometry.
+        // Cached until this object or one of its parents is moved.
+        QMatrix4x4 rendererMatrix() const;
+
         QList<SceneObject*> childSceneObjects() const;
 
+        // Bounds of the object's own geometry in local space. Cached until
+        // the object is flagged as needing a renderer update.
+        BoundingBox localBounds() const;
+
+        // Local bounds in the space of the root object. Also cached until
+        // this object or one of its parents is moved.
+        BoundingBox worldBounds() const;
+
+        // World bounds of this object and all of its descendants, so that
+        // a whole subtree can be rejected with one test.
+        BoundingBox hierarchyBounds() const;
+
         QColor color() const;
         void setColor(const QColor &col);
 
         bool mustExist() const;
         void setMustExist(bool mustExist);
 
+        // Hidden objects stay in the scene but aren't drawn.
+        // Only the object itself is hidden, not its children.
+        bool isHidden() const;
+        void setHidden(bool hidden);
+
     public slots:
         void flagNeedsRendererUpdate();
 
@@ -67,8 +105,13 @@ namespace Model
         virtual ~SceneObject();
 
         virtual void customEvent(QEvent *event);
+        virtual void childEvent(QChildEvent *event) override;
         virtual void bakeGeometry(Renderer::GeometryBuilder &builder) const;
 
+        // Subclasses with geometry return its bounds in local space.
+        // Called when the bounds are needed after flagNeedsRendererUpdate().
+        virtual BoundingBox computeLocalBounds() const;
+
         // Called by subclasses to convert hierarchy state to non-scalable.
         void updateScalableState(bool isScalable);
 
@@ -91,8 +134,16 @@ namespace Model
         void commonInit();
         void handleSpatialConfigurationChange(SpatialConfigurationChange* event);
         HierarchyState* initHierarchyState(bool isScalable);
-        void updateGeometryColours(Renderer::GeometryBuilder &builder) const;
-        void updateGeometryColours(Renderer::GeometrySection* section) const;
+        void updateGeometryColours(Renderer::GeometryBuilder &builder, const QColor &col) const;
+        void updateGeometryColours(Renderer::GeometrySection* section, const QColor &col) const;
+
+        void setNeedsRendererUpdate();
+
+        // World bounds and renderer matrices depend on every parent's transform,
+        // so moving an object invalidates them, and flags a renderer update,
+        // for its whole subtree.
+        void invalidateWorldState();
+        void invalidateHierarchyBounds();
 
         Scene* const m_pParentScene;
         const quint32 m_iObjectId;
@@ -101,6 +152,17 @@ namespace Model
         mutable bool m_bNeedsRendererUpdate;
         QColor m_colColor;
         bool m_bMustExist;
+        bool m_bHidden;
+
+        mutable BoundingBox m_LocalBounds;
+        mutable BoundingBox m_WorldBounds;
+        mutable BoundingBox m_HierarchyBounds;
+        mutable bool m_bLocalBoundsStale;
+        mutable bool m_bWorldBoundsStale;
+        mutable bool m_bHierarchyBoundsStale;
+
+        mutable QMatrix4x4 m_matRenderer;
+        mutable bool m_bRendererMatrixStale;
     };
 }
 
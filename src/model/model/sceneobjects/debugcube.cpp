@@ -42,6 +42,12 @@ namespace Model
         }
     }
 
+    QString DebugCube::sharedMeshKey() const
+    {
+        // Cubes of the same size share their geometry.
+        return QString("DebugCube/%1/%2").arg(m_flRadius).arg(m_bDrawFrame ? 1 : 0);
+    }
+
     float DebugCube::radius() const
     {
         return m_flRadius;
@@ -17,6 +17,8 @@ namespace Model
         bool drawFrame() const;
         void setDrawFrame(bool draw);
 
+        virtual QString sharedMeshKey() const override;
+
     protected:
         DebugCube(const SceneObjectInitParams &initParams, SceneObject* parentObject);
         DebugCube(const DebugCube *cloneFrom, const SceneObjectInitParams &initParams);
@@ -0,0 +1,200 @@
+#include "displacement.h"
+#include "model/scene/scene.h"
+#include "model/global/resourceenvironment.h"
+
+namespace Model
+{
+    Displacement::Displacement(const SceneObjectInitParams &initParams, SceneObject* parentObject)
+        : SceneObject(initParams, parentObject)
+    {
+        commonInit();
+    }
+
+    Displacement::Displacement(const Displacement* cloneFrom, const SceneObjectInitParams &initParams)
+        : SceneObject(cloneFrom, initParams)
+    {
+        commonInit();
+
+        m_iPower = cloneFrom->m_iPower;
+        m_BasePositions = cloneFrom->m_BasePositions;
+        m_Positions = cloneFrom->m_Positions;
+        m_vecFaceNormal = cloneFrom->m_vecFaceNormal;
+        m_Alphas = cloneFrom->m_Alphas;
+        m_pTexturePlane->setMaterialId(cloneFrom->m_pTexturePlane->materialId());
+        m_pTexturePlane->setScale(cloneFrom->m_pTexturePlane->scale());
+        m_pTexturePlane->setTranslation(cloneFrom->m_pTexturePlane->translation());
+        m_pTexturePlane->setRotation(cloneFrom->m_pTexturePlane->rotation());
+    }
+
+    Displacement::~Displacement()
+    {
+
+    }
+
+    void Displacement::commonInit()
+    {
+        m_iPower = 0;
+        m_pTexturePlane = new TexturePlane(this);
+        connect(m_pTexturePlane, &TexturePlane::dataChanged, this, &Displacement::flagNeedsRendererUpdate);
+    }
+
+    BoundingBox Displacement::computeLocalBounds() const
+    {
+        return BoundingBox::fromPoints(m_Positions);
+    }
+
+    int Displacement::verticesPerSide(int power)
+    {
+        return (1 << power) + 1;
+    }
+
+    int Displacement::maxPower()
+    {
+        return 4;
+    }
+
+    int Displacement::power() const
+    {
+        return m_iPower;
+    }
+
+    int Displacement::verticesPerSide() const
+    {
+        return verticesPerSide(m_iPower);
+    }
+
+    bool Displacement::setSurface(int power, const QVector<QVector3D> &basePositions,
+                                  const QVector<QVector3D> &positions, const QVector3D &faceNormal)
+    {
+        if ( power < 1 || power > maxPower() )
+            return false;
+
+        const int side = verticesPerSide(power);
+        if ( basePositions.count() != side * side || positions.count() != side * side )
+            return false;
+
+        m_iPower = power;
+        m_BasePositions = basePositions;
+        m_Positions = positions;
+        m_vecFaceNormal = faceNormal.normalized();
+
+        flagNeedsRendererUpdate();
+        return true;
+    }
+
+    const QVector<QVector3D>& Displacement::basePositions() const
+    {
+        return m_BasePositions;
+    }
+
+    const QVector<QVector3D>& Displacement::positions() const
+    {
+        return m_Positions;
+    }
+
+    QVector3D Displacement::faceNormal() const
+    {
+        return m_vecFaceNormal;
+    }
+
+    const QVector<float>& Displacement::alphas() const
+    {
+        return m_Alphas;
+    }
+
+    void Displacement::setAlphas(const QVector<float> &alphas)
+    {
+        m_Alphas = alphas;
+    }
+
+    TexturePlane* Displacement::texturePlane() const
+    {
+        return m_pTexturePlane;
+    }
+
+    void Displacement::bakeGeometry(Renderer::GeometryBuilder &builder) const
+    {
+        using namespace Renderer;
+
+        if ( m_iPower < 1 )
+            return;
+
+        const int side = verticesPerSide();
+        const int cells = side - 1;
+
+        GeometrySection* section = builder.createNewSection(
+                    m_pTexturePlane->materialId(),
+                    builder.modelToWorldMatrix());
+
+        section->addPositions(m_Positions);
+
+        // Work out which way round the grid runs relative to the face,
+        // so that triangles face the same way as the original face.
+        const QVector3D baseRow = m_BasePositions.at(side) - m_BasePositions.at(0);
+        const QVector3D baseColumn = m_BasePositions.at(1) - m_BasePositions.at(0);
+        const bool flip = QVector3D::dotProduct(QVector3D::crossProduct(baseRow, baseColumn), m_vecFaceNormal) < 0;
+
+        QVector<QVector3D> normals(m_Positions.count());
+
+        for ( int row = 0; row < cells; ++row )
+        {
+            for ( int column = 0; column < cells; ++column )
+            {
+                const quint32 i00 = (row * side) + column;
+                const quint32 i10 = ((row + 1) * side) + column;
+                const quint32 i11 = ((row + 1) * side) + column + 1;
+                const quint32 i01 = (row * side) + column + 1;
+
+                // Alternate the diagonal like the engine does, so that
+                // the surface is symmetrical.
+                quint32 tris[2][3];
+                if ( (row + column) % 2 == 0 )
+                {
+                    tris[0][0] = i00; tris[0][1] = i10; tris[0][2] = i11;
+                    tris[1][0] = i00; tris[1][1] = i11; tris[1][2] = i01;
+                }
+                else
+                {
+                    tris[0][0] = i00; tris[0][1] = i10; tris[0][2] = i01;
+                    tris[1][0] = i10; tris[1][1] = i11; tris[1][2] = i01;
+                }
+
+                for ( int t = 0; t < 2; ++t )
+                {
+                    if ( flip )
+                    {
+                        qSwap(tris[t][1], tris[t][2]);
+                    }
+
+                    section->addIndexTriangle(tris[t][0], tris[t][1], tris[t][2]);
+
+                    const QVector3D& p0 = m_Positions.at(tris[t][0]);
+                    const QVector3D& p1 = m_Positions.at(tris[t][1]);
+                    const QVector3D& p2 = m_Positions.at(tris[t][2]);
+                    const QVector3D faceNormal = QVector3D::crossProduct(p1 - p0, p2 - p0);
+
+                    normals[tris[t][0]] += faceNormal;
+                    normals[tris[t][1]] += faceNormal;
+                    normals[tris[t][2]] += faceNormal;
+                }
+            }
+        }
+
+        for ( int i = 0; i < normals.count(); ++i )
+        {
+            const QVector3D normal = normals.at(i).normalized();
+            section->addNormal(normal.isNull() ? m_vecFaceNormal : normal);
+        }
+
+        TextureStore* texStore = ResourceEnvironment::globalInstance()->textureStore();
+        MaterialStore* matStore = ResourceEnvironment::globalInstance()->materialStore();
+
+        RenderMaterialPointer mat = (*matStore)(m_pTexturePlane->materialId());
+        OpenGLTexturePointer tex = (*texStore)(mat->texture(ShaderDefs::MainTexture));
+
+        for ( int i = 0; i < m_BasePositions.count(); ++i )
+        {
+            section->addTextureCoordinate(m_pTexturePlane->textureCoordinate(m_BasePositions.at(i), tex->size(), m_vecFaceNormal));
+        }
+    }
+}
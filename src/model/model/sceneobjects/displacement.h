@@ -0,0 +1,64 @@
+#ifndef DISPLACEMENT_H
+#define DISPLACEMENT_H
+
+#include "model_global.h"
+#include "model/scene/sceneobject.h"
+#include "model/genericbrush/textureplane.h"
+#include <QVector>
+#include <QVector3D>
+
+namespace Model
+{
+    // A displacement surface built from a four-sided brush face.
+    // Vertices form a square grid of (2^power + 1) vertices per side, stored row by row.
+    // Base positions are the undisplaced positions on the original face, and are used
+    // to project texture co-ordinates so that the texture doesn't stretch with the surface.
+    class MODELSHARED_EXPORT Displacement : public SceneObject
+    {
+        friend class Scene;
+        Q_OBJECT
+    public:
+        static int verticesPerSide(int power);
+
+        // Displacements of higher powers aren't supported by the engine.
+        static int maxPower();
+
+        int power() const;
+        int verticesPerSide() const;
+
+        // Returns false and leaves the surface unchanged if the power is out of range,
+        // or if the vertex counts don't match it.
+        bool setSurface(int power, const QVector<QVector3D>& basePositions,
+                        const QVector<QVector3D>& positions, const QVector3D& faceNormal);
+
+        const QVector<QVector3D>& basePositions() const;
+        const QVector<QVector3D>& positions() const;
+        QVector3D faceNormal() const;
+
+        // Blend alpha per vertex, from 0 to 255. Empty if the map specified none.
+        const QVector<float>& alphas() const;
+        void setAlphas(const QVector<float>& alphas);
+
+        TexturePlane* texturePlane() const;
+
+    protected:
+        Displacement(const SceneObjectInitParams &initParams, SceneObject* parentObject);
+        Displacement(const Displacement* cloneFrom, const SceneObjectInitParams &initParams);
+        virtual ~Displacement();
+
+        virtual void bakeGeometry(Renderer::GeometryBuilder &builder) const override;
+        virtual BoundingBox computeLocalBounds() const override;
+
+    private:
+        void commonInit();
+
+        int m_iPower;
+        QVector<QVector3D> m_BasePositions;
+        QVector<QVector3D> m_Positions;
+        QVector3D m_vecFaceNormal;
+        QVector<float> m_Alphas;
+        TexturePlane* m_pTexturePlane;
+    };
+}
+
+#endif // DISPLACEMENT_H
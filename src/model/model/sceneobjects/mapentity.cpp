@@ -0,0 +1,126 @@
+#include "mapentity.h"
+#include "model/scene/scene.h"
+#include "model/global/resourceenvironment.h"
+#include "model/factories/geometryfactory.h"
+
+namespace Model
+{
+    MapEntity::MapEntity(const SceneObjectInitParams &initParams, SceneObject* parentObject)
+        : SceneObject(initParams, parentObject)
+    {
+        commonInit();
+    }
+
+    MapEntity::MapEntity(const MapEntity* cloneFrom, const SceneObjectInitParams &initParams)
+        : SceneObject(cloneFrom, initParams)
+    {
+        commonInit();
+
+        m_iEntityId = cloneFrom->m_iEntityId;
+        m_KeyValues = cloneFrom->m_KeyValues;
+        m_Outputs = cloneFrom->m_Outputs;
+        m_bBrushEntity = cloneFrom->m_bBrushEntity;
+        m_flMarkerRadius = cloneFrom->m_flMarkerRadius;
+    }
+
+    MapEntity::~MapEntity()
+    {
+
+    }
+
+    void MapEntity::commonInit()
+    {
+        m_iEntityId = 0;
+        m_bBrushEntity = false;
+        m_flMarkerRadius = 8;
+    }
+
+    void MapEntity::bakeGeometry(Renderer::GeometryBuilder &builder) const
+    {
+        // Brush entities are drawn by their brushes.
+        if ( m_bBrushEntity )
+            return;
+
+        builder.setMaterialId(ResourceEnvironment::globalInstance()->materialStore()
+                              ->presetMaterialId(MaterialStore::UnlitPerVertexColor3D));
+        GeometryFactory::cube(builder, m_flMarkerRadius, color());
+    }
+
+    int MapEntity::entityId() const
+    {
+        return m_iEntityId;
+    }
+
+    void MapEntity::setEntityId(int id)
+    {
+        m_iEntityId = id;
+    }
+
+    QString MapEntity::className() const
+    {
+        return keyValue("classname");
+    }
+
+    void MapEntity::setClassName(const QString &className)
+    {
+        setKeyValue("classname", className);
+    }
+
+    QString MapEntity::targetName() const
+    {
+        return keyValue("targetname");
+    }
+
+    QMap<QString, QString> MapEntity::keyValues() const
+    {
+        return m_KeyValues;
+    }
+
+    QString MapEntity::keyValue(const QString &key, const QString &defaultValue) const
+    {
+        return m_KeyValues.value(key, defaultValue);
+    }
+
+    void MapEntity::setKeyValue(const QString &key, const QString &value)
+    {
+        m_KeyValues.insert(key, value);
+    }
+
+    QList<MapEntity::Output> MapEntity::outputs() const
+    {
+        return m_Outputs;
+    }
+
+    void MapEntity::setOutputs(const QList<Output> &outputs)
+    {
+        m_Outputs = outputs;
+    }
+
+    bool MapEntity::isBrushEntity() const
+    {
+        return m_bBrushEntity;
+    }
+
+    void MapEntity::setBrushEntity(bool brushEntity)
+    {
+        if ( brushEntity == m_bBrushEntity )
+            return;
+
+        m_bBrushEntity = brushEntity;
+        flagNeedsRendererUpdate();
+    }
+
+    float MapEntity::markerRadius() const
+    {
+        return m_flMarkerRadius;
+    }
+
+    void MapEntity::setMarkerRadius(float radius)
+    {
+        if ( radius == m_flMarkerRadius )
+            return;
+
+        m_flMarkerRadius = radius;
+        flagNeedsRendererUpdate();
+    }
+}
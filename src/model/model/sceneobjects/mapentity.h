@@ -0,0 +1,65 @@
+#ifndef MAPENTITY_H
+#define MAPENTITY_H
+
+#include "model_global.h"
+#include "model/scene/sceneobject.h"
+#include <QMap>
+#include <QList>
+#include <QPair>
+
+namespace Model
+{
+    // An entity from a map file. Brush entities own their brushes as child
+    // objects, which are specified in world space, so the entity itself stays
+    // at the origin. Point entities are positioned using their "origin" and
+    // "angles" keys and are drawn as a small marker.
+    class MODELSHARED_EXPORT MapEntity : public SceneObject
+    {
+        friend class Scene;
+        Q_OBJECT
+    public:
+        typedef QPair<QString, QString> Output;
+
+        int entityId() const;
+        void setEntityId(int id);
+
+        QString className() const;
+        void setClassName(const QString& className);
+
+        QString targetName() const;
+
+        // All keyvalues, including "classname" and "origin".
+        QMap<QString, QString> keyValues() const;
+        QString keyValue(const QString& key, const QString& defaultValue = QString()) const;
+        void setKeyValue(const QString& key, const QString& value);
+
+        // Entries from the "connections" block as (output, target) pairs.
+        QList<Output> outputs() const;
+        void setOutputs(const QList<Output>& outputs);
+
+        bool isBrushEntity() const;
+        void setBrushEntity(bool brushEntity);
+
+        float markerRadius() const;
+        void setMarkerRadius(float radius);
+
+    protected:
+        MapEntity(const SceneObjectInitParams &initParams, SceneObject* parentObject);
+        MapEntity(const MapEntity* cloneFrom, const SceneObjectInitParams &initParams);
+        virtual ~MapEntity();
+
+        virtual void bakeGeometry(Renderer::GeometryBuilder &builder) const override;
+        virtual bool customVertexColours() const override { return true; }
+
+    private:
+        void commonInit();
+
+        int m_iEntityId;
+        QMap<QString, QString> m_KeyValues;
+        QList<Output> m_Outputs;
+        bool m_bBrushEntity;
+        float m_flMarkerRadius;
+    };
+}
+
+#endif // MAPENTITY_H
@@ -0,0 +1,34 @@
+#include "mapgroup.h"
+#include "model/scene/scene.h"
+
+namespace Model
+{
+    MapGroup::MapGroup(const SceneObjectInitParams &initParams, SceneObject* parentObject)
+        : SceneObject(initParams, parentObject),
+          m_iGroupId(0)
+    {
+
+    }
+
+    MapGroup::MapGroup(const MapGroup* cloneFrom, const SceneObjectInitParams &initParams)
+        : SceneObject(cloneFrom, initParams),
+          m_iGroupId(cloneFrom->m_iGroupId)
+    {
+
+    }
+
+    MapGroup::~MapGroup()
+    {
+
+    }
+
+    int MapGroup::groupId() const
+    {
+        return m_iGroupId;
+    }
+
+    void MapGroup::setGroupId(int id)
+    {
+        m_iGroupId = id;
+    }
+}
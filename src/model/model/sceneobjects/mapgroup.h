@@ -0,0 +1,29 @@
+#ifndef MAPGROUP_H
+#define MAPGROUP_H
+
+#include "model_global.h"
+#include "model/scene/sceneobject.h"
+
+namespace Model
+{
+    // An editor group from a map file. Grouped objects are children of the group.
+    // Groups have no geometry of their own.
+    class MODELSHARED_EXPORT MapGroup : public SceneObject
+    {
+        friend class Scene;
+        Q_OBJECT
+    public:
+        int groupId() const;
+        void setGroupId(int id);
+
+    protected:
+        MapGroup(const SceneObjectInitParams &initParams, SceneObject* parentObject);
+        MapGroup(const MapGroup* cloneFrom, const SceneObjectInitParams &initParams);
+        virtual ~MapGroup();
+
+    private:
+        int m_iGroupId;
+    };
+}
+
+#endif // MAPGROUP_H
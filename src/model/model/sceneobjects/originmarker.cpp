@@ -62,4 +62,9 @@ namespace Model
     {
         return false;
     }
+
+    QString OriginMarker::sharedMeshKey() const
+    {
+        return QString("OriginMarker");
+    }
 }
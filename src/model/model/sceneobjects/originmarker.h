@@ -12,6 +12,7 @@ namespace Model
         Q_OBJECT
     public:
         virtual bool scalable() const override;
+        virtual QString sharedMeshKey() const override;
 
     protected:
         OriginMarker(const SceneObjectInitParams &initParams, SceneObject* parentObject);
@@ -2,6 +2,24 @@
 #include "model/global/resourceenvironment.h"
 #include "renderer/opengl/scopedcurrentcontext.h"
 #include "calliperutil/debug/debug.h"
+#include <QtConcurrent>
+
+namespace
+{
+    // Below this many objects, handing them to worker threads costs more than it saves.
+    const int PARALLEL_BAKE_THRESHOLD = 32;
+
+    struct BakeJob
+    {
+        Model::SceneObject* object;
+        Renderer::GeometryBuilder* builder;
+    };
+
+    void bakeObject(BakeJob &job)
+    {
+        job.object->rendererUpdate(*job.builder);
+    }
+}
 
 namespace Model
 {
@@ -11,7 +29,6 @@ namespace Model
         : m_pScene(scene),
           m_pRenderer(renderer),
           m_pFrameBuffer(frameBuffer),
-          m_matRecursiveUpdateMatrix(),
           m_pShaderPalette(Q_NULLPTR),
           m_vecDirectionalLight(QVector3D(1,1,1).normalized())
     {
@@ -43,45 +60,108 @@ namespace Model
 
         CUTL_ASSERT_SUCCESS(m_pFrameBuffer->bind());
 
-        m_matRecursiveUpdateMatrix.setToIdentity();
-        updateObjectRecursive(m_pScene->rootObject());
+        updateObjects();
         drawAllObjects(worldToCamera, projection);
 
         CUTL_ASSERT_SUCCESS(m_pFrameBuffer->release());
     }
 
-    void SceneRenderer::updateObjectRecursive(SceneObject *object)
+    void SceneRenderer::updateObjects()
     {
         using namespace Renderer;
-        ResourceEnvironment* resourceEnv = ResourceEnvironment::globalInstance();
 
-        QMatrix4x4 oldMatrix = m_matRecursiveUpdateMatrix;
-        m_matRecursiveUpdateMatrix = object->hierarchy().parentToLocal() * m_matRecursiveUpdateMatrix;
+        // Only objects that have changed since the last frame are visited,
+        // so a frame where nothing has changed costs next to nothing here.
+        foreach ( quint32 objectId, m_pScene->takeDestroyedObjects() )
+        {
+            m_pRenderer->removeObject(objectId);
+        }
+
+        const RenderFunctorGroup renderFunctors = ResourceEnvironment::globalInstance()->renderFunctors();
+        const QSet<quint32> objectIds = m_pScene->takeObjectsNeedingRendererUpdate();
+        QVector<BakeJob> jobs;
+        jobs.reserve(objectIds.count());
 
-        if ( object->needsRendererUpdate() )
+        foreach ( quint32 objectId, objectIds )
         {
-            GeometryBuilder builder(resourceEnv->renderFunctors(),
-                                    m_pShaderPalette,
-                                    0,
-                                    m_matRecursiveUpdateMatrix);
-            object->rendererUpdate(builder);
+            SceneObject* object = m_pScene->sceneObject(objectId);
+            if ( !object )
+            {
+                continue;
+            }
+
+            if ( object->isHidden() )
+            {
+                m_pRenderer->removeObject(objectId);
+                continue;
+            }
+
+            if ( !object->sharedMeshKey().isEmpty() )
+            {
+                updateInstance(object);
+                continue;
+            }
+
+            // Renderer matrices are cached lazily, and parents are shared
+            // between objects, so they're fetched here rather than by the workers.
+            BakeJob job;
+            job.object = object;
+            job.builder = new GeometryBuilder(renderFunctors, m_pShaderPalette, 0, object->rendererMatrix());
+            jobs.append(job);
+        }
 
+        // Baking only reads from the scene and the resource stores, so objects can
+        // be baked in parallel. The render model is only updated once they're done.
+        if ( jobs.count() < PARALLEL_BAKE_THRESHOLD )
+        {
+            for ( int i = 0; i < jobs.count(); i++ )
+            {
+                bakeObject(jobs[i]);
+            }
+        }
+        else
+        {
+            QtConcurrent::blockingMap(jobs, bakeObject);
+        }
+
+        foreach ( const BakeJob &job, jobs )
+        {
             m_pRenderer->updateObject(
                 RendererInputObjectParams(
-                    object->objectId(),
-                    m_pScene->classify(object->objectId()),
-                    builder
+                    job.object->objectId(),
+                    m_pScene->classify(job.object->objectId()),
+                    *job.builder
                 )
             );
+
+            delete job.builder;
         }
+    }
+
+    void SceneRenderer::updateInstance(SceneObject *object)
+    {
+        using namespace Renderer;
 
-        QList<SceneObject*> children = object->childSceneObjects();
-        foreach ( SceneObject* child, children )
+        const QString meshKey = object->sharedMeshKey();
+        if ( !m_pRenderer->containsSharedMesh(meshKey) )
         {
-            updateObjectRecursive(child);
+            GeometryBuilder builder(ResourceEnvironment::globalInstance()->renderFunctors(),
+                                    m_pShaderPalette,
+                                    0,
+                                    QMatrix4x4());
+            object->bakeSharedMesh(builder);
+            m_pRenderer->registerSharedMesh(meshKey, builder);
         }
 
-        m_matRecursiveUpdateMatrix = oldMatrix;
+        m_pRenderer->updateInstance(
+            RendererInputInstanceParams(
+                object->objectId(),
+                m_pScene->classify(object->objectId()),
+                meshKey,
+                object->rendererMatrix(),
+                object->rendererInstanceUpdate()
+            )
+        );
     }
 
     void SceneRenderer::drawAllObjects(const QMatrix4x4 &worldToCamera, const QMatrix4x4 &projection)
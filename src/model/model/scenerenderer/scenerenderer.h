@@ -35,14 +35,14 @@ namespace Model
         void render(const QMatrix4x4& worldToCamera, const QMatrix4x4& projection);
 
     private:
-        void updateObjectRecursive(SceneObject* object);
+        void updateObjects();
+        void updateInstance(SceneObject* object);
         void drawAllObjects(const QMatrix4x4& worldToCamera, const QMatrix4x4& projection);
 
         Scene* m_pScene;
         Renderer::RenderModel* m_pRenderer;
         QOpenGLFramebufferObject* m_pFrameBuffer;
 
-        QMatrix4x4  m_matRecursiveUpdateMatrix;
         Renderer::BaseShaderPalette* m_pShaderPalette;
         QVector3D m_vecDirectionalLight;
     };
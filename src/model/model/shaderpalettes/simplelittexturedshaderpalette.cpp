@@ -22,6 +22,11 @@ namespace Model
                 return KnownShaderDefs::UnlitPerVertexColourShaderId;
             }
 
+            case Renderer::ShaderDefs::LitTextureArray3D:
+            {
+                return KnownShaderDefs::SimpleLitTextureArrayShaderId;
+            }
+
             default:
             {
                 return KnownShaderDefs::UnknownShaderId;
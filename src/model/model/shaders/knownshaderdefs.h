@@ -17,6 +17,7 @@ namespace Model
 
             SimpleLitShaderId,
             UnlitPerVertexColourShaderId,
+            SimpleLitTextureArrayShaderId,
 
             TOTAL_SHADERS
         };
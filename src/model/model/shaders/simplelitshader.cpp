@@ -29,7 +29,7 @@ namespace Model
 
     bool SimpleLitShader::hasLocalUniformBlockBinding() const
     {
-        return true;
+        return false;
     }
 
     Renderer::VertexFormat SimpleLitShader::vertexFormat() const
@@ -39,6 +39,12 @@ namespace Model
 
     int SimpleLitShader::maxBatchedItems() const
     {
-        return 8;
+        // Buffer textures are guaranteed to hold at least 65536 texels.
+        return 16384;
+    }
+
+    Renderer::ShaderDefs::MatrixStorage SimpleLitShader::matrixStorage() const
+    {
+        return Renderer::ShaderDefs::BufferTextureMatrixStorage;
     }
 }
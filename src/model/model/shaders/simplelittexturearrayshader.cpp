@@ -0,0 +1,50 @@
+#include "simplelittexturearrayshader.h"
+#include "calliperutil/qobject/qobjectutil.h"
+namespace Model
+{
+    SimpleLitTextureArrayShader::SimpleLitTextureArrayShader(QObject* parent)
+        : Renderer::OpenGLShaderProgram(KnownShaderDefs::SimpleLitTextureArrayShaderId,
+                                        CalliperUtil::QObjectUtil::nonNamespacedClassName<SimpleLitTextureArrayShader>(),
+                                        parent)
+    {
+
+    }
+
+    SimpleLitTextureArrayShader::~SimpleLitTextureArrayShader()
+    {
+
+    }
+
+    KnownShaderDefs::KnownShaderId SimpleLitTextureArrayShader::knownShaderId() const
+    {
+        return static_cast<KnownShaderDefs::KnownShaderId>(shaderStoreId());
+    }
+
+    void SimpleLitTextureArrayShader::construct()
+    {
+        addShaderFileWithCommonHeaders(QOpenGLShader::Vertex, ":/model/shaders/simplelittexturearrayshader.vert");
+        addShaderFileWithCommonHeaders(QOpenGLShader::Fragment, ":/model/shaders/simplelittexturearrayshader.frag");
+        link();
+    }
+
+    bool SimpleLitTextureArrayShader::hasLocalUniformBlockBinding() const
+    {
+        return false;
+    }
+
+    Renderer::VertexFormat SimpleLitTextureArrayShader::vertexFormat() const
+    {
+        return Renderer::VertexFormat(4, 3, 4, 3);
+    }
+
+    int SimpleLitTextureArrayShader::maxBatchedItems() const
+    {
+        // Buffer textures are guaranteed to hold at least 65536 texels.
+        return 16384;
+    }
+
+    Renderer::ShaderDefs::MatrixStorage SimpleLitTextureArrayShader::matrixStorage() const
+    {
+        return Renderer::ShaderDefs::BufferTextureMatrixStorage;
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef SIMPLELITTEXTUREARRAYSHADER_H
+#define SIMPLELITTEXTUREARRAYSHADER_H
+
+#include "model_global.h"
+#include "renderer/opengl/openglshaderprogram.h"
+#include "knownshaderdefs.h"
+
+namespace Model
+{
+    class MODELSHARED_EXPORT SimpleLitTextureArrayShader : public Renderer::OpenGLShaderProgram
+    {
+        Q_OBJECT
+    public:
+        SimpleLitTextureArrayShader(QObject* parent = 0);
+        virtual ~SimpleLitTextureArrayShader();
+
+        KnownShaderDefs::KnownShaderId knownShaderId() const;
+
+        virtual void construct() override;
+        virtual bool hasLocalUniformBlockBinding() const override;
+        virtual Renderer::VertexFormat vertexFormat() const override;
+        virtual int maxBatchedItems() const override;
+        virtual Renderer::ShaderDefs::MatrixStorage matrixStorage() const override;
+    };
+}
+
+#endif // SIMPLELITTEXTUREARRAYSHADER_H
@@ -28,7 +28,7 @@ namespace Model
 
     bool UnlitPerVertexColorShader::hasLocalUniformBlockBinding() const
     {
-        return true;
+        return false;
     }
 
     Renderer::VertexFormat UnlitPerVertexColorShader::vertexFormat() const
@@ -38,6 +38,12 @@ namespace Model
 
     int UnlitPerVertexColorShader::maxBatchedItems() const
     {
-        return 8;
+        // Buffer textures are guaranteed to hold at least 65536 texels.
+        return 16384;
+    }
+
+    Renderer::ShaderDefs::MatrixStorage UnlitPerVertexColorShader::matrixStorage() const
+    {
+        return Renderer::ShaderDefs::BufferTextureMatrixStorage;
     }
 }
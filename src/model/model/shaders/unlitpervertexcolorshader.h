@@ -20,6 +20,7 @@ namespace Model
         virtual bool hasLocalUniformBlockBinding() const override;
         virtual Renderer::VertexFormat vertexFormat() const override;
         virtual int maxBatchedItems() const override;
+        virtual Renderer::ShaderDefs::MatrixStorage matrixStorage() const override;
     };
 }
 
@@ -0,0 +1,21 @@
+#ifndef IMATERIALRESOLVER_H
+#define IMATERIALRESOLVER_H
+
+#include "model_global.h"
+#include "renderer/functors/imaterialretrievalfunctor.h"
+
+namespace Model
+{
+    class IMaterialResolver
+    {
+    public:
+        virtual ~IMaterialResolver() {}
+
+        // Called by the material store the first time a path with no material is requested.
+        // The resolver should create the material through the store and return it,
+        // or return a null pointer if the path cannot be resolved.
+        virtual Renderer::RenderMaterialPointer resolveMaterial(const QString& path) = 0;
+    };
+}
+
+#endif // IMATERIALRESOLVER_H
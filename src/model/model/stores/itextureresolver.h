@@ -0,0 +1,21 @@
+#ifndef ITEXTURERESOLVER_H
+#define ITEXTURERESOLVER_H
+
+#include "model_global.h"
+#include "renderer/functors/itextureretrievalfunctor.h"
+
+namespace Model
+{
+    class ITextureResolver
+    {
+    public:
+        virtual ~ITextureResolver() {}
+
+        // Called by the texture store to restore a texture that was evicted to stay within
+        // its memory budget. The texture keeps its ID and path but has no storage.
+        // An OpenGL context is current. Return false if the texture cannot be restored.
+        virtual bool reloadTexture(Renderer::OpenGLTexturePointer& texture) = 0;
+    };
+}
+
+#endif // ITEXTURERESOLVER_H
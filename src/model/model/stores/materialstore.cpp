@@ -10,7 +10,8 @@ namespace Model
 {
     MaterialStore::MaterialStore()
         : m_iNextMaterialId(1),
-          m_pDefaultMaterial(Renderer::RenderMaterialPointer::create(0, QString()))
+          m_pDefaultMaterial(Renderer::RenderMaterialPointer::create(0, QString())),
+          m_pMaterialResolver(Q_NULLPTR)
     {
         m_pDefaultMaterial->setShaderTechnique(Renderer::ShaderDefs::LitTextured3D);
         m_pDefaultMaterial->addTexture(Renderer::ShaderDefs::MainTexture, 0);
@@ -76,14 +77,46 @@ namespace Model
         return materialPointer;
     }
 
-    quint32 MaterialStore::getMaterialId(const QString &path) const
+    quint32 MaterialStore::existingMaterialId(const QString &path) const
     {
         return m_MaterialPathTable.value(path, 0);
     }
 
+    quint32 MaterialStore::getMaterialId(const QString &path)
+    {
+        quint32 materialId = existingMaterialId(path);
+        if ( materialId != 0 || !m_pMaterialResolver || path.isEmpty() || m_UnresolvedPaths.contains(path) )
+        {
+            return materialId;
+        }
+
+        Renderer::RenderMaterialPointer material = m_pMaterialResolver->resolveMaterial(path);
+        if ( !material )
+        {
+            m_UnresolvedPaths.insert(path);
+            return 0;
+        }
+
+        return material->materialStoreId();
+    }
+
     Renderer::RenderMaterialPointer MaterialStore::getMaterial(const QString &path) const
     {
-        return getMaterial(getMaterialId(path));
+        return getMaterial(existingMaterialId(path));
+    }
+
+    IMaterialResolver* MaterialStore::materialResolver() const
+    {
+        return m_pMaterialResolver;
+    }
+
+    void MaterialStore::setMaterialResolver(IMaterialResolver *resolver)
+    {
+        if ( m_pMaterialResolver == resolver )
+            return;
+
+        m_pMaterialResolver = resolver;
+        m_UnresolvedPaths.clear();
     }
 
     Renderer::RenderMaterialPointer MaterialStore::defaultMaterial() const
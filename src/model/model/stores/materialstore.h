@@ -3,8 +3,10 @@
 
 #include "model_global.h"
 #include <QHash>
+#include <QSet>
 #include "renderer/materials/rendermaterial.h"
 #include "renderer/functors/imaterialretrievalfunctor.h"
+#include "model/stores/imaterialresolver.h"
 
 namespace Model
 {
@@ -22,9 +24,18 @@ namespace Model
         virtual Renderer::RenderMaterialPointer operator ()(quint32 materialId) const override;
         Renderer::RenderMaterialPointer getMaterial(quint32 materialId) const;
         Renderer::RenderMaterialPointer createMaterial(const QString &path);
-        quint32 getMaterialId(const QString &path) const;
+
+        // If no material exists for the path and a resolver is set, the resolver
+        // is asked to create one. Paths it fails to resolve are not retried.
+        quint32 getMaterialId(const QString &path);
+
+        // Only returns materials that already exist.
         Renderer::RenderMaterialPointer getMaterial(const QString &path) const;
 
+        // The resolver is not owned by the store.
+        IMaterialResolver* materialResolver() const;
+        void setMaterialResolver(IMaterialResolver* resolver);
+
         Renderer::RenderMaterialPointer defaultMaterial() const;
         Renderer::RenderMaterialPointer presetMaterial(PresetMaterial material) const;
         quint32 presetMaterialId(PresetMaterial material) const;
@@ -35,12 +46,15 @@ namespace Model
         void createPresetMaterial(PresetMaterial preset, Renderer::RenderMaterial* material);
         Renderer::RenderMaterialPointer createMaterialInternal(const QString &path, quint32 id);
         Renderer::RenderMaterialPointer createMaterialInternal(Renderer::RenderMaterial* material);
+        quint32 existingMaterialId(const QString& path) const;
 
         quint32 m_iNextMaterialId;
         Renderer::RenderMaterialPointer m_pDefaultMaterial;
         QHash<quint32, Renderer::RenderMaterialPointer> m_MaterialTable;
         QHash<QString, quint32> m_MaterialPathTable;
         QHash<PresetMaterial, quint32> m_PresetMaterialTable;
+        IMaterialResolver* m_pMaterialResolver;
+        QSet<QString> m_UnresolvedPaths;
     };
 }
 
@@ -1,6 +1,7 @@
 #include "shaderstore.h"
 #include "model/shaders/simplelitshader.h"
 #include "model/shaders/unlitpervertexcolorshader.h"
+#include "model/shaders/simplelittexturearrayshader.h"
 
 namespace Model
 {
@@ -10,6 +11,7 @@ namespace Model
 
         addShaderProgram(new SimpleLitShader());
         addShaderProgram(new UnlitPerVertexColorShader());
+        addShaderProgram(new SimpleLitTextureArrayShader());
     }
 
     ShaderStore::~ShaderStore()
@@ -1,13 +1,73 @@
 #include "texturestore.h"
+#include "itextureresolver.h"
 #include <QtDebug>
+#include <QStringList>
+#include <QMutexLocker>
+#include <algorithm>
 
 namespace Model
 {
     Q_LOGGING_CATEGORY(lcTextureStore, "Model.TextureStore")
 
+    namespace
+    {
+        // Bytes for a single image of the given dimensions.
+        quint64 imageMemory(QOpenGLTexture::TextureFormat format, quint64 width, quint64 height)
+        {
+            const quint64 blocks = ((width + 3) / 4) * ((height + 3) / 4);
+
+            switch ( format )
+            {
+                case QOpenGLTexture::RGB_DXT1:
+                case QOpenGLTexture::RGBA_DXT1:
+                case QOpenGLTexture::R_ATI1N_UNorm:
+                case QOpenGLTexture::R_ATI1N_SNorm:
+                    return blocks * 8;
+
+                case QOpenGLTexture::RGBA_DXT3:
+                case QOpenGLTexture::RGBA_DXT5:
+                case QOpenGLTexture::RG_ATI2N_UNorm:
+                case QOpenGLTexture::RG_ATI2N_SNorm:
+                    return blocks * 16;
+
+                case QOpenGLTexture::R8_UNorm:
+                case QOpenGLTexture::R8_SNorm:
+                case QOpenGLTexture::R8U:
+                case QOpenGLTexture::R8I:
+                    return width * height;
+
+                case QOpenGLTexture::RG8_UNorm:
+                case QOpenGLTexture::RG8_SNorm:
+                case QOpenGLTexture::R16_UNorm:
+                case QOpenGLTexture::R16F:
+                case QOpenGLTexture::D16:
+                    return width * height * 2;
+
+                case QOpenGLTexture::RGB8_UNorm:
+                case QOpenGLTexture::SRGB8:
+                    return width * height * 3;
+
+                case QOpenGLTexture::RGBA16_UNorm:
+                case QOpenGLTexture::RGBA16F:
+                case QOpenGLTexture::RG32F:
+                    return width * height * 8;
+
+                case QOpenGLTexture::RGBA32F:
+                    return width * height * 16;
+
+                default:
+                    // RGBA8 and other 32-bit formats.
+                    return width * height * 4;
+            }
+        }
+    }
+
     TextureStore::TextureStore()
         : m_iNextTextureId(1),
-          m_pDefaultTexture(Renderer::OpenGLTexturePointer::create(0, QOpenGLTexture::Target2D))
+          m_pDefaultTexture(Renderer::OpenGLTexturePointer::create(0, QOpenGLTexture::Target2D)),
+          m_iCurrentFrame(1),
+          m_iTextureMemoryBudget(0),
+          m_pTextureResolver(Q_NULLPTR)
     {
 
     }
@@ -34,6 +94,17 @@ namespace Model
 
     Renderer::OpenGLTexturePointer TextureStore::operator ()(quint32 textureId) const
     {
+        QMutexLocker locker(&m_UsageMutex);
+
+        if ( m_EvictedTextures.contains(textureId) )
+        {
+            m_RequestedTextures.insert(textureId);
+        }
+        else if ( m_TextureTable.contains(textureId) )
+        {
+            m_LastUsedFrame.insert(textureId, m_iCurrentFrame);
+        }
+
         return getTexture(textureId);
     }
 
@@ -49,10 +120,11 @@ namespace Model
         OpenGLTexturePointer texture = OpenGLTexturePointer::create(acquireNextTextureId(), QImage(path).mirrored());
         texture->create();
         processCreatedTexture(texture, path);
+        m_FileTextures.insert(texture->textureStoreId());
         return texture;
     }
 
-    Renderer::OpenGLTexturePointer TextureStore::createEmptyTexture(const QString &path)
+    Renderer::OpenGLTexturePointer TextureStore::createEmptyTexture(const QString &path, QOpenGLTexture::Target target)
     {
         using namespace Renderer;
 
@@ -61,7 +133,7 @@ namespace Model
             return getTexture(m_TexturePathTable.value(path));
         }
 
-        OpenGLTexturePointer texture = OpenGLTexturePointer::create(acquireNextTextureId(), QOpenGLTexture::Target2D);
+        OpenGLTexturePointer texture = OpenGLTexturePointer::create(acquireNextTextureId(), target);
         processCreatedTexture(texture, path);
         return texture;
     }
@@ -94,6 +166,10 @@ namespace Model
 
         m_TextureTable.remove(textureId);
         m_TexturePathTable.remove(texture->path());
+        m_FileTextures.remove(textureId);
+        m_EvictedTextures.remove(textureId);
+        m_RequestedTextures.remove(textureId);
+        m_LastUsedFrame.remove(textureId);
         texture->destroy();
     }
 
@@ -119,4 +195,242 @@ namespace Model
         m_pDefaultTexture->setData(image.mirrored());
         m_pDefaultTexture->create();
     }
+
+    quint64 TextureStore::textureMemory(const QOpenGLTexture &texture)
+    {
+        if ( !texture.isCreated() || !texture.isStorageAllocated() )
+        {
+            return 0;
+        }
+
+        const int mipLevels = qMax(texture.mipLevels(), 1);
+        const quint64 layers = qMax(texture.layers(), 1);
+        const quint64 faces = qMax(texture.faces(), 1);
+
+        quint64 bytes = 0;
+        for ( int mip = 0; mip < mipLevels; ++mip )
+        {
+            const quint64 width = qMax(texture.width() >> mip, 1);
+            const quint64 height = qMax(texture.height() >> mip, 1);
+            const quint64 depth = qMax(texture.depth() >> mip, 1);
+
+            bytes += imageMemory(texture.format(), width, height) * depth;
+        }
+
+        return bytes * layers * faces;
+    }
+
+    quint64 TextureStore::textureMemory(quint32 textureId) const
+    {
+        if ( !m_TextureTable.contains(textureId) )
+        {
+            return 0;
+        }
+
+        return textureMemory(*m_TextureTable.value(textureId));
+    }
+
+    quint64 TextureStore::totalTextureMemory() const
+    {
+        quint64 total = 0;
+        foreach ( const Renderer::OpenGLTexturePointer& texture, m_TextureTable )
+        {
+            total += textureMemory(*texture);
+        }
+
+        return total;
+    }
+
+    QMap<QString, quint64> TextureStore::textureMemoryByPathPrefix(int pathDepth) const
+    {
+        QMap<QString, quint64> usage;
+        foreach ( const Renderer::OpenGLTexturePointer& texture, m_TextureTable )
+        {
+            // The last component is the texture's own name, so is never part of the prefix.
+            QStringList components = texture->path().split('/', QString::SkipEmptyParts);
+            QString prefix = QStringList(components.mid(0, qMin(pathDepth, components.count() - 1))).join('/');
+
+            usage[prefix] += textureMemory(*texture);
+        }
+
+        return usage;
+    }
+
+    quint64 TextureStore::currentFrame() const
+    {
+        return m_iCurrentFrame;
+    }
+
+    quint64 TextureStore::lastUsedFrame(quint32 textureId) const
+    {
+        return m_LastUsedFrame.value(textureId, 0);
+    }
+
+    void TextureStore::endFrame()
+    {
+        evictTexturesOverBudget();
+        ++m_iCurrentFrame;
+    }
+
+    quint64 TextureStore::textureMemoryBudget() const
+    {
+        return m_iTextureMemoryBudget;
+    }
+
+    void TextureStore::setTextureMemoryBudget(quint64 bytes)
+    {
+        m_iTextureMemoryBudget = bytes;
+    }
+
+    bool TextureStore::isEvictable(quint32 textureId) const
+    {
+        if ( m_EvictedTextures.contains(textureId) || lastUsedFrame(textureId) >= m_iCurrentFrame )
+        {
+            return false;
+        }
+
+        // Texture arrays are assembled from several sources, so can't be reloaded.
+        const Renderer::OpenGLTexturePointer texture = m_TextureTable.value(textureId);
+        if ( !texture || texture->target() != QOpenGLTexture::Target2D )
+        {
+            return false;
+        }
+
+        return m_FileTextures.contains(textureId) || m_pTextureResolver;
+    }
+
+    int TextureStore::evictTexturesOverBudget()
+    {
+        if ( m_iTextureMemoryBudget == 0 )
+        {
+            return 0;
+        }
+
+        quint64 total = totalTextureMemory();
+        if ( total <= m_iTextureMemoryBudget )
+        {
+            return 0;
+        }
+
+        QList<QPair<quint64, quint32> > candidates;
+        for ( QHash<quint32, Renderer::OpenGLTexturePointer>::const_iterator it = m_TextureTable.constBegin();
+              it != m_TextureTable.constEnd(); ++it )
+        {
+            if ( isEvictable(it.key()) )
+            {
+                candidates.append(qMakePair(lastUsedFrame(it.key()), it.key()));
+            }
+        }
+
+        // Least recently used first, and by ID for textures used in the same frame.
+        std::sort(candidates.begin(), candidates.end());
+
+        int evicted = 0;
+        for ( int i = 0; i < candidates.count() && total > m_iTextureMemoryBudget; ++i )
+        {
+            const quint32 textureId = candidates.at(i).second;
+            Renderer::OpenGLTexturePointer texture = m_TextureTable.value(textureId);
+
+            const quint64 bytes = textureMemory(*texture);
+            if ( bytes == 0 )
+            {
+                continue;
+            }
+
+            // Geometry built while the texture is evicted still needs its real size.
+            texture->setImageSize(texture->size());
+            texture->destroy();
+            m_EvictedTextures.insert(textureId);
+            total -= bytes;
+            ++evicted;
+        }
+
+        if ( total > m_iTextureMemoryBudget )
+        {
+            qCDebug(lcTextureStore) << "Textures in use exceed the memory budget:" << total << "bytes, budget is"
+                                    << m_iTextureMemoryBudget << "bytes";
+        }
+
+        if ( evicted > 0 )
+        {
+            qCDebug(lcTextureStore) << "Evicted" << evicted << "textures, now using" << total << "bytes";
+        }
+
+        return evicted;
+    }
+
+    bool TextureStore::isEvicted(quint32 textureId) const
+    {
+        return m_EvictedTextures.contains(textureId);
+    }
+
+    int TextureStore::evictedTextureCount() const
+    {
+        return m_EvictedTextures.count();
+    }
+
+    ITextureResolver* TextureStore::textureResolver() const
+    {
+        return m_pTextureResolver;
+    }
+
+    void TextureStore::setTextureResolver(ITextureResolver *resolver)
+    {
+        m_pTextureResolver = resolver;
+    }
+
+    bool TextureStore::hasRequestedTextures() const
+    {
+        return !m_RequestedTextures.isEmpty();
+    }
+
+    int TextureStore::restoreRequestedTextures(int maxRestores)
+    {
+        int restored = 0;
+
+        QSet<quint32>::iterator it = m_RequestedTextures.begin();
+        while ( it != m_RequestedTextures.end() && (maxRestores < 0 || restored < maxRestores) )
+        {
+            const quint32 textureId = *it;
+            it = m_RequestedTextures.erase(it);
+
+            if ( !m_EvictedTextures.contains(textureId) )
+            {
+                continue;
+            }
+
+            if ( !restoreTexture(textureId) )
+            {
+                qCWarning(lcTextureStore) << "Failed to restore evicted texture" << m_TextureTable.value(textureId)->path();
+                destroyTexture(textureId);
+                continue;
+            }
+
+            m_EvictedTextures.remove(textureId);
+            m_LastUsedFrame.insert(textureId, m_iCurrentFrame);
+            ++restored;
+        }
+
+        return restored;
+    }
+
+    bool TextureStore::restoreTexture(quint32 textureId)
+    {
+        Renderer::OpenGLTexturePointer texture = m_TextureTable.value(textureId);
+
+        if ( m_FileTextures.contains(textureId) )
+        {
+            QImage image(texture->path());
+            if ( image.isNull() )
+            {
+                return false;
+            }
+
+            texture->setData(image.mirrored());
+            texture->create();
+            return true;
+        }
+
+        return m_pTextureResolver && m_pTextureResolver->reloadTexture(texture);
+    }
 }
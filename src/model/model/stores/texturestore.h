@@ -4,6 +4,9 @@
 #include "model_global.h"
 
 #include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QMutex>
 #include <QLoggingCategory>
 
 #include "renderer/opengl/opengltexture.h"
@@ -13,16 +16,25 @@ namespace Model
 {
     Q_DECLARE_LOGGING_CATEGORY(lcTextureStore)
 
+    class ITextureResolver;
+
     class MODELSHARED_EXPORT TextureStore : public Renderer::ITextureRetrievalFunctor
     {
     public:
         TextureStore();
         ~TextureStore();
 
+        // Retrieval through the functor counts as the texture being used this frame.
+        // If the texture has been evicted, it is still returned so that its size is available,
+        // and it is queued to be restored by restoreRequestedTextures(). It has no GL object
+        // until then, so the renderer binds the default texture in its place.
+        // The functor may be called from several threads at once while geometry is
+        // baked, but nothing else in the store may be used while that happens.
         virtual Renderer::OpenGLTexturePointer operator ()(quint32 textureId) const override;
         Renderer::OpenGLTexturePointer getTexture(quint32 textureId) const;
         Renderer::OpenGLTexturePointer createTextureFromFile(const QString &path);
-        Renderer::OpenGLTexturePointer createEmptyTexture(const QString& path);
+        Renderer::OpenGLTexturePointer createEmptyTexture(const QString& path,
+                                                          QOpenGLTexture::Target target = QOpenGLTexture::Target2D);
         quint32 getTextureId(const QString &path) const;
         Renderer::OpenGLTexturePointer getTexture(const QString &path) const;
 
@@ -34,14 +46,65 @@ namespace Model
         Renderer::OpenGLTexturePointer defaultTexture() const;
         void setDefaultTextureFromFile(const QString& path);
 
+        // Bytes of GPU storage allocated for a texture, including all mips, layers and faces.
+        static quint64 textureMemory(const QOpenGLTexture& texture);
+        quint64 textureMemory(quint32 textureId) const;
+        quint64 totalTextureMemory() const;
+
+        // Memory use summed by the first pathDepth components of each texture's path,
+        // eg. "nature" for "nature/rockfloor005a" with a depth of 1.
+        QMap<QString, quint64> textureMemoryByPathPrefix(int pathDepth = 1) const;
+
+        // Frames are counted by calls to endFrame().
+        quint64 currentFrame() const;
+        quint64 lastUsedFrame(quint32 textureId) const;
+
+        // Call once per frame after drawing. Advances the frame counter and, if a
+        // budget is set, evicts the least recently used textures until the store is
+        // within the budget. Requires a current OpenGL context.
+        void endFrame();
+
+        // A budget of 0 means no limit.
+        quint64 textureMemoryBudget() const;
+        void setTextureMemoryBudget(quint64 bytes);
+
+        // Frees the storage of textures that have not been used in the current frame,
+        // least recently used first, until total memory is within the budget.
+        // Returns the number of textures evicted.
+        int evictTexturesOverBudget();
+        bool isEvicted(quint32 textureId) const;
+        int evictedTextureCount() const;
+
+        // Textures created from files are restored by the store. Other textures can only
+        // be evicted if a resolver is set to restore them.
+        ITextureResolver* textureResolver() const;
+        void setTextureResolver(ITextureResolver* resolver);
+
+        // Restores evicted textures that have been requested since the last call.
+        // Requires a current OpenGL context. A negative maxRestores means no limit.
+        // Returns the number of textures restored.
+        int restoreRequestedTextures(int maxRestores = -1);
+        bool hasRequestedTextures() const;
+
     private:
         quint32 acquireNextTextureId();
         void processCreatedTexture(const Renderer::OpenGLTexturePointer& texture, const QString& path);
+        bool isEvictable(quint32 textureId) const;
+        bool restoreTexture(quint32 textureId);
 
         quint32 m_iNextTextureId;
         Renderer::OpenGLTexturePointer m_pDefaultTexture;
         QHash<quint32, Renderer::OpenGLTexturePointer> m_TextureTable;
         QHash<QString, quint32> m_TexturePathTable;
+
+        QSet<quint32> m_FileTextures;
+        QSet<quint32> m_EvictedTextures;
+        mutable QSet<quint32> m_RequestedTextures;
+        mutable QHash<quint32, quint64> m_LastUsedFrame;
+        mutable QMutex m_UsageMutex;    // Guards the two above within operator ().
+        quint64 m_iCurrentFrame;
+        quint64 m_iTextureMemoryBudget;
+        ITextureResolver* m_pTextureResolver;
     };
 }
 
@@ -17,24 +17,27 @@ SOURCES += \
     renderer/geometry/geometrysection.cpp \
     renderer/geometry/vertex3d.cpp \
     renderer/materials/rendermaterial.cpp \
+    renderer/opengl/openglbuffertexture.cpp \
     renderer/opengl/openglerrors.cpp \
     renderer/opengl/openglshaderprogram.cpp \
     renderer/opengl/opengltexture.cpp \
     renderer/opengl/opengluniformbuffer.cpp \
     renderer/opengl/openglvertexarrayobject.cpp \
     renderer/rendermodel/0-modellevel/rendermodel.cpp \
-    renderer/rendermodel/0-modellevel/rendermodelkey.cpp \
     renderer/rendermodel/1-passlevel/rendermodelpass.cpp \
     renderer/rendermodel/1-passlevel/rendermodelpasskey.cpp \
     renderer/rendermodel/2-batchgrouplevel/rendermodelbatchgroup.cpp \
     renderer/rendermodel/2-batchgrouplevel/rendermodelbatchgroupkey.cpp \
+    renderer/rendermodel/3-batchlevel/bufferarena.cpp \
+    renderer/rendermodel/3-batchlevel/instancebatch.cpp \
     renderer/rendermodel/3-batchlevel/matrixbatch.cpp \
     renderer/rendermodel/3-batchlevel/matrixbatchkey.cpp \
     renderer/rendermodel/3-batchlevel/openglbatch.cpp \
+    renderer/rendermodel/3-batchlevel/sharedmeshsection.cpp \
     renderer/rendermodel/4-batchitemlevel/matrixbatchitem.cpp \
-    renderer/rendermodel/4-batchitemlevel/matrixbatchitemkey.cpp \
     renderer/rendermodel/rendererdrawparams.cpp \
     renderer/rendermodel/rendererinputobjectparams.cpp \
+    renderer/rendermodel/rendererinputinstanceparams.cpp \
     renderer/shaders/globalshaderuniforms.cpp \
     renderer/shaders/shaderdefs.cpp \
     renderer/shaders/vertexformat.cpp \
@@ -53,6 +56,7 @@ HEADERS +=\
     renderer/geometry/geometrysection.h \
     renderer/geometry/vertex3d.h \
     renderer/materials/rendermaterial.h \
+    renderer/opengl/openglbuffertexture.h \
     renderer/opengl/openglerrors.h \
     renderer/opengl/openglhelpers.h \
     renderer/opengl/openglshaderprogram.h \
@@ -60,18 +64,21 @@ HEADERS +=\
     renderer/opengl/opengluniformbuffer.h \
     renderer/opengl/openglvertexarrayobject.h \
     renderer/rendermodel/0-modellevel/rendermodel.h \
-    renderer/rendermodel/0-modellevel/rendermodelkey.h \
     renderer/rendermodel/1-passlevel/rendermodelpass.h \
     renderer/rendermodel/1-passlevel/rendermodelpasskey.h \
     renderer/rendermodel/2-batchgrouplevel/rendermodelbatchgroup.h \
     renderer/rendermodel/2-batchgrouplevel/rendermodelbatchgroupkey.h \
+    renderer/rendermodel/3-batchlevel/bufferarena.h \
+    renderer/rendermodel/3-batchlevel/instancebatch.h \
     renderer/rendermodel/3-batchlevel/matrixbatch.h \
     renderer/rendermodel/3-batchlevel/matrixbatchkey.h \
     renderer/rendermodel/3-batchlevel/openglbatch.h \
+    renderer/rendermodel/3-batchlevel/sharedmeshsection.h \
     renderer/rendermodel/4-batchitemlevel/matrixbatchitem.h \
-    renderer/rendermodel/4-batchitemlevel/matrixbatchitemkey.h \
     renderer/rendermodel/rendererdrawparams.h \
     renderer/rendermodel/rendererinputobjectparams.h \
+    renderer/rendermodel/rendererinputinstanceparams.h \
+    renderer/rendermodel/slotmap.h \
     renderer/rendermodel/rendererobjectflags.h \
     renderer/shaders/globalshaderuniforms.h \
     renderer/shaders/ishaderspec.h \
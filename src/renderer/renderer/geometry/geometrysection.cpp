@@ -91,7 +91,8 @@ namespace Renderer
           m_iMaterialId(materialId),
           m_matModelToWorld(modelToWorldMatrix),
           m_pShader(getShader()),
-          m_VertexFormat(m_pShader ? m_pShader->vertexFormat() : VertexFormat(0,0,0,0))
+          m_VertexFormat(m_pShader ? m_pShader->vertexFormat() : VertexFormat(0,0,0,0)),
+          m_flTextureArrayLayer(getTextureArrayLayer())
     {
         init();
     }
@@ -148,7 +149,8 @@ namespace Renderer
 
     void GeometrySection::addTextureCoordinate(const QVector2D &coord)
     {
-        append<QVector2D>(m_Attributes[TextureCoordinateAttribute], coord, 2,
+        // If the shader takes a third component, it's the layer within the texture array.
+        append<QVector3D>(m_Attributes[TextureCoordinateAttribute], QVector3D(coord, m_flTextureArrayLayer), 3,
                           vertexFormatComponents(m_VertexFormat, TextureCoordinateAttribute));
     }
 
@@ -295,6 +297,12 @@ namespace Renderer
         m_iMaterialId = id;
     }
 
+    quint32 GeometrySection::batchMaterialId() const
+    {
+        RenderMaterialPointer material = (*materialFunctor())(m_iMaterialId);
+        return material ? material->batchMaterialId() : m_iMaterialId;
+    }
+
     GLenum GeometrySection::drawMode() const
     {
         return m_iDrawMode;
@@ -348,4 +356,12 @@ namespace Renderer
         quint16 shaderId = m_pShaderPalette->shader(shaderTechnique);
         return (*shaderFunctor())(shaderId);
     }
+
+    float GeometrySection::getTextureArrayLayer() const
+    {
+        RenderMaterialPointer material = (*materialFunctor())(m_iMaterialId);
+        return material && material->textureArrayLayer() >= 0
+                ? static_cast<float>(material->textureArrayLayer())
+                : 0.0f;
+    }
 }
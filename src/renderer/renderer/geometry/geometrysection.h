@@ -82,6 +82,10 @@ namespace Renderer
         quint32 materialId() const;
         void setMaterialId(quint32 id);
 
+        // Material whose textures are bound when this section is drawn.
+        // See RenderMaterial::batchMaterialId().
+        quint32 batchMaterialId() const;
+
         GLenum drawMode() const;
         void setDrawMode(GLenum mode);
 
@@ -101,6 +105,7 @@ namespace Renderer
     private:
         void init();
         OpenGLShaderProgram* getShader() const;
+        float getTextureArrayLayer() const;
 
         QList<QVector<float> >  m_Attributes;
         QVector<quint32>        m_Indices;
@@ -115,6 +120,7 @@ namespace Renderer
         QMatrix4x4 m_matModelToWorld;
         OpenGLShaderProgram* m_pShader;
         VertexFormat m_VertexFormat;
+        float m_flTextureArrayLayer;
     };
 
     typedef QList<GeometrySection> GeometrySectionList;
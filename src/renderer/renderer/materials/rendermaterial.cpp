@@ -6,7 +6,12 @@ namespace Renderer
         : m_iId(id),
           m_strPath(path),
           m_TextureUnitToIdMap(),
-          m_nTechnique(ShaderDefs::UnlitTextured3D)
+          m_nTechnique(ShaderDefs::UnlitTextured3D),
+          m_iBatchMaterialId(0),
+          m_iTextureArrayLayer(-1),
+          m_bTranslucent(false),
+          m_bAlphaTest(false),
+          m_flAlphaTestReference(0.5f)
     {
 
     }
@@ -70,4 +75,50 @@ namespace Renderer
     {
         return m_TextureUnitToIdMap.contains(ShaderDefs::MainTexture);
     }
+
+    quint32 RenderMaterial::batchMaterialId() const
+    {
+        return m_iBatchMaterialId != 0 ? m_iBatchMaterialId : m_iId;
+    }
+
+    void RenderMaterial::setBatchMaterialId(quint32 id)
+    {
+        m_iBatchMaterialId = id;
+    }
+
+    int RenderMaterial::textureArrayLayer() const
+    {
+        return m_iTextureArrayLayer;
+    }
+
+    void RenderMaterial::setTextureArrayLayer(int layer)
+    {
+        m_iTextureArrayLayer = layer;
+    }
+
+    bool RenderMaterial::isTranslucent() const
+    {
+        return m_bTranslucent;
+    }
+
+    void RenderMaterial::setTranslucent(bool translucent)
+    {
+        m_bTranslucent = translucent;
+    }
+
+    bool RenderMaterial::isAlphaTested() const
+    {
+        return m_bAlphaTest;
+    }
+
+    float RenderMaterial::alphaTestReference() const
+    {
+        return m_flAlphaTestReference;
+    }
+
+    void RenderMaterial::setAlphaTest(bool enabled, float reference)
+    {
+        m_bAlphaTest = enabled;
+        m_flAlphaTestReference = reference;
+    }
 }
@@ -30,11 +30,36 @@ namespace Renderer
 
         const QMap<ShaderDefs::TextureUnit, quint32>& textureUnitMap() const;
 
+        // Materials whose main texture is a layer in a texture array share their
+        // texture bindings with a single material for the array. The renderer batches
+        // geometry by this material instead, so that all materials in the array can
+        // be drawn together. If no batch material is set, this returns the material's own ID.
+        quint32 batchMaterialId() const;
+        void setBatchMaterialId(quint32 id);
+
+        // Layer within the main texture that this material uses, or -1 if the
+        // main texture is not a texture array.
+        int textureArrayLayer() const;
+        void setTextureArrayLayer(int layer);
+
+        bool isTranslucent() const;
+        void setTranslucent(bool translucent);
+
+        // Fragments with an alpha below the reference are discarded when alpha testing is enabled.
+        bool isAlphaTested() const;
+        float alphaTestReference() const;
+        void setAlphaTest(bool enabled, float reference = 0.5f);
+
     private:
         quint32 m_iId;
         QString m_strPath;
         QMap<ShaderDefs::TextureUnit, quint32> m_TextureUnitToIdMap;
         ShaderDefs::ShaderTechnique m_nTechnique;
+        quint32 m_iBatchMaterialId;
+        int m_iTextureArrayLayer;
+        bool m_bTranslucent;
+        bool m_bAlphaTest;
+        float m_flAlphaTestReference;
     };
 }
 
@@ -0,0 +1,187 @@
+#include "openglbuffertexture.h"
+#include "openglhelpers.h"
+#include "renderer/opengl/openglerrors.h"
+
+namespace Renderer
+{
+    OpenGLBufferTexture::OpenGLBufferTexture(QOpenGLBuffer::UsagePattern pattern)
+        : m_iBufferHandle(0),
+          m_iTextureHandle(0),
+          m_bCreated(false),
+          m_iUsagePattern(pattern)
+    {
+
+    }
+
+    OpenGLBufferTexture::OpenGLBufferTexture() : OpenGLBufferTexture(QOpenGLBuffer::StaticDraw)
+    {
+
+    }
+
+    OpenGLBufferTexture::~OpenGLBufferTexture()
+    {
+        destroy();
+    }
+
+    bool OpenGLBufferTexture::create()
+    {
+        if ( m_bCreated )
+            return true;
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glGenBuffers(1, &m_iBufferHandle));
+        if ( m_iBufferHandle == 0 )
+            return false;
+
+        GLTRY(f->glGenTextures(1, &m_iTextureHandle));
+        if ( m_iTextureHandle == 0 )
+        {
+            GLTRY(f->glDeleteBuffers(1, &m_iBufferHandle));
+            m_iBufferHandle = 0;
+            return false;
+        }
+
+        // The texture refers to the buffer object rather than its storage,
+        // so this only needs doing once.
+        GLTRY(f->glBindBuffer(GL_TEXTURE_BUFFER, m_iBufferHandle));
+        GLTRY(f->glBindTexture(GL_TEXTURE_BUFFER, m_iTextureHandle));
+        GLTRY(f->glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_iBufferHandle));
+        GLTRY(f->glBindTexture(GL_TEXTURE_BUFFER, 0));
+        GLTRY(f->glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+        m_bCreated = true;
+        return true;
+    }
+
+    void OpenGLBufferTexture::destroy()
+    {
+        if ( !m_bCreated )
+            return;
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glDeleteTextures(1, &m_iTextureHandle));
+        GLTRY(f->glDeleteBuffers(1, &m_iBufferHandle));
+        m_iTextureHandle = 0;
+        m_iBufferHandle = 0;
+        m_bCreated = false;
+    }
+
+    bool OpenGLBufferTexture::isCreated() const
+    {
+        return m_bCreated;
+    }
+
+    GLuint OpenGLBufferTexture::bufferId() const
+    {
+        return m_iBufferHandle;
+    }
+
+    GLuint OpenGLBufferTexture::textureId() const
+    {
+        return m_iTextureHandle;
+    }
+
+    void OpenGLBufferTexture::bind()
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glBindBuffer(GL_TEXTURE_BUFFER, m_iBufferHandle));
+    }
+
+    void OpenGLBufferTexture::release()
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glBindBuffer(GL_TEXTURE_BUFFER, 0));
+    }
+
+    QOpenGLBuffer::UsagePattern OpenGLBufferTexture::usagePattern() const
+    {
+        return m_iUsagePattern;
+    }
+
+    void OpenGLBufferTexture::setUsagePattern(QOpenGLBuffer::UsagePattern pattern)
+    {
+        m_iUsagePattern = pattern;
+    }
+
+    void OpenGLBufferTexture::allocate(const void *data, int count)
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glBufferData(GL_TEXTURE_BUFFER, count, data, m_iUsagePattern));
+    }
+
+    void OpenGLBufferTexture::allocate(int count)
+    {
+        allocate(Q_NULLPTR, count);
+    }
+
+    void OpenGLBufferTexture::write(int offset, const void *data, int count)
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glBufferSubData(GL_TEXTURE_BUFFER, offset, count, data));
+    }
+
+    int OpenGLBufferTexture::size() const
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        GLint value = -1;
+        GLTRY(f->glGetBufferParameteriv(GL_TEXTURE_BUFFER, GL_BUFFER_SIZE, &value));
+        return value;
+    }
+
+    void* OpenGLBufferTexture::map(QOpenGLBuffer::Access access)
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        void* ret = Q_NULLPTR;
+        GLTRY(ret = f->glMapBuffer(GL_TEXTURE_BUFFER, access));
+        return ret;
+    }
+
+    void OpenGLBufferTexture::unmap()
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glUnmapBuffer(GL_TEXTURE_BUFFER));
+    }
+
+    void OpenGLBufferTexture::bindTexture(int textureUnit)
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glActiveTexture(GL_TEXTURE0 + textureUnit));
+        GLTRY(f->glBindTexture(GL_TEXTURE_BUFFER, m_iTextureHandle));
+    }
+
+    void OpenGLBufferTexture::releaseTexture(int textureUnit)
+    {
+        Q_ASSERT_X(m_bCreated, Q_FUNC_INFO, "Buffer must be created first!");
+
+        GL_CURRENT_F;
+
+        GLTRY(f->glActiveTexture(GL_TEXTURE0 + textureUnit));
+        GLTRY(f->glBindTexture(GL_TEXTURE_BUFFER, 0));
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef OPENGLBUFFERTEXTURE_H
+#define OPENGLBUFFERTEXTURE_H
+
+#include "renderer_global.h"
+#include <QOpenGLBuffer>
+
+namespace Renderer
+{
+    // A buffer object exposed to shaders as a samplerBuffer.
+    // Each texel is an RGBA32F value, so a matrix takes up four texels.
+    class OpenGLBufferTexture
+    {
+    public:
+        OpenGLBufferTexture();
+        OpenGLBufferTexture(QOpenGLBuffer::UsagePattern pattern);
+        ~OpenGLBufferTexture();
+
+        GLuint bufferId() const;
+        GLuint textureId() const;
+
+        bool create();
+        void destroy();
+        bool isCreated() const;
+        int size() const;
+
+        // The buffer is bound to GL_TEXTURE_BUFFER.
+        void bind();
+        void release();
+
+        void allocate(const void* data, int count);
+        void allocate(int count);
+        void write(int offset, const void *data, int count);
+        void* map(QOpenGLBuffer::Access access);
+        void unmap();
+
+        // The texture is bound to the given unit.
+        void bindTexture(int textureUnit);
+        void releaseTexture(int textureUnit);
+
+        // This should not be called after allocate() or write().
+        QOpenGLBuffer::UsagePattern usagePattern() const;
+        void setUsagePattern(QOpenGLBuffer::UsagePattern pattern);
+
+    private:
+        Q_DISABLE_COPY(OpenGLBufferTexture)
+
+        GLuint  m_iBufferHandle;
+        GLuint  m_iTextureHandle;
+        bool    m_bCreated;
+        QOpenGLBuffer::UsagePattern m_iUsagePattern;
+    };
+}
+
+#endif // OPENGLBUFFERTEXTURE_H
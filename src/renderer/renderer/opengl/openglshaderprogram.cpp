@@ -78,6 +78,11 @@ namespace Renderer
         {
             enableAttributeArray(ShaderDefs::TextureCoordinateAttribute);
         }
+
+        if ( matrixStorage() == ShaderDefs::BufferTextureMatrixStorage )
+        {
+            enableAttributeArray(ShaderDefs::ObjectIdAttribute);
+        }
     }
 
     void OpenGLShaderProgram::disableAttributeArrays()
@@ -103,6 +108,11 @@ namespace Renderer
         {
             disableAttributeArray(ShaderDefs::TextureCoordinateAttribute);
         }
+
+        if ( matrixStorage() == ShaderDefs::BufferTextureMatrixStorage )
+        {
+            disableAttributeArray(ShaderDefs::ObjectIdAttribute);
+        }
     }
 
     quint16 OpenGLShaderProgram::shaderStoreId() const
@@ -140,6 +150,19 @@ namespace Renderer
         }
     }
 
+    void OpenGLShaderProgram::setMatrixBufferTextureBinding()
+    {
+        int location = uniformLocation(ShaderDefs::MATRIX_BUFFER_SAMPLER_NAME);
+        if ( location >= 0 )
+        {
+            GLTRY(setUniformValue(location, static_cast<GLint>(ShaderDefs::MatrixBufferTexture)));
+        }
+        else
+        {
+            Q_ASSERT_X(false, Q_FUNC_INFO, "Matrix buffer sampler not found in shader!");
+        }
+    }
+
     bool OpenGLShaderProgram::hasLocalUniformBlockBinding() const
     {
         return false;
@@ -20,6 +20,7 @@ namespace Renderer
         // Should be bound before calling, and released after!
         virtual void setGlobalUniformBlockBinding();
         void setLocalUniformBlockBinding();
+        void setMatrixBufferTextureBinding();
         virtual bool hasLocalUniformBlockBinding() const;
 
         void enableAttributeArrays();
@@ -29,6 +29,16 @@ namespace Renderer
 
     QSize OpenGLTexture::size() const
     {
+        if ( !isStorageAllocated() && m_ImageSize.isValid() )
+        {
+            return m_ImageSize;
+        }
+
         return QSize(width(), height());
     }
+
+    void OpenGLTexture::setImageSize(const QSize &size)
+    {
+        m_ImageSize = size;
+    }
 }
@@ -17,11 +17,17 @@ namespace Renderer
         QString path() const;
         void setPath(const QString &path);
 
+        // Before storage is allocated, this returns the size set by setImageSize().
         QSize size() const;
 
+        // Sets the size a texture will have once its image is loaded,
+        // so that geometry built against it beforehand gets the right co-ordinates.
+        void setImageSize(const QSize &size);
+
     private:
         quint32 m_iId;
         QString m_szPath;
+        QSize m_ImageSize;
     };
 }
 
@@ -1,6 +1,9 @@
 #include "rendermodel.h"
 #include <QtDebug>
+#include <QSet>
 #include "renderer/opengl/openglerrors.h"
+#include "renderer/opengl/openglhelpers.h"
+#include "renderer/opengl/openglshaderprogram.h"
 #include "renderer/rendermodel/rendererobjectflags.h"
 #include "renderer/opengl/scopedcurrentcontext.h"
 
@@ -20,6 +23,14 @@ namespace
     {
         return flagWasSet(after, before, flag);
     }
+
+    inline Renderer::RenderModelBatchGroupKey batchGroupKeyForSection(const Renderer::GeometrySection* section)
+    {
+        return Renderer::RenderModelBatchGroupKey(section->shaderId(),
+                                                  section->batchMaterialId(),
+                                                  section->drawMode(),
+                                                  section->drawWidth());
+    }
 }
 
 namespace Renderer
@@ -29,7 +40,9 @@ namespace Renderer
     RenderModel::RenderModel()
         : m_RenderFunctors(),
           m_DrawParams(),
-          m_GlobalShaderUniforms(QOpenGLBuffer::DynamicDraw)
+          m_GlobalShaderUniforms(QOpenGLBuffer::DynamicDraw),
+          m_iUploadedBytesLastFrame(0),
+          m_bInstancesRemoved(false)
     {
         ScopedCurrentContext scopedContext;
         Q_UNUSED(scopedContext);
@@ -45,6 +58,8 @@ namespace Renderer
         Q_UNUSED(scopedContext);
 
         clearRenderPasses();
+        m_StoredInstances.clear();
+        m_SharedMeshes.clear();
         m_GlobalShaderUniforms.destroy();
         m_VAO.destroy();
     }
@@ -73,6 +88,9 @@ namespace Renderer
 
     void RenderModel::clearRenderPasses()
     {
+        // Stored objects point into the passes.
+        m_StoredObjects.clear();
+        m_ObjectHandles.clear();
         m_RenderPasses.clear();
     }
 
@@ -113,11 +131,8 @@ namespace Renderer
 
     void RenderModel::updateObject(const RendererInputObjectParams &object)
     {
-        // This could be optimised by checking whether any keys matched
-        // the ones incoming in this update, and only clearing (not
-        // removing) entries for the ones that match.
-        // For now, we just remove any previous entries.
-        removeObject(object.objectId());
+        // An object can't have its own geometry and be an instance too.
+        removeInstance(object.objectId());
 
         // Don't bother going through all this if we don't actually have any geometry.
         bool allEmpty = true;
@@ -131,158 +146,305 @@ namespace Renderer
         }
 
         if ( allEmpty )
+        {
+            removeObject(object.objectId());
             return;
+        }
 
         RenderModelPassKey passKey(object.passIndex());
-        bool drawable = true;
-        if ( m_ObjectFlags.contains(object.objectId()) )
+        RenderModelPass* pass = getRenderPass(passKey).data();
+        if ( !pass )
         {
-            drawable = (m_ObjectFlags.value(object.objectId()) & HiddenObjectFlag) == HiddenObjectFlag;
+            pass = createRenderPass(passKey).data();
         }
 
-        RenderModelKeyListPointer list = RenderModelKeyListPointer::create();
+        StoredObject* stored = Q_NULLPTR;
+        QHash<quint32, SlotHandle>::const_iterator handleIt = m_ObjectHandles.constFind(object.objectId());
+        if ( handleIt != m_ObjectHandles.constEnd() )
+        {
+            stored = m_StoredObjects.get(handleIt.value());
+            Q_ASSERT_X(stored, Q_FUNC_INFO, "Stale handle for stored object!");
+        }
 
-        quint8 sectionId = 0;
-        foreach ( GeometrySection* section, object.geometrySectionList() )
+        // Objects that already exist keep their hidden state.
+        const bool drawable = !stored || !flagIsSet(m_ObjectFlags.value(object.objectId()), HiddenObjectFlag);
+
+        const QList<GeometrySection*>& sections = object.geometrySectionList();
+        QList<RenderModelBatchGroupKey> batchGroupKeys;
+        QList<MatrixBatchKey> matrixBatchKeys;
+        foreach ( GeometrySection* section, sections )
+        {
+            batchGroupKeys.append(batchGroupKeyForSection(section));
+            matrixBatchKeys.append(MatrixBatchKey(section->modelToWorldMatrix()));
+        }
+
+        // Stored sections whose keys match an incoming section keep their items,
+        // and only have their data replaced, so changing something like colours
+        // or texture co-ordinates doesn't tear down and re-create matrix batches.
+        // Stored sections that match nothing are removed before any new ones are
+        // created, and can't take any batch that a matched section is using with them.
+        QVarLengthArray<StoredSection, 4> matched(sections.count());
+        if ( stored )
         {
-            RenderModelKey key = RenderModelKey(
-                            passKey,
-                            RenderModelBatchGroupKey(
-                                section->shaderId(),
-                                section->materialId(),
-                                section->drawMode(),
-                                section->drawWidth()
-                            ),
-                            MatrixBatchKey(section->modelToWorldMatrix()),
-                            MatrixBatchItemKey(object.objectId(), sectionId)
-                        );
-
-            RenderModelPass::RenderModelBatchGroupPointer batchGroup;
-            MatrixBatch::MatrixBatchItemPointer batchItem = createOrFetchMatrixBatchItem(key, &batchGroup);
-            batchItem->clear();
-
-            section->consolidate(batchItem->m_Positions,
-                                batchItem->m_Normals,
-                                batchItem->m_Colors,
-                                batchItem->m_TextureCoordinates,
-                                batchItem->m_Indices);
-
-            list->append(key);
-            batchGroup->setMatrixBatchDrawable(key.matrixBatchKey(), drawable);
-
-            sectionId++;
+            for ( int i = 0; i < stored->sections.count(); i++ )
+            {
+                const StoredSection &storedSection = stored->sections.at(i);
+                int match = -1;
+
+                if ( storedSection.pass == pass )
+                {
+                    const MatrixBatchKey storedMatrixBatchKey(storedSection.matrixBatch->matrix());
+                    for ( int j = 0; j < sections.count(); j++ )
+                    {
+                        if ( !matched[j].matrixBatch &&
+                             storedSection.batchGroup->key() == batchGroupKeys.at(j) &&
+                             storedMatrixBatchKey == matrixBatchKeys.at(j) )
+                        {
+                            match = j;
+                            break;
+                        }
+                    }
+                }
+
+                if ( match >= 0 )
+                {
+                    matched[match] = storedSection;
+                }
+                else
+                {
+                    removeStoredSection(storedSection);
+                }
+            }
         }
 
-        m_StoredObjects.insert(object.objectId(), list);
-        m_ObjectFlags.insert(object.objectId(), NoObjectFlag);
+        StoredObject updated;
+        for ( int i = 0; i < sections.count(); i++ )
+        {
+            StoredSection storedSection = matched[i];
+            MatrixBatchItem* batchItem = Q_NULLPTR;
+
+            if ( storedSection.matrixBatch )
+            {
+                batchItem = storedSection.matrixBatch->item(storedSection.item);
+                batchItem->clear();
+
+                // Item contents aren't tracked by the batch.
+                storedSection.matrixBatch->setDirty(true);
+            }
+            else
+            {
+                storedSection = createStoredSection(pass, batchGroupKeys.at(i), matrixBatchKeys.at(i));
+                batchItem = storedSection.matrixBatch->item(storedSection.item);
+            }
+
+            sections.at(i)->consolidate(batchItem->m_Positions,
+                                        batchItem->m_Normals,
+                                        batchItem->m_Colors,
+                                        batchItem->m_TextureCoordinates,
+                                        batchItem->m_Indices);
+
+            updated.sections.append(storedSection);
+            storedSection.batchGroup->setMatrixBatchDrawable(matrixBatchKeys.at(i), drawable);
+        }
+
+        if ( stored )
+        {
+            stored->sections = updated.sections;
+        }
+        else
+        {
+            m_ObjectHandles.insert(object.objectId(), m_StoredObjects.insert(updated));
+            m_ObjectFlags.insert(object.objectId(), NoObjectFlag);
+        }
     }
 
     void RenderModel::removeObject(quint32 objectId)
     {
-        if ( m_StoredObjects.contains(objectId) )
+        QHash<quint32, SlotHandle>::iterator it = m_ObjectHandles.find(objectId);
+        if ( it != m_ObjectHandles.end() )
         {
-            RenderModelKeyListPointer keysForObject = m_StoredObjects.take(objectId);
-            foreach ( const RenderModelKey &key, *keysForObject.data() )
+            const StoredObject* stored = m_StoredObjects.get(it.value());
+            Q_ASSERT_X(stored, Q_FUNC_INFO, "Stale handle for stored object!");
+
+            for ( int i = 0; stored && i < stored->sections.count(); i++ )
             {
-                cleanMatrixBatchItem(key);
+                removeStoredSection(stored->sections.at(i));
             }
+
+            m_StoredObjects.remove(it.value());
+            m_ObjectHandles.erase(it);
         }
 
+        removeInstance(objectId);
+
         // We've already taken from stored objects.
         // Remove flags record as well.
         m_ObjectFlags.remove(objectId);
     }
 
-    bool RenderModel::getModelItems(const RenderModelKey &key,
-                                    RenderModelPassPointer &pass,
-                                    RenderModelPass::RenderModelBatchGroupPointer &batchGroup,
-                                    RenderModelBatchGroup::MatrixBatchPointer &matrixBatch,
-                                    MatrixBatch::MatrixBatchItemPointer &batchItem) const
+    void RenderModel::registerSharedMesh(const QString &key, const GeometryBuilder &builder)
     {
-        pass = getRenderPass(key.passKey());
-        if ( pass.isNull() )
-        {
-            return false;
-        }
+        if ( m_SharedMeshes.contains(key) )
+            return;
 
-        batchGroup = pass->getBatchGroup(key.batchGroupKey());
-        if ( batchGroup.isNull() )
+        SharedMesh mesh;
+        foreach ( GeometrySection* section, builder.sections() )
         {
-            return false;
-        }
+            if ( section->isEmpty() )
+                continue;
 
-        matrixBatch = batchGroup->getMatrixBatch(key.matrixBatchKey());
-        if ( matrixBatch.isNull() )
-        {
-            return false;
+            OpenGLShaderProgram* shaderProgram = (*m_RenderFunctors.shaderFunctor)(section->shaderId());
+            if ( !shaderProgram || shaderProgram->matrixStorage() != ShaderDefs::BufferTextureMatrixStorage )
+            {
+                Q_ASSERT_X(false, Q_FUNC_INFO, "Shared mesh section's shader cannot draw instances!");
+                continue;
+            }
+
+            mesh.append(SharedMeshSectionEntry(
+                            batchGroupKeyForSection(section),
+                            RenderModelBatchGroup::SharedMeshSectionPointer::create(*section)
+                        ));
         }
 
-        batchItem = matrixBatch->getItem(key.matrixBatchItemKey());
-        return !batchItem.isNull();
+        m_SharedMeshes.insert(key, mesh);
+    }
+
+    bool RenderModel::containsSharedMesh(const QString &key) const
+    {
+        return m_SharedMeshes.contains(key);
     }
 
-    MatrixBatch::MatrixBatchItemPointer RenderModel::createOrFetchMatrixBatchItem(const RenderModelKey &key,
-                                                     RenderModelPass::RenderModelBatchGroupPointer* batchGroupOut)
+    void RenderModel::updateInstance(const RendererInputInstanceParams &instance)
     {
-        // 1: Get the pass.
-        RenderModelPassPointer pass = getRenderPass(key.passKey());
+        removeObject(instance.objectId());
+
+        Q_ASSERT_X(m_SharedMeshes.contains(instance.sharedMeshKey()), Q_FUNC_INFO, "Shared mesh has not been registered!");
+        if ( !m_SharedMeshes.contains(instance.sharedMeshKey()) )
+            return;
+
+        RenderModelPassKey passKey(instance.passIndex());
+        RenderModelPassPointer pass = getRenderPass(passKey);
         if ( pass.isNull() )
         {
-            pass = createRenderPass(key.passKey());
+            pass = createRenderPass(passKey);
         }
 
-        // 2: Get the batch group.
-        // At some point we'll probably want to deal with usage patterns too.
-        RenderModelPass::RenderModelBatchGroupPointer batchGroup = pass->getBatchGroup(key.batchGroupKey());
-        if ( batchGroup.isNull() )
+        foreach ( const SharedMeshSectionEntry &entry, m_SharedMeshes.value(instance.sharedMeshKey()) )
         {
-            batchGroup = pass->createBatchGroup(key.batchGroupKey());
+            RenderModelPass::RenderModelBatchGroupPointer batchGroup = pass->getBatchGroup(entry.batchGroupKey);
+            if ( batchGroup.isNull() )
+            {
+                batchGroup = pass->createBatchGroup(entry.batchGroupKey);
+            }
+
+            RenderModelBatchGroup::InstanceBatchPointer instanceBatch = batchGroup->createInstanceBatch(entry.mesh);
+            instanceBatch->setInstance(instance.objectId(),
+                                       instance.modelToWorldMatrix() * entry.mesh->meshMatrix(),
+                                       instance.color());
         }
-        if ( batchGroup )
+
+        m_StoredInstances.insert(instance.objectId(), StoredInstance(instance.passIndex(), instance.sharedMeshKey()));
+        m_ObjectFlags.insert(instance.objectId(), NoObjectFlag);
+    }
+
+    void RenderModel::removeInstance(quint32 objectId)
+    {
+        if ( !m_StoredInstances.contains(objectId) )
+            return;
+
+        StoredInstance stored = m_StoredInstances.take(objectId);
+        m_bInstancesRemoved = true;
+
+        RenderModelPassPointer pass = getRenderPass(RenderModelPassKey(stored.passIndex));
+        if ( pass.isNull() )
+            return;
+
+        foreach ( const SharedMeshSectionEntry &entry, m_SharedMeshes.value(stored.sharedMeshKey) )
         {
-            *batchGroupOut = batchGroup;
+            RenderModelPass::RenderModelBatchGroupPointer batchGroup = pass->getBatchGroup(entry.batchGroupKey);
+            if ( batchGroup.isNull() )
+                continue;
+
+            RenderModelBatchGroup::InstanceBatchPointer instanceBatch = batchGroup->getInstanceBatch(entry.mesh);
+            if ( instanceBatch.isNull() )
+                continue;
+
+            instanceBatch->removeInstance(objectId);
+
+            if ( instanceBatch->instanceCount() < 1 )
+            {
+                batchGroup->removeInstanceBatch(entry.mesh);
+            }
+
+            if ( batchGroup->isEmpty() )
+            {
+                pass->removeBatchGroup(entry.batchGroupKey);
+            }
         }
+    }
 
-        // 3: Get the batch.
-        RenderModelBatchGroup::MatrixBatchPointer matrixBatch = batchGroup->getMatrixBatch(key.matrixBatchKey());
-        if ( matrixBatch.isNull() )
+    void RenderModel::releaseUnusedSharedMeshes()
+    {
+        if ( !m_bInstancesRemoved )
+            return;
+
+        QSet<QString> usedKeys;
+        foreach ( const StoredInstance &stored, m_StoredInstances )
         {
-            matrixBatch = batchGroup->createMatrixBatch(key.matrixBatchKey());
+            usedKeys.insert(stored.sharedMeshKey);
         }
 
-        // 4: Get the batch item.
-        MatrixBatch::MatrixBatchItemPointer batchItem = matrixBatch->getItem(key.matrixBatchItemKey());
-        if ( batchItem.isNull() )
+        foreach ( const QString &key, m_SharedMeshes.keys() )
         {
-            batchItem = matrixBatch->createItem(key.matrixBatchItemKey());
+            if ( !usedKeys.contains(key) )
+            {
+                m_SharedMeshes.remove(key);
+            }
         }
 
-        return batchItem;
+        m_bInstancesRemoved = false;
     }
 
-    void RenderModel::cleanMatrixBatchItem(const RenderModelKey &key)
+    RenderModel::StoredSection RenderModel::createStoredSection(RenderModelPass *pass,
+                                                                const RenderModelBatchGroupKey &batchGroupKey,
+                                                                const MatrixBatchKey &matrixBatchKey)
     {
-        RenderModelPassPointer pass;
-        RenderModelPass::RenderModelBatchGroupPointer batchGroup;
-        RenderModelBatchGroup::MatrixBatchPointer matrixBatch;
-        MatrixBatch::MatrixBatchItemPointer batchItem;
+        // At some point we'll probably want to deal with usage patterns too.
+        StoredSection storedSection;
+        storedSection.pass = pass;
 
-        if ( !getModelItems(key, pass, batchGroup, matrixBatch, batchItem) )
+        storedSection.batchGroup = pass->batchGroup(batchGroupKey);
+        if ( !storedSection.batchGroup )
         {
-            return;
+            storedSection.batchGroup = pass->createBatchGroup(batchGroupKey).data();
         }
 
-        batchItem.clear();
-        matrixBatch->removeItem(key.matrixBatchItemKey());
+        storedSection.matrixBatch = storedSection.batchGroup->matrixBatch(matrixBatchKey);
+        if ( !storedSection.matrixBatch )
+        {
+            storedSection.matrixBatch = storedSection.batchGroup->createMatrixBatch(matrixBatchKey).data();
+        }
+
+        // Creating the item marks the matrix batch as dirty.
+        storedSection.item = storedSection.matrixBatch->createItem();
+        return storedSection;
+    }
 
-        if ( matrixBatch->itemCount() < 1 )
+    void RenderModel::removeStoredSection(const StoredSection &storedSection)
+    {
+        storedSection.matrixBatch->removeItem(storedSection.item);
+
+        // Removing either of these destroys it, so take copies of their keys first.
+        if ( storedSection.matrixBatch->itemCount() < 1 )
         {
-            batchGroup->removeMatrixBatch(key.matrixBatchKey());
+            const MatrixBatchKey matrixBatchKey(storedSection.matrixBatch->matrix());
+            storedSection.batchGroup->removeMatrixBatch(matrixBatchKey);
         }
 
-        if ( batchGroup->matrixBatchCount() < 1 )
+        if ( storedSection.batchGroup->isEmpty() )
         {
-            pass->removeBatchGroup(key.batchGroupKey());
+            const RenderModelBatchGroupKey batchGroupKey = storedSection.batchGroup->key();
+            storedSection.pass->removeBatchGroup(batchGroupKey);
         }
     }
 
@@ -294,18 +456,36 @@ namespace Renderer
             updateGlobalShaderUniforms();
         }
 
+        releaseUnusedSharedMeshes();
+
         m_VAO.bind();
 
+        // Only instanced draws enable the instance colour array, so other
+        // draws should leave vertex colours as they are.
+        GL_CURRENT_F;
+        GLTRY(f->glVertexAttrib4f(ShaderDefs::InstanceColorAttribute, 1.0f, 1.0f, 1.0f, 1.0f));
+
         uploadGlobalShaderUniforms();
 
+        m_iUploadedBytesLastFrame = 0;
         foreach ( const RenderModelPassPointer &pass, m_RenderPasses.values() )
         {
-            pass->drawAllBatchGroups();
+            m_iUploadedBytesLastFrame += pass->drawAllBatchGroups();
+        }
+
+        if ( m_iUploadedBytesLastFrame > 0 )
+        {
+            qCDebug(lcRenderModelVerbose) << "Uploaded" << m_iUploadedBytesLastFrame << "bytes of geometry";
         }
 
         m_VAO.release();
     }
 
+    int RenderModel::uploadedBytesLastFrame() const
+    {
+        return m_iUploadedBytesLastFrame;
+    }
+
     void RenderModel::uploadGlobalShaderUniforms()
     {
         m_GlobalShaderUniforms.upload();
@@ -353,22 +533,64 @@ namespace Renderer
         return m_ObjectFlags.value(objectId, NoObjectFlag);
     }
 
+    QVector<RenderModel::StoredSection> RenderModel::storedSections(quint32 objectId) const
+    {
+        QVector<StoredSection> sections;
+
+        QHash<quint32, SlotHandle>::const_iterator handleIt = m_ObjectHandles.constFind(objectId);
+        if ( handleIt == m_ObjectHandles.constEnd() )
+            return sections;
+
+        const StoredObject* stored = m_StoredObjects.get(handleIt.value());
+        if ( !stored )
+            return sections;
+
+        for ( int i = 0; i < stored->sections.count(); i++ )
+        {
+            sections.append(stored->sections.at(i));
+        }
+
+        return sections;
+    }
+
     void RenderModel::setObjectHidden(quint32 objectId, bool hidden)
     {
-        Q_ASSERT_X(m_StoredObjects.contains(objectId), Q_FUNC_INFO, "Object does not exist!");
-        RenderModelKeyListPointer list = m_StoredObjects.value(objectId);
+        if ( m_StoredInstances.contains(objectId) )
+        {
+            setInstanceHidden(objectId, hidden);
+            return;
+        }
+
+        const StoredObject* stored = m_StoredObjects.get(m_ObjectHandles.value(objectId));
+        Q_ASSERT_X(stored, Q_FUNC_INFO, "Object does not exist!");
+        if ( !stored )
+            return;
 
-        foreach ( const RenderModelKey &key, *(list.data()) )
+        for ( int i = 0; i < stored->sections.count(); i++ )
         {
-            RenderModelPassPointer pass = getRenderPass(key.passKey());
-            if ( pass.isNull() )
-                continue;
+            const StoredSection &storedSection = stored->sections.at(i);
+            storedSection.batchGroup->setMatrixBatchDrawable(MatrixBatchKey(storedSection.matrixBatch->matrix()), !hidden);
+        }
+    }
 
-            RenderModelPass::RenderModelBatchGroupPointer batchGroup = pass->getBatchGroup(key.batchGroupKey());
+    void RenderModel::setInstanceHidden(quint32 objectId, bool hidden)
+    {
+        const StoredInstance stored = m_StoredInstances.value(objectId);
+        RenderModelPassPointer pass = getRenderPass(RenderModelPassKey(stored.passIndex));
+        if ( pass.isNull() )
+            return;
+
+        foreach ( const SharedMeshSectionEntry &entry, m_SharedMeshes.value(stored.sharedMeshKey) )
+        {
+            RenderModelPass::RenderModelBatchGroupPointer batchGroup = pass->getBatchGroup(entry.batchGroupKey);
             if ( batchGroup.isNull() )
                 continue;
 
-            batchGroup->setMatrixBatchDrawable(key.matrixBatchKey(), !hidden);
+            RenderModelBatchGroup::InstanceBatchPointer instanceBatch = batchGroup->getInstanceBatch(entry.mesh);
+            if ( instanceBatch.isNull() )
+                continue;
+
+            instanceBatch->setInstanceDrawable(objectId, !hidden);
         }
     }
 }
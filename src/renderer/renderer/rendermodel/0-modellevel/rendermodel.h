@@ -6,13 +6,17 @@
 #include <QHash>
 #include <QList>
 #include <QMap>
+#include <QVarLengthArray>
+#include <QVector>
 #include <QLoggingCategory>
 
 #include "renderer/rendermodel/1-passlevel/rendermodelpass.h"
 #include "renderer/rendermodel/1-passlevel/rendermodelpasskey.h"
+#include "renderer/rendermodel/slotmap.h"
 #include "renderer/shaders/globalshaderuniforms.h"
 #include "renderer/opengl/openglvertexarrayobject.h"
 #include "renderer/rendermodel/rendererinputobjectparams.h"
+#include "renderer/rendermodel/rendererinputinstanceparams.h"
 #include "renderer/rendermodel/rendererdrawparams.h"
 #include "renderer/functors/renderfunctorgroup.h"
 
@@ -23,6 +27,23 @@ namespace Renderer
     class RENDERERSHARED_EXPORT RenderModel
     {
     public:
+        // Where one geometry section of an object is stored, so that it can be
+        // removed without looking anything up. The pass, batch group and matrix
+        // batch are owned by the levels above them, and can't be destroyed
+        // while they still hold the section's item.
+        struct StoredSection
+        {
+            StoredSection()
+                : pass(Q_NULLPTR), batchGroup(Q_NULLPTR), matrixBatch(Q_NULLPTR)
+            {
+            }
+
+            RenderModelPass* pass;
+            RenderModelBatchGroup* batchGroup;
+            MatrixBatch* matrixBatch;
+            SlotHandle item;
+        };
+
         RenderModel();
         ~RenderModel();
 
@@ -37,15 +58,61 @@ namespace Renderer
         void updateObject(const RendererInputObjectParams &object);
         void removeObject(quint32 objectId);
 
+        // Shared meshes are held once, and each object that uses one is drawn as an instance
+        // of it with glDrawElementsInstanced, instead of having its own copy of the geometry.
+        // Only sections whose shaders use BufferTextureMatrixStorage can be shared.
+        // Registering a key that is already registered does nothing. A shared mesh is
+        // released if it has no instances left when the model is next drawn.
+        void registerSharedMesh(const QString &key, const GeometryBuilder &builder);
+        bool containsSharedMesh(const QString &key) const;
+        void updateInstance(const RendererInputInstanceParams &instance);
+
         void draw(const RendererDrawParams &params);
 
+        // Bytes written to OpenGL buffers during the last call to draw().
+        int uploadedBytesLastFrame() const;
+
         void setObjectFlags(quint32 objectId, quint32 flags);
         void clearObjectFlags(quint32 objectId, quint32 flags);
         quint32 getObjectFlags(quint32 objectId) const;
 
+        // Where each of an object's sections is currently stored, for tests and debugging.
+        // The pointers are only valid until the object is next updated or removed.
+        QVector<StoredSection> storedSections(quint32 objectId) const;
+
     private:
         typedef QSharedPointer<RenderModelPass> RenderModelPassPointer;
-        typedef QSharedPointer<QList<RenderModelKey> > RenderModelKeyListPointer;
+
+        struct StoredObject
+        {
+            // Most objects only have a few sections.
+            QVarLengthArray<StoredSection, 4> sections;
+        };
+
+        struct SharedMeshSectionEntry
+        {
+            SharedMeshSectionEntry(const RenderModelBatchGroupKey &key,
+                                   const RenderModelBatchGroup::SharedMeshSectionPointer &sectionMesh)
+                : batchGroupKey(key), mesh(sectionMesh)
+            {
+            }
+
+            RenderModelBatchGroupKey batchGroupKey;
+            RenderModelBatchGroup::SharedMeshSectionPointer mesh;
+        };
+
+        typedef QList<SharedMeshSectionEntry> SharedMesh;
+
+        struct StoredInstance
+        {
+            StoredInstance(int pass = 0, const QString &meshKey = QString())
+                : passIndex(pass), sharedMeshKey(meshKey)
+            {
+            }
+
+            int passIndex;
+            QString sharedMeshKey;
+        };
 
         RenderModelPassPointer createRenderPass(const RenderModelPassKey &key);
         RenderModelPassPointer getRenderPass(const RenderModelPassKey &key) const;
@@ -55,15 +122,14 @@ namespace Renderer
         void uploadGlobalShaderUniforms();
         void updateGlobalShaderUniforms();
         void setObjectHidden(quint32 objectId, bool hidden);
+        void setInstanceHidden(quint32 objectId, bool hidden);
+        void removeInstance(quint32 objectId);
+        void releaseUnusedSharedMeshes();
 
-        MatrixBatch::MatrixBatchItemPointer createOrFetchMatrixBatchItem(const RenderModelKey &key,
-                                                RenderModelPass::RenderModelBatchGroupPointer* batchGroup = Q_NULLPTR);
-        void cleanMatrixBatchItem(const RenderModelKey &key);
-        bool getModelItems(const RenderModelKey &key,
-                           RenderModelPassPointer &pass,
-                           RenderModelPass::RenderModelBatchGroupPointer &batchGroup,
-                           RenderModelBatchGroup::MatrixBatchPointer &matrixBatch,
-                           MatrixBatch::MatrixBatchItemPointer &batchItem) const;
+        StoredSection createStoredSection(RenderModelPass* pass,
+                                          const RenderModelBatchGroupKey &batchGroupKey,
+                                          const MatrixBatchKey &matrixBatchKey);
+        void removeStoredSection(const StoredSection &storedSection);
 
         RenderFunctorGroup m_RenderFunctors;
         RendererDrawParams m_DrawParams;
@@ -72,8 +138,13 @@ namespace Renderer
         OpenGLVertexArrayObject m_VAO;
 
         QMap<RenderModelPassKey, RenderModelPassPointer>   m_RenderPasses;
-        QHash<quint32, RenderModelKeyListPointer> m_StoredObjects;
+        SlotMap<StoredObject> m_StoredObjects;
+        QHash<quint32, SlotHandle> m_ObjectHandles;
         QHash<quint32, quint32> m_ObjectFlags;
+        QHash<QString, SharedMesh> m_SharedMeshes;
+        QHash<quint32, StoredInstance> m_StoredInstances;
+        bool m_bInstancesRemoved;
+        int m_iUploadedBytesLastFrame;
     };
 }
 
@@ -22,7 +22,16 @@ namespace
         {
             newShader->bind();
             newShader->setGlobalUniformBlockBinding();
-            newShader->setLocalUniformBlockBinding();
+
+            if ( newShader->matrixStorage() == Renderer::ShaderDefs::BufferTextureMatrixStorage )
+            {
+                newShader->setMatrixBufferTextureBinding();
+            }
+            else
+            {
+                newShader->setLocalUniformBlockBinding();
+            }
+
             newShader->enableAttributeArrays();
         }
 
@@ -57,6 +66,12 @@ namespace Renderer
         return m_BatchGroups.value(key, RenderModelBatchGroupPointer());
     }
 
+    RenderModelBatchGroup* RenderModelPass::batchGroup(const RenderModelBatchGroupKey &key) const
+    {
+        QMap<RenderModelBatchGroupKey, RenderModelBatchGroupPointer>::const_iterator it = m_BatchGroups.constFind(key);
+        return it != m_BatchGroups.constEnd() ? it.value().data() : Q_NULLPTR;
+    }
+
     void RenderModelPass::removeBatchGroup(const RenderModelBatchGroupKey &key)
     {
         m_BatchGroups.remove(key);
@@ -86,19 +101,22 @@ namespace Renderer
         changeMaterialIfDifferent(material, newMaterial);
     }
 
-    void RenderModelPass::drawAllBatchGroups()
+    int RenderModelPass::drawAllBatchGroups()
     {
         OpenGLShaderProgram* currentShaderProgram = Q_NULLPTR;
         RenderMaterialPointer currentMaterial;
+        int uploadedBytes = 0;
 
         foreach ( const RenderModelBatchGroupPointer &batchGroup, m_BatchGroups.values() )
         {
             setIfRequired(batchGroup->key(), currentShaderProgram, currentMaterial);
-            batchGroup->drawAllBatches(currentShaderProgram);
+            uploadedBytes += batchGroup->drawAllBatches(currentShaderProgram);
         }
 
         changeShaderIfDifferent(currentShaderProgram, Q_NULLPTR);
         changeMaterialIfDifferent(currentMaterial, RenderMaterialPointer());
+
+        return uploadedBytes;
     }
 
     void RenderModelPass::changeMaterialIfDifferent(Renderer::RenderMaterialPointer &origMaterial,
@@ -127,7 +145,7 @@ namespace Renderer
 
         foreach ( quint32 texture, m_TextureUnitMap.values() )
         {
-            OpenGLTexturePointer tex = (*m_RenderFunctors.textureFunctor)(texture);
+            OpenGLTexturePointer tex = textureForBinding(texture);
             if ( tex.isNull() )
                 continue;
 
@@ -139,11 +157,24 @@ namespace Renderer
 
         for ( TextureUnitMap::const_iterator it = m_TextureUnitMap.constBegin(); it != m_TextureUnitMap.constEnd(); ++it )
         {
-             OpenGLTexturePointer tex = (*m_RenderFunctors.textureFunctor)(it.value());
+            OpenGLTexturePointer tex = textureForBinding(it.value());
             if ( tex.isNull() )
                 continue;
 
             tex->bind(it.key());
         }
     }
+
+    OpenGLTexturePointer RenderModelPass::textureForBinding(quint32 textureId) const
+    {
+        OpenGLTexturePointer tex = (*m_RenderFunctors.textureFunctor)(textureId);
+
+        // Textures that are still loading have no GL object yet, so draw with the default texture.
+        if ( !tex.isNull() && !tex->isCreated() && textureId != 0 )
+        {
+            tex = (*m_RenderFunctors.textureFunctor)(0);
+        }
+
+        return tex;
+    }
 }
@@ -22,17 +22,22 @@ namespace Renderer
         RenderModelBatchGroupPointer createBatchGroup(const RenderModelBatchGroupKey &key,
                                                       QOpenGLBuffer::UsagePattern usagePattern = QOpenGLBuffer::DynamicDraw);
         RenderModelBatchGroupPointer getBatchGroup(const RenderModelBatchGroupKey &key) const;
+
+        // As getBatchGroup(), without copying the shared pointer.
+        RenderModelBatchGroup* batchGroup(const RenderModelBatchGroupKey &key) const;
         void removeBatchGroup(const RenderModelBatchGroupKey &key);
         bool containsBatchGroup(const RenderModelBatchGroupKey &key) const;
         void clearBatchGroups();
 
         void printDebugInfo() const;
 
-        void drawAllBatchGroups();
+        // Returns the number of bytes uploaded before drawing.
+        int drawAllBatchGroups();
 
     private:
         void setIfRequired(const RenderModelBatchGroupKey &key, OpenGLShaderProgram* &shaderProgram, RenderMaterialPointer &material);
         void setTextureUnitMap(const QMap<ShaderDefs::TextureUnit, quint32>& map);
+        OpenGLTexturePointer textureForBinding(quint32 textureId) const;
         void changeMaterialIfDifferent(Renderer::RenderMaterialPointer &origMaterial,
                                       const Renderer::RenderMaterialPointer &newMaterial);
 
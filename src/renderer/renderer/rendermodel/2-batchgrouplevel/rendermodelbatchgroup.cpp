@@ -70,12 +70,19 @@ namespace Renderer
         return m_MatrixBatches.value(key, MatrixBatchPointer());
     }
 
+    MatrixBatch* RenderModelBatchGroup::matrixBatch(const MatrixBatchKey &key) const
+    {
+        QHash<MatrixBatchKey, MatrixBatchPointer>::const_iterator it = m_MatrixBatches.constFind(key);
+        return it != m_MatrixBatches.constEnd() ? it.value().data() : Q_NULLPTR;
+    }
+
     void RenderModelBatchGroup::clear()
     {
         m_WaitingBatches.clear();
         m_FullBatches.clear();
         m_MatrixOpenGLMap.clear();
         m_MatrixBatches.clear();
+        m_InstanceBatches.clear();
     }
 
     QOpenGLBuffer::UsagePattern RenderModelBatchGroup::usagePattern() const
@@ -113,7 +120,8 @@ namespace Renderer
         qDebug() << "Matrix batches:" << m_MatrixBatches.count()
                  << "Full OpenGL batches:" << m_FullBatches.count()
                  << "Waiting OpenGL batches:" << m_WaitingBatches.count()
-                 << "Matrix batches in use:" << m_MatrixOpenGLMap.count();
+                 << "Matrix batches in use:" << m_MatrixOpenGLMap.count()
+                 << "Instance batches:" << m_InstanceBatches.count();
     }
 
     int RenderModelBatchGroup::matrixBatchCount() const
@@ -121,13 +129,22 @@ namespace Renderer
         return m_MatrixBatches.count();
     }
 
-    void RenderModelBatchGroup::drawAllBatches(QOpenGLShaderProgram *shaderProgram)
+    int RenderModelBatchGroup::drawAllBatches(QOpenGLShaderProgram *shaderProgram)
     {
-        ensureAllBatchesUploaded(m_FullBatches);
-        ensureAllBatchesUploaded(m_WaitingBatches);
+        int uploadedBytes = 0;
+        uploadedBytes += ensureAllBatchesUploaded(m_FullBatches);
+        uploadedBytes += ensureAllBatchesUploaded(m_WaitingBatches);
 
         draw(m_FullBatches, shaderProgram);
         draw(m_WaitingBatches, shaderProgram);
+
+        foreach ( const InstanceBatchPointer &instanceBatch, m_InstanceBatches.values() )
+        {
+            uploadedBytes += instanceBatch->uploadIfRequired();
+            instanceBatch->draw(shaderProgram, m_iDrawMode);
+        }
+
+        return uploadedBytes;
     }
 
     void RenderModelBatchGroup::draw(QSet<OpenGLBatchPointer> &batches, QOpenGLShaderProgram* shaderProgram)
@@ -144,14 +161,17 @@ namespace Renderer
         }
     }
 
-    void RenderModelBatchGroup::ensureAllBatchesUploaded(QSet<OpenGLBatchPointer> &batches)
+    int RenderModelBatchGroup::ensureAllBatchesUploaded(QSet<OpenGLBatchPointer> &batches)
     {
         typedef QSet<OpenGLBatchPointer> BatchSet;
 
+        int uploadedBytes = 0;
         for ( BatchSet::iterator it = batches.begin(); it != batches.end(); ++it )
         {
-            (*it)->uploadIfRequired();
+            uploadedBytes += (*it)->uploadIfRequired();
         }
+
+        return uploadedBytes;
     }
 
     const RenderModelBatchGroupKey& RenderModelBatchGroup::key() const
@@ -182,6 +202,41 @@ namespace Renderer
         }
     }
 
+    RenderModelBatchGroup::InstanceBatchPointer RenderModelBatchGroup::createInstanceBatch(const SharedMeshSectionPointer &mesh)
+    {
+        Q_ASSERT_X(m_pShaderSpec->matrixStorage() == ShaderDefs::BufferTextureMatrixStorage, Q_FUNC_INFO,
+                   "Instances can only be drawn by shaders that use buffer texture matrix storage!");
+
+        InstanceBatchPointer instanceBatch = m_InstanceBatches.value(mesh.data(), InstanceBatchPointer());
+        if ( instanceBatch.isNull() )
+        {
+            instanceBatch = InstanceBatchPointer::create(mesh, m_iUsagePattern);
+            m_InstanceBatches.insert(mesh.data(), instanceBatch);
+        }
+
+        return instanceBatch;
+    }
+
+    RenderModelBatchGroup::InstanceBatchPointer RenderModelBatchGroup::getInstanceBatch(const SharedMeshSectionPointer &mesh) const
+    {
+        return m_InstanceBatches.value(mesh.data(), InstanceBatchPointer());
+    }
+
+    void RenderModelBatchGroup::removeInstanceBatch(const SharedMeshSectionPointer &mesh)
+    {
+        m_InstanceBatches.remove(mesh.data());
+    }
+
+    int RenderModelBatchGroup::instanceBatchCount() const
+    {
+        return m_InstanceBatches.count();
+    }
+
+    bool RenderModelBatchGroup::isEmpty() const
+    {
+        return m_MatrixBatches.isEmpty() && m_InstanceBatches.isEmpty();
+    }
+
     void RenderModelBatchGroup::addMatrixBatchToOpenGLBatch(const MatrixBatchKey &key)
     {
         Q_ASSERT_X(!m_MatrixOpenGLMap.contains(key), Q_FUNC_INFO, "Matrix batch already has an OpenGL batch!");
@@ -7,6 +7,7 @@
 #include <QHash>
 #include "renderer/rendermodel/3-batchlevel/matrixbatchkey.h"
 #include "renderer/rendermodel/3-batchlevel/matrixbatch.h"
+#include "renderer/rendermodel/3-batchlevel/instancebatch.h"
 #include <QOpenGLBuffer>
 #include "renderer/shaders/vertexformat.h"
 #include <QPair>
@@ -20,6 +21,8 @@ namespace Renderer
     {
     public:
         typedef QSharedPointer<MatrixBatch> MatrixBatchPointer;
+        typedef QSharedPointer<InstanceBatch> InstanceBatchPointer;
+        typedef InstanceBatch::SharedMeshSectionPointer SharedMeshSectionPointer;
 
         RenderModelBatchGroup(const RenderModelBatchGroupKey &key, QOpenGLBuffer::UsagePattern usagePattern, const IShaderSpec* shaderSpec);
         ~RenderModelBatchGroup();
@@ -29,6 +32,9 @@ namespace Renderer
 
         MatrixBatchPointer createMatrixBatch(const MatrixBatchKey &key);
         MatrixBatchPointer getMatrixBatch(const MatrixBatchKey &key) const;
+
+        // As getMatrixBatch(), without copying the shared pointer.
+        MatrixBatch* matrixBatch(const MatrixBatchKey &key) const;
         void removeMatrixBatch(const MatrixBatchKey &key);
         bool containsMatrixBatch(const MatrixBatchKey &key) const;
         int matrixBatchCount() const;
@@ -36,9 +42,19 @@ namespace Renderer
         void setMatrixBatchDrawable(const MatrixBatchKey &key, bool drawable);
         bool matrixBatchDrawable(const MatrixBatchKey &key) const;
 
+        // Instances of a shared mesh section. The shader must use BufferTextureMatrixStorage.
+        InstanceBatchPointer createInstanceBatch(const SharedMeshSectionPointer &mesh);
+        InstanceBatchPointer getInstanceBatch(const SharedMeshSectionPointer &mesh) const;
+        void removeInstanceBatch(const SharedMeshSectionPointer &mesh);
+        int instanceBatchCount() const;
+
+        // True if there are no matrix batches or instance batches left.
+        bool isEmpty() const;
+
         void printDebugInfo() const;
 
-        void drawAllBatches(QOpenGLShaderProgram* shaderProgram);
+        // Returns the number of bytes uploaded before drawing.
+        int drawAllBatches(QOpenGLShaderProgram* shaderProgram);
 
     private:
         typedef QSharedPointer<OpenGLBatch> OpenGLBatchPointer;
@@ -47,7 +63,7 @@ namespace Renderer
         void setWaiting(const OpenGLBatchPointer &batch);
         OpenGLBatchPointer getNextWaitingGlBatch();
         void draw(QSet<OpenGLBatchPointer> &batches, QOpenGLShaderProgram* shaderProgram);
-        void ensureAllBatchesUploaded(QSet<OpenGLBatchPointer> &batches);
+        int ensureAllBatchesUploaded(QSet<OpenGLBatchPointer> &batches);
         void addMatrixBatchToOpenGLBatch(const MatrixBatchKey &key);
         void removeMatrixBatchFromOpenGLBatch(const MatrixBatchKey &key);
 
@@ -56,6 +72,7 @@ namespace Renderer
 
         QHash<MatrixBatchKey, MatrixBatchPointer> m_MatrixBatches;
         QHash<MatrixBatchKey, OpenGLBatchPointer> m_MatrixOpenGLMap;
+        QHash<SharedMeshSection*, InstanceBatchPointer> m_InstanceBatches;
 
         const RenderModelBatchGroupKey m_Key;   // For convenience
         const QOpenGLBuffer::UsagePattern m_iUsagePattern;
@@ -0,0 +1,103 @@
+#include "bufferarena.h"
+
+namespace Renderer
+{
+    BufferArena::BufferArena()
+        : m_iSize(0), m_iUsedSize(0)
+    {
+    }
+
+    int BufferArena::allocate(int size)
+    {
+        Q_ASSERT_X(size >= 0, Q_FUNC_INFO, "Cannot allocate a negative size!");
+        if ( size < 1 )
+            return 0;
+
+        m_iUsedSize += size;
+
+        // Take the first freed range that fits.
+        for ( QMap<int, int>::iterator it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it )
+        {
+            if ( it.value() < size )
+                continue;
+
+            const int offset = it.key();
+            const int remaining = it.value() - size;
+            m_FreeRanges.erase(it);
+
+            if ( remaining > 0 )
+            {
+                m_FreeRanges.insert(offset + size, remaining);
+            }
+
+            return offset;
+        }
+
+        const int offset = m_iSize;
+        m_iSize += size;
+        return offset;
+    }
+
+    void BufferArena::free(int offset, int size)
+    {
+        if ( size < 1 )
+            return;
+
+        Q_ASSERT_X(offset >= 0 && offset + size <= m_iSize, Q_FUNC_INFO, "Range is outside the arena!");
+        m_iUsedSize -= size;
+
+        // Merge with the neighbouring free ranges.
+        QMap<int, int>::iterator next = m_FreeRanges.lowerBound(offset);
+        Q_ASSERT_X(next == m_FreeRanges.end() || next.key() >= offset + size, Q_FUNC_INFO, "Range was already free!");
+
+        if ( next != m_FreeRanges.end() && next.key() == offset + size )
+        {
+            size += next.value();
+            next = m_FreeRanges.erase(next);
+        }
+
+        if ( next != m_FreeRanges.begin() )
+        {
+            QMap<int, int>::iterator previous = next - 1;
+            Q_ASSERT_X(previous.key() + previous.value() <= offset, Q_FUNC_INFO, "Range was already free!");
+
+            if ( previous.key() + previous.value() == offset )
+            {
+                offset = previous.key();
+                size += previous.value();
+                m_FreeRanges.erase(previous);
+            }
+        }
+
+        // Nothing needs to be kept past the last range in use.
+        if ( offset + size == m_iSize )
+        {
+            m_iSize = offset;
+            return;
+        }
+
+        m_FreeRanges.insert(offset, size);
+    }
+
+    void BufferArena::clear()
+    {
+        m_FreeRanges.clear();
+        m_iSize = 0;
+        m_iUsedSize = 0;
+    }
+
+    int BufferArena::size() const
+    {
+        return m_iSize;
+    }
+
+    int BufferArena::usedSize() const
+    {
+        return m_iUsedSize;
+    }
+
+    int BufferArena::freeRangeCount() const
+    {
+        return m_FreeRanges.count();
+    }
+}
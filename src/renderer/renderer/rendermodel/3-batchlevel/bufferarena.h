@@ -0,0 +1,35 @@
+#ifndef BUFFERARENA_H
+#define BUFFERARENA_H
+
+#include "renderer_global.h"
+#include <QMap>
+
+namespace Renderer
+{
+    // Hands out ranges within a buffer, measured in whatever units the caller likes.
+    // Freed ranges are reused by later allocations that fit within them, so ranges
+    // that stay allocated never have to move.
+    class RENDERERSHARED_EXPORT BufferArena
+    {
+    public:
+        BufferArena();
+
+        // Returns the offset of the new range. The arena grows if no freed range is big enough.
+        // Allocating zero units returns zero and reserves nothing.
+        int allocate(int size);
+        void free(int offset, int size);
+        void clear();
+
+        // One past the end of the last range in use.
+        int size() const;
+        int usedSize() const;
+        int freeRangeCount() const;
+
+    private:
+        QMap<int, int>  m_FreeRanges;   // Offset to size
+        int             m_iSize;
+        int             m_iUsedSize;
+    };
+}
+
+#endif // BUFFERARENA_H
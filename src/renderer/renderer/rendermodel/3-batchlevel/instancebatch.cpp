@@ -0,0 +1,217 @@
+#include "instancebatch.h"
+#include "renderer/opengl/openglhelpers.h"
+#include "renderer/opengl/openglerrors.h"
+#include "renderer/shaders/shaderdefs.h"
+#include <QByteArray>
+
+namespace Renderer
+{
+    InstanceBatch::InstanceBatch(const SharedMeshSectionPointer &mesh, QOpenGLBuffer::UsagePattern usagePattern)
+        : m_pMesh(mesh),
+          m_iUsagePattern(usagePattern),
+          m_bCreated(false),
+          m_InstanceBuffer(QOpenGLBuffer::VertexBuffer),
+          m_MatrixBufferTexture(usagePattern),
+          m_iInstanceCapacity(0),
+          m_iDrawableCount(0),
+          m_bNeedsUpload(true)
+    {
+        Q_ASSERT(!m_pMesh.isNull());
+        GLTRY(m_InstanceBuffer.setUsagePattern(m_iUsagePattern));
+    }
+
+    InstanceBatch::~InstanceBatch()
+    {
+        destroy();
+    }
+
+    void InstanceBatch::create()
+    {
+        if ( m_bCreated )
+            return;
+
+        m_bCreated = true;
+        GLTRY(m_bCreated = m_bCreated && m_InstanceBuffer.create());
+        GLTRY(m_bCreated = m_bCreated && m_MatrixBufferTexture.create());
+    }
+
+    void InstanceBatch::destroy()
+    {
+        if ( !m_bCreated )
+            return;
+
+        GLTRY(m_InstanceBuffer.destroy());
+        GLTRY(m_MatrixBufferTexture.destroy());
+
+        m_iInstanceCapacity = 0;
+        m_bNeedsUpload = true;
+        m_bCreated = false;
+    }
+
+    bool InstanceBatch::isCreated() const
+    {
+        return m_bCreated;
+    }
+
+    const InstanceBatch::SharedMeshSectionPointer& InstanceBatch::mesh() const
+    {
+        return m_pMesh;
+    }
+
+    int InstanceBatch::withSlack(int count)
+    {
+        return count + (count / 2);
+    }
+
+    void InstanceBatch::setInstance(quint32 objectId, const QMatrix4x4 &matrix, const QColor &color)
+    {
+        Instance& instance = m_Instances[objectId];
+        instance.matrix = matrix;
+        instance.color = color;
+        m_bNeedsUpload = true;
+    }
+
+    void InstanceBatch::removeInstance(quint32 objectId)
+    {
+        if ( m_Instances.remove(objectId) > 0 )
+        {
+            m_bNeedsUpload = true;
+        }
+    }
+
+    bool InstanceBatch::containsInstance(quint32 objectId) const
+    {
+        return m_Instances.contains(objectId);
+    }
+
+    int InstanceBatch::instanceCount() const
+    {
+        return m_Instances.count();
+    }
+
+    void InstanceBatch::setInstanceDrawable(quint32 objectId, bool drawable)
+    {
+        QHash<quint32, Instance>::iterator it = m_Instances.find(objectId);
+        if ( it == m_Instances.end() || it.value().drawable == drawable )
+            return;
+
+        it.value().drawable = drawable;
+        m_bNeedsUpload = true;
+    }
+
+    bool InstanceBatch::instanceDrawable(quint32 objectId) const
+    {
+        return m_Instances.value(objectId).drawable;
+    }
+
+    int InstanceBatch::uploadIfRequired()
+    {
+        int uploadedBytes = m_pMesh->uploadIfRequired();
+
+        if ( m_bNeedsUpload )
+        {
+            uploadedBytes += upload();
+            m_bNeedsUpload = false;
+        }
+
+        return uploadedBytes;
+    }
+
+    int InstanceBatch::upload()
+    {
+        create();
+
+        // Drawable instances are packed at the front, so each one's object ID is its index.
+        const int matrixBytes = 16 * sizeof(float);
+        const int colorBytes = 4 * sizeof(float);
+        QByteArray matrixData;
+        QByteArray colorData;
+        matrixData.reserve(m_Instances.count() * matrixBytes);
+        colorData.reserve(m_Instances.count() * colorBytes);
+
+        m_iDrawableCount = 0;
+        for ( QHash<quint32, Instance>::const_iterator it = m_Instances.constBegin(); it != m_Instances.constEnd(); ++it )
+        {
+            const Instance& instance = it.value();
+            if ( !instance.drawable )
+                continue;
+
+            const float color[4] = { static_cast<float>(instance.color.redF()),
+                                     static_cast<float>(instance.color.greenF()),
+                                     static_cast<float>(instance.color.blueF()),
+                                     static_cast<float>(instance.color.alphaF()) };
+
+            matrixData.append(reinterpret_cast<const char*>(instance.matrix.constData()), matrixBytes);
+            colorData.append(reinterpret_cast<const char*>(color), colorBytes);
+            m_iDrawableCount++;
+        }
+
+        if ( m_iDrawableCount < 1 )
+            return 0;
+
+        if ( m_iDrawableCount > m_iInstanceCapacity )
+        {
+            m_iInstanceCapacity = withSlack(m_iDrawableCount);
+
+            // The IDs never change, so they're only written when the buffer grows.
+            QVector<quint32> objectIds(m_iInstanceCapacity);
+            for ( int i = 0; i < objectIds.count(); i++ )
+            {
+                objectIds[i] = i;
+            }
+
+            const int idBytes = m_iInstanceCapacity * sizeof(quint32);
+            GLTRY(m_InstanceBuffer.bind());
+            GLTRY(m_InstanceBuffer.allocate(idBytes + (m_iInstanceCapacity * colorBytes)));
+            GLTRY(m_InstanceBuffer.write(0, objectIds.constData(), idBytes));
+            GLTRY(m_InstanceBuffer.release());
+
+            GLTRY(m_MatrixBufferTexture.bind());
+            GLTRY(m_MatrixBufferTexture.allocate(m_iInstanceCapacity * matrixBytes));
+            GLTRY(m_MatrixBufferTexture.release());
+        }
+
+        GLTRY(m_InstanceBuffer.bind());
+        GLTRY(m_InstanceBuffer.write(m_iInstanceCapacity * sizeof(quint32), colorData.constData(), colorData.size()));
+        GLTRY(m_InstanceBuffer.release());
+
+        GLTRY(m_MatrixBufferTexture.bind());
+        GLTRY(m_MatrixBufferTexture.write(0, matrixData.constData(), matrixData.size()));
+        GLTRY(m_MatrixBufferTexture.release());
+
+        return colorData.size() + matrixData.size();
+    }
+
+    void InstanceBatch::draw(QOpenGLShaderProgram *shaderProgram, GLenum drawMode)
+    {
+        if ( m_iDrawableCount < 1 || m_pMesh->indexCount() < 1 )
+            return;
+
+        GL_CURRENT_F;
+
+        m_pMesh->bind();
+        m_pMesh->setVertexAttributes(shaderProgram);
+
+        // Attribute pointers keep referring to the instance buffer once it's released.
+        const quintptr colorOffset = m_iInstanceCapacity * sizeof(quint32);
+        GLTRY(m_InstanceBuffer.bind());
+        GLTRY(f->glVertexAttribIPointer(ShaderDefs::ObjectIdAttribute, 1, GL_UNSIGNED_INT, 0, Q_NULLPTR));
+        GLTRY(f->glVertexAttribDivisor(ShaderDefs::ObjectIdAttribute, 1));
+        GLTRY(f->glEnableVertexAttribArray(ShaderDefs::InstanceColorAttribute));
+        GLTRY(f->glVertexAttribPointer(ShaderDefs::InstanceColorAttribute, 4, GL_FLOAT, GL_FALSE, 0,
+                                       reinterpret_cast<const void*>(colorOffset)));
+        GLTRY(f->glVertexAttribDivisor(ShaderDefs::InstanceColorAttribute, 1));
+        GLTRY(m_InstanceBuffer.release());
+
+        GLTRY(m_MatrixBufferTexture.bindTexture(ShaderDefs::MatrixBufferTexture));
+        GLTRY(f->glDrawElementsInstanced(drawMode, m_pMesh->indexCount(), GL_UNSIGNED_INT, Q_NULLPTR, m_iDrawableCount));
+        m_MatrixBufferTexture.releaseTexture(ShaderDefs::MatrixBufferTexture);
+
+        // Put the attributes back as batches expect them.
+        GLTRY(f->glVertexAttribDivisor(ShaderDefs::ObjectIdAttribute, 0));
+        GLTRY(f->glVertexAttribDivisor(ShaderDefs::InstanceColorAttribute, 0));
+        GLTRY(f->glDisableVertexAttribArray(ShaderDefs::InstanceColorAttribute));
+
+        m_pMesh->release();
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef INSTANCEBATCH_H
+#define INSTANCEBATCH_H
+
+#include "renderer_global.h"
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include <QSharedPointer>
+#include <QHash>
+#include <QMatrix4x4>
+#include <QColor>
+#include "renderer/opengl/openglbuffertexture.h"
+#include "sharedmeshsection.h"
+
+namespace Renderer
+{
+    // Every instance of one shared mesh section within a batch group, drawn with
+    // a single glDrawElementsInstanced call.
+    //
+    // Each instance's matrix is held in a buffer texture, as for batches which use
+    // BufferTextureMatrixStorage, so only shaders which use that storage can draw
+    // instances. The instance buffer holds a section of object IDs followed by a
+    // section of colours, and both are given a divisor of 1 when drawing.
+    class InstanceBatch
+    {
+    public:
+        typedef QSharedPointer<SharedMeshSection> SharedMeshSectionPointer;
+
+        InstanceBatch(const SharedMeshSectionPointer &mesh, QOpenGLBuffer::UsagePattern usagePattern);
+        ~InstanceBatch();
+
+        void create();
+        void destroy();
+        bool isCreated() const;
+
+        const SharedMeshSectionPointer& mesh() const;
+
+        void setInstance(quint32 objectId, const QMatrix4x4 &matrix, const QColor &color);
+        void removeInstance(quint32 objectId);
+        bool containsInstance(quint32 objectId) const;
+        int instanceCount() const;
+
+        // Hidden instances are kept, but not drawn.
+        void setInstanceDrawable(quint32 objectId, bool drawable);
+        bool instanceDrawable(quint32 objectId) const;
+
+        // Returns the number of bytes written to the buffers.
+        int uploadIfRequired();
+
+        // The shader program must already be bound.
+        void draw(QOpenGLShaderProgram* shaderProgram, GLenum drawMode);
+
+    private:
+        struct Instance
+        {
+            Instance()
+                : drawable(true)
+            {
+            }
+
+            QMatrix4x4 matrix;
+            QColor color;
+            bool drawable;
+        };
+
+        static int withSlack(int count);
+
+        int upload();
+
+        const SharedMeshSectionPointer m_pMesh;
+        const QOpenGLBuffer::UsagePattern m_iUsagePattern;
+        bool m_bCreated;
+
+        QHash<quint32, Instance> m_Instances;
+
+        QOpenGLBuffer       m_InstanceBuffer;
+        OpenGLBufferTexture m_MatrixBufferTexture;
+        int                 m_iInstanceCapacity;
+        int                 m_iDrawableCount;
+        bool                m_bNeedsUpload;
+    };
+}
+
+#endif // INSTANCEBATCH_H
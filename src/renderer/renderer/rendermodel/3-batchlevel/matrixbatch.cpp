@@ -30,21 +30,22 @@ namespace
         indexDelta += data.count();
     }
 
-    void copyItemDataIntoBuffer(const Renderer::MatrixBatch::MatrixBatchItemPointer &item, char* buffer, int size,
+    void copyItemDataIntoBuffer(const Renderer::MatrixBatchItem &item, char* buffer, int size,
                                 int& positionOffset, int& normalOffset,
                                 int& colorOffset, int& texCoordOffset)
     {
-        copyItemDataIntoBuffer(item->m_Positions, buffer, size, positionOffset);
-        copyItemDataIntoBuffer(item->m_Normals, buffer, size, normalOffset);
-        copyItemDataIntoBuffer(item->m_Colors, buffer, size, colorOffset);
-        copyItemDataIntoBuffer(item->m_TextureCoordinates, buffer, size, texCoordOffset);
+        copyItemDataIntoBuffer(item.m_Positions, buffer, size, positionOffset);
+        copyItemDataIntoBuffer(item.m_Normals, buffer, size, normalOffset);
+        copyItemDataIntoBuffer(item.m_Colors, buffer, size, colorOffset);
+        copyItemDataIntoBuffer(item.m_TextureCoordinates, buffer, size, texCoordOffset);
     }
 }
 
 namespace Renderer
 {
     MatrixBatch::MatrixBatch(const QMatrix4x4 &matrix)
-        : m_matModelToWorld(matrix)
+        : m_matModelToWorld(matrix),
+          m_bDirty(true)
     {
 
     }
@@ -57,39 +58,40 @@ namespace Renderer
     void MatrixBatch::clearItems()
     {
         m_Items.clear();
+        m_bDirty = true;
     }
 
-    MatrixBatch::MatrixBatchItemPointer MatrixBatch::createItem(const MatrixBatchItemKey &key)
+    SlotHandle MatrixBatch::createItem()
     {
-        // If the object already exists, the old shared pointer will be replaced
-        // and will delete the batch item it was holding.
-        MatrixBatchItemPointer item = MatrixBatchItemPointer::create();
-        m_Items.insert(key, item);
-        return item;
+        m_bDirty = true;
+        return m_Items.insert(MatrixBatchItem());
     }
 
-    MatrixBatch::MatrixBatchItemPointer MatrixBatch::getItem(const MatrixBatchItemKey &key) const
+    MatrixBatchItem* MatrixBatch::item(const SlotHandle &handle)
     {
-        return m_Items.value(key, MatrixBatchItemPointer());
+        return m_Items.get(handle);
     }
 
-    void MatrixBatch::removeItem(const MatrixBatchItemKey &key)
+    void MatrixBatch::removeItem(const SlotHandle &handle)
     {
-        m_Items.remove(key);
+        if ( m_Items.remove(handle) )
+        {
+            m_bDirty = true;
+        }
     }
 
-    bool MatrixBatch::containsItem(const MatrixBatchItemKey &key) const
+    bool MatrixBatch::containsItem(const SlotHandle &handle) const
     {
-        return m_Items.contains(key);
+        return m_Items.contains(handle);
     }
 
     MatrixBatchItemMetadata MatrixBatch::buildItemMetadata() const
     {
         MatrixBatchItemMetadata meta;
 
-        foreach ( MatrixBatchItemPointer item, m_Items )
+        for ( SlotMap<MatrixBatchItem>::const_iterator it = m_Items.constBegin(); it != m_Items.constEnd(); ++it )
         {
-            meta += item->buildMetadata();
+            meta += it->buildMetadata();
         }
 
         return meta;
@@ -98,19 +100,19 @@ namespace Renderer
     void MatrixBatch::copyVertexDataIntoBuffer(char* buffer, int size, int &positionOffset, int &normalOffset,
                                          int &colorOffset, int &texCoordOffset) const
     {
-        foreach ( const MatrixBatchItemPointer &item, m_Items.values() )
+        for ( SlotMap<MatrixBatchItem>::const_iterator it = m_Items.constBegin(); it != m_Items.constEnd(); ++it )
         {
-            copyItemDataIntoBuffer(item, buffer, size,
+            copyItemDataIntoBuffer(*it, buffer, size,
                                    positionOffset, normalOffset, colorOffset, texCoordOffset);
         }
     }
 
     void MatrixBatch::copyIndexDataIntoBuffer(char *buffer, int size, quint32 &indexDelta, int positionComponents, int &offset)
     {
-        foreach ( const MatrixBatchItemPointer &item, m_Items.values() )
+        for ( SlotMap<MatrixBatchItem>::const_iterator it = m_Items.constBegin(); it != m_Items.constEnd(); ++it )
         {
-            copyItemDataIntoBuffer(item->m_Indices, buffer, size, indexDelta, offset);
-            indexDelta += item->m_Positions.count() / positionComponents;
+            copyItemDataIntoBuffer(it->m_Indices, buffer, size, indexDelta, offset);
+            indexDelta += it->m_Positions.count() / positionComponents;
         }
     }
 
@@ -128,4 +130,14 @@ namespace Renderer
     {
         return m_Items.count();
     }
+
+    bool MatrixBatch::isDirty() const
+    {
+        return m_bDirty;
+    }
+
+    void MatrixBatch::setDirty(bool dirty)
+    {
+        m_bDirty = dirty;
+    }
 }
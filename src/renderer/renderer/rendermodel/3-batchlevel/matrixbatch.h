@@ -2,43 +2,45 @@
 #define MATRIXBATCH_H
 
 #include "renderer_global.h"
-#include <QHash>
 #include "renderer/rendermodel/4-batchitemlevel/matrixbatchitem.h"
-#include <QSharedPointer>
-#include "renderer/rendermodel/4-batchitemlevel/matrixbatchitemkey.h"
+#include "renderer/rendermodel/slotmap.h"
 #include <QOpenGLBuffer>
 #include <QMatrix4x4>
 
 namespace Renderer
 {
     // This class groups all vertex data that is related to the same
-    // model-to-world matrix.
+    // model-to-world matrix. Items are stored contiguously and referred
+    // to by handle, which whoever created the item should keep.
     class MatrixBatch
     {
     public:
-        typedef QSharedPointer<MatrixBatchItem> MatrixBatchItemPointer;
-
         MatrixBatch(const QMatrix4x4 &matrix);
         ~MatrixBatch();
 
         const QMatrix4x4& matrix() const;
         void clearItems();
 
-        // Creates an item for the given object ID.
-        // If an item already exists, it is replaced.
-        MatrixBatchItemPointer createItem(const MatrixBatchItemKey &key);
+        // Creates a new, empty item.
+        SlotHandle createItem();
 
-        // Gets the item for the given object ID.
-        // If it does not exist, null is returned.
-        MatrixBatchItemPointer getItem(const MatrixBatchItemKey &key) const;
+        // Gets the item for the given handle. The pointer is only valid
+        // until the next item is created or removed.
+        // If the item does not exist, null is returned.
+        MatrixBatchItem* item(const SlotHandle &handle);
 
-        // Removes the item for the given object ID.
         // If the item doesn't exist, this function does nothing.
-        void removeItem(const MatrixBatchItemKey &key);
+        void removeItem(const SlotHandle &handle);
 
-        bool containsItem(const MatrixBatchItemKey &key) const;
+        bool containsItem(const SlotHandle &handle) const;
         int itemCount() const;
 
+        // Set whenever items are created or removed. The contents of items aren't
+        // tracked, so this must also be set by whoever modifies an item's data.
+        // Cleared by the OpenGL batch once the data has been uploaded.
+        bool isDirty() const;
+        void setDirty(bool dirty);
+
         MatrixBatchItemMetadata buildItemMetadata() const;
 
         void copyVertexDataIntoBuffer(char* buffer, int size, int& positionOffset, int& normalOffset,
@@ -49,7 +51,8 @@ namespace Renderer
 
     private:
         const QMatrix4x4 m_matModelToWorld;
-        QHash<MatrixBatchItemKey, MatrixBatchItemPointer>    m_Items;
+        SlotMap<MatrixBatchItem>    m_Items;
+        bool m_bDirty;
     };
 }
 
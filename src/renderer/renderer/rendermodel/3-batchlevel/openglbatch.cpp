@@ -1,9 +1,18 @@
 #include "openglbatch.h"
 #include "renderer/opengl/openglhelpers.h"
 #include "renderer/opengl/openglerrors.h"
+#include <QByteArray>
 
 namespace
 {
+    void writeSection(QOpenGLBuffer &buffer, int offset, const char* data, int count)
+    {
+        if ( count > 0 )
+        {
+            GLTRY(buffer.write(offset, data, count));
+        }
+    }
+
     void trySetAttributeBuffer(QOpenGLShaderProgram *shaderProgram,
                                int offsetInBytes,
                                Renderer::ShaderDefs::VertexArrayAttribute attribute,
@@ -18,21 +27,8 @@ namespace
         }
     }
 
-    template<typename T>
-    void readBufferData(QOpenGLBuffer &buffer, QVector<T> &out)
-    {
-        if ( !buffer.isCreated() )
-            return;
-
-        buffer.bind();
-        out.resize(buffer.size() / sizeof(T));
-        memcpy(out.data(), buffer.map(QOpenGLBuffer::ReadOnly), buffer.size());
-        buffer.unmap();
-        buffer.release();
-    }
-
-    template<typename T>
-    void readBufferData(Renderer::OpenGLUniformBuffer &buffer, QVector<T> &out)
+    template<typename T, typename B>
+    void readBufferData(B &buffer, QVector<T> &out)
     {
         if ( !buffer.isCreated() )
             return;
@@ -56,7 +52,13 @@ namespace Renderer
           m_VertexBuffer(QOpenGLBuffer::VertexBuffer),
           m_IndexBuffer(QOpenGLBuffer::IndexBuffer),
           m_UniformBuffer(m_iUsagePattern),
+          m_MatrixBufferTexture(m_iUsagePattern),
           m_bNeedsUpload(true),
+          m_iVertexCapacity(0),
+          m_iIndexCapacity(0),
+          m_iMatrixCapacity(0),
+          m_bBuffersReallocated(false),
+          m_bDrawCommandsStale(true),
           m_iDrawMode(GL_TRIANGLES)
     {
         Q_ASSERT(shaderSpec);
@@ -80,7 +82,15 @@ namespace Renderer
         m_bCreated = true;
         GLTRY(m_bCreated = m_bCreated && m_VertexBuffer.create());
         GLTRY(m_bCreated = m_bCreated && m_IndexBuffer.create());
-        GLTRY(m_bCreated = m_bCreated && m_UniformBuffer.create());
+
+        if ( usesBufferTextureMatrices() )
+        {
+            GLTRY(m_bCreated = m_bCreated && m_MatrixBufferTexture.create());
+        }
+        else
+        {
+            GLTRY(m_bCreated = m_bCreated && m_UniformBuffer.create());
+        }
     }
 
     void OpenGLBatch::destroy()
@@ -91,6 +101,13 @@ namespace Renderer
         GLTRY(m_VertexBuffer.destroy());
         GLTRY(m_IndexBuffer.destroy());
         GLTRY(m_UniformBuffer.destroy());
+        GLTRY(m_MatrixBufferTexture.destroy());
+
+        // Nothing is allocated any more.
+        m_iVertexCapacity = 0;
+        m_iIndexCapacity = 0;
+        m_iMatrixCapacity = 0;
+        setNeedsUpload(true);
 
         m_bCreated = false;
     }
@@ -125,135 +142,371 @@ namespace Renderer
         return batchSize() == 1;
     }
 
-    void OpenGLBatch::upload()
+    int OpenGLBatch::upload()
+    {
+        const bool uploadEverything = m_bNeedsUpload;
+        updateSlotRanges();
+        reallocateIfRequired();
+
+        int uploadedBytes = 0;
+        if ( reallocateMatricesIfRequired() )
+        {
+            uploadedBytes += uploadMatrices(0, m_Slots.count());
+        }
+
+        if ( m_bBuffersReallocated || uploadEverything )
+        {
+            uploadedBytes += uploadAllSlots();
+            m_bBuffersReallocated = false;
+            return uploadedBytes;
+        }
+
+        for ( int i = 0; i < m_Slots.count(); i++ )
+        {
+            const MatrixBatchSlot& slot = m_Slots.at(i);
+            if ( !slot.batch.isNull() && !slot.uploaded )
+            {
+                uploadedBytes += uploadSlot(i);
+            }
+        }
+
+        return uploadedBytes;
+    }
+
+    int OpenGLBatch::withSlack(int count)
     {
-        calculateRequiredSizeOfBuffers();
-        uploadVertices();
-        uploadIndices();
-        uploadUniforms();
+        // Half as much again.
+        return count + (count / 2);
     }
 
-    void OpenGLBatch::uploadVertices()
+    bool OpenGLBatch::usesBufferTextureMatrices() const
     {
-        bool successfulBind = false;
-        GLTRY(successfulBind = m_VertexBuffer.bind());
-        Q_ASSERT_X(successfulBind, Q_FUNC_INFO, "Could not bind vertex buffer");
+        return m_pShaderSpec->matrixStorage() == ShaderDefs::BufferTextureMatrixStorage;
+    }
 
-        GLTRY(m_VertexBuffer.allocate(m_UploadMetadata.totalVertexBytes()));
+    int OpenGLBatch::vertexBytes() const
+    {
+        const VertexFormat format = m_pShaderSpec->vertexFormat();
+        const int objectIdBytes = usesBufferTextureMatrices() ? sizeof(quint32) : 0;
+        return (format.totalVertexComponents() * sizeof(float)) + objectIdBytes;
+    }
 
-        void* vBuffer = Q_NULLPTR;
-        GLTRY(vBuffer = m_VertexBuffer.map(QOpenGLBuffer::WriteOnly));
-        char* buffer = reinterpret_cast<char*>(vBuffer);
+    OpenGLBatch::SectionBases OpenGLBatch::sectionStarts(int sectionVertices, int vertex) const
+    {
+        const VertexFormat format = m_pShaderSpec->vertexFormat();
+        const int positionBytes = format.positionComponents() * sizeof(float);
+        const int normalBytes = format.normalComponents() * sizeof(float);
+        const int colorBytes = format.colorComponents() * sizeof(float);
+        const int texCoordBytes = format.textureCoordinateComponents() * sizeof(float);
 
-        int size = 0;
-        GLTRY(size = m_VertexBuffer.size());
+        SectionBases starts;
+        starts.position = vertex * positionBytes;
+        starts.normal = (sectionVertices * positionBytes) + (vertex * normalBytes);
+        starts.color = (sectionVertices * (positionBytes + normalBytes)) + (vertex * colorBytes);
+        starts.textureCoordinate = (sectionVertices * (positionBytes + normalBytes + colorBytes)) + (vertex * texCoordBytes);
+        starts.objectId = (sectionVertices * (positionBytes + normalBytes + colorBytes + texCoordBytes)) +
+                          (vertex * static_cast<int>(sizeof(quint32)));
+        return starts;
+    }
 
-        copyAllVertexData(buffer, size);
+    void OpenGLBatch::updateSlotRanges()
+    {
+        for ( int i = 0; i < m_Slots.count(); i++ )
+        {
+            MatrixBatchSlot& slot = m_Slots[i];
+            if ( slot.batch.isNull() )
+                continue;
 
-        GLTRY(m_VertexBuffer.unmap());
-        GLTRY(m_VertexBuffer.release());
+            if ( m_bNeedsUpload )
+            {
+                slot.uploaded = false;
+            }
+
+            if ( !slot.batch->isDirty() && slot.uploaded )
+                continue;
+
+            slot.sizes = slot.batch->buildItemMetadata();
+            slot.batch->setDirty(false);
+            slot.uploaded = false;
+            resizeSlotRanges(slot);
+        }
     }
 
-    void OpenGLBatch::copyAllVertexData(char* buffer, int size)
+    void OpenGLBatch::resizeSlotRanges(MatrixBatchSlot &slot)
     {
-        int offset = 0;
+        const int positionComponents = m_pShaderSpec->vertexFormat().positionComponents();
+        const int vertexCount = positionComponents > 0
+                ? slot.sizes.m_iPositionBytes / (positionComponents * static_cast<int>(sizeof(float)))
+                : 0;
+        const int indexCount = slot.sizes.m_iIndexBytes / sizeof(quint32);
+
+        // Move to a new range if the old one is too small, or mostly going unused.
+        if ( vertexCount > slot.vertexCapacity || vertexCount * 4 < slot.vertexCapacity )
+        {
+            m_VertexArena.free(slot.vertexOffset, slot.vertexCapacity);
+            slot.vertexCapacity = withSlack(vertexCount);
+            slot.vertexOffset = m_VertexArena.allocate(slot.vertexCapacity);
+            m_bDrawCommandsStale = true;
+        }
+
+        if ( indexCount > slot.indexCapacity || indexCount * 4 < slot.indexCapacity )
+        {
+            m_IndexArena.free(slot.indexOffset, slot.indexCapacity);
+            slot.indexCapacity = withSlack(indexCount);
+            slot.indexOffset = m_IndexArena.allocate(slot.indexCapacity);
+            m_bDrawCommandsStale = true;
+        }
+
+        if ( vertexCount != slot.vertexCount || indexCount != slot.indexCount )
+        {
+            slot.vertexCount = vertexCount;
+            slot.indexCount = indexCount;
+            m_bDrawCommandsStale = true;
+        }
+    }
 
-        int positionOffset = offset;
-        offset += m_UploadMetadata.m_iPositionBytes;
+    void OpenGLBatch::freeSlotRanges(MatrixBatchSlot &slot)
+    {
+        m_VertexArena.free(slot.vertexOffset, slot.vertexCapacity);
+        m_IndexArena.free(slot.indexOffset, slot.indexCapacity);
+        slot.vertexOffset = 0;
+        slot.vertexCapacity = 0;
+        slot.vertexCount = 0;
+        slot.indexOffset = 0;
+        slot.indexCapacity = 0;
+        slot.indexCount = 0;
+        m_bDrawCommandsStale = true;
+    }
 
-        int normalOffset = offset;
-        offset += m_UploadMetadata.m_iNormalBytes;
+    bool OpenGLBatch::reallocateIfRequired()
+    {
+        const bool tooSmall = m_VertexArena.size() > m_iVertexCapacity ||
+                              m_IndexArena.size() > m_iIndexCapacity;
 
-        int colorOffset = offset;
-        offset += m_UploadMetadata.m_iColorBytes;
+        // Give the memory back if most of it is going unused.
+        const bool tooLarge = m_iVertexCapacity > 4 * withSlack(m_VertexArena.size()) ||
+                              m_iIndexCapacity > 4 * withSlack(m_IndexArena.size());
 
-        int texCoordOffset = offset;
-        offset += m_UploadMetadata.m_iTextureCoordinateBytes;
+        if ( !tooSmall && !tooLarge )
+            return false;
 
-        quint32 id = 0;
-        foreach ( const MatrixBatchPointer& batch, m_MatrixBatchTable )
+        // The buffers themselves are allocated when everything is uploaded again.
+        m_iVertexCapacity = withSlack(m_VertexArena.size());
+        m_iIndexCapacity = withSlack(m_IndexArena.size());
+        m_bBuffersReallocated = true;
+        return true;
+    }
+
+    bool OpenGLBatch::reallocateMatricesIfRequired()
+    {
+        if ( usesBufferTextureMatrices() )
         {
-            int oldPositionOffset = positionOffset;
-            batch->copyVertexDataIntoBuffer(buffer, size, positionOffset, normalOffset, colorOffset, texCoordOffset);
-            updateObjectIds(buffer, oldPositionOffset, positionOffset - oldPositionOffset, id);
-            id++;
+            // There may be thousands of matrices, so only allocate what is needed.
+            if ( m_Slots.count() <= m_iMatrixCapacity )
+                return false;
+
+            m_iMatrixCapacity = qMin(withSlack(m_Slots.count()), m_pShaderSpec->maxBatchedItems());
+            GLTRY(m_MatrixBufferTexture.bind());
+            GLTRY(m_MatrixBufferTexture.allocate(m_iMatrixCapacity * 16 * sizeof(float)));
+            GLTRY(m_MatrixBufferTexture.release());
+            return true;
         }
+
+        if ( m_iMatrixCapacity > 0 )
+            return false;
+
+        // The uniform block is a fixed size.
+        m_iMatrixCapacity = m_pShaderSpec->maxBatchedItems();
+        GLTRY(m_UniformBuffer.bind());
+        GLTRY(m_UniformBuffer.allocate(m_iMatrixCapacity * 16 * sizeof(float)));
+        GLTRY(m_UniformBuffer.release());
+        return true;
     }
 
-    void OpenGLBatch::updateObjectIds(char *buffer, int offset, int numBytes, quint32 id)
+    void OpenGLBatch::copySlotData(int index, char *vertexData, int vertexDataSize, const SectionBases &starts,
+                                   char *indexData, int indexDataSize, int indexStart)
     {
-        int numFloats = numBytes / sizeof(float);
-        float* floatData = reinterpret_cast<float*>(buffer);
-        int numComponents = m_pShaderSpec->vertexFormat().positionComponents();
-        int floatOffset = offset / sizeof(float);
+        const MatrixBatchSlot& slot = m_Slots.at(index);
 
-        for ( int i = floatOffset; i < floatOffset + numFloats; i++ )
+        int positionOffset = starts.position;
+        int normalOffset = starts.normal;
+        int colorOffset = starts.color;
+        int texCoordOffset = starts.textureCoordinate;
+        slot.batch->copyVertexDataIntoBuffer(vertexData, vertexDataSize,
+                                             positionOffset, normalOffset, colorOffset, texCoordOffset);
+
+        // With buffer texture matrices the IDs have their own section,
+        // rather than being packed into the positions.
+        if ( usesBufferTextureMatrices() )
         {
-            // Fast forward past the first components.
-            i += numComponents - 1;
+            Q_ASSERT_X(starts.objectId + (slot.vertexCount * static_cast<int>(sizeof(quint32))) <= vertexDataSize,
+                       Q_FUNC_INFO, "GL buffer overflow when copying object IDs!");
 
-            // Set the last component using a mask.
-            // We bit shift down and then up again to set the
-            // lower bits to zero, then OR with the masked ID.
-            quint32 valAsInt = static_cast<quint32>(floatData[i]);
-            valAsInt = ((valAsInt >> m_iMaskBitsRequired) << m_iMaskBitsRequired) | (id & m_iObjectIdMask);
-            float f = static_cast<float>(valAsInt);
-            floatData[i] = f;
+            quint32* objectIds = reinterpret_cast<quint32*>(vertexData + starts.objectId);
+            for ( int i = 0; i < slot.vertexCount; i++ )
+            {
+                objectIds[i] = index;
+            }
+        }
+        else
+        {
+            updateObjectIds(vertexData, starts.position, positionOffset - starts.position, index);
         }
+
+        // Indices stay relative to the slot's first vertex, which is passed as the base vertex when drawing.
+        quint32 indexDelta = 0;
+        int indexOffset = indexStart;
+        slot.batch->copyIndexDataIntoBuffer(indexData, indexDataSize, indexDelta,
+                                            m_pShaderSpec->vertexFormat().positionComponents(), indexOffset);
     }
 
-    void OpenGLBatch::uploadIndices()
+    int OpenGLBatch::uploadAllSlots()
     {
+        // Gaps between ranges are zeroed rather than left undefined.
+        QByteArray vertexData(m_iVertexCapacity * vertexBytes(), 0);
+        QByteArray indexData(m_iIndexCapacity * static_cast<int>(sizeof(quint32)), 0);
+
+        for ( int i = 0; i < m_Slots.count(); i++ )
+        {
+            MatrixBatchSlot& slot = m_Slots[i];
+            if ( slot.batch.isNull() )
+                continue;
+
+            copySlotData(i, vertexData.data(), vertexData.size(), sectionStarts(m_iVertexCapacity, slot.vertexOffset),
+                         indexData.data(), indexData.size(), slot.indexOffset * sizeof(quint32));
+            slot.uploaded = true;
+        }
+
         bool successfulBind = false;
+        GLTRY(successfulBind = m_VertexBuffer.bind());
+        Q_ASSERT_X(successfulBind, Q_FUNC_INFO, "Could not bind vertex buffer");
+        GLTRY(m_VertexBuffer.allocate(vertexData.constData(), vertexData.size()));
+        GLTRY(m_VertexBuffer.release());
+
+        successfulBind = false;
         GLTRY(successfulBind = m_IndexBuffer.bind());
         Q_ASSERT_X(successfulBind, Q_FUNC_INFO, "Could not bind index buffer");
+        GLTRY(m_IndexBuffer.allocate(indexData.constData(), indexData.size()));
+        GLTRY(m_IndexBuffer.release());
 
-        GLTRY(m_IndexBuffer.allocate(m_UploadMetadata.m_iIndexBytes));
+        return vertexData.size() + indexData.size() + uploadMatrices(0, m_Slots.count());
+    }
 
-        void* vBuffer = Q_NULLPTR;
-        GLTRY(vBuffer = m_IndexBuffer.map(QOpenGLBuffer::WriteOnly));
-        char* buffer = reinterpret_cast<char*>(vBuffer);
+    int OpenGLBatch::uploadSlot(int index)
+    {
+        MatrixBatchSlot& slot = m_Slots[index];
 
-        int size = 0;
-        GLTRY(size = m_IndexBuffer.size());
+        // Lay the slot's data out in the same way as in the buffers, but without any gaps.
+        const SectionBases staged = sectionStarts(slot.vertexCount, 0);
+        QByteArray vertexData(slot.vertexCount * vertexBytes(), Qt::Uninitialized);
+        QByteArray indexData(slot.indexCount * static_cast<int>(sizeof(quint32)), Qt::Uninitialized);
+        copySlotData(index, vertexData.data(), vertexData.size(), staged, indexData.data(), indexData.size(), 0);
 
-        int offset = 0;
-        int positionComponents = m_pShaderSpec->vertexFormat().positionComponents();
-        quint32 indexDelta = 0;
+        const SectionBases target = sectionStarts(m_iVertexCapacity, slot.vertexOffset);
+        const char* source = vertexData.constData();
+
+        bool successfulBind = false;
+        GLTRY(successfulBind = m_VertexBuffer.bind());
+        Q_ASSERT_X(successfulBind, Q_FUNC_INFO, "Could not bind vertex buffer");
+        writeSection(m_VertexBuffer, target.position, source + staged.position, staged.normal - staged.position);
+        writeSection(m_VertexBuffer, target.normal, source + staged.normal, staged.color - staged.normal);
+        writeSection(m_VertexBuffer, target.color, source + staged.color, staged.textureCoordinate - staged.color);
+        writeSection(m_VertexBuffer, target.textureCoordinate, source + staged.textureCoordinate,
+                     staged.objectId - staged.textureCoordinate);
+        writeSection(m_VertexBuffer, target.objectId, source + staged.objectId, vertexData.size() - staged.objectId);
+        GLTRY(m_VertexBuffer.release());
 
-        foreach ( const MatrixBatchPointer& batch, m_MatrixBatchTable.values() )
+        if ( !indexData.isEmpty() )
         {
-            batch->copyIndexDataIntoBuffer(buffer, size, indexDelta, positionComponents, offset);
+            successfulBind = false;
+            GLTRY(successfulBind = m_IndexBuffer.bind());
+            Q_ASSERT_X(successfulBind, Q_FUNC_INFO, "Could not bind index buffer");
+            GLTRY(m_IndexBuffer.write(slot.indexOffset * sizeof(quint32), indexData.constData(), indexData.size()));
+            GLTRY(m_IndexBuffer.release());
         }
 
-        GLTRY(m_IndexBuffer.unmap());
-        GLTRY(m_IndexBuffer.release());
+        slot.uploaded = true;
+        return vertexData.size() + indexData.size() + uploadMatrices(index, index + 1);
     }
 
-    void OpenGLBatch::uploadUniforms()
+    int OpenGLBatch::uploadMatrices(int begin, int end)
     {
-        // Warning: The specific order of these commands may be important.
-        // UBOs are finnicky.
+        if ( begin >= end )
+            return 0;
 
-        GLTRY(m_UniformBuffer.bind());
-        GLTRY(m_UniformBuffer.allocate(m_pShaderSpec->maxBatchedItems() * 16 * sizeof(float)));
-        GLTRY(m_UniformBuffer.release());
+        // Each matrix batch's object ID is its index into the matrices.
+        // Free slots are given an identity matrix.
+        const int matrixBytes = 16 * sizeof(float);
+        const QMatrix4x4 identity;
+        QByteArray matrixData((end - begin) * matrixBytes, Qt::Uninitialized);
+        for ( int i = begin; i < end; i++ )
+        {
+            const MatrixBatchPointer& batch = m_Slots.at(i).batch;
+            const QMatrix4x4& matrix = batch.isNull() ? identity : batch->matrix();
+            memcpy(matrixData.data() + ((i - begin) * matrixBytes), matrix.constData(), matrixBytes);
+        }
 
-        GLTRY(m_UniformBuffer.bindToIndex(ShaderDefs::LocalUniformBlockBindingPoint));
+        if ( usesBufferTextureMatrices() )
+        {
+            GLTRY(m_MatrixBufferTexture.bind());
+            GLTRY(m_MatrixBufferTexture.write(begin * matrixBytes, matrixData.constData(), matrixData.size()));
+            GLTRY(m_MatrixBufferTexture.release());
+        }
+        else
+        {
+            GLTRY(m_UniformBuffer.bind());
+            GLTRY(m_UniformBuffer.write(begin * matrixBytes, matrixData.constData(), matrixData.size()));
+            GLTRY(m_UniformBuffer.release());
+        }
 
-        int offset = 0;
-        foreach ( const MatrixBatchPointer& batch, m_MatrixBatchTable.values() )
+        return matrixData.size();
+    }
+
+    void OpenGLBatch::buildDrawCommands()
+    {
+        m_DrawCounts.clear();
+        m_DrawIndexOffsets.clear();
+        m_DrawBaseVertices.clear();
+
+        for ( int i = 0; i < m_Slots.count(); i++ )
         {
-            GLTRY(m_UniformBuffer.write(offset, batch->matrix().constData(), 16 * sizeof(float)));
-            offset += 16 * sizeof(float);
+            const MatrixBatchSlot& slot = m_Slots.at(i);
+            if ( slot.batch.isNull() || slot.indexCount < 1 )
+                continue;
+
+            m_DrawCounts.append(slot.indexCount);
+            m_DrawIndexOffsets.append(reinterpret_cast<const GLvoid*>(static_cast<quintptr>(slot.indexOffset * sizeof(quint32))));
+            m_DrawBaseVertices.append(slot.vertexOffset);
         }
 
-        GLTRY(m_UniformBuffer.release());
+        m_bDrawCommandsStale = false;
+    }
+
+    void OpenGLBatch::updateObjectIds(char *buffer, int offset, int numBytes, quint32 id)
+    {
+        int numFloats = numBytes / sizeof(float);
+        float* floatData = reinterpret_cast<float*>(buffer);
+        int numComponents = m_pShaderSpec->vertexFormat().positionComponents();
+        int floatOffset = offset / sizeof(float);
+
+        for ( int i = floatOffset; i < floatOffset + numFloats; i++ )
+        {
+            // Fast forward past the first components.
+            i += numComponents - 1;
+
+            // Set the last component using a mask.
+            // We bit shift down and then up again to set the
+            // lower bits to zero, then OR with the masked ID.
+            quint32 valAsInt = static_cast<quint32>(floatData[i]);
+            valAsInt = ((valAsInt >> m_iMaskBitsRequired) << m_iMaskBitsRequired) | (id & m_iObjectIdMask);
+            float f = static_cast<float>(valAsInt);
+            floatData[i] = f;
+        }
     }
 
     int OpenGLBatch::matrixBatchCount() const
     {
-        return m_MatrixBatchTable.count();
+        return m_SlotTable.count();
     }
 
     bool OpenGLBatch::matrixBatchLimitReached() const
@@ -269,39 +522,60 @@ namespace Renderer
         if ( matrixBatchLimitReached() )
             return;
 
-        m_MatrixBatchTable.insert(key, batch);
-        setNeedsUpload(true);
+        if ( m_SlotTable.contains(key) )
+        {
+            removeMatrixBatch(key);
+        }
+
+        // Reuse a free slot if there is one, so that object IDs stay within the batch size.
+        int index = -1;
+        if ( !m_FreeSlots.isEmpty() )
+        {
+            index = m_FreeSlots.takeLast();
+        }
+        else
+        {
+            index = m_Slots.count();
+            m_Slots.append(MatrixBatchSlot());
+        }
+
+        m_Slots[index].batch = batch;
+        m_Slots[index].uploaded = false;
+        m_SlotTable.insert(key, index);
     }
 
     void OpenGLBatch::removeMatrixBatch(const MatrixBatchKey &key)
     {
-        if ( m_MatrixBatchTable.remove(key) > 0 )
-        {
-            setNeedsUpload(true);
-        }
+        QHash<MatrixBatchKey, int>::iterator it = m_SlotTable.find(key);
+        if ( it == m_SlotTable.end() )
+            return;
+
+        // Nothing else moves, so no other batch needs writing again.
+        const int index = it.value();
+        m_SlotTable.erase(it);
+
+        freeSlotRanges(m_Slots[index]);
+        m_Slots[index] = MatrixBatchSlot();
+        m_FreeSlots.append(index);
     }
 
     OpenGLBatch::MatrixBatchPointer OpenGLBatch::matrixBatchAt(const MatrixBatchKey &key) const
     {
-        return m_MatrixBatchTable.value(key, MatrixBatchPointer());
+        const int index = m_SlotTable.value(key, -1);
+        return index >= 0 ? m_Slots.at(index).batch : MatrixBatchPointer();
     }
 
     void OpenGLBatch::clearMatrixBatches()
     {
-        m_MatrixBatchTable.clear();
+        m_SlotTable.clear();
+        m_Slots.clear();
+        m_FreeSlots.clear();
+        m_VertexArena.clear();
+        m_IndexArena.clear();
+        m_bDrawCommandsStale = true;
         setNeedsUpload(true);
     }
 
-    void OpenGLBatch::calculateRequiredSizeOfBuffers()
-    {
-        m_UploadMetadata.reset();
-
-        foreach ( const MatrixBatchPointer& matBatch, m_MatrixBatchTable.values() )
-        {
-            m_UploadMetadata += matBatch->buildItemMetadata();
-        }
-    }
-
     void OpenGLBatch::setNeedsUpload(bool needsUpload)
     {
         m_bNeedsUpload = needsUpload;
@@ -309,16 +583,27 @@ namespace Renderer
 
     bool OpenGLBatch::needsUpload() const
     {
-        return m_bNeedsUpload;
-    }
+        if ( m_bNeedsUpload )
+            return true;
 
-    void OpenGLBatch::uploadIfRequired()
-    {
-        if ( needsUpload() )
+        for ( int i = 0; i < m_Slots.count(); i++ )
         {
-            upload();
-            setNeedsUpload(false);
+            const MatrixBatchSlot& slot = m_Slots.at(i);
+            if ( !slot.batch.isNull() && (!slot.uploaded || slot.batch->isDirty()) )
+                return true;
         }
+
+        return false;
+    }
+
+    int OpenGLBatch::uploadIfRequired()
+    {
+        if ( !needsUpload() )
+            return 0;
+
+        const int uploadedBytes = upload();
+        setNeedsUpload(false);
+        return uploadedBytes;
     }
 
     void OpenGLBatch::setVertexAttributes(QOpenGLShaderProgram *shaderProgram) const
@@ -328,6 +613,14 @@ namespace Renderer
         setAttributeBuffer(shaderProgram, ShaderDefs::NormalAttribute, offset);
         setAttributeBuffer(shaderProgram, ShaderDefs::ColorAttribute, offset);
         setAttributeBuffer(shaderProgram, ShaderDefs::TextureCoordinateAttribute, offset);
+
+        if ( usesBufferTextureMatrices() )
+        {
+            // QOpenGLShaderProgram only sets float attributes.
+            GL_CURRENT_F;
+            GLTRY(f->glVertexAttribIPointer(ShaderDefs::ObjectIdAttribute, 1, GL_UNSIGNED_INT, 0,
+                                            reinterpret_cast<const void*>(static_cast<quintptr>(offset))));
+        }
     }
 
     void OpenGLBatch::setAttributeBuffer(QOpenGLShaderProgram *shaderProgram, ShaderDefs::VertexArrayAttribute att, int &offsetInBytes) const
@@ -339,28 +632,28 @@ namespace Renderer
             case ShaderDefs::PositionAttribute:
             {
                 trySetAttributeBuffer(shaderProgram, offsetInBytes, att, vertexFormat.positionComponents());
-                offsetInBytes += m_UploadMetadata.m_iPositionBytes;
+                offsetInBytes += m_iVertexCapacity * vertexFormat.positionComponents() * sizeof(float);
                 break;
             }
 
             case ShaderDefs::NormalAttribute:
             {
                 trySetAttributeBuffer(shaderProgram, offsetInBytes, att, vertexFormat.normalComponents());
-                offsetInBytes += m_UploadMetadata.m_iNormalBytes;
+                offsetInBytes += m_iVertexCapacity * vertexFormat.normalComponents() * sizeof(float);
                 break;
             }
 
             case ShaderDefs::ColorAttribute:
             {
                 trySetAttributeBuffer(shaderProgram, offsetInBytes, att, vertexFormat.colorComponents());
-                offsetInBytes += m_UploadMetadata.m_iColorBytes;
+                offsetInBytes += m_iVertexCapacity * vertexFormat.colorComponents() * sizeof(float);
                 break;
             }
 
             case ShaderDefs::TextureCoordinateAttribute:
             {
                 trySetAttributeBuffer(shaderProgram, offsetInBytes, att, vertexFormat.textureCoordinateComponents());
-                offsetInBytes += m_UploadMetadata.m_iTextureCoordinateBytes;
+                offsetInBytes += m_iVertexCapacity * vertexFormat.textureCoordinateComponents() * sizeof(float);
                 break;
             }
 
@@ -376,20 +669,51 @@ namespace Renderer
     {
         GLTRY(m_VertexBuffer.bind());
         GLTRY(m_IndexBuffer.bind());
-        GLTRY(m_UniformBuffer.bindToIndex(ShaderDefs::LocalUniformBlockBindingPoint));
+
+        if ( usesBufferTextureMatrices() )
+        {
+            GLTRY(m_MatrixBufferTexture.bindTexture(ShaderDefs::MatrixBufferTexture));
+        }
+        else
+        {
+            GLTRY(m_UniformBuffer.bindToIndex(ShaderDefs::LocalUniformBlockBindingPoint));
+        }
     }
 
     void OpenGLBatch::draw()
     {
+        if ( m_bDrawCommandsStale )
+        {
+            buildDrawCommands();
+        }
+
+        if ( m_DrawCounts.isEmpty() )
+            return;
+
         GL_CURRENT_F;
-        GLTRY(f->glDrawElements(m_iDrawMode, m_UploadMetadata.m_iIndexBytes / sizeof(quint32), GL_UNSIGNED_INT, (void*)0));
+        GLTRY(f->glMultiDrawElementsBaseVertex(m_iDrawMode, m_DrawCounts.constData(), GL_UNSIGNED_INT,
+                                               m_DrawIndexOffsets.data(), m_DrawCounts.count(),
+                                               m_DrawBaseVertices.data()));
+    }
+
+    int OpenGLBatch::drawCommandCount() const
+    {
+        return m_DrawCounts.count();
     }
 
     void OpenGLBatch::releaseAll()
     {
         m_VertexBuffer.release();
         m_IndexBuffer.release();
-        m_UniformBuffer.release();
+
+        if ( usesBufferTextureMatrices() )
+        {
+            m_MatrixBufferTexture.releaseTexture(ShaderDefs::MatrixBufferTexture);
+        }
+        else
+        {
+            m_UniformBuffer.release();
+        }
     }
 
     void OpenGLBatch::exportVertexData(QVector<float> &out)
@@ -404,7 +728,14 @@ namespace Renderer
 
     void OpenGLBatch::exportUniformData(QVector<float> &out)
     {
-        readBufferData<float>(m_UniformBuffer, out);
+        if ( usesBufferTextureMatrices() )
+        {
+            readBufferData<float>(m_MatrixBufferTexture, out);
+        }
+        else
+        {
+            readBufferData<float>(m_UniformBuffer, out);
+        }
     }
 
     GLenum OpenGLBatch::drawMode() const
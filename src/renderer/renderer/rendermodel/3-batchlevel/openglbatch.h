@@ -4,6 +4,7 @@
 #include "renderer_global.h"
 #include <QOpenGLBuffer>
 #include "renderer/opengl/opengluniformbuffer.h"
+#include "renderer/opengl/openglbuffertexture.h"
 #include "renderer/shaders/vertexformat.h"
 #include "matrixbatch.h"
 #include "renderer/shaders/ishaderspec.h"
@@ -11,9 +12,25 @@
 #include "renderer/shaders/shaderdefs.h"
 #include "matrixbatch.h"
 #include "renderer/rendermodel/3-batchlevel/matrixbatchkey.h"
+#include "bufferarena.h"
+#include <QList>
+#include <QVector>
+#include <QSharedPointer>
 
 namespace Renderer
 {
+    // Each matrix batch is given a slot, whose index is its object ID, and its own ranges
+    // within the vertex and index buffers. Ranges are handed out by arenas, so a matrix
+    // batch keeps its ranges until it outgrows them, and removing one never moves the
+    // others. When a matrix batch changes, only its ranges are written.
+    //
+    // The whole batch is drawn with one glMultiDrawElementsBaseVertex call. Its arrays of
+    // draw commands are only rebuilt when a range is allocated, freed or changes length.
+    // Buffers and ranges are allocated with some slack, so that they don't need
+    // reallocating whenever a batch grows a little.
+    //
+    // Matrices are stored according to the shader's ShaderDefs::MatrixStorage. For buffer
+    // texture storage, a section of object IDs follows the other vertex sections.
     class OpenGLBatch
     {
     public:
@@ -25,7 +42,9 @@ namespace Renderer
         void create();
         void destroy();
         bool isCreated() const;
-        void upload();
+
+        // Returns the number of bytes written to the buffers.
+        int upload();
 
         const IShaderSpec* shaderSpec() const;
         VertexFormat vertexFormat() const;
@@ -41,17 +60,22 @@ namespace Renderer
         MatrixBatchPointer matrixBatchAt(const MatrixBatchKey &key) const;
         void clearMatrixBatches();
 
-        // The state of this flag must be set externally if the contents
-        // of a referenced matrix batch are changed.
+        // True if any matrix batch is dirty, or if everything has been flagged for upload.
+        // Setting the flag causes every matrix batch to be uploaded again.
         bool needsUpload() const;
         void setNeedsUpload(bool needsUpload);
-        void uploadIfRequired();
+
+        // Returns the number of bytes written to the buffers.
+        int uploadIfRequired();
 
         void setVertexAttributes(QOpenGLShaderProgram* shaderProgram) const;
         void bindAll();
         void draw();
         void releaseAll();
 
+        // Number of ranges submitted by the last call to draw().
+        int drawCommandCount() const;
+
         void exportVertexData(QVector<float> &out);
         void exportIndexData(QVector<quint32> &out);
         void exportUniformData(QVector<float> &out);
@@ -78,14 +102,62 @@ namespace Renderer
             return sizeof(quint32)*8;
         }
 
-        void uploadVertices();
-        void uploadIndices();
-        void uploadUniforms();
-        void calculateRequiredSizeOfBuffers();
+        // A matrix batch's place within the buffers. Vertex ranges are counted in
+        // vertices and apply to every vertex section; index ranges are counted in indices.
+        // Free slots have no batch.
+        struct MatrixBatchSlot
+        {
+            MatrixBatchSlot()
+                : vertexOffset(0), vertexCapacity(0), vertexCount(0),
+                  indexOffset(0), indexCapacity(0), indexCount(0),
+                  uploaded(false)
+            {
+            }
+
+            MatrixBatchPointer batch;
+            MatrixBatchItemMetadata sizes;
+            int vertexOffset;
+            int vertexCapacity;
+            int vertexCount;
+            int indexOffset;
+            int indexCapacity;
+            int indexCount;
+            bool uploaded;
+        };
+
+        // Byte offsets into each section of vertex data.
+        struct SectionBases
+        {
+            int position;
+            int normal;
+            int color;
+            int textureCoordinate;
+            int objectId;
+        };
+
+        static int withSlack(int count);
+
+        bool usesBufferTextureMatrices() const;
+        int vertexBytes() const;
+
+        // Byte offsets of the given vertex within each section, when each section
+        // has room for sectionVertices vertices.
+        SectionBases sectionStarts(int sectionVertices, int vertex) const;
+
+        void updateSlotRanges();
+        void resizeSlotRanges(MatrixBatchSlot &slot);
+        void freeSlotRanges(MatrixBatchSlot &slot);
+        bool reallocateIfRequired();
+        bool reallocateMatricesIfRequired();
+        void copySlotData(int index, char* vertexData, int vertexDataSize, const SectionBases &starts,
+                          char* indexData, int indexDataSize, int indexStart);
+        int uploadAllSlots();
+        int uploadSlot(int index);
+        int uploadMatrices(int begin, int end);
+        void buildDrawCommands();
         void setAttributeBuffer(QOpenGLShaderProgram* shaderProgram,
                                 Renderer::ShaderDefs::VertexArrayAttribute att,
                                 int &offsetInBytes) const;
-        void copyAllVertexData(char* buffer, int size);
         void updateObjectIds(char* buffer, int offset, int numBytes, quint32 id);
 
         const QOpenGLBuffer::UsagePattern m_iUsagePattern;
@@ -97,9 +169,27 @@ namespace Renderer
         QOpenGLBuffer       m_VertexBuffer;
         QOpenGLBuffer       m_IndexBuffer;
         OpenGLUniformBuffer m_UniformBuffer;
+        OpenGLBufferTexture m_MatrixBufferTexture;
         bool                m_bNeedsUpload;
-        QHash<MatrixBatchKey, MatrixBatchPointer>   m_MatrixBatchTable;
-        MatrixBatchItemMetadata m_UploadMetadata;
+
+        QHash<MatrixBatchKey, int>  m_SlotTable;
+        QVector<MatrixBatchSlot>    m_Slots;
+        QList<int>                  m_FreeSlots;
+        BufferArena                 m_VertexArena;
+        BufferArena                 m_IndexArena;
+
+        // Vertices and indices allocated in the buffers. If either buffer had to be
+        // reallocated, every slot is written in one go.
+        int                     m_iVertexCapacity;
+        int                     m_iIndexCapacity;
+        int                     m_iMatrixCapacity;
+        bool                    m_bBuffersReallocated;
+
+        // Arguments to glMultiDrawElementsBaseVertex.
+        QVector<GLsizei>        m_DrawCounts;
+        QVector<const GLvoid*>  m_DrawIndexOffsets;
+        QVector<GLint>          m_DrawBaseVertices;
+        bool                    m_bDrawCommandsStale;
 
         GLenum m_iDrawMode;
     };
@@ -0,0 +1,157 @@
+#include "sharedmeshsection.h"
+#include "renderer/opengl/openglerrors.h"
+#include "renderer/shaders/shaderdefs.h"
+
+namespace
+{
+    void trySetAttributeBuffer(QOpenGLShaderProgram *shaderProgram,
+                               int &offsetInBytes,
+                               Renderer::ShaderDefs::VertexArrayAttribute attribute,
+                               int components,
+                               int vertexCount)
+    {
+        if ( components > 0 )
+        {
+            shaderProgram->setAttributeBuffer(attribute, GL_FLOAT, offsetInBytes, components);
+        }
+
+        offsetInBytes += vertexCount * components * sizeof(float);
+    }
+}
+
+namespace Renderer
+{
+    SharedMeshSection::SharedMeshSection(const GeometrySection &section)
+        : m_VertexFormat(section.vertexFormat()),
+          m_matMesh(section.modelToWorldMatrix()),
+          m_iVertexCount(0),
+          m_iIndexCount(0),
+          m_bUploaded(false),
+          m_VertexBuffer(QOpenGLBuffer::VertexBuffer),
+          m_IndexBuffer(QOpenGLBuffer::IndexBuffer),
+          m_bCreated(false)
+    {
+        QVector<float> positions;
+        QVector<float> normals;
+        QVector<float> colors;
+        QVector<float> textureCoordinates;
+        m_iIndexCount = section.consolidate(positions, normals, colors, textureCoordinates, m_IndexData);
+
+        if ( m_VertexFormat.positionComponents() > 0 )
+        {
+            m_iVertexCount = positions.count() / m_VertexFormat.positionComponents();
+        }
+
+        m_VertexData.reserve(positions.count() + normals.count() + colors.count() + textureCoordinates.count());
+        m_VertexData.append(positions);
+        m_VertexData.append(normals);
+        m_VertexData.append(colors);
+        m_VertexData.append(textureCoordinates);
+
+        // The geometry never changes once uploaded.
+        GLTRY(m_VertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw));
+        GLTRY(m_IndexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw));
+    }
+
+    SharedMeshSection::~SharedMeshSection()
+    {
+        destroy();
+    }
+
+    void SharedMeshSection::create()
+    {
+        if ( m_bCreated )
+            return;
+
+        m_bCreated = true;
+        GLTRY(m_bCreated = m_bCreated && m_VertexBuffer.create());
+        GLTRY(m_bCreated = m_bCreated && m_IndexBuffer.create());
+    }
+
+    void SharedMeshSection::destroy()
+    {
+        if ( !m_bCreated )
+            return;
+
+        GLTRY(m_VertexBuffer.destroy());
+        GLTRY(m_IndexBuffer.destroy());
+        m_bCreated = false;
+    }
+
+    bool SharedMeshSection::isCreated() const
+    {
+        return m_bCreated;
+    }
+
+    int SharedMeshSection::uploadIfRequired()
+    {
+        if ( m_bUploaded )
+            return 0;
+
+        create();
+
+        const int vertexBytes = m_VertexData.count() * sizeof(float);
+        const int indexBytes = m_IndexData.count() * sizeof(quint32);
+
+        GLTRY(m_VertexBuffer.bind());
+        GLTRY(m_VertexBuffer.allocate(m_VertexData.constData(), vertexBytes));
+        GLTRY(m_VertexBuffer.release());
+
+        GLTRY(m_IndexBuffer.bind());
+        GLTRY(m_IndexBuffer.allocate(m_IndexData.constData(), indexBytes));
+        GLTRY(m_IndexBuffer.release());
+
+        m_VertexData.clear();
+        m_VertexData.squeeze();
+        m_IndexData.clear();
+        m_IndexData.squeeze();
+        m_bUploaded = true;
+
+        return vertexBytes + indexBytes;
+    }
+
+    VertexFormat SharedMeshSection::vertexFormat() const
+    {
+        return m_VertexFormat;
+    }
+
+    int SharedMeshSection::vertexCount() const
+    {
+        return m_iVertexCount;
+    }
+
+    int SharedMeshSection::indexCount() const
+    {
+        return m_iIndexCount;
+    }
+
+    const QMatrix4x4& SharedMeshSection::meshMatrix() const
+    {
+        return m_matMesh;
+    }
+
+    void SharedMeshSection::bind()
+    {
+        GLTRY(m_VertexBuffer.bind());
+        GLTRY(m_IndexBuffer.bind());
+    }
+
+    void SharedMeshSection::setVertexAttributes(QOpenGLShaderProgram *shaderProgram) const
+    {
+        int offset = 0;
+        trySetAttributeBuffer(shaderProgram, offset, ShaderDefs::PositionAttribute,
+                              m_VertexFormat.positionComponents(), m_iVertexCount);
+        trySetAttributeBuffer(shaderProgram, offset, ShaderDefs::NormalAttribute,
+                              m_VertexFormat.normalComponents(), m_iVertexCount);
+        trySetAttributeBuffer(shaderProgram, offset, ShaderDefs::ColorAttribute,
+                              m_VertexFormat.colorComponents(), m_iVertexCount);
+        trySetAttributeBuffer(shaderProgram, offset, ShaderDefs::TextureCoordinateAttribute,
+                              m_VertexFormat.textureCoordinateComponents(), m_iVertexCount);
+    }
+
+    void SharedMeshSection::release()
+    {
+        m_VertexBuffer.release();
+        m_IndexBuffer.release();
+    }
+}
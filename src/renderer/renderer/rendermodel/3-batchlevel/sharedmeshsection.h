@@ -0,0 +1,64 @@
+#ifndef SHAREDMESHSECTION_H
+#define SHAREDMESHSECTION_H
+
+#include "renderer_global.h"
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include <QMatrix4x4>
+#include <QVector>
+#include "renderer/geometry/geometrysection.h"
+#include "renderer/shaders/vertexformat.h"
+
+namespace Renderer
+{
+    // One section of a shared mesh, held once on the GPU no matter how many
+    // instances of it are drawn. The section's data is copied when this is
+    // constructed and uploaded the first time it's needed.
+    //
+    // Vertex data is laid out as for an OpenGLBatch: positions, then normals,
+    // then colours, then texture co-ordinates.
+    class SharedMeshSection
+    {
+    public:
+        SharedMeshSection(const GeometrySection &section);
+        ~SharedMeshSection();
+
+        void create();
+        void destroy();
+        bool isCreated() const;
+
+        // Returns the number of bytes written to the buffers.
+        int uploadIfRequired();
+
+        VertexFormat vertexFormat() const;
+        int vertexCount() const;
+        int indexCount() const;
+
+        // Transform from the section into the space of the mesh as a whole.
+        // Instance matrices are applied after this one.
+        const QMatrix4x4& meshMatrix() const;
+
+        void bind();
+        void setVertexAttributes(QOpenGLShaderProgram* shaderProgram) const;
+        void release();
+
+    private:
+        Q_DISABLE_COPY(SharedMeshSection)
+
+        const VertexFormat m_VertexFormat;
+        const QMatrix4x4 m_matMesh;
+        int m_iVertexCount;
+        int m_iIndexCount;
+
+        // Cleared once uploaded.
+        QVector<float> m_VertexData;
+        QVector<quint32> m_IndexData;
+        bool m_bUploaded;
+
+        QOpenGLBuffer m_VertexBuffer;
+        QOpenGLBuffer m_IndexBuffer;
+        bool m_bCreated;
+    };
+}
+
+#endif // SHAREDMESHSECTION_H
@@ -31,6 +31,20 @@ namespace Renderer
 
             return *this;
         }
+
+        inline bool operator ==(const MatrixBatchItemMetadata &other) const
+        {
+            return m_iPositionBytes == other.m_iPositionBytes &&
+                   m_iNormalBytes == other.m_iNormalBytes &&
+                   m_iColorBytes == other.m_iColorBytes &&
+                   m_iTextureCoordinateBytes == other.m_iTextureCoordinateBytes &&
+                   m_iIndexBytes == other.m_iIndexBytes;
+        }
+
+        inline bool operator !=(const MatrixBatchItemMetadata &other) const
+        {
+            return !(*this == other);
+        }
     };
 
     // This is just a collection of data.
@@ -0,0 +1,37 @@
+#include "rendererinputinstanceparams.h"
+
+namespace Renderer
+{
+    RendererInputInstanceParams::RendererInputInstanceParams(quint32 objectId, int passIndex, const QString &sharedMeshKey,
+                                                             const QMatrix4x4 &modelToWorldMatrix, const QColor &color)
+        : m_iObjectId(objectId), m_iPassIndex(passIndex), m_szSharedMeshKey(sharedMeshKey),
+          m_matModelToWorld(modelToWorldMatrix), m_colColor(color)
+    {
+
+    }
+
+    quint32 RendererInputInstanceParams::objectId() const
+    {
+        return m_iObjectId;
+    }
+
+    int RendererInputInstanceParams::passIndex() const
+    {
+        return m_iPassIndex;
+    }
+
+    const QString& RendererInputInstanceParams::sharedMeshKey() const
+    {
+        return m_szSharedMeshKey;
+    }
+
+    const QMatrix4x4& RendererInputInstanceParams::modelToWorldMatrix() const
+    {
+        return m_matModelToWorld;
+    }
+
+    const QColor& RendererInputInstanceParams::color() const
+    {
+        return m_colColor;
+    }
+}
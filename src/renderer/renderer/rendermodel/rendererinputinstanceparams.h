@@ -0,0 +1,34 @@
+#ifndef RENDERERINPUTINSTANCEPARAMS_H
+#define RENDERERINPUTINSTANCEPARAMS_H
+
+#include "renderer_global.h"
+#include <QString>
+#include <QMatrix4x4>
+#include <QColor>
+
+namespace Renderer
+{
+    class RENDERERSHARED_EXPORT RendererInputInstanceParams
+    {
+    public:
+        RendererInputInstanceParams(quint32 objectId, int passIndex, const QString &sharedMeshKey,
+                                    const QMatrix4x4 &modelToWorldMatrix, const QColor &color);
+
+        quint32 objectId() const;
+        int passIndex() const;
+        const QString& sharedMeshKey() const;
+        const QMatrix4x4& modelToWorldMatrix() const;
+
+        // The mesh's vertex colours are multiplied by this.
+        const QColor& color() const;
+
+    private:
+        const quint32 m_iObjectId;
+        const int m_iPassIndex;
+        const QString m_szSharedMeshKey;
+        const QMatrix4x4 m_matModelToWorld;
+        const QColor m_colColor;
+    };
+}
+
+#endif // RENDERERINPUTINSTANCEPARAMS_H
@@ -2,7 +2,6 @@
 #define RENDERERINPUTOBJECTPARAMS_H
 
 #include "renderer_global.h"
-#include "renderer/rendermodel/0-modellevel/rendermodelkey.h"
 #include "renderer/geometry/geometrysection.h"
 #include "renderer/geometry/geometrybuilder.h"
 #include <QList>
@@ -0,0 +1,203 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include "renderer_global.h"
+#include <QVector>
+
+namespace Renderer
+{
+    // Refers to a value in a SlotMap. Removing the value changes its slot's
+    // generation, so the handle finds nothing afterwards, even once the
+    // slot has been reused. A default constructed handle is null.
+    class SlotHandle
+    {
+    public:
+        SlotHandle()
+            : m_iIndex(0), m_iGeneration(0)
+        {
+        }
+
+        SlotHandle(quint32 index, quint32 generation)
+            : m_iIndex(index), m_iGeneration(generation)
+        {
+        }
+
+        inline quint32 index() const
+        {
+            return m_iIndex;
+        }
+
+        inline quint32 generation() const
+        {
+            return m_iGeneration;
+        }
+
+        inline bool isNull() const
+        {
+            return m_iGeneration == 0;
+        }
+
+        inline bool operator ==(const SlotHandle &other) const
+        {
+            return m_iIndex == other.m_iIndex && m_iGeneration == other.m_iGeneration;
+        }
+
+        inline bool operator !=(const SlotHandle &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        quint32 m_iIndex;
+        quint32 m_iGeneration;
+    };
+
+    // Values are kept contiguous, so iterating over them is as quick as for a QVector,
+    // and inserting, removing and looking up a value by its handle are all O(1).
+    // Removing a value moves the last one into its place, so iteration order and
+    // pointers to values are not stable; only handles are.
+    template<typename T>
+    class SlotMap
+    {
+    public:
+        typedef typename QVector<T>::iterator iterator;
+        typedef typename QVector<T>::const_iterator const_iterator;
+
+        SlotHandle insert(const T &value)
+        {
+            quint32 slotIndex = 0;
+            if ( m_FreeSlots.isEmpty() )
+            {
+                slotIndex = m_Slots.count();
+                m_Slots.append(Slot());
+            }
+            else
+            {
+                slotIndex = m_FreeSlots.takeLast();
+            }
+
+            Slot &slot = m_Slots[slotIndex];
+            slot.valueIndex = m_Values.count();
+
+            m_Values.append(value);
+            m_ValueSlots.append(slotIndex);
+            return SlotHandle(slotIndex, slot.generation);
+        }
+
+        // Returns false if the handle was stale.
+        bool remove(const SlotHandle &handle)
+        {
+            if ( !contains(handle) )
+                return false;
+
+            Slot &slot = m_Slots[handle.index()];
+            const int valueIndex = slot.valueIndex;
+            const int lastIndex = m_Values.count() - 1;
+
+            if ( valueIndex != lastIndex )
+            {
+                m_Values[valueIndex] = m_Values.at(lastIndex);
+                m_ValueSlots[valueIndex] = m_ValueSlots.at(lastIndex);
+                m_Slots[m_ValueSlots.at(valueIndex)].valueIndex = valueIndex;
+            }
+
+            m_Values.removeLast();
+            m_ValueSlots.removeLast();
+            release(handle.index());
+            return true;
+        }
+
+        bool contains(const SlotHandle &handle) const
+        {
+            return handle.index() < static_cast<quint32>(m_Slots.count()) &&
+                   m_Slots.at(handle.index()).generation == handle.generation() &&
+                   m_Slots.at(handle.index()).valueIndex >= 0;
+        }
+
+        // Returns null if the handle is stale.
+        T* get(const SlotHandle &handle)
+        {
+            return contains(handle) ? &m_Values[m_Slots.at(handle.index()).valueIndex] : Q_NULLPTR;
+        }
+
+        const T* get(const SlotHandle &handle) const
+        {
+            return contains(handle) ? &m_Values.at(m_Slots.at(handle.index()).valueIndex) : Q_NULLPTR;
+        }
+
+        // Every handle given out so far becomes stale.
+        void clear()
+        {
+            foreach ( quint32 slotIndex, m_ValueSlots )
+            {
+                release(slotIndex);
+            }
+
+            m_Values.clear();
+            m_ValueSlots.clear();
+        }
+
+        void reserve(int count)
+        {
+            m_Values.reserve(count);
+            m_ValueSlots.reserve(count);
+            m_Slots.reserve(count);
+        }
+
+        inline int count() const
+        {
+            return m_Values.count();
+        }
+
+        inline bool isEmpty() const
+        {
+            return m_Values.isEmpty();
+        }
+
+        // The handle of the value at the given position in iteration order.
+        SlotHandle handleAt(int valueIndex) const
+        {
+            const quint32 slotIndex = m_ValueSlots.at(valueIndex);
+            return SlotHandle(slotIndex, m_Slots.at(slotIndex).generation);
+        }
+
+        inline iterator begin() { return m_Values.begin(); }
+        inline iterator end() { return m_Values.end(); }
+        inline const_iterator begin() const { return m_Values.constBegin(); }
+        inline const_iterator end() const { return m_Values.constEnd(); }
+        inline const_iterator constBegin() const { return m_Values.constBegin(); }
+        inline const_iterator constEnd() const { return m_Values.constEnd(); }
+
+    private:
+        struct Slot
+        {
+            Slot()
+                : valueIndex(-1), generation(1)
+            {
+            }
+
+            int valueIndex;     // -1 if free
+            quint32 generation; // Never 0, so that null handles never match
+        };
+
+        void release(quint32 slotIndex)
+        {
+            Slot &slot = m_Slots[slotIndex];
+            slot.valueIndex = -1;
+
+            if ( ++slot.generation == 0 )
+            {
+                slot.generation = 1;
+            }
+
+            m_FreeSlots.append(slotIndex);
+        }
+
+        QVector<T>          m_Values;
+        QVector<quint32>    m_ValueSlots;   // Slot index of each value
+        QVector<Slot>       m_Slots;
+        QVector<quint32>    m_FreeSlots;
+    };
+}
+
+#endif // SLOTMAP_H
@@ -3,6 +3,7 @@
 
 #include "renderer_global.h"
 #include "vertexformat.h"
+#include "shaderdefs.h"
 
 namespace Renderer
 {
@@ -16,6 +17,11 @@ namespace Renderer
         // Maximum number of items supported in a batch.
         // Return 1 if the shader doesn't support batching.
         virtual int maxBatchedItems() const = 0;
+
+        virtual ShaderDefs::MatrixStorage matrixStorage() const
+        {
+            return ShaderDefs::UniformBlockMatrixStorage;
+        }
     };
 }
 
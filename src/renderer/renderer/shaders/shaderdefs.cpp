@@ -4,6 +4,7 @@ namespace Renderer
 {
     const char* ShaderDefs::GLOBAL_UNIFORM_BLOCK_NAME = "GlobalUniformBlock";
     const char* ShaderDefs::LOCAL_UNIFORM_BLOCK_NAME = "LocalUniformBlock";
+    const char* ShaderDefs::MATRIX_BUFFER_SAMPLER_NAME = "modelToWorldMatrices";
 
     ShaderDefs::VertexFormatUpperBound ShaderDefs::shaderMaxVertexFormat(ShaderTechnique technique)
     {
@@ -24,6 +25,11 @@ namespace Renderer
                 return VertexFormatUpperBound(4, 3, 4, 0);
             }
 
+            case LitTextureArray3D:
+            {
+                return VertexFormatUpperBound(4, 3, 4, 3);
+            }
+
             default:
             {
                 Q_ASSERT_X(false, Q_FUNC_INFO, "No vertex format specified for this shader technique!");
@@ -24,6 +24,15 @@ namespace Renderer
             ColorAttribute              = 2,
             TextureCoordinateAttribute  = 3,
 
+            // Integer index of the item's matrix, for shaders
+            // which use BufferTextureMatrixStorage.
+            ObjectIdAttribute           = 4,
+
+            // Per-instance colour for instanced draws, which the vertex
+            // colour is multiplied by. Otherwise this array is disabled
+            // and the attribute's current value is white.
+            InstanceColorAttribute      = 5,
+
             VertexAttributeLocationCount
         };
         Q_ENUM(VertexArrayAttribute)
@@ -36,6 +45,10 @@ namespace Renderer
             UnlitTextured3D,
             LitTextured3D,
             UnlitPerVertexColor3D,
+
+            // Like LitTextured3D, but the main texture is a 2D array texture.
+            // The third texture co-ordinate component holds the layer.
+            LitTextureArray3D,
         };
         Q_ENUM(ShaderTechnique)
 
@@ -46,12 +59,30 @@ namespace Renderer
         };
         Q_ENUM(UniformBlockBindingPoint)
 
+        // Where batched shaders read each item's model to world matrix from.
+        enum MatrixStorage
+        {
+            // An array of matrices in the local uniform block. Uniform blocks are small,
+            // so only a few items can be batched together. The item's index is stored in
+            // the last position component.
+            UniformBlockMatrixStorage,
+
+            // A buffer texture holding four RGBA32F texels per matrix, bound to the
+            // MatrixBufferTexture unit. This can hold thousands of matrices. The item's
+            // index is passed in ObjectIdAttribute.
+            BufferTextureMatrixStorage,
+        };
+        Q_ENUM(MatrixStorage)
+
         // Canonical texture units for different purposes.
         enum TextureUnit
         {
             MainTexture         = 0,
             SecondaryTexture    = 1,
             NormalMap           = 2,
+
+            // Reserved for batch matrices; materials should not use this.
+            MatrixBufferTexture = 3,
         };
         Q_ENUM(TextureUnit)
 
@@ -67,6 +98,7 @@ namespace Renderer
 
         static const char* GLOBAL_UNIFORM_BLOCK_NAME;
         static const char* LOCAL_UNIFORM_BLOCK_NAME;
+        static const char* MATRIX_BUFFER_SAMPLER_NAME;
     };
 }
 
@@ -0,0 +1,215 @@
+#include <QString>
+#include <QtTest>
+#include <QVector3D>
+#include "model/math/boundingbox.h"
+#include "model/math/ray3d.h"
+#include "model/scene/scene.h"
+#include "model/genericbrush/genericbrush.h"
+#include "model/factories/genericbrushfactory.h"
+
+using namespace Model;
+
+namespace
+{
+    // Reparenting goes through rotation vectors, so the transforms pick up rounding error.
+    bool fuzzyEqual(const BoundingBox &a, const BoundingBox &b)
+    {
+        return !a.isNull() && !b.isNull()
+                && (a.min() - b.min()).length() < 0.001f
+                && (a.max() - b.max()).length() < 0.001f;
+    }
+}
+
+class TestBoundingBox : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBoundingBox();
+
+private Q_SLOTS:
+    void testNullBox();
+    void testUnite();
+    void testIntersectsBox();
+    void testIntersectsRay();
+    void testTransformed();
+    void testBrushBounds();
+    void testHierarchyBounds();
+    void testReparentBounds();
+};
+
+TestBoundingBox::TestBoundingBox()
+{
+}
+
+void TestBoundingBox::testNullBox()
+{
+    BoundingBox box;
+    QVERIFY(box.isNull());
+    QVERIFY(!box.contains(QVector3D()));
+    QVERIFY(!box.intersects(BoundingBox(QVector3D(-1,-1,-1), QVector3D(1,1,1))));
+    QVERIFY(!box.intersects(Ray3D(QVector3D(), QVector3D(1,0,0))));
+    QVERIFY(box.transformed(QMatrix4x4()).isNull());
+    QCOMPARE(box, BoundingBox::fromPoints(QVector<QVector3D>()));
+}
+
+void TestBoundingBox::testUnite()
+{
+    BoundingBox box;
+    box.unite(QVector3D(1, 2, 3));
+    QVERIFY(!box.isNull());
+    QCOMPARE(box.min(), QVector3D(1, 2, 3));
+    QCOMPARE(box.max(), QVector3D(1, 2, 3));
+
+    box.unite(QVector3D(-1, 5, 0));
+    QCOMPARE(box.min(), QVector3D(-1, 2, 0));
+    QCOMPARE(box.max(), QVector3D(1, 5, 3));
+
+    // Uniting with a null box does nothing.
+    QCOMPARE(box.united(BoundingBox()), box);
+    QCOMPARE(BoundingBox().united(box), box);
+
+    const BoundingBox other(QVector3D(0, 0, 10), QVector3D(-4, 1, 8));
+    QCOMPARE(other.min(), QVector3D(-4, 0, 8));
+    QCOMPARE(box.united(other), BoundingBox(QVector3D(-4, 0, 0), QVector3D(1, 5, 10)));
+}
+
+void TestBoundingBox::testIntersectsBox()
+{
+    const BoundingBox box(QVector3D(0, 0, 0), QVector3D(10, 10, 10));
+
+    QVERIFY(box.intersects(BoundingBox(QVector3D(5, 5, 5), QVector3D(20, 20, 20))));
+    QVERIFY(box.intersects(BoundingBox(QVector3D(10, 10, 10), QVector3D(20, 20, 20))));
+    QVERIFY(box.intersects(BoundingBox(QVector3D(2, 2, 2), QVector3D(3, 3, 3))));
+    QVERIFY(!box.intersects(BoundingBox(QVector3D(11, 0, 0), QVector3D(20, 10, 10))));
+    QVERIFY(!box.intersects(BoundingBox(QVector3D(0, 0, -5), QVector3D(10, 10, -1))));
+
+    QVERIFY(box.contains(QVector3D(0, 5, 10)));
+    QVERIFY(!box.contains(QVector3D(0, 5, 10.5f)));
+}
+
+void TestBoundingBox::testIntersectsRay()
+{
+    const BoundingBox box(QVector3D(0, 0, 0), QVector3D(10, 10, 10));
+    float distance = -1.0f;
+
+    QVERIFY(box.intersects(Ray3D(QVector3D(-5, 5, 5), QVector3D(1, 0, 0)), &distance));
+    QCOMPARE(distance, 5.0f);
+
+    // Starting inside.
+    QVERIFY(box.intersects(Ray3D(QVector3D(5, 5, 5), QVector3D(0, 0, -1)), &distance));
+    QCOMPARE(distance, 0.0f);
+
+    // Pointing away, parallel to a face outside, and passing beside the box.
+    QVERIFY(!box.intersects(Ray3D(QVector3D(-5, 5, 5), QVector3D(-1, 0, 0))));
+    QVERIFY(!box.intersects(Ray3D(QVector3D(-5, 11, 5), QVector3D(1, 0, 0))));
+    QVERIFY(!box.intersects(Ray3D(QVector3D(-5, -5, 5), QVector3D(1, -1, 0))));
+
+    QVERIFY(box.intersects(Ray3D(QVector3D(-5, -5, -5), QVector3D(1, 1, 1)), &distance));
+    QVERIFY(qAbs(distance - QVector3D(5, 5, 5).length()) < 0.001f);
+}
+
+void TestBoundingBox::testTransformed()
+{
+    const BoundingBox box(QVector3D(-1, -2, -3), QVector3D(1, 2, 3));
+
+    QMatrix4x4 translation;
+    translation.translate(10, 20, 30);
+    QCOMPARE(box.transformed(translation), BoundingBox(QVector3D(9, 18, 27), QVector3D(11, 22, 33)));
+
+    // Turning a quarter about Z swaps the X and Y extents.
+    QMatrix4x4 rotation;
+    rotation.rotate(90.0f, 0, 0, 1);
+    const BoundingBox rotated = box.transformed(rotation);
+    QVERIFY((rotated.min() - QVector3D(-2, -1, -3)).length() < 0.001f);
+    QVERIFY((rotated.max() - QVector3D(2, 1, 3)).length() < 0.001f);
+}
+
+void TestBoundingBox::testBrushBounds()
+{
+    Scene scene;
+    GenericBrush* brush = GenericBrushFactory::createBrushFromMinMaxVectors(scene.rootObject(), QVector3D(-8, -8, 0), QVector3D(8, 8, 32));
+
+    QCOMPARE(brush->localBounds(), BoundingBox(QVector3D(-8, -8, 0), QVector3D(8, 8, 32)));
+    QCOMPARE(brush->worldBounds(), brush->localBounds());
+
+    // Moving changes only the world bounds.
+    brush->hierarchy().setPosition(QVector3D(100, 0, 0));
+    QCOMPARE(brush->localBounds(), BoundingBox(QVector3D(-8, -8, 0), QVector3D(8, 8, 32)));
+    QCOMPARE(brush->worldBounds(), BoundingBox(QVector3D(92, -8, 0), QVector3D(108, 8, 32)));
+
+    // Changing the vertices changes both.
+    brush->replaceBrushVertex(0, QVector3D(-16, -8, 0));
+    QCOMPARE(brush->localBounds(), BoundingBox(QVector3D(-16, -8, 0), QVector3D(8, 8, 32)));
+    QCOMPARE(brush->worldBounds(), BoundingBox(QVector3D(84, -8, 0), QVector3D(108, 8, 32)));
+
+    brush->clearBrushVertices();
+    QVERIFY(brush->localBounds().isNull());
+    QVERIFY(brush->worldBounds().isNull());
+}
+
+void TestBoundingBox::testHierarchyBounds()
+{
+    Scene scene;
+    SceneObject* group = scene.createSceneObject<SceneObject>(scene.rootObject());
+    GenericBrush* first = GenericBrushFactory::createBrushFromMinMaxVectors(group, QVector3D(0, 0, 0), QVector3D(16, 16, 16));
+    GenericBrush* second = GenericBrushFactory::createBrushFromMinMaxVectors(group, QVector3D(64, 0, 0), QVector3D(80, 16, 16));
+
+    // The group has no geometry of its own.
+    QVERIFY(group->worldBounds().isNull());
+    QCOMPARE(group->hierarchyBounds(), BoundingBox(QVector3D(0, 0, 0), QVector3D(80, 16, 16)));
+    QCOMPARE(scene.rootObject()->hierarchyBounds(), group->hierarchyBounds());
+
+    // Moving the group moves everything below it.
+    group->hierarchy().setPosition(QVector3D(0, 0, 100));
+    QCOMPARE(first->worldBounds(), BoundingBox(QVector3D(0, 0, 100), QVector3D(16, 16, 116)));
+    QCOMPARE(scene.rootObject()->hierarchyBounds(), BoundingBox(QVector3D(0, 0, 100), QVector3D(80, 16, 116)));
+
+    // Moving a child updates the parents.
+    second->hierarchy().setPosition(QVector3D(0, 32, 0));
+    QCOMPARE(scene.rootObject()->hierarchyBounds(), BoundingBox(QVector3D(0, 0, 100), QVector3D(80, 48, 116)));
+
+    // As does adding and removing children.
+    GenericBrush* third = GenericBrushFactory::createBrushFromMinMaxVectors(group, QVector3D(-32, 0, 0), QVector3D(-16, 16, 16));
+    QCOMPARE(scene.rootObject()->hierarchyBounds(), BoundingBox(QVector3D(-32, 0, 100), QVector3D(80, 48, 116)));
+
+    scene.destroySceneObject(second);
+    QCOMPARE(group->hierarchyBounds(), BoundingBox(QVector3D(-32, 0, 100), QVector3D(16, 16, 116)));
+
+    scene.destroySceneObject(third);
+    scene.destroySceneObject(first);
+    QVERIFY(group->hierarchyBounds().isNull());
+    QVERIFY(scene.rootObject()->hierarchyBounds().isNull());
+}
+
+void TestBoundingBox::testReparentBounds()
+{
+    Scene scene;
+    SceneObject* from = scene.createSceneObject<SceneObject>(scene.rootObject());
+    SceneObject* to = scene.createSceneObject<SceneObject>(scene.rootObject());
+    to->hierarchy().setPosition(QVector3D(100, 0, 0));
+
+    GenericBrush* brush = GenericBrushFactory::createBrushFromMinMaxVectors(from, QVector3D(0, 0, 0), QVector3D(16, 16, 16));
+    GenericBrush* child = GenericBrushFactory::createBrushFromMinMaxVectors(brush, QVector3D(32, 0, 0), QVector3D(48, 16, 16));
+
+    // Compute everything, so that stale values would be returned afterwards.
+    QCOMPARE(from->hierarchyBounds(), BoundingBox(QVector3D(0, 0, 0), QVector3D(48, 16, 16)));
+    QVERIFY(to->hierarchyBounds().isNull());
+    QVERIFY(fuzzyEqual(child->worldBounds(), BoundingBox(QVector3D(32, 0, 0), QVector3D(48, 16, 16))));
+
+    // Reparenting keeps the world transform, but moves the bounds from one parent to the other.
+    brush->setParentObject(to);
+    QVERIFY(from->hierarchyBounds().isNull());
+    QVERIFY(fuzzyEqual(to->hierarchyBounds(), BoundingBox(QVector3D(0, 0, 0), QVector3D(48, 16, 16))));
+    QVERIFY(fuzzyEqual(brush->worldBounds(), BoundingBox(QVector3D(0, 0, 0), QVector3D(16, 16, 16))));
+    QVERIFY(fuzzyEqual(child->worldBounds(), BoundingBox(QVector3D(32, 0, 0), QVector3D(48, 16, 16))));
+
+    // Moving the new parent now moves the reparented subtree.
+    to->hierarchy().setPosition(QVector3D(100, 0, 64));
+    QVERIFY(fuzzyEqual(child->worldBounds(), BoundingBox(QVector3D(32, 0, 64), QVector3D(48, 16, 80))));
+    QVERIFY(fuzzyEqual(scene.rootObject()->hierarchyBounds(), BoundingBox(QVector3D(0, 0, 64), QVector3D(48, 16, 80))));
+}
+
+QTEST_GUILESS_MAIN(TestBoundingBox)
+
+#include "tst_testboundingbox.moc"
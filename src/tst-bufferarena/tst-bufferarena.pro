@@ -0,0 +1,25 @@
+QT       += testlib gui
+
+TARGET = tst_testbufferarena
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += tst_testbufferarena.cpp
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../renderer/release/ -lrenderer
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../renderer/debug/ -lrenderer
+else:unix: LIBS += -L$$OUT_PWD/../renderer/ -lrenderer
+
+INCLUDEPATH += $$PWD/../renderer
+DEPENDPATH += $$PWD/../renderer
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../calliperutil/release/ -lcalliperutil
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../calliperutil/debug/ -lcalliperutil
+else:unix: LIBS += -L$$OUT_PWD/../calliperutil/ -lcalliperutil
+
+INCLUDEPATH += $$PWD/../calliperutil
+DEPENDPATH += $$PWD/../calliperutil
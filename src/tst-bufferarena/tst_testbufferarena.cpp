@@ -0,0 +1,118 @@
+#include <QString>
+#include <QtTest>
+#include "renderer/rendermodel/3-batchlevel/bufferarena.h"
+
+using namespace Renderer;
+
+class TestBufferArena : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBufferArena();
+
+private Q_SLOTS:
+    void testAllocate();
+    void testReuseFreedRange();
+    void testMergeFreedRanges();
+    void testShrinkFromEnd();
+    void testZeroSize();
+};
+
+TestBufferArena::TestBufferArena()
+{
+}
+
+void TestBufferArena::testAllocate()
+{
+    BufferArena arena;
+    QCOMPARE(arena.size(), 0);
+
+    QCOMPARE(arena.allocate(10), 0);
+    QCOMPARE(arena.allocate(5), 10);
+    QCOMPARE(arena.allocate(7), 15);
+    QCOMPARE(arena.size(), 22);
+    QCOMPARE(arena.usedSize(), 22);
+
+    arena.clear();
+    QCOMPARE(arena.size(), 0);
+    QCOMPARE(arena.usedSize(), 0);
+    QCOMPARE(arena.allocate(3), 0);
+}
+
+void TestBufferArena::testReuseFreedRange()
+{
+    BufferArena arena;
+    arena.allocate(10);
+    const int middle = arena.allocate(8);
+    arena.allocate(10);
+
+    arena.free(middle, 8);
+    QCOMPARE(arena.size(), 28);
+    QCOMPARE(arena.usedSize(), 20);
+    QCOMPARE(arena.freeRangeCount(), 1);
+
+    // Too big for the gap, so goes on the end.
+    QCOMPARE(arena.allocate(9), 28);
+
+    // Fits in the gap, leaving the remainder free.
+    QCOMPARE(arena.allocate(6), middle);
+    QCOMPARE(arena.freeRangeCount(), 1);
+    QCOMPARE(arena.allocate(2), middle + 6);
+    QCOMPARE(arena.freeRangeCount(), 0);
+    QCOMPARE(arena.size(), 37);
+}
+
+void TestBufferArena::testMergeFreedRanges()
+{
+    BufferArena arena;
+    const int a = arena.allocate(4);
+    const int b = arena.allocate(4);
+    const int c = arena.allocate(4);
+    arena.allocate(4);
+
+    arena.free(a, 4);
+    arena.free(c, 4);
+    QCOMPARE(arena.freeRangeCount(), 2);
+
+    // Freeing the range between joins all three.
+    arena.free(b, 4);
+    QCOMPARE(arena.freeRangeCount(), 1);
+    QCOMPARE(arena.allocate(12), 0);
+    QCOMPARE(arena.freeRangeCount(), 0);
+    QCOMPARE(arena.size(), 16);
+}
+
+void TestBufferArena::testShrinkFromEnd()
+{
+    BufferArena arena;
+    const int a = arena.allocate(4);
+    const int b = arena.allocate(4);
+    const int c = arena.allocate(4);
+
+    arena.free(b, 4);
+    QCOMPARE(arena.size(), 12);
+
+    // Freeing the last range also gives back the free range before it.
+    arena.free(c, 4);
+    QCOMPARE(arena.size(), 4);
+    QCOMPARE(arena.freeRangeCount(), 0);
+
+    arena.free(a, 4);
+    QCOMPARE(arena.size(), 0);
+    QCOMPARE(arena.usedSize(), 0);
+}
+
+void TestBufferArena::testZeroSize()
+{
+    BufferArena arena;
+    arena.allocate(4);
+    QCOMPARE(arena.allocate(0), 0);
+    arena.free(0, 0);
+    QCOMPARE(arena.size(), 4);
+    QCOMPARE(arena.usedSize(), 4);
+}
+
+QTEST_APPLESS_MAIN(TestBufferArena)
+
+#include "tst_testbufferarena.moc"
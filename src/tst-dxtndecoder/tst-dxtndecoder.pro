@@ -0,0 +1,19 @@
+QT       += testlib
+QT       -= gui
+
+TARGET = tst_testdxtndecoder
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += tst_testdxtndecoder.cpp
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../dep-vtflib/release/ -ldep-vtflib
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../dep-vtflib/debug/ -ldep-vtflib
+else:unix: LIBS += -L$$OUT_PWD/../dep-vtflib/ -ldep-vtflib
+
+INCLUDEPATH += $$PWD/../dep-vtflib
+DEPENDPATH += $$PWD/../dep-vtflib
@@ -0,0 +1,187 @@
+#include <QString>
+#include <QtTest>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include "VTFLib/src/VTFDXTnDecoder.h"
+#include "VTFLib/src/VTFFile.h"
+
+Q_DECLARE_METATYPE(VTFImageFormat)
+Q_DECLARE_METATYPE(VTFLib::DXTnDecoder)
+
+class TestDXTnDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestDXTnDecoder();
+
+private Q_SLOTS:
+    void testBitExact_data();
+    void testBitExact();
+    void benchmarkThroughput_data();
+    void benchmarkThroughput();
+
+private:
+    // Deterministic pseudo-random blocks. Every third block has equal endpoints
+    // so that the DXT1 three colour and DXT5 six alpha modes are exercised.
+    static QByteArray randomBlocks(VTFImageFormat format, quint32 width, quint32 height, quint32 seed)
+    {
+        const int blockSize = format == IMAGE_FORMAT_DXT1 ? 8 : 16;
+        const int colourOffset = format == IMAGE_FORMAT_DXT1 ? 0 : 8;
+        const int blockCount = ((width + 3) / 4) * ((height + 3) / 4);
+
+        QByteArray data(blockCount * blockSize, Qt::Uninitialized);
+        for ( int i = 0; i < data.size(); ++i )
+        {
+            seed = (seed * 1664525u) + 1013904223u;
+            data[i] = static_cast<char>(seed >> 24);
+        }
+
+        for ( int block = 0; block < blockCount; block += 3 )
+        {
+            char* base = data.data() + (block * blockSize);
+            base[colourOffset + 2] = base[colourOffset];
+            base[colourOffset + 3] = base[colourOffset + 1];
+
+            if ( format == IMAGE_FORMAT_DXT5 )
+            {
+                base[1] = base[0];
+            }
+        }
+
+        return data;
+    }
+
+    static void addFormatRows(quint32 width, quint32 height)
+    {
+        static const VTFImageFormat formats[] = { IMAGE_FORMAT_DXT1, IMAGE_FORMAT_DXT3, IMAGE_FORMAT_DXT5 };
+
+        for ( VTFImageFormat format : formats )
+        {
+            for ( int decoder = VTFLib::DXTN_DECODER_SSE2; decoder < VTFLib::DXTN_DECODER_COUNT; ++decoder )
+            {
+                QTest::newRow(QString("%1 %2 %3x%4")
+                              .arg(VTFLib::CVTFFile::ImageFormatName(format))
+                              .arg(VTFLib::DXTnDecoderName(static_cast<VTFLib::DXTnDecoder>(decoder)))
+                              .arg(width)
+                              .arg(height)
+                              .toLatin1().constData())
+                        << format << static_cast<VTFLib::DXTnDecoder>(decoder) << width << height;
+            }
+        }
+    }
+};
+
+TestDXTnDecoder::TestDXTnDecoder()
+{
+}
+
+void TestDXTnDecoder::testBitExact_data()
+{
+    QTest::addColumn<VTFImageFormat>("format");
+    QTest::addColumn<VTFLib::DXTnDecoder>("decoder");
+    QTest::addColumn<quint32>("width");
+    QTest::addColumn<quint32>("height");
+
+    // Mip tails, non-multiple-of-4 edges, odd block counts per row and a full size texture.
+    static const quint32 sizes[][2] =
+    {
+        { 1, 1 }, { 2, 2 }, { 3, 5 }, { 4, 4 }, { 5, 7 },
+        { 8, 4 }, { 12, 4 }, { 13, 9 }, { 260, 132 }, { 1024, 512 }
+    };
+
+    for ( const quint32* size : sizes )
+    {
+        addFormatRows(size[0], size[1]);
+    }
+}
+
+void TestDXTnDecoder::testBitExact()
+{
+    QFETCH(VTFImageFormat, format);
+    QFETCH(VTFLib::DXTnDecoder, decoder);
+    QFETCH(quint32, width);
+    QFETCH(quint32, height);
+
+    if ( !VTFLib::IsDXTnDecoderSupported(decoder) )
+    {
+        QSKIP("Decoder is not supported by this CPU.");
+    }
+
+    const QByteArray source = randomBlocks(format, width, height, width * 31 + height);
+
+    // Pre-fill with a sentinel so that writes outside the image are detected too.
+    QByteArray reference(width * height * 4, static_cast<char>(0xCD));
+    QByteArray result(width * height * 4, static_cast<char>(0xCD));
+
+    const vlByte* src = reinterpret_cast<const vlByte*>(source.constData());
+    QVERIFY(VTFLib::DecompressDXTn(src, reinterpret_cast<vlByte*>(reference.data()), width, height,
+                                   format, VTFLib::DXTN_DECODER_SCALAR));
+    QVERIFY(VTFLib::DecompressDXTn(src, reinterpret_cast<vlByte*>(result.data()), width, height,
+                                   format, decoder));
+
+    QVERIFY2(result == reference, "Decoded output should be identical to the scalar decoder.");
+}
+
+void TestDXTnDecoder::benchmarkThroughput_data()
+{
+    QTest::addColumn<VTFImageFormat>("format");
+    QTest::addColumn<VTFLib::DXTnDecoder>("decoder");
+    QTest::addColumn<quint32>("width");
+    QTest::addColumn<quint32>("height");
+
+    static const VTFImageFormat formats[] = { IMAGE_FORMAT_DXT1, IMAGE_FORMAT_DXT3, IMAGE_FORMAT_DXT5 };
+
+    for ( VTFImageFormat format : formats )
+    {
+        for ( int decoder = VTFLib::DXTN_DECODER_SCALAR; decoder < VTFLib::DXTN_DECODER_COUNT; ++decoder )
+        {
+            QTest::newRow(QString("%1 %2")
+                          .arg(VTFLib::CVTFFile::ImageFormatName(format))
+                          .arg(VTFLib::DXTnDecoderName(static_cast<VTFLib::DXTnDecoder>(decoder)))
+                          .toLatin1().constData())
+                    << format << static_cast<VTFLib::DXTnDecoder>(decoder) << 2048u << 2048u;
+        }
+    }
+}
+
+void TestDXTnDecoder::benchmarkThroughput()
+{
+    QFETCH(VTFImageFormat, format);
+    QFETCH(VTFLib::DXTnDecoder, decoder);
+    QFETCH(quint32, width);
+    QFETCH(quint32, height);
+
+    if ( !VTFLib::IsDXTnDecoderSupported(decoder) )
+    {
+        QSKIP("Decoder is not supported by this CPU.");
+    }
+
+    const QByteArray source = randomBlocks(format, width, height, 1);
+    QByteArray result(width * height * 4, Qt::Uninitialized);
+
+    const vlByte* src = reinterpret_cast<const vlByte*>(source.constData());
+    vlByte* dst = reinterpret_cast<vlByte*>(result.data());
+
+    // Throughput is reported in decoded bytes, across every pass QBENCHMARK makes.
+    QElapsedTimer timer;
+    qint64 bytes = 0;
+    timer.start();
+
+    QBENCHMARK
+    {
+        VTFLib::DecompressDXTn(src, dst, width, height, format, decoder);
+        bytes += result.size();
+    }
+
+    const qint64 elapsed = timer.nsecsElapsed();
+    if ( elapsed > 0 )
+    {
+        QTest::setBenchmarkResult((static_cast<qreal>(bytes) * 1000000000.0) / static_cast<qreal>(elapsed),
+                                  QTest::BytesPerSecond);
+    }
+}
+
+QTEST_APPLESS_MAIN(TestDXTnDecoder)
+
+#include "tst_testdxtndecoder.moc"
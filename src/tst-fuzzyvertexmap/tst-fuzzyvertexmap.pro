@@ -0,0 +1,46 @@
+QT       += testlib gui
+
+TARGET = tst_testfuzzyvertexmap
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += tst_testfuzzyvertexmap.cpp
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../model/release/ -lmodel
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../model/debug/ -lmodel
+else:unix: LIBS += -L$$OUT_PWD/../model/ -lmodel
+
+INCLUDEPATH += $$PWD/../model
+DEPENDPATH += $$PWD/../model
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../renderer/release/ -lrenderer
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../renderer/debug/ -lrenderer
+else:unix: LIBS += -L$$OUT_PWD/../renderer/ -lrenderer
+
+INCLUDEPATH += $$PWD/../renderer
+DEPENDPATH += $$PWD/../renderer
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../calliperutil/release/ -lcalliperutil
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../calliperutil/debug/ -lcalliperutil
+else:unix: LIBS += -L$$OUT_PWD/../calliperutil/ -lcalliperutil
+
+INCLUDEPATH += $$PWD/../calliperutil
+DEPENDPATH += $$PWD/../calliperutil
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../file-formats/release/ -lfile-formats
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../file-formats/debug/ -lfile-formats
+else:unix: LIBS += -L$$OUT_PWD/../file-formats/ -lfile-formats
+
+INCLUDEPATH += $$PWD/../file-formats
+DEPENDPATH += $$PWD/../file-formats
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../dep-vtflib/release/ -ldep-vtflib
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../dep-vtflib/debug/ -ldep-vtflib
+else:unix: LIBS += -L$$OUT_PWD/../dep-vtflib/ -ldep-vtflib
+
+INCLUDEPATH += $$PWD/../dep-vtflib
+DEPENDPATH += $$PWD/../dep-vtflib
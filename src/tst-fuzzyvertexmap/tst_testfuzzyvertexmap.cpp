@@ -0,0 +1,398 @@
+#include <QString>
+#include <QtTest>
+#include <QVector3D>
+#include <QtMath>
+#include "model/math/fuzzyvertexmap.h"
+#include "model/math/modelmath.h"
+#include "model/math/texturedwinding.h"
+
+using namespace Model;
+
+namespace
+{
+    // The linear scan that FuzzyVertexMap used before it kept a grid,
+    // kept here as a reference for results and for benchmarking.
+    class ReferenceVertexMap
+    {
+    public:
+        explicit ReferenceVertexMap(float tolerance) : m_flTolerance(tolerance)
+        {
+        }
+
+        int mapToIndex(const QVector3D &vec)
+        {
+            for ( int i = 0; i < m_Vertices.count(); ++i )
+            {
+                const QVector3D& other = m_Vertices.at(i);
+                if ( qFabs(vec.x() - other.x()) < m_flTolerance &&
+                     qFabs(vec.y() - other.y()) < m_flTolerance &&
+                     qFabs(vec.z() - other.z()) < m_flTolerance )
+                {
+                    return i;
+                }
+            }
+
+            m_Vertices.append(vec);
+            return m_Vertices.count() - 1;
+        }
+
+        int count() const
+        {
+            return m_Vertices.count();
+        }
+
+    private:
+        QVector<QVector3D> m_Vertices;
+        float m_flTolerance;
+    };
+
+    // Deterministic so that benchmark runs are comparable.
+    class Random
+    {
+    public:
+        explicit Random(quint32 seed) : m_iState(seed)
+        {
+        }
+
+        quint32 next()
+        {
+            m_iState = (m_iState * 1664525u) + 1013904223u;
+            return m_iState >> 8;
+        }
+
+        // In [-1, 1].
+        float nextSigned()
+        {
+            return (static_cast<float>(next() % 2000001) / 1000000.0f) - 1.0f;
+        }
+
+    private:
+        quint32 m_iState;
+    };
+
+    // Corners of a grid of blocks, as in a map built on the Hammer grid. Each block
+    // contributes its own copy of its eight corners, nudged by less than half the
+    // tolerance, so neighbouring blocks weld to the same vertices.
+    QVector<QVector3D> blockGridPoints(int blocksPerSide, float blockSize, float jitter, quint32 seed)
+    {
+        Random random(seed);
+        QVector<QVector3D> points;
+        points.reserve(blocksPerSide * blocksPerSide * blocksPerSide * 8);
+
+        for ( int x = 0; x < blocksPerSide; ++x )
+        {
+            for ( int y = 0; y < blocksPerSide; ++y )
+            {
+                for ( int z = 0; z < blocksPerSide; ++z )
+                {
+                    for ( int corner = 0; corner < 8; ++corner )
+                    {
+                        const QVector3D position((x + (corner & 1)) * blockSize,
+                                                 (y + ((corner >> 1) & 1)) * blockSize,
+                                                 (z + ((corner >> 2) & 1)) * blockSize);
+
+                        const QVector3D offset(random.nextSigned(), random.nextSigned(), random.nextSigned());
+                        points.append(position + (jitter * offset));
+                    }
+                }
+            }
+        }
+
+        return points;
+    }
+
+    // Faces of a convex brush approximating a sphere, with their normals spread
+    // evenly over the sphere.
+    QList<TexturedWinding*> sphereBrushWindings(int faceCount, float radius)
+    {
+        QList<TexturedWinding*> windings;
+        const float goldenAngle = static_cast<float>(M_PI) * (3.0f - qSqrt(5.0f));
+
+        for ( int i = 0; i < faceCount; ++i )
+        {
+            const float z = 1.0f - ((2.0f * (i + 0.5f)) / faceCount);
+            const float r = qSqrt(1.0f - (z * z));
+            const float theta = goldenAngle * i;
+
+            const QVector3D normal(r * qCos(theta), r * qSin(theta), z);
+            windings.append(new TexturedWinding(Plane3D(normal, radius), 0));
+        }
+
+        ModelMath::clipWindingsWithEachOther<TexturedWinding>(windings);
+        return windings;
+    }
+}
+
+class TestFuzzyVertexMap : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFuzzyVertexMap();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testTolerance_data();
+    void testTolerance();
+    void testCellBoundaries();
+    void testEarliestMatch();
+    void testNoTolerance();
+    void testSetTolerance();
+    void testMatchesReference_data();
+    void testMatchesReference();
+    void testBrushWindings();
+    void benchmarkReferenceBrush();
+    void benchmarkBrush();
+    void benchmarkReferenceMap();
+    void benchmarkMap();
+
+private:
+    QList<TexturedWinding*> m_BrushWindings;
+    QVector<QVector3D> m_MapPoints;
+};
+
+TestFuzzyVertexMap::TestFuzzyVertexMap()
+{
+}
+
+void TestFuzzyVertexMap::initTestCase()
+{
+    m_BrushWindings = sphereBrushWindings(400, 512.0f);
+
+    // 24^3 blocks gives a little over 110,000 points, about the size of a large map.
+    m_MapPoints = blockGridPoints(24, 64.0f, 0.004f, 0xC0FFEEu);
+}
+
+void TestFuzzyVertexMap::cleanupTestCase()
+{
+    qDeleteAll(m_BrushWindings);
+    m_BrushWindings.clear();
+}
+
+void TestFuzzyVertexMap::testTolerance_data()
+{
+    QTest::addColumn<QVector3D>("first");
+    QTest::addColumn<QVector3D>("second");
+    QTest::addColumn<bool>("merged");
+
+    QTest::newRow("Identical") << QVector3D(1, 2, 3) << QVector3D(1, 2, 3) << true;
+    QTest::newRow("Within tolerance") << QVector3D(1, 2, 3) << QVector3D(1.005f, 1.995f, 3.009f) << true;
+    QTest::newRow("Outside tolerance on one axis") << QVector3D(1, 2, 3) << QVector3D(1, 2, 3.02f) << false;
+    QTest::newRow("Within tolerance across zero") << QVector3D(-0.004f, 0, 0.004f) << QVector3D(0.004f, 0, -0.004f) << true;
+    QTest::newRow("Large coordinates") << QVector3D(16384, -16384, 16384) << QVector3D(16384, -16384, 16384.001f) << true;
+}
+
+void TestFuzzyVertexMap::testTolerance()
+{
+    QFETCH(QVector3D, first);
+    QFETCH(QVector3D, second);
+    QFETCH(bool, merged);
+
+    FuzzyVertexMap map;
+    QCOMPARE(map.mapToIndex(first), 0);
+    QCOMPARE(map.mapToIndex(second), merged ? 0 : 1);
+    QCOMPARE(map.count(), merged ? 1 : 2);
+}
+
+void TestFuzzyVertexMap::testCellBoundaries()
+{
+    // Vertices either side of a cell boundary must still be found, on every axis.
+    FuzzyVertexMap map;
+    map.setTolerance(1.0f);
+
+    const QVector3D base(9.9f, 19.9f, -0.1f);
+    QCOMPARE(map.mapToIndex(base), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(10.5f, 19.9f, -0.1f)), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(9.9f, 20.5f, -0.1f)), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(9.9f, 19.9f, 0.5f)), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(10.5f, 20.5f, 0.5f)), 0);
+    QCOMPARE(map.count(), 1);
+
+    // More than the tolerance away is not close enough.
+    QCOMPARE(map.mapToIndex(QVector3D(11.0f, 19.9f, -0.1f)), 1);
+    QCOMPARE(map.count(), 2);
+}
+
+void TestFuzzyVertexMap::testEarliestMatch()
+{
+    FuzzyVertexMap map;
+    map.setTolerance(1.0f);
+
+    QCOMPARE(map.mapToIndex(QVector3D(0, 0, 0)), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(1.5f, 0, 0)), 1);
+
+    // Close enough to both, so the one added first wins.
+    QCOMPARE(map.mapToIndex(QVector3D(0.75f, 0, 0)), 0);
+
+    // Only close enough to the second.
+    QCOMPARE(map.mapToIndex(QVector3D(1.2f, 0, 0)), 1);
+    QCOMPARE(map.count(), 2);
+
+    const QList<QVector3D> vertices = map.vertexList();
+    QCOMPARE(vertices.count(), 2);
+    QCOMPARE(vertices.at(0), QVector3D(0, 0, 0));
+    QCOMPARE(vertices.at(1), QVector3D(1.5f, 0, 0));
+}
+
+void TestFuzzyVertexMap::testNoTolerance()
+{
+    FuzzyVertexMap map;
+    map.setTolerance(0.0f);
+
+    QCOMPARE(map.mapToIndex(QVector3D(1, 2, 3)), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(1, 2, 3)), 1);
+    QCOMPARE(map.count(), 2);
+    QCOMPARE(map.vertexList().count(), 2);
+}
+
+void TestFuzzyVertexMap::testSetTolerance()
+{
+    FuzzyVertexMap map;
+    QCOMPARE(map.mapToIndex(QVector3D(0, 0, 0)), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(0.5f, 0, 0)), 1);
+
+    // Existing vertices are not merged, but must be found with the new tolerance.
+    map.setTolerance(2.0f);
+    QCOMPARE(map.count(), 2);
+    QCOMPARE(map.mapToIndex(QVector3D(1.9f, 0, 0)), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(2.2f, 0, 0)), 1);
+    QCOMPARE(map.count(), 2);
+
+    map.clear();
+    QCOMPARE(map.count(), 0);
+    QCOMPARE(map.mapToIndex(QVector3D(5, 5, 5)), 0);
+}
+
+void TestFuzzyVertexMap::testMatchesReference_data()
+{
+    QTest::addColumn<float>("tolerance");
+    QTest::addColumn<float>("jitter");
+
+    QTest::newRow("Default tolerance") << 0.01f << 0.004f;
+    QTest::newRow("Jitter larger than tolerance") << 0.01f << 0.03f;
+    QTest::newRow("Coarse tolerance") << 16.0f << 12.0f;
+    QTest::newRow("No tolerance") << 0.0f << 0.004f;
+}
+
+void TestFuzzyVertexMap::testMatchesReference()
+{
+    QFETCH(float, tolerance);
+    QFETCH(float, jitter);
+
+    const QVector3D offset(-200.0f, 37.5f, -0.25f);
+    const QVector<QVector3D> points = blockGridPoints(6, 32.0f, jitter, 12345u);
+
+    FuzzyVertexMap map;
+    map.setTolerance(tolerance);
+    ReferenceVertexMap reference(tolerance);
+
+    for ( int i = 0; i < points.count(); ++i )
+    {
+        const QVector3D point = points.at(i) + offset;
+        QCOMPARE(map.mapToIndex(point), reference.mapToIndex(point));
+    }
+
+    QCOMPARE(map.count(), reference.count());
+}
+
+void TestFuzzyVertexMap::testBrushWindings()
+{
+    ReferenceVertexMap reference(0.01f);
+    int windingVertexCount = 0;
+
+    for ( int i = 0; i < m_BrushWindings.count(); ++i )
+    {
+        TexturedWinding* winding = m_BrushWindings.at(i);
+        for ( TexturedWinding::ConstVertexIterator it = winding->verticesBegin(); it != winding->verticesEnd(); ++it )
+        {
+            reference.mapToIndex(it->position());
+            ++windingVertexCount;
+        }
+    }
+
+    QVERIFY(windingVertexCount > 0);
+
+    const QList<QVector3D> vertices = ModelMath::windingsToVertices<TexturedWinding>(m_BrushWindings);
+    QCOMPARE(vertices.count(), reference.count());
+    QVERIFY(vertices.count() < windingVertexCount);
+}
+
+void TestFuzzyVertexMap::benchmarkReferenceBrush()
+{
+    int count = 0;
+
+    QBENCHMARK
+    {
+        ReferenceVertexMap reference(0.01f);
+        for ( int i = 0; i < m_BrushWindings.count(); ++i )
+        {
+            TexturedWinding* winding = m_BrushWindings.at(i);
+            for ( TexturedWinding::ConstVertexIterator it = winding->verticesBegin(); it != winding->verticesEnd(); ++it )
+            {
+                reference.mapToIndex(it->position());
+            }
+        }
+
+        count += reference.count();
+    }
+
+    Q_UNUSED(count);
+}
+
+void TestFuzzyVertexMap::benchmarkBrush()
+{
+    int count = 0;
+
+    QBENCHMARK
+    {
+        count += ModelMath::windingsToVertices<TexturedWinding>(m_BrushWindings).count();
+    }
+
+    Q_UNUSED(count);
+}
+
+void TestFuzzyVertexMap::benchmarkReferenceMap()
+{
+    // The whole map takes minutes with a linear scan, so only weld a slice of it.
+    const int pointCount = qMin(m_MapPoints.count(), 8192);
+    int count = 0;
+
+    QBENCHMARK
+    {
+        ReferenceVertexMap reference(0.01f);
+        for ( int i = 0; i < pointCount; ++i )
+        {
+            reference.mapToIndex(m_MapPoints.at(i));
+        }
+
+        count += reference.count();
+    }
+
+    Q_UNUSED(count);
+}
+
+void TestFuzzyVertexMap::benchmarkMap()
+{
+    int count = 0;
+
+    QBENCHMARK
+    {
+        FuzzyVertexMap map;
+        map.reserve(m_MapPoints.count() / 8);
+
+        foreach ( const QVector3D& point, m_MapPoints )
+        {
+            map.mapToIndex(point);
+        }
+
+        count = map.count();
+    }
+
+    // Every block shares its corners with its neighbours.
+    QCOMPARE(count, 25 * 25 * 25);
+}
+
+QTEST_APPLESS_MAIN(TestFuzzyVertexMap)
+
+#include "tst_testfuzzyvertexmap.moc"
@@ -0,0 +1,449 @@
+#include <QString>
+#include <QtTest>
+#include <QSurfaceFormat>
+#include "renderer/rendermodel/slotmap.h"
+#include "renderer/rendermodel/3-batchlevel/matrixbatch.h"
+#include "renderer/rendermodel/0-modellevel/rendermodel.h"
+#include "renderer/global/mainrendercontext.h"
+#include "renderer/opengl/scopedcurrentcontext.h"
+#include "renderer/geometry/geometrybuilder.h"
+
+using namespace Renderer;
+
+namespace
+{
+    const int BENCHMARK_OBJECT_COUNT = 100000;
+
+    class TestShader : public OpenGLShaderProgram
+    {
+    public:
+        TestShader(quint16 id, const VertexFormat &format, QObject* parent = 0)
+            : OpenGLShaderProgram(id, "TestShader", parent),
+              m_VertexFormat(format)
+        {
+        }
+
+        virtual void construct() override
+        {
+        }
+
+        virtual VertexFormat vertexFormat() const override
+        {
+            return m_VertexFormat;
+        }
+
+        virtual int maxBatchedItems() const override
+        {
+            return 16384;
+        }
+
+        virtual ShaderDefs::MatrixStorage matrixStorage() const override
+        {
+            return ShaderDefs::BufferTextureMatrixStorage;
+        }
+
+    private:
+        VertexFormat m_VertexFormat;
+    };
+
+    // Shader 1 is for per-vertex colours, and shader 2 is for textures.
+
+    class TestShaderFunctor : public IShaderRetrievalFunctor
+    {
+    public:
+        TestShaderFunctor()
+            : m_ColorShader(1, VertexFormat(4, 0, 4, 0)),
+              m_TextureShader(2, VertexFormat(4, 0, 4, 2))
+        {
+        }
+
+        virtual OpenGLShaderProgram* operator ()(quint16 shaderId) const override
+        {
+            const TestShader* shader = shaderId == 2 ? &m_TextureShader : &m_ColorShader;
+            return const_cast<TestShader*>(shader);
+        }
+
+    private:
+        TestShader m_ColorShader;
+        TestShader m_TextureShader;
+    };
+
+    class TestTextureFunctor : public ITextureRetrievalFunctor
+    {
+    public:
+        virtual OpenGLTexturePointer operator ()(quint32 textureId) const override
+        {
+            Q_UNUSED(textureId);
+            return OpenGLTexturePointer();
+        }
+    };
+
+    // Material 1 uses per-vertex colours. Materials 2 and 3 are textured,
+    // and use different textures. Any other ID gets material 1.
+    class TestMaterialFunctor : public IMaterialRetrievalFunctor
+    {
+    public:
+        TestMaterialFunctor()
+        {
+            RenderMaterialPointer colorMaterial = RenderMaterialPointer::create(1, "color");
+            colorMaterial->setShaderTechnique(ShaderDefs::UnlitPerVertexColor3D);
+            m_Materials.insert(1, colorMaterial);
+
+            for ( quint32 id = 2; id <= 3; id++ )
+            {
+                RenderMaterialPointer texturedMaterial = RenderMaterialPointer::create(id, "textured");
+                texturedMaterial->setShaderTechnique(ShaderDefs::UnlitTextured3D);
+                texturedMaterial->addTexture(ShaderDefs::MainTexture, id);
+                m_Materials.insert(id, texturedMaterial);
+            }
+        }
+
+        virtual RenderMaterialPointer operator ()(quint32 materialId) const override
+        {
+            return m_Materials.value(materialId, m_Materials.value(1));
+        }
+
+    private:
+        QHash<quint32, RenderMaterialPointer> m_Materials;
+    };
+
+    class TestShaderPalette : public BaseShaderPalette
+    {
+    public:
+        virtual quint16 shader(ShaderDefs::ShaderTechnique technique) const override
+        {
+            return technique == ShaderDefs::UnlitPerVertexColor3D ? 1 : 2;
+        }
+    };
+
+    void buildQuad(GeometryBuilder &builder, const QColor &color = QColor(Qt::white),
+                   const QVector2D &texCoordOffset = QVector2D())
+    {
+        GeometrySection* section = builder.createNewSection();
+
+        section->addPosition(QVector3D(0, 0, 0));
+        section->addPosition(QVector3D(1, 0, 0));
+        section->addPosition(QVector3D(1, 1, 0));
+        section->addPosition(QVector3D(0, 1, 0));
+
+        for ( int i = 0; i < 4; i++ )
+        {
+            section->addColor(color);
+        }
+
+        section->addTextureCoordinate(texCoordOffset + QVector2D(0, 0));
+        section->addTextureCoordinate(texCoordOffset + QVector2D(1, 0));
+        section->addTextureCoordinate(texCoordOffset + QVector2D(1, 1));
+        section->addTextureCoordinate(texCoordOffset + QVector2D(0, 1));
+
+        section->addIndexTriangle(0, 1, 2);
+        section->addIndexTriangle(0, 2, 3);
+    }
+
+    QMatrix4x4 translation(const QVector3D &offset)
+    {
+        QMatrix4x4 matrix;
+        matrix.translate(offset);
+        return matrix;
+    }
+}
+
+class TestRenderModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRenderModel();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testSlotMapInsertRemove();
+    void testSlotMapStaleHandle();
+    void testSlotMapClear();
+    void testMatrixBatchItems();
+    void testUpdateObjectInPlace();
+    void testUpdateObjectChangesBatch();
+
+    void benchmarkUpdateObjects();
+
+private:
+    void populate(RenderModel &renderModel, const GeometryBuilder &builder);
+    void updateQuad(RenderModel &renderModel, quint32 objectId, quint32 materialId, const QMatrix4x4 &matrix,
+                    const QColor &color = QColor(Qt::white), const QVector2D &texCoordOffset = QVector2D());
+
+    bool m_bHaveContext;
+    TestShaderFunctor* m_pShaderFunctor;
+    TestTextureFunctor m_TextureFunctor;
+    TestMaterialFunctor m_MaterialFunctor;
+    TestShaderPalette m_ShaderPalette;
+};
+
+TestRenderModel::TestRenderModel()
+    : m_bHaveContext(false),
+      m_pShaderFunctor(Q_NULLPTR)
+{
+}
+
+void TestRenderModel::initTestCase()
+{
+    QSurfaceFormat format;
+    format.setMajorVersion(4);
+    format.setMinorVersion(1);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setRenderableType(QSurfaceFormat::OpenGL);
+    QSurfaceFormat::setDefaultFormat(format);
+
+    MainRenderContext::globalInitialise();
+    m_bHaveContext = MainRenderContext::globalInstance()->create();
+
+    if ( m_bHaveContext )
+    {
+        ScopedCurrentContext scopedContext;
+        Q_UNUSED(scopedContext);
+        m_pShaderFunctor = new TestShaderFunctor();
+    }
+}
+
+void TestRenderModel::cleanupTestCase()
+{
+    if ( m_pShaderFunctor )
+    {
+        ScopedCurrentContext scopedContext;
+        Q_UNUSED(scopedContext);
+        delete m_pShaderFunctor;
+        m_pShaderFunctor = Q_NULLPTR;
+    }
+
+    MainRenderContext::globalShutdown();
+}
+
+void TestRenderModel::testSlotMapInsertRemove()
+{
+    SlotMap<int> map;
+    QVERIFY(map.isEmpty());
+
+    SlotHandle a = map.insert(1);
+    SlotHandle b = map.insert(2);
+    SlotHandle c = map.insert(3);
+    QCOMPARE(map.count(), 3);
+    QCOMPARE(*map.get(b), 2);
+
+    // The last value is moved into the removed one's place.
+    QVERIFY(map.remove(a));
+    QCOMPARE(map.count(), 2);
+    QVERIFY(!map.contains(a));
+    QCOMPARE(*map.get(b), 2);
+    QCOMPARE(*map.get(c), 3);
+    QCOMPARE(*map.constBegin(), 3);
+    QVERIFY(map.handleAt(0) == c);
+
+    QVERIFY(!map.remove(a));
+    QVERIFY(SlotHandle().isNull());
+    QVERIFY(!map.contains(SlotHandle()));
+}
+
+void TestRenderModel::testSlotMapStaleHandle()
+{
+    SlotMap<int> map;
+    SlotHandle first = map.insert(1);
+    map.remove(first);
+
+    // The slot is reused, but the old handle mustn't find the new value.
+    SlotHandle second = map.insert(2);
+    QCOMPARE(second.index(), first.index());
+    QVERIFY(second != first);
+    QVERIFY(map.get(first) == Q_NULLPTR);
+    QCOMPARE(*map.get(second), 2);
+}
+
+void TestRenderModel::testSlotMapClear()
+{
+    SlotMap<int> map;
+    SlotHandle a = map.insert(1);
+    SlotHandle b = map.insert(2);
+
+    map.clear();
+    QVERIFY(map.isEmpty());
+    QVERIFY(!map.contains(a));
+    QVERIFY(!map.contains(b));
+
+    SlotHandle c = map.insert(3);
+    QVERIFY(c != a && c != b);
+    QCOMPARE(*map.get(c), 3);
+}
+
+void TestRenderModel::testMatrixBatchItems()
+{
+    MatrixBatch batch((QMatrix4x4()));
+    batch.setDirty(false);
+
+    SlotHandle a = batch.createItem();
+    SlotHandle b = batch.createItem();
+    QVERIFY(batch.isDirty());
+    QCOMPARE(batch.itemCount(), 2);
+
+    batch.item(b)->m_Positions.append(1.0f);
+    batch.setDirty(false);
+
+    batch.removeItem(a);
+    QVERIFY(batch.isDirty());
+    QVERIFY(!batch.containsItem(a));
+    QCOMPARE(batch.item(b)->m_Positions.count(), 1);
+
+    batch.setDirty(false);
+    batch.removeItem(a);
+    QVERIFY(!batch.isDirty());
+}
+
+void TestRenderModel::updateQuad(RenderModel &renderModel, quint32 objectId, quint32 materialId, const QMatrix4x4 &matrix,
+                                 const QColor &color, const QVector2D &texCoordOffset)
+{
+    RenderFunctorGroup functors(m_pShaderFunctor, &m_TextureFunctor, &m_MaterialFunctor);
+    GeometryBuilder builder(functors, &m_ShaderPalette, materialId, matrix);
+    buildQuad(builder, color, texCoordOffset);
+    renderModel.updateObject(RendererInputObjectParams(objectId, 0, builder));
+}
+
+void TestRenderModel::testUpdateObjectInPlace()
+{
+    if ( !m_bHaveContext )
+    {
+        QSKIP("No OpenGL 4.1 context is available.");
+    }
+
+    ScopedCurrentContext scopedContext;
+    Q_UNUSED(scopedContext);
+
+    RenderModel renderModel;
+    renderModel.setRenderFunctors(RenderFunctorGroup(m_pShaderFunctor, &m_TextureFunctor, &m_MaterialFunctor));
+
+    // Different matrices, so each object has its own matrix batch within the same batch group.
+    const QMatrix4x4 matrix = translation(QVector3D(0, 0, 0));
+    updateQuad(renderModel, 1, 2, matrix);
+    updateQuad(renderModel, 2, 2, translation(QVector3D(10, 0, 0)));
+
+    const QVector<RenderModel::StoredSection> before = renderModel.storedSections(1);
+    const QVector<RenderModel::StoredSection> other = renderModel.storedSections(2);
+    QCOMPARE(before.count(), 1);
+    QCOMPARE(other.count(), 1);
+    QVERIFY(before.at(0).batchGroup == other.at(0).batchGroup);
+    QVERIFY(before.at(0).matrixBatch != other.at(0).matrixBatch);
+    QCOMPARE(before.at(0).batchGroup->matrixBatchCount(), 2);
+
+    // As if both had just been uploaded.
+    before.at(0).matrixBatch->setDirty(false);
+    other.at(0).matrixBatch->setDirty(false);
+
+    const MatrixBatchItem originalItem = *before.at(0).matrixBatch->item(before.at(0).item);
+    const MatrixBatchItemMetadata originalSizes = before.at(0).matrixBatch->buildItemMetadata();
+
+    updateQuad(renderModel, 1, 2, matrix, QColor(Qt::red), QVector2D(0.5f, 0.5f));
+
+    // The same item is reused, and nothing is re-batched.
+    const QVector<RenderModel::StoredSection> after = renderModel.storedSections(1);
+    QCOMPARE(after.count(), 1);
+    QVERIFY(after.at(0).pass == before.at(0).pass);
+    QVERIFY(after.at(0).batchGroup == before.at(0).batchGroup);
+    QVERIFY(after.at(0).matrixBatch == before.at(0).matrixBatch);
+    QVERIFY(after.at(0).item == before.at(0).item);
+    QCOMPARE(after.at(0).batchGroup->matrixBatchCount(), 2);
+    QCOMPARE(after.at(0).matrixBatch->itemCount(), 1);
+
+    // Only the updated object's matrix batch needs uploading again. Its sizes and indices
+    // haven't changed, so it keeps its ranges in the buffers and only the vertex data
+    // within them is rewritten.
+    QVERIFY(after.at(0).matrixBatch->isDirty());
+    QVERIFY(!other.at(0).matrixBatch->isDirty());
+    QVERIFY(after.at(0).matrixBatch->buildItemMetadata() == originalSizes);
+
+    const MatrixBatchItem* item = after.at(0).matrixBatch->item(after.at(0).item);
+    QVERIFY(item->m_Positions == originalItem.m_Positions);
+    QVERIFY(item->m_Indices == originalItem.m_Indices);
+    QVERIFY(item->m_Colors != originalItem.m_Colors);
+    QVERIFY(item->m_TextureCoordinates != originalItem.m_TextureCoordinates);
+}
+
+void TestRenderModel::testUpdateObjectChangesBatch()
+{
+    if ( !m_bHaveContext )
+    {
+        QSKIP("No OpenGL 4.1 context is available.");
+    }
+
+    ScopedCurrentContext scopedContext;
+    Q_UNUSED(scopedContext);
+
+    RenderModel renderModel;
+    renderModel.setRenderFunctors(RenderFunctorGroup(m_pShaderFunctor, &m_TextureFunctor, &m_MaterialFunctor));
+
+    // The second object keeps the original batch group alive, so its pointer stays valid.
+    const QMatrix4x4 matrix = translation(QVector3D(0, 0, 0));
+    updateQuad(renderModel, 1, 2, matrix);
+    updateQuad(renderModel, 2, 2, translation(QVector3D(10, 0, 0)));
+
+    QVector<RenderModel::StoredSection> sections = renderModel.storedSections(1);
+    QCOMPARE(sections.count(), 1);
+    RenderModelBatchGroup* texturedGroup = sections.at(0).batchGroup;
+    QCOMPARE(texturedGroup->key().shaderId(), static_cast<quint16>(2));
+    QCOMPARE(texturedGroup->key().materialId(), static_cast<quint32>(2));
+    QCOMPARE(texturedGroup->matrixBatchCount(), 2);
+
+    // Same shader, different texture.
+    updateQuad(renderModel, 1, 3, matrix);
+
+    sections = renderModel.storedSections(1);
+    QCOMPARE(sections.count(), 1);
+    QVERIFY(sections.at(0).batchGroup != texturedGroup);
+    QCOMPARE(sections.at(0).batchGroup->key().shaderId(), static_cast<quint16>(2));
+    QCOMPARE(sections.at(0).batchGroup->key().materialId(), static_cast<quint32>(3));
+    QCOMPARE(sections.at(0).matrixBatch->itemCount(), 1);
+    QCOMPARE(texturedGroup->matrixBatchCount(), 1);
+
+    // Different shader.
+    updateQuad(renderModel, 1, 1, matrix);
+
+    sections = renderModel.storedSections(1);
+    QCOMPARE(sections.count(), 1);
+    QCOMPARE(sections.at(0).batchGroup->key().shaderId(), static_cast<quint16>(1));
+    QCOMPARE(sections.at(0).batchGroup->key().materialId(), static_cast<quint32>(1));
+    QVERIFY(sections.at(0).pass->batchGroup(RenderModelBatchGroupKey(2, 3)) == Q_NULLPTR);
+    QCOMPARE(texturedGroup->matrixBatchCount(), 1);
+}
+
+void TestRenderModel::populate(RenderModel &renderModel, const GeometryBuilder &builder)
+{
+    for ( int i = 1; i <= BENCHMARK_OBJECT_COUNT; i++ )
+    {
+        renderModel.updateObject(RendererInputObjectParams(i, 0, builder));
+    }
+}
+
+void TestRenderModel::benchmarkUpdateObjects()
+{
+    if ( !m_bHaveContext )
+    {
+        QSKIP("No OpenGL 4.1 context is available.");
+    }
+
+    ScopedCurrentContext scopedContext;
+    Q_UNUSED(scopedContext);
+
+    RenderFunctorGroup functors(m_pShaderFunctor, &m_TextureFunctor, &m_MaterialFunctor);
+    GeometryBuilder builder(functors, &m_ShaderPalette, 1, QMatrix4x4());
+    buildQuad(builder);
+
+    RenderModel renderModel;
+    renderModel.setRenderFunctors(functors);
+    populate(renderModel, builder);
+
+    QBENCHMARK
+    {
+        populate(renderModel, builder);
+    }
+}
+
+QTEST_MAIN(TestRenderModel)
+
+#include "tst_testrendermodel.moc"
@@ -0,0 +1,108 @@
+#include <QString>
+#include <QtTest>
+#include <QVector3D>
+#include "model/scene/scene.h"
+
+using namespace Model;
+
+class TestScene : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestScene();
+
+private Q_SLOTS:
+    void testNewObjectsNeedRendererUpdate();
+    void testMovingFlagsSubtree();
+    void testDestroyedObjects();
+    void testRendererMatrix();
+};
+
+TestScene::TestScene()
+{
+}
+
+void TestScene::testNewObjectsNeedRendererUpdate()
+{
+    Scene scene;
+    SceneObject* object = scene.createSceneObject<SceneObject>(scene.rootObject());
+
+    QSet<quint32> objects = scene.takeObjectsNeedingRendererUpdate();
+    QCOMPARE(objects.count(), 2);
+    QVERIFY(objects.contains(scene.rootObject()->objectId()));
+    QVERIFY(objects.contains(object->objectId()));
+
+    // Nothing has changed since.
+    QVERIFY(scene.takeObjectsNeedingRendererUpdate().isEmpty());
+
+    object->setColor(QColor(Qt::red));
+    objects = scene.takeObjectsNeedingRendererUpdate();
+    QCOMPARE(objects.count(), 1);
+    QVERIFY(objects.contains(object->objectId()));
+}
+
+void TestScene::testMovingFlagsSubtree()
+{
+    Scene scene;
+    SceneObject* group = scene.createSceneObject<SceneObject>(scene.rootObject());
+    SceneObject* child = scene.createSceneObject<SceneObject>(group);
+    SceneObject* other = scene.createSceneObject<SceneObject>(scene.rootObject());
+    scene.takeObjectsNeedingRendererUpdate();
+
+    group->hierarchy().setPosition(QVector3D(0, 0, 64));
+
+    QSet<quint32> objects = scene.takeObjectsNeedingRendererUpdate();
+    QCOMPARE(objects.count(), 2);
+    QVERIFY(objects.contains(group->objectId()));
+    QVERIFY(objects.contains(child->objectId()));
+    QVERIFY(!objects.contains(other->objectId()));
+}
+
+void TestScene::testDestroyedObjects()
+{
+    Scene scene;
+    SceneObject* group = scene.createSceneObject<SceneObject>(scene.rootObject());
+    SceneObject* child = scene.createSceneObject<SceneObject>(group);
+    const quint32 groupId = group->objectId();
+    const quint32 childId = child->objectId();
+
+    scene.destroySceneObject(group);
+
+    QSet<quint32> destroyed = scene.takeDestroyedObjects();
+    QCOMPARE(destroyed.count(), 2);
+    QVERIFY(destroyed.contains(groupId));
+    QVERIFY(destroyed.contains(childId));
+    QVERIFY(scene.takeDestroyedObjects().isEmpty());
+
+    // Destroyed objects don't need updating any more.
+    QSet<quint32> objects = scene.takeObjectsNeedingRendererUpdate();
+    QVERIFY(!objects.contains(groupId));
+    QVERIFY(!objects.contains(childId));
+}
+
+void TestScene::testRendererMatrix()
+{
+    Scene scene;
+    SceneObject* group = scene.createSceneObject<SceneObject>(scene.rootObject());
+    SceneObject* child = scene.createSceneObject<SceneObject>(group);
+
+    group->hierarchy().setPosition(QVector3D(0, 0, 64));
+    child->hierarchy().setPosition(QVector3D(16, 0, 0));
+
+    QMatrix4x4 expected = child->hierarchy().parentToLocal()
+            * group->hierarchy().parentToLocal()
+            * scene.rootObject()->hierarchy().parentToLocal();
+    QCOMPARE(child->rendererMatrix(), expected);
+
+    // Moving the parent must not leave the child's cached matrix behind.
+    group->hierarchy().setPosition(QVector3D(0, 32, 0));
+    expected = child->hierarchy().parentToLocal()
+            * group->hierarchy().parentToLocal()
+            * scene.rootObject()->hierarchy().parentToLocal();
+    QCOMPARE(child->rendererMatrix(), expected);
+}
+
+QTEST_GUILESS_MAIN(TestScene)
+
+#include "tst_testscene.moc"
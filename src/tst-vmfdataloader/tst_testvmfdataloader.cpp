@@ -0,0 +1,260 @@
+#include <QString>
+#include <QtTest>
+#include <QVector3D>
+#include <QSurfaceFormat>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include "model-loaders/filedataloaders/vmf/vmfdataloader.h"
+#include "model/filedatamodels/map/mapfiledatamodel.h"
+#include "model/genericbrush/genericbrush.h"
+#include "model/sceneobjects/mapentity.h"
+#include "model/global/resourceenvironment.h"
+#include "renderer/global/mainrendercontext.h"
+#include "renderer/opengl/scopedcurrentcontext.h"
+
+using namespace Model;
+using namespace ModelLoaders;
+
+namespace
+{
+    const int COPIED_BRUSH_COUNT = 200;
+
+    QString vectorString(float x, float y, float z)
+    {
+        return QString("(%1 %2 %3)").arg(x, 0, 'f', 3).arg(y, 0, 'f', 3).arg(z, 0, 'f', 3);
+    }
+
+    void writeSide(QTextStream &stream, int &sideId, const QString &plane)
+    {
+        stream << "\t\tside\n\t\t{\n"
+               << "\t\t\t\"id\" \"" << sideId++ << "\"\n"
+               << "\t\t\t\"plane\" \"" << plane << "\"\n"
+               << "\t\t\t\"material\" \"TOOLS/TOOLSNODRAW\"\n"
+               << "\t\t}\n";
+    }
+
+    // A box with one vertical edge cut off, so that the brush has off-grid vertices.
+    void writeSolid(QTextStream &stream, int solidId, int &sideId, const QVector3D &min, const QVector3D &max)
+    {
+        const float cut = 13.7f;
+
+        stream << "\tsolid\n\t{\n\t\t\"id\" \"" << solidId << "\"\n";
+
+        writeSide(stream, sideId, vectorString(min.x(), max.y(), max.z()) + " " + vectorString(max.x(), max.y(), max.z()) + " " + vectorString(max.x(), min.y(), max.z()));
+        writeSide(stream, sideId, vectorString(min.x(), min.y(), min.z()) + " " + vectorString(max.x(), min.y(), min.z()) + " " + vectorString(max.x(), max.y(), min.z()));
+        writeSide(stream, sideId, vectorString(min.x(), max.y(), max.z()) + " " + vectorString(min.x(), min.y(), max.z()) + " " + vectorString(min.x(), min.y(), min.z()));
+        writeSide(stream, sideId, vectorString(max.x(), max.y(), min.z()) + " " + vectorString(max.x(), min.y(), min.z()) + " " + vectorString(max.x(), min.y(), max.z()));
+        writeSide(stream, sideId, vectorString(max.x(), max.y(), max.z()) + " " + vectorString(min.x(), max.y(), max.z()) + " " + vectorString(min.x(), max.y(), min.z()));
+        writeSide(stream, sideId, vectorString(max.x(), min.y(), min.z()) + " " + vectorString(min.x(), min.y(), min.z()) + " " + vectorString(min.x(), min.y(), max.z()));
+        writeSide(stream, sideId, vectorString(max.x() - cut, max.y(), max.z()) + " " + vectorString(max.x(), max.y() - cut, min.z()) + " " + vectorString(max.x(), max.y() - cut, max.z()));
+
+        stream << "\t}\n";
+    }
+
+    // Copies of the same brush in different places, so that most of them reuse the first one's geometry.
+    bool writeCopiedBrushMap(const QString &path)
+    {
+        QFile file(path);
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Text) )
+            return false;
+
+        QTextStream stream(&file);
+        stream << "world\n{\n\t\"id\" \"1\"\n\t\"classname\" \"worldspawn\"\n";
+
+        int sideId = 1;
+        for ( int i = 0; i < COPIED_BRUSH_COUNT; ++i )
+        {
+            const QVector3D min((i % 10) * 100.25f, (i / 10) * 130.5f, (i % 3) * 17.125f);
+            writeSolid(stream, i + 2, sideId, min, min + QVector3D(64, 48, 32));
+        }
+
+        stream << "}\n";
+        return true;
+    }
+
+    void collectBrushVertices(const SceneObject* object, QList<QVector<QVector3D> > &vertices)
+    {
+        const GenericBrush* brush = qobject_cast<const GenericBrush*>(object);
+        if ( brush )
+        {
+            vertices.append(brush->brushVertexList());
+        }
+
+        foreach ( const SceneObject* child, object->childSceneObjects() )
+        {
+            collectBrushVertices(child, vertices);
+        }
+    }
+
+    SceneObject* findObject(SceneObject* object, const QString &name)
+    {
+        if ( object->objectName() == name )
+            return object;
+
+        foreach ( SceneObject* child, object->childSceneObjects() )
+        {
+            SceneObject* found = findObject(child, name);
+            if ( found )
+                return found;
+        }
+
+        return Q_NULLPTR;
+    }
+}
+
+class TestVmfDataLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestVmfDataLoader();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testThreadCountDoesNotAffectGeometry();
+    void testHiddenObjects();
+
+private:
+    bool loadBrushVertices(const QString &path, int threadCount, QList<QVector<QVector3D> > &vertices);
+
+    bool m_bHaveContext;
+    QTemporaryDir m_TempDir;
+};
+
+TestVmfDataLoader::TestVmfDataLoader()
+    : m_bHaveContext(false)
+{
+}
+
+void TestVmfDataLoader::initTestCase()
+{
+    QVERIFY(m_TempDir.isValid());
+
+    QSurfaceFormat format;
+    format.setMajorVersion(4);
+    format.setMinorVersion(1);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setRenderableType(QSurfaceFormat::OpenGL);
+    QSurfaceFormat::setDefaultFormat(format);
+
+    Renderer::MainRenderContext::globalInitialise();
+    m_bHaveContext = Renderer::MainRenderContext::globalInstance()->create();
+
+    if ( m_bHaveContext )
+    {
+        Renderer::ScopedCurrentContext scopedContext;
+        Q_UNUSED(scopedContext);
+        ResourceEnvironment::globalInitialise();
+    }
+}
+
+void TestVmfDataLoader::cleanupTestCase()
+{
+    if ( m_bHaveContext )
+    {
+        Renderer::ScopedCurrentContext scopedContext;
+        Q_UNUSED(scopedContext);
+        ResourceEnvironment::globalShutdown();
+    }
+
+    Renderer::MainRenderContext::globalShutdown();
+}
+
+bool TestVmfDataLoader::loadBrushVertices(const QString &path, int threadCount, QList<QVector<QVector3D> > &vertices)
+{
+    Renderer::ScopedCurrentContext scopedContext;
+    Q_UNUSED(scopedContext);
+
+    MapFileDataModel model;
+    VmfDataLoader loader;
+    loader.setDataModel(&model);
+    loader.setMapCacheDirectory(QString());
+    loader.setBrushThreadCount(threadCount);
+
+    // Small batches, so that copies of the brush are spread across them.
+    loader.setBrushBatchSize(4);
+
+    QString error;
+    if ( loader.load(path, &error) != BaseFileLoader::Success )
+    {
+        qWarning() << "Failed to load" << path << "-" << error;
+        return false;
+    }
+
+    collectBrushVertices(model.scene()->rootObject(), vertices);
+    return true;
+}
+
+void TestVmfDataLoader::testThreadCountDoesNotAffectGeometry()
+{
+    if ( !m_bHaveContext )
+    {
+        QSKIP("No OpenGL 4.1 context is available.");
+    }
+
+    const QString path = m_TempDir.filePath("copiedbrushes.vmf");
+    QVERIFY(writeCopiedBrushMap(path));
+
+    QList<QVector<QVector3D> > serialVertices;
+    QVERIFY(loadBrushVertices(path, 1, serialVertices));
+    QCOMPARE(serialVertices.count(), COPIED_BRUSH_COUNT);
+
+    // Workers finish in a different order each time, so try a few loads.
+    for ( int attempt = 0; attempt < 5; ++attempt )
+    {
+        QList<QVector<QVector3D> > parallelVertices;
+        QVERIFY(loadBrushVertices(path, 4, parallelVertices));
+        QCOMPARE(parallelVertices.count(), serialVertices.count());
+
+        for ( int i = 0; i < serialVertices.count(); ++i )
+        {
+            QCOMPARE(parallelVertices.at(i), serialVertices.at(i));
+        }
+    }
+}
+
+void TestVmfDataLoader::testHiddenObjects()
+{
+    if ( !m_bHaveContext )
+    {
+        QSKIP("No OpenGL 4.1 context is available.");
+    }
+
+    Renderer::ScopedCurrentContext scopedContext;
+    Q_UNUSED(scopedContext);
+
+    MapFileDataModel model;
+    VmfDataLoader loader;
+    loader.setDataModel(&model);
+    loader.setMapCacheDirectory(QString());
+
+    QString error;
+    QCOMPARE(loader.load(QString(SRCDIR) + "hiddenobjects.vmf", &error), BaseFileLoader::Success);
+
+    SceneObject* root = model.scene()->rootObject();
+
+    SceneObject* visibleBrush = findObject(root, "planeBrush2");
+    QVERIFY(visibleBrush);
+    QVERIFY(!visibleBrush->isHidden());
+
+    // A solid in a "hidden" block under the world.
+    SceneObject* hiddenBrush = findObject(root, "planeBrush3");
+    QVERIFY(hiddenBrush);
+    QVERIFY(hiddenBrush->isHidden());
+
+    // An entity in a "hidden" block at the root, along with its solids.
+    MapEntity* hiddenEntity = qobject_cast<MapEntity*>(findObject(root, "func_detail4"));
+    QVERIFY(hiddenEntity);
+    QVERIFY(hiddenEntity->isHidden());
+    QVERIFY(hiddenEntity->isBrushEntity());
+
+    SceneObject* entityBrush = findObject(hiddenEntity, "planeBrush5");
+    QVERIFY(entityBrush);
+    QVERIFY(entityBrush->isHidden());
+}
+
+QTEST_MAIN(TestVmfDataLoader)
+
+#include "tst_testvmfdataloader.moc"
@@ -0,0 +1,411 @@
+#include <QString>
+#include <QtTest>
+#include <QStringList>
+#include <QVector3D>
+#include "model-loaders/filedataloaders/vmf/vmfplaneparser.h"
+#include "model/math/doubleplane3d.h"
+
+using namespace ModelLoaders;
+using namespace Model;
+
+namespace
+{
+    // The split-based parser that VmfDataLoader used before VmfPlaneParser,
+    // kept here as a reference for results and for benchmarking.
+    struct ReferenceParseError
+    {
+    };
+
+    QVector3D referenceVectorFromCoord(const QString &coord)
+    {
+        QString s = coord.trimmed();
+        if ( s.startsWith("(") )
+        {
+            if ( s.length() < 2 )
+                throw ReferenceParseError();
+
+            s = s.right(s.length()-1);
+        }
+
+        if ( s.endsWith(")") )
+        {
+            if ( s.length() < 2 )
+                throw ReferenceParseError();
+
+            s = s.left(s.length()-1);
+        }
+
+        QStringList list = s.split(" ");
+        if ( list.count() < 3 )
+            throw ReferenceParseError();
+
+        bool success = false;
+        float x = list.at(0).toFloat(&success);
+        if ( !success )
+            throw ReferenceParseError();
+
+        float y = list.at(1).toFloat(&success);
+        if ( !success )
+            throw ReferenceParseError();
+
+        float z = list.at(2).toFloat(&success);
+        if ( !success )
+            throw ReferenceParseError();
+
+        return QVector3D(x,y,z);
+    }
+
+    void referenceVectorsFromCoords(const QString &coords, QVector3D &v0, QVector3D &v1, QVector3D &v2)
+    {
+        QStringList fragments = coords.split(" ");
+        if ( fragments.count() != 9 )
+            throw ReferenceParseError();
+
+        v0 = referenceVectorFromCoord(fragments.at(0) + " " + fragments.at(1) + " " + fragments.at(2));
+        v1 = referenceVectorFromCoord(fragments.at(3) + " " + fragments.at(4) + " " + fragments.at(5));
+        v2 = referenceVectorFromCoord(fragments.at(6) + " " + fragments.at(7) + " " + fragments.at(8));
+    }
+
+    // Deterministic so that benchmark runs are comparable.
+    class Random
+    {
+    public:
+        explicit Random(quint32 seed) : m_iState(seed)
+        {
+        }
+
+        quint32 next()
+        {
+            m_iState = (m_iState * 1664525u) + 1013904223u;
+            return m_iState >> 8;
+        }
+
+    private:
+        quint32 m_iState;
+    };
+
+    QString randomComponent(Random& random)
+    {
+        const quint32 kind = random.next() % 4;
+        const int sign = (random.next() % 2) ? 1 : -1;
+
+        switch ( kind )
+        {
+            case 0:
+            {
+                // Grid-aligned integers, by far the most common in hand-made maps.
+                return QString::number(sign * static_cast<int>(random.next() % 16384));
+            }
+
+            case 1:
+            {
+                // Decimals as written by Hammer after vertex manipulation.
+                const double value = sign * (static_cast<double>(random.next() % 1000000) / 1000.0);
+                return QString::number(value, 'f', 3);
+            }
+
+            case 2:
+            {
+                const double value = sign * (static_cast<double>(random.next()) / 3.0);
+                return QString::number(value, 'g', 9);
+            }
+
+            default:
+            {
+                const double value = sign * (static_cast<double>(random.next()) / 7.0);
+                return QString::number(value, 'e', 6);
+            }
+        }
+    }
+
+    QString randomPlane(Random& random)
+    {
+        QStringList points;
+        for ( int i = 0; i < 3; ++i )
+        {
+            points.append(QString("(%1 %2 %3)")
+                          .arg(randomComponent(random))
+                          .arg(randomComponent(random))
+                          .arg(randomComponent(random)));
+        }
+
+        return points.join(" ");
+    }
+
+    bool sameBits(const QVector3D& a, const QVector3D& b)
+    {
+        return a.x() == b.x() && a.y() == b.y() && a.z() == b.z();
+    }
+
+    // Three points on the plane x + 2y + 4z = 1234567.891, far from the origin and off the grid,
+    // and a fourth point that lies exactly on the same plane.
+    const char* const OFF_GRID_PLANE =
+            "(100000.123 200000.456 183641.714) (-150000.789 50000.321 321142.0095) (30000.654 -120000.987 361142.30275)";
+    const DoubleVector3D OFF_GRID_POINT(77777.777, 33333.333, 272530.862);
+}
+
+class TestVmfPlaneParser : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestVmfPlaneParser();
+
+private Q_SLOTS:
+    void initTestCase();
+    void testValid_data();
+    void testValid();
+    void testInvalid_data();
+    void testInvalid();
+    void testMatchesToFloat();
+    void testMatchesReference();
+    void testLatin1MatchesUtf16();
+    void testDoublePrecision();
+    void testDoubleInvalid();
+    void testOffGridPlane();
+    void benchmarkReferenceParser();
+    void benchmarkPlaneParser();
+    void benchmarkPlaneParserLatin1();
+
+private:
+    QStringList m_Planes;
+};
+
+TestVmfPlaneParser::TestVmfPlaneParser()
+{
+}
+
+void TestVmfPlaneParser::initTestCase()
+{
+    Random random(0xC0FFEEu);
+    for ( int i = 0; i < 2000; ++i )
+    {
+        m_Planes.append(randomPlane(random));
+    }
+}
+
+void TestVmfPlaneParser::testValid_data()
+{
+    QTest::addColumn<QString>("plane");
+    QTest::addColumn<QVector3D>("v0");
+    QTest::addColumn<QVector3D>("v1");
+    QTest::addColumn<QVector3D>("v2");
+
+    QTest::newRow("Integers")
+            << "(-512 512 64) (512 512 64) (512 -512 64)"
+            << QVector3D(-512, 512, 64) << QVector3D(512, 512, 64) << QVector3D(512, -512, 64);
+
+    QTest::newRow("Decimals")
+            << "(0.5 -0.25 .125) (1.0 2. -3.75) (0 0 0)"
+            << QVector3D(0.5f, -0.25f, 0.125f) << QVector3D(1, 2, -3.75f) << QVector3D(0, 0, 0);
+
+    QTest::newRow("Exponents and signs")
+            << "(1e2 +2.5E-1 -3e+1) (0 0 1) (0 1 0)"
+            << QVector3D(100, 0.25f, -30) << QVector3D(0, 0, 1) << QVector3D(0, 1, 0);
+
+    QTest::newRow("Extra whitespace")
+            << "  ( 1   2\t3 )(4 5 6)\n(7 8 9)  "
+            << QVector3D(1, 2, 3) << QVector3D(4, 5, 6) << QVector3D(7, 8, 9);
+
+    QTest::newRow("Long mantissa")
+            << "(0.1000000000000000000000001 12345678901234567890 0) (0 0 0) (0 0 0)"
+            << QVector3D(0.1f, 12345678901234567890.0f, 0) << QVector3D(0, 0, 0) << QVector3D(0, 0, 0);
+}
+
+void TestVmfPlaneParser::testValid()
+{
+    QFETCH(QString, plane);
+    QFETCH(QVector3D, v0);
+    QFETCH(QVector3D, v1);
+    QFETCH(QVector3D, v2);
+
+    QVector3D r0, r1, r2;
+    QString error;
+    QVERIFY2(VmfPlaneParser::parse(plane, r0, r1, r2, &error), qPrintable(error));
+    QCOMPARE(r0, v0);
+    QCOMPARE(r1, v1);
+    QCOMPARE(r2, v2);
+}
+
+void TestVmfPlaneParser::testInvalid_data()
+{
+    QTest::addColumn<QString>("plane");
+
+    QTest::newRow("Empty") << "";
+    QTest::newRow("Two points") << "(0 0 0) (1 1 1)";
+    QTest::newRow("Two components") << "(0 0) (1 1 1) (2 2 2)";
+    QTest::newRow("Four components") << "(0 0 0 0) (1 1 1) (2 2 2)";
+    QTest::newRow("Missing bracket") << "(0 0 0 (1 1 1) (2 2 2)";
+    QTest::newRow("Not a number") << "(a 0 0) (1 1 1) (2 2 2)";
+    QTest::newRow("Lone sign") << "(- 0 0) (1 1 1) (2 2 2)";
+    QTest::newRow("Lone point") << "(. 0 0) (1 1 1) (2 2 2)";
+    QTest::newRow("Empty exponent") << "(1e 0 0) (1 1 1) (2 2 2)";
+    QTest::newRow("Joined numbers") << "(1-2 0 0) (1 1 1) (2 2 2)";
+    QTest::newRow("Out of range") << "(1e39 0 0) (1 1 1) (2 2 2)";
+    QTest::newRow("Trailing characters") << "(0 0 0) (1 1 1) (2 2 2) x";
+    QTest::newRow("Non-ASCII") << QString("(0 0 0) (1 1 1) (2 2 2%1)").arg(QChar(0x00B2));
+}
+
+void TestVmfPlaneParser::testInvalid()
+{
+    QFETCH(QString, plane);
+
+    QVector3D v0, v1, v2;
+    QString error;
+    QVERIFY(!VmfPlaneParser::parse(plane, v0, v1, v2, &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void TestVmfPlaneParser::testMatchesToFloat()
+{
+    Random random(12345u);
+    for ( int i = 0; i < 20000; ++i )
+    {
+        const QString component = randomComponent(random);
+        const QString plane = QString("(%1 0 0) (0 0 0) (0 0 0)").arg(component);
+
+        bool ok = false;
+        const float expected = component.toFloat(&ok);
+        QVERIFY(ok);
+
+        QVector3D v0, v1, v2;
+        QVERIFY2(VmfPlaneParser::parse(plane, v0, v1, v2), qPrintable(component));
+        QVERIFY2(v0.x() == expected, qPrintable(component));
+    }
+}
+
+void TestVmfPlaneParser::testMatchesReference()
+{
+    foreach ( const QString& plane, m_Planes )
+    {
+        QVector3D e0, e1, e2;
+        referenceVectorsFromCoords(plane, e0, e1, e2);
+
+        QVector3D v0, v1, v2;
+        QVERIFY2(VmfPlaneParser::parse(plane, v0, v1, v2), qPrintable(plane));
+        QVERIFY2(sameBits(v0, e0) && sameBits(v1, e1) && sameBits(v2, e2), qPrintable(plane));
+    }
+}
+
+void TestVmfPlaneParser::testLatin1MatchesUtf16()
+{
+    foreach ( const QString& plane, m_Planes )
+    {
+        const QByteArray latin1 = plane.toLatin1();
+
+        QVector3D a0, a1, a2;
+        QVector3D b0, b1, b2;
+        QVERIFY(VmfPlaneParser::parse(latin1, a0, a1, a2));
+        QVERIFY(VmfPlaneParser::parse(plane, b0, b1, b2));
+        QVERIFY2(sameBits(a0, b0) && sameBits(a1, b1) && sameBits(a2, b2), qPrintable(plane));
+    }
+}
+
+void TestVmfPlaneParser::testDoublePrecision()
+{
+    Random random(54321u);
+    for ( int i = 0; i < 20000; ++i )
+    {
+        const QString component = randomComponent(random);
+        const QString plane = QString("(%1 0 0) (0 0 0) (0 0 0)").arg(component);
+
+        bool ok = false;
+        const double expected = component.toDouble(&ok);
+        QVERIFY(ok);
+
+        DoubleVector3D v0, v1, v2;
+        QVERIFY2(VmfPlaneParser::parse(plane, v0, v1, v2), qPrintable(component));
+        QVERIFY2(v0.x() == expected, qPrintable(component));
+    }
+}
+
+void TestVmfPlaneParser::testDoubleInvalid()
+{
+    DoubleVector3D v0, v1, v2;
+    QString error;
+    QVERIFY(!VmfPlaneParser::parse(QString("(1e400 0 0) (1 1 1) (2 2 2)"), v0, v1, v2, &error));
+    QVERIFY(!error.isEmpty());
+
+    // Out of range for a float, but not for a double.
+    QVERIFY(VmfPlaneParser::parse(QString("(1e39 0 0) (1 1 1) (2 2 2)"), v0, v1, v2));
+    QCOMPARE(v0.x(), 1e39);
+}
+
+void TestVmfPlaneParser::testOffGridPlane()
+{
+    const QString plane(OFF_GRID_PLANE);
+
+    DoubleVector3D d0, d1, d2;
+    QVERIFY(VmfPlaneParser::parse(plane, d0, d1, d2));
+    const double doubleError = qAbs(DoublePlane3D(d0, d1, d2).signedDistance(OFF_GRID_POINT));
+    QVERIFY2(doubleError < 1e-6, qPrintable(QString::number(doubleError)));
+
+    // Parsing into floats moves the points far enough to tilt the plane away from the fourth point,
+    // which is what a winding built from the plane would be clipped against.
+    QVector3D f0, f1, f2;
+    QVERIFY(VmfPlaneParser::parse(plane, f0, f1, f2));
+    const double floatError = qAbs(DoublePlane3D(DoubleVector3D(f0), DoubleVector3D(f1), DoubleVector3D(f2))
+                                   .signedDistance(OFF_GRID_POINT));
+    QVERIFY2(floatError > 1e-3, qPrintable(QString::number(floatError)));
+}
+
+void TestVmfPlaneParser::benchmarkReferenceParser()
+{
+    QVector3D v0, v1, v2;
+    float sum = 0;
+
+    QBENCHMARK
+    {
+        foreach ( const QString& plane, m_Planes )
+        {
+            referenceVectorsFromCoords(plane, v0, v1, v2);
+            sum += v0.x();
+        }
+    }
+
+    Q_UNUSED(sum);
+}
+
+void TestVmfPlaneParser::benchmarkPlaneParser()
+{
+    QVector3D v0, v1, v2;
+    float sum = 0;
+
+    QBENCHMARK
+    {
+        foreach ( const QString& plane, m_Planes )
+        {
+            VmfPlaneParser::parse(plane, v0, v1, v2);
+            sum += v0.x();
+        }
+    }
+
+    Q_UNUSED(sum);
+}
+
+void TestVmfPlaneParser::benchmarkPlaneParserLatin1()
+{
+    QList<QByteArray> planes;
+    foreach ( const QString& plane, m_Planes )
+    {
+        planes.append(plane.toLatin1());
+    }
+
+    QVector3D v0, v1, v2;
+    float sum = 0;
+
+    QBENCHMARK
+    {
+        foreach ( const QByteArray& plane, planes )
+        {
+            VmfPlaneParser::parse(plane, v0, v1, v2);
+            sum += v0.x();
+        }
+    }
+
+    Q_UNUSED(sum);
+}
+
+QTEST_APPLESS_MAIN(TestVmfPlaneParser)
+
+#include "tst_testvmfplaneparser.moc"
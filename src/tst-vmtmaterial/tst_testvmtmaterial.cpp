@@ -0,0 +1,214 @@
+#include <QString>
+#include <QtTest>
+#include <QHash>
+#include "file-formats/vmt/vmtmaterial.h"
+#include "file-formats/vmt/vmtmaterialcache.h"
+
+using namespace FileFormats;
+
+class TestVMTMaterial : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestVMTMaterial();
+
+private Q_SLOTS:
+    void init();
+    void testParameters();
+    void testNormalisePath_data();
+    void testNormalisePath();
+    void testPatch();
+    void testNestedPatch();
+    void testIncludeParsedOnce();
+    void testIncludeCycle();
+    void testMissingInclude();
+    void testDeduplication();
+
+private:
+    VMTMaterialCache createCache()
+    {
+        return VMTMaterialCache([this](const QString& path)
+        {
+            m_ReadCounts[path]++;
+            return m_Files.value(path);
+        });
+    }
+
+    QHash<QString, QByteArray> m_Files;
+    QHash<QString, int> m_ReadCounts;
+};
+
+TestVMTMaterial::TestVMTMaterial()
+{
+}
+
+void TestVMTMaterial::init()
+{
+    m_Files.clear();
+    m_ReadCounts.clear();
+
+    m_Files.insert("nature/blendrockgrass",
+                   "\"WorldVertexTransition\"\n"
+                   "{\n"
+                   "    \"$BaseTexture\" \"Nature\\RockFloor005a\"\n"
+                   "    \"$basetexture2\" \"nature/grassfloor002a.vtf\"\n"
+                   "    \"$surfaceprop\" \"dirt\"\n"
+                   "}\n");
+
+    m_Files.insert("maps/test/nature/blendrockgrass_wvt_patch",
+                   "\"patch\"\n"
+                   "{\n"
+                   "    \"include\" \"materials/nature/blendrockgrass.vmt\"\n"
+                   "    \"insert\"\n"
+                   "    {\n"
+                   "        \"$Translucent\" \"1\"\n"
+                   "    }\n"
+                   "    \"replace\"\n"
+                   "    {\n"
+                   "        \"$surfaceprop\" \"gravel\"\n"
+                   "        \"$alphatest\" \"1\"\n"
+                   "    }\n"
+                   "}\n");
+}
+
+void TestVMTMaterial::testParameters()
+{
+    VMTMaterialCache cache = createCache();
+    VMTMaterialPointer material = cache.material("materials/Nature/BlendRockGrass.vmt");
+
+    QVERIFY(material);
+    QCOMPARE(material->shaderName(), QString("worldvertextransition"));
+    QVERIFY(material->hasParameter("$BASETEXTURE"));
+    QCOMPARE(material->baseTexture(), QString("nature/rockfloor005a"));
+    QCOMPARE(material->baseTexture2(), QString("nature/grassfloor002a"));
+    QCOMPARE(material->stringParameter("$surfaceprop"), QString("dirt"));
+    QVERIFY(!material->isTranslucent());
+    QVERIFY(!material->isAlphaTest());
+    QCOMPARE(material->alphaTestReference(), 0.5f);
+}
+
+void TestVMTMaterial::testNormalisePath_data()
+{
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<QString>("extension");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("Already normalised") << "tools/toolsnodraw" << "vmt" << "tools/toolsnodraw";
+    QTest::newRow("Prefix and extension") << "materials/tools/toolsnodraw.vmt" << "vmt" << "tools/toolsnodraw";
+    QTest::newRow("Backslashes and case") << "Materials\\Tools\\ToolsNodraw.VMT" << "vmt" << "tools/toolsnodraw";
+    QTest::newRow("Other extension kept") << "tools/toolsnodraw.vtf" << "vmt" << "tools/toolsnodraw.vtf";
+}
+
+void TestVMTMaterial::testNormalisePath()
+{
+    QFETCH(QString, path);
+    QFETCH(QString, extension);
+    QFETCH(QString, expected);
+
+    QCOMPARE(VMTMaterial::normalisePath(path, extension), expected);
+}
+
+void TestVMTMaterial::testPatch()
+{
+    VMTMaterialCache cache = createCache();
+    QString error;
+    VMTMaterialPointer material = cache.material("maps/test/nature/blendrockgrass_wvt_patch", &error);
+
+    QVERIFY2(material, qPrintable(error));
+    QCOMPARE(material->shaderName(), QString("worldvertextransition"));
+    QCOMPARE(material->baseTexture(), QString("nature/rockfloor005a"));
+    QVERIFY(material->isTranslucent());
+    QCOMPARE(material->stringParameter("$surfaceprop"), QString("gravel"));
+
+    // Replace must not add parameters that the included material doesn't have.
+    QVERIFY(!material->hasParameter("$alphatest"));
+}
+
+void TestVMTMaterial::testNestedPatch()
+{
+    m_Files.insert("maps/test/nested_patch",
+                   "patch\n"
+                   "{\n"
+                   "    include \"materials/maps/test/nature/blendrockgrass_wvt_patch.vmt\"\n"
+                   "    insert\n"
+                   "    {\n"
+                   "        $alphatestreference \".75\"\n"
+                   "    }\n"
+                   "}\n");
+
+    VMTMaterialCache cache = createCache();
+    QString error;
+    VMTMaterialPointer material = cache.material("maps/test/nested_patch", &error);
+
+    QVERIFY2(material, qPrintable(error));
+    QVERIFY(material->isTranslucent());
+    QCOMPARE(material->alphaTestReference(), 0.75f);
+    QCOMPARE(material->stringParameter("$surfaceprop"), QString("gravel"));
+}
+
+void TestVMTMaterial::testIncludeParsedOnce()
+{
+    for ( int i = 0; i < 10; ++i )
+    {
+        m_Files.insert(QString("maps/test/patch%1").arg(i),
+                       QString("patch { include \"materials/nature/blendrockgrass.vmt\" insert { $detailscale %1 } }")
+                       .arg(i).toLatin1());
+    }
+
+    VMTMaterialCache cache = createCache();
+    for ( int i = 0; i < 10; ++i )
+    {
+        QVERIFY(cache.material(QString("maps/test/patch%1").arg(i)));
+    }
+
+    QVERIFY(cache.material("nature/blendrockgrass"));
+    QCOMPARE(m_ReadCounts.value("nature/blendrockgrass"), 1);
+    QCOMPARE(cache.count(), 11);
+}
+
+void TestVMTMaterial::testIncludeCycle()
+{
+    m_Files.insert("a", "patch { include \"materials/b.vmt\" }");
+    m_Files.insert("b", "patch { include \"materials/a.vmt\" }");
+
+    VMTMaterialCache cache = createCache();
+    QString error;
+    QVERIFY(!cache.material("a", &error));
+    QVERIFY(!error.isEmpty());
+
+    // Failures are remembered, so neither file is read again.
+    QVERIFY(!cache.material("b"));
+    QCOMPARE(m_ReadCounts.value("a"), 1);
+    QCOMPARE(m_ReadCounts.value("b"), 1);
+}
+
+void TestVMTMaterial::testMissingInclude()
+{
+    m_Files.insert("orphan", "patch { include \"materials/doesnotexist.vmt\" }");
+
+    VMTMaterialCache cache = createCache();
+    QVERIFY(!cache.material("orphan"));
+    QVERIFY(!cache.contains("orphan"));
+}
+
+void TestVMTMaterial::testDeduplication()
+{
+    m_Files.insert("copy", m_Files.value("nature/blendrockgrass"));
+    m_Files.insert("patch_noop", "patch { include \"materials/nature/blendrockgrass.vmt\" }");
+
+    VMTMaterialCache cache = createCache();
+    VMTMaterialPointer original = cache.material("nature/blendrockgrass");
+    VMTMaterialPointer copy = cache.material("copy");
+    VMTMaterialPointer patched = cache.material("patch_noop");
+
+    QVERIFY(original);
+    QCOMPARE(copy.data(), original.data());
+    QCOMPARE(patched.data(), original.data());
+    QCOMPARE(cache.count(), 3);
+    QCOMPARE(cache.uniqueCount(), 1);
+}
+
+QTEST_APPLESS_MAIN(TestVMTMaterial)
+
+#include "tst_testvmtmaterial.moc"
@@ -0,0 +1,195 @@
+#include <QString>
+#include <QtTest>
+#include <QByteArray>
+#include <QThread>
+#include "VTFLib/src/VTFLib.h"
+#include "VTFLib/src/VTFResample.h"
+
+Q_DECLARE_METATYPE(VTFMipmapFilter)
+
+class TestVTFResample : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestVTFResample();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testBoxHalving();
+    void testConstantImage_data();
+    void testConstantImage();
+    void testThreadCountIndependence_data();
+    void testThreadCountIndependence();
+    void testDXTnMipmapsNeedEncoder();
+    void benchmarkGenerateMipmaps_data();
+    void benchmarkGenerateMipmaps();
+
+private:
+    static QByteArray randomImage(quint32 width, quint32 height, quint32 seed)
+    {
+        QByteArray data(width * height * 4, Qt::Uninitialized);
+        for ( int i = 0; i < data.size(); ++i )
+        {
+            seed = (seed * 1664525u) + 1013904223u;
+            data[i] = static_cast<char>(seed >> 24);
+        }
+
+        return data;
+    }
+
+    static QByteArray resample(const QByteArray& source, quint32 width, quint32 height,
+                               quint32 destWidth, quint32 destHeight, VTFMipmapFilter filter, quint32 threads)
+    {
+        QByteArray dest(destWidth * destHeight * 4, Qt::Uninitialized);
+        VTFLib::ResampleRGBA8888(reinterpret_cast<const vlByte*>(source.constData()),
+                                 reinterpret_cast<vlByte*>(dest.data()),
+                                 width, height, destWidth, destHeight, filter, threads);
+        return dest;
+    }
+};
+
+TestVTFResample::TestVTFResample()
+{
+}
+
+void TestVTFResample::initTestCase()
+{
+    vlInitialize();
+}
+
+void TestVTFResample::cleanupTestCase()
+{
+    vlSetInteger(VTFLIB_THREAD_COUNT, 0);
+    vlShutdown();
+}
+
+void TestVTFResample::testBoxHalving()
+{
+    const quint32 width = 130;
+    const quint32 height = 66;
+    const QByteArray source = randomImage(width, height, 3);
+    const QByteArray dest = resample(source, width, height, width / 2, height / 2, MIPMAP_FILTER_BOX, 4);
+
+    const uchar* src = reinterpret_cast<const uchar*>(source.constData());
+    const uchar* dst = reinterpret_cast<const uchar*>(dest.constData());
+
+    for ( quint32 y = 0; y < height / 2; ++y )
+    {
+        for ( quint32 x = 0; x < width / 2; ++x )
+        {
+            for ( quint32 c = 0; c < 4; ++c )
+            {
+                const quint32 row0 = (2 * y * width + 2 * x) * 4 + c;
+                const quint32 row1 = row0 + width * 4;
+                const quint32 expected = (src[row0] + src[row0 + 4] + src[row1] + src[row1 + 4] + 2) / 4;
+
+                QCOMPARE(static_cast<quint32>(dst[(y * (width / 2) + x) * 4 + c]), expected);
+            }
+        }
+    }
+}
+
+void TestVTFResample::testConstantImage_data()
+{
+    QTest::addColumn<VTFMipmapFilter>("filter");
+    QTest::addColumn<quint32>("destWidth");
+    QTest::addColumn<quint32>("destHeight");
+
+    QTest::newRow("Point down") << MIPMAP_FILTER_POINT << 37u << 11u;
+    QTest::newRow("Box down") << MIPMAP_FILTER_BOX << 37u << 11u;
+    QTest::newRow("Triangle down") << MIPMAP_FILTER_TRIANGLE << 37u << 11u;
+    QTest::newRow("Triangle up") << MIPMAP_FILTER_TRIANGLE << 301u << 257u;
+    QTest::newRow("Triangle to 1x1") << MIPMAP_FILTER_TRIANGLE << 1u << 1u;
+}
+
+void TestVTFResample::testConstantImage()
+{
+    QFETCH(VTFMipmapFilter, filter);
+    QFETCH(quint32, destWidth);
+    QFETCH(quint32, destHeight);
+
+    // Normalised filters must not change a flat colour.
+    const QByteArray source(128 * 64 * 4, static_cast<char>(77));
+    const QByteArray dest = resample(source, 128, 64, destWidth, destHeight, filter, 4);
+
+    QCOMPARE(dest, QByteArray(destWidth * destHeight * 4, static_cast<char>(77)));
+}
+
+void TestVTFResample::testThreadCountIndependence_data()
+{
+    QTest::addColumn<VTFMipmapFilter>("filter");
+
+    QTest::newRow("Box") << MIPMAP_FILTER_BOX;
+    QTest::newRow("Triangle") << MIPMAP_FILTER_TRIANGLE;
+}
+
+void TestVTFResample::testThreadCountIndependence()
+{
+    QFETCH(VTFMipmapFilter, filter);
+
+    const QByteArray source = randomImage(1000, 700, 5);
+    QCOMPARE(resample(source, 1000, 700, 333, 211, filter, 8),
+             resample(source, 1000, 700, 333, 211, filter, 1));
+    QCOMPARE(resample(source, 1000, 700, 500, 350, filter, 8),
+             resample(source, 1000, 700, 500, 350, filter, 1));
+}
+
+void TestVTFResample::testDXTnMipmapsNeedEncoder()
+{
+#if defined(USE_NVDXT) || defined(USE_LIBTXC_DXTN)
+    QSKIP("VTFLib is built with a DXTn encoder.");
+#else
+    VTFLib::CVTFFile file;
+    QVERIFY(file.Create(64, 64, 4, 6, 1, IMAGE_FORMAT_DXT1, vlFalse, vlTrue, vlFalse));
+
+    // The restriction is reported before any work is handed to other threads.
+    vlSetInteger(VTFLIB_THREAD_COUNT, 4);
+    QVERIFY(!file.GenerateMipmaps(MIPMAP_FILTER_BOX));
+    QVERIFY(QString(vlGetLastError()).endsWith("NVDXT or libtxc_dxtn support required to generate mipmaps for DXTn images."));
+#endif
+}
+
+void TestVTFResample::benchmarkGenerateMipmaps_data()
+{
+    QTest::addColumn<VTFMipmapFilter>("filter");
+    QTest::addColumn<int>("threads");
+
+    const int idealThreads = QThread::idealThreadCount() > 0 ? QThread::idealThreadCount() : 1;
+
+    QTest::newRow("Box, 1 thread") << MIPMAP_FILTER_BOX << 1;
+    QTest::newRow(QString("Box, %1 threads").arg(idealThreads).toLatin1().constData()) << MIPMAP_FILTER_BOX << idealThreads;
+    QTest::newRow("Triangle, 1 thread") << MIPMAP_FILTER_TRIANGLE << 1;
+    QTest::newRow(QString("Triangle, %1 threads").arg(idealThreads).toLatin1().constData()) << MIPMAP_FILTER_TRIANGLE << idealThreads;
+}
+
+void TestVTFResample::benchmarkGenerateMipmaps()
+{
+    QFETCH(VTFMipmapFilter, filter);
+    QFETCH(int, threads);
+
+    // A 1024x1024 cubemap with 4 frames: 24 independent mip chains.
+    VTFLib::CVTFFile file;
+    QVERIFY(file.Create(1024, 1024, 4, 6, 1, IMAGE_FORMAT_RGBA8888, vlFalse, vlTrue, vlFalse));
+
+    const QByteArray image = randomImage(1024, 1024, 9);
+    for ( vlUInt frame = 0; frame < file.GetFrameCount(); ++frame )
+    {
+        for ( vlUInt face = 0; face < file.GetFaceCount(); ++face )
+        {
+            memcpy(file.GetData(frame, face, 0, 0), image.constData(), image.size());
+        }
+    }
+
+    vlSetInteger(VTFLIB_THREAD_COUNT, threads);
+
+    QBENCHMARK
+    {
+        QVERIFY(file.GenerateMipmaps(filter));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestVTFResample)
+
+#include "tst_testvtfresample.moc"
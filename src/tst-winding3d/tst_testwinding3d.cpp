@@ -0,0 +1,729 @@
+#include <QString>
+#include <QtTest>
+#include <QVector3D>
+#include <QtMath>
+#include <QSet>
+#include "model/math/winding3d.h"
+#include "model/math/arraywinding3d.h"
+#include "model/math/doubleplane3d.h"
+#include "model/math/modelmath.h"
+#include "model/math/texturedwinding.h"
+#include "model/factories/genericbrushfactory.h"
+
+using namespace Model;
+
+namespace
+{
+    // Deterministic so that benchmark runs are comparable.
+    class Random
+    {
+    public:
+        explicit Random(quint32 seed) : m_iState(seed)
+        {
+        }
+
+        quint32 next()
+        {
+            m_iState = (m_iState * 1664525u) + 1013904223u;
+            return m_iState >> 8;
+        }
+
+        // In [0, 1].
+        float nextUnit()
+        {
+            return static_cast<float>(next() % 1000001) / 1000000.0f;
+        }
+
+    private:
+        quint32 m_iState;
+    };
+
+    QList<Plane3D> boxPlanes(const QVector3D& min, const QVector3D& max)
+    {
+        QList<Plane3D> planes;
+        planes.append(Plane3D(QVector3D(1,0,0), max.x()));
+        planes.append(Plane3D(QVector3D(-1,0,0), -min.x()));
+        planes.append(Plane3D(QVector3D(0,1,0), max.y()));
+        planes.append(Plane3D(QVector3D(0,-1,0), -min.y()));
+        planes.append(Plane3D(QVector3D(0,0,1), max.z()));
+        planes.append(Plane3D(QVector3D(0,0,-1), -min.z()));
+        return planes;
+    }
+
+    // A convex brush roughly approximating a sphere, with its faces at slightly
+    // different distances so that no three of them meet at a single point.
+    QList<Plane3D> roundBrushPlanes(Random& random, int faceCount, const QVector3D& centre, float radius)
+    {
+        QList<Plane3D> planes;
+        const float goldenAngle = static_cast<float>(M_PI) * (3.0f - qSqrt(5.0f));
+        const float twist = random.nextUnit() * 2.0f * static_cast<float>(M_PI);
+
+        for ( int i = 0; i < faceCount; ++i )
+        {
+            const float z = 1.0f - ((2.0f * (i + 0.5f)) / faceCount);
+            const float r = qSqrt(1.0f - (z * z));
+            const float theta = (goldenAngle * i) + twist;
+
+            const QVector3D normal(r * qCos(theta), r * qSin(theta), z);
+            const float distance = radius * (0.9f + (0.2f * random.nextUnit()));
+            planes.append(Plane3D(normal, QVector3D::dotProduct(normal, centre) + distance));
+        }
+
+        return planes;
+    }
+
+    template<typename T>
+    QList<T*> createWindings(const QList<Plane3D>& planes)
+    {
+        QList<T*> windings;
+        foreach ( const Plane3D& plane, planes )
+        {
+            windings.append(new T(plane));
+        }
+
+        return windings;
+    }
+
+    QList<ArrayWinding3D*> createWindings(const QList<DoublePlane3D>& planes, ArrayWinding3D::Precision precision)
+    {
+        QList<ArrayWinding3D*> windings;
+        foreach ( const DoublePlane3D& plane, planes )
+        {
+            windings.append(new ArrayWinding3D(plane, precision));
+        }
+
+        return windings;
+    }
+
+    QList<TexturedWinding*> createTexturedWindings(const QList<DoublePlane3D>& planes)
+    {
+        QList<TexturedWinding*> windings;
+        foreach ( const DoublePlane3D& plane, planes )
+        {
+            windings.append(new TexturedWinding(plane, 0, ArrayWinding3D::DoublePrecision));
+        }
+
+        return windings;
+    }
+
+    // Hammer writes plane points rounded to the grid, or to a few decimal places.
+    DoubleVector3D roundPoint(const DoubleVector3D& point, double quantum)
+    {
+        return DoubleVector3D(qRound64(point.x() / quantum) * quantum,
+                              qRound64(point.y() / quantum) * quantum,
+                              qRound64(point.z() / quantum) * quantum);
+    }
+
+    // Plane through three points, facing away from a point inside the brush.
+    DoublePlane3D outwardPlane(const DoubleVector3D& v0, const DoubleVector3D& v1, const DoubleVector3D& v2, const DoubleVector3D& inside)
+    {
+        const DoublePlane3D plane(v0, v1, v2);
+        return plane.signedDistance(inside) < 0.0 ? plane : DoublePlane3D(v0, v2, v1);
+    }
+
+    // A short cylinder far from the origin, with its points snapped to the grid.
+    // Neighbouring sides are nearly parallel.
+    QList<DoublePlane3D> cylinderBrush(const DoubleVector3D& base, double radius, int sides, double height)
+    {
+        const DoubleVector3D inside = base + DoubleVector3D(0, 0, height / 2.0);
+
+        QList<DoublePlane3D> planes;
+        for ( int i = 0; i < sides; ++i )
+        {
+            const double a0 = (2.0 * M_PI * i) / sides;
+            const double a1 = (2.0 * M_PI * (i + 1)) / sides;
+            const DoubleVector3D p0 = roundPoint(base + DoubleVector3D(radius * qCos(a0), radius * qSin(a0), 0), 1.0);
+            const DoubleVector3D p1 = roundPoint(base + DoubleVector3D(radius * qCos(a1), radius * qSin(a1), 0), 1.0);
+            planes.append(outwardPlane(p0, p1, p1 + DoubleVector3D(0, 0, height), inside));
+        }
+
+        planes.append(DoublePlane3D(DoubleVector3D(0, 0, 1), base.z() + height));
+        planes.append(DoublePlane3D(DoubleVector3D(0, 0, -1), -base.z()));
+        return planes;
+    }
+
+    // A box turned off every axis, with its points written to three decimal places.
+    QList<DoublePlane3D> rotatedBoxBrush(const DoubleVector3D& centre, const DoubleVector3D& halfSize, double yaw, double pitch)
+    {
+        const DoubleVector3D yawed(qCos(yaw), qSin(yaw), 0);
+        DoubleVector3D axes[3];
+        axes[0] = (qCos(pitch) * yawed) + (qSin(pitch) * DoubleVector3D(0, 0, 1));
+        axes[1] = DoubleVector3D(-qSin(yaw), qCos(yaw), 0);
+        axes[2] = (qCos(pitch) * DoubleVector3D(0, 0, 1)) - (qSin(pitch) * yawed);
+        const double extents[3] = { halfSize.x(), halfSize.y(), halfSize.z() };
+
+        QList<DoublePlane3D> planes;
+        for ( int axis = 0; axis < 3; ++axis )
+        {
+            const DoubleVector3D u = extents[(axis + 1) % 3] * axes[(axis + 1) % 3];
+            const DoubleVector3D v = extents[(axis + 2) % 3] * axes[(axis + 2) % 3];
+
+            for ( int sign = -1; sign <= 1; sign += 2 )
+            {
+                const DoubleVector3D origin = centre + ((sign * extents[axis]) * axes[axis]);
+                planes.append(outwardPlane(roundPoint(origin, 0.001),
+                                           roundPoint(origin + u, 0.001),
+                                           roundPoint(origin + v, 0.001),
+                                           centre));
+            }
+        }
+
+        return planes;
+    }
+
+    // A tall, thin pyramid whose faces meet at a very sharp point.
+    QList<DoublePlane3D> spikeBrush(const DoubleVector3D& base, double halfWidth, double height)
+    {
+        const DoubleVector3D apex = base + DoubleVector3D(0, 0, height);
+        const DoubleVector3D inside = base + DoubleVector3D(0, 0, 1);
+        const DoubleVector3D corners[4] =
+        {
+            base + DoubleVector3D(-halfWidth, -halfWidth, 0),
+            base + DoubleVector3D(halfWidth, -halfWidth, 0),
+            base + DoubleVector3D(halfWidth, halfWidth, 0),
+            base + DoubleVector3D(-halfWidth, halfWidth, 0)
+        };
+
+        QList<DoublePlane3D> planes;
+        for ( int i = 0; i < 4; ++i )
+        {
+            planes.append(outwardPlane(corners[i], corners[(i + 1) % 4], apex, inside));
+        }
+
+        planes.append(DoublePlane3D(DoubleVector3D(0, 0, -1), -base.z()));
+        return planes;
+    }
+
+    // A long, thin slab with a very shallow slope.
+    QList<DoublePlane3D> rampBrush(const DoubleVector3D& corner, double length, double width, double rise, double thickness)
+    {
+        const DoubleVector3D slope = DoubleVector3D(-rise, 0, length).normalized();
+
+        QList<DoublePlane3D> planes;
+        planes.append(DoublePlane3D(slope, DoubleVector3D::dotProduct(slope, corner) + thickness * slope.z()));
+        planes.append(DoublePlane3D(-slope, -DoubleVector3D::dotProduct(slope, corner)));
+        planes.append(DoublePlane3D(DoubleVector3D(1, 0, 0), corner.x() + length));
+        planes.append(DoublePlane3D(DoubleVector3D(-1, 0, 0), -corner.x()));
+        planes.append(DoublePlane3D(DoubleVector3D(0, 1, 0), corner.y() + width));
+        planes.append(DoublePlane3D(DoubleVector3D(0, -1, 0), -corner.y()));
+        return planes;
+    }
+
+    bool sameVertices(const QList<QVector3D>& a, const QList<QVector3D>& b)
+    {
+        if ( a.count() != b.count() )
+            return false;
+
+        foreach ( const QVector3D& va, a )
+        {
+            bool found = false;
+            foreach ( const QVector3D& vb, b )
+            {
+                if ( qAbs(va.x() - vb.x()) < 0.01f && qAbs(va.y() - vb.y()) < 0.01f && qAbs(va.z() - vb.z()) < 0.01f )
+                {
+                    found = true;
+                    break;
+                }
+            }
+
+            if ( !found )
+                return false;
+        }
+
+        return true;
+    }
+}
+
+class TestWinding3D : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestWinding3D();
+
+private Q_SLOTS:
+    void initTestCase();
+    void testBlankWinding();
+    void testBox();
+    void testClipAway();
+    void testClipNothing();
+    void testClipThroughVertices();
+    void testMatchesLinkedWinding();
+    void testDoubleMatchesSingle();
+    void testPathologicalBrushes_data();
+    void testPathologicalBrushes();
+    void testBrushGeometryCache();
+    void testBrushGeometryCacheOrder();
+    void benchmarkLinkedWinding();
+    void benchmarkArrayWinding_data();
+    void benchmarkArrayWinding();
+    void benchmarkPathologicalBrushes_data();
+    void benchmarkPathologicalBrushes();
+    void benchmarkBrushGeometryCache_data();
+    void benchmarkBrushGeometryCache();
+
+private:
+    QList<QList<Plane3D> > m_Brushes;
+    QList<QList<DoublePlane3D> > m_PathologicalBrushes;
+    QStringList m_PathologicalNames;
+};
+
+TestWinding3D::TestWinding3D()
+{
+}
+
+void TestWinding3D::initTestCase()
+{
+    Random random(0xC0FFEEu);
+
+    // Mostly boxes and simple shapes, as in a real map, with some finely cut brushes.
+    for ( int i = 0; i < 300; ++i )
+    {
+        const QVector3D centre((random.next() % 8192) - 4096.0f, (random.next() % 8192) - 4096.0f, (random.next() % 2048) - 1024.0f);
+
+        if ( i % 3 == 0 )
+        {
+            const QVector3D halfSize(8 + (random.next() % 256), 8 + (random.next() % 256), 8 + (random.next() % 256));
+            m_Brushes.append(boxPlanes(centre - halfSize, centre + halfSize));
+        }
+        else
+        {
+            const int faceCount = (i % 10 == 1) ? 48 + (random.next() % 48) : 7 + (random.next() % 12);
+            m_Brushes.append(roundBrushPlanes(random, faceCount, centre, 32.0f + (random.next() % 256)));
+        }
+    }
+
+    // Brushes that float clipping gets wrong near the edges of the map.
+    m_PathologicalNames << "Large cylinder";
+    m_PathologicalBrushes.append(cylinderBrush(DoubleVector3D(12000, -12000, 8000), 4000, 64, 16));
+
+    m_PathologicalNames << "Finely divided cylinder";
+    m_PathologicalBrushes.append(cylinderBrush(DoubleVector3D(-15000, 14000, -15000), 1000, 128, 8));
+
+    m_PathologicalNames << "Rotated plank";
+    m_PathologicalBrushes.append(rotatedBoxBrush(DoubleVector3D(-15500, 9000, 12000), DoubleVector3D(12, 1000, 1.5), 0.588, 0.211));
+
+    m_PathologicalNames << "Nearly level slab";
+    m_PathologicalBrushes.append(rotatedBoxBrush(DoubleVector3D(15000, 15000, -15000), DoubleVector3D(256, 256, 0.5), 0.1, 0.0007));
+
+    m_PathologicalNames << "Spike";
+    m_PathologicalBrushes.append(spikeBrush(DoubleVector3D(14000, -14000, -14000), 4, 4096));
+
+    m_PathologicalNames << "Shallow ramp";
+    m_PathologicalBrushes.append(rampBrush(DoubleVector3D(15000, 15000, -15000), 1000, 512, 1, 2));
+}
+
+void TestWinding3D::testBlankWinding()
+{
+    ArrayWinding3D winding(Plane3D(QVector3D(0.3f, -0.2f, 0.9f), 64.0f));
+    QCOMPARE(winding.vertexCount(), 4);
+    QVERIFY(!winding.isClosed());
+
+    // The vertices are far enough out that only a loose check makes sense.
+    const Plane3D plane = winding.plane();
+    foreach ( const QVector3D& vertex, winding.vertexList() )
+    {
+        QVERIFY(qAbs(QVector3D::dotProduct(plane.normal(), vertex) - plane.distance()) < 0.5f);
+    }
+
+    ArrayWinding3D nullWinding((Plane3D()));
+    QVERIFY(nullWinding.isNull());
+    QCOMPARE(nullWinding.vertexCount(), 0);
+}
+
+void TestWinding3D::testBox()
+{
+    const QVector3D min(-64, -32, 0);
+    const QVector3D max(64, 32, 128);
+    QList<ArrayWinding3D*> windings = createWindings<ArrayWinding3D>(boxPlanes(min, max));
+    ModelMath::clipWindingsWithEachOther<ArrayWinding3D>(windings);
+
+    foreach ( ArrayWinding3D* winding, windings )
+    {
+        QCOMPARE(winding->vertexCount(), 4);
+        QVERIFY(winding->isClosed());
+
+        foreach ( const QVector3D& vertex, winding->vertexList() )
+        {
+            QVERIFY(qFuzzyCompare(vertex.x(), min.x()) || qFuzzyCompare(vertex.x(), max.x()));
+            QVERIFY(qFuzzyCompare(vertex.y(), min.y()) || qFuzzyCompare(vertex.y(), max.y()));
+            QVERIFY(qFuzzyIsNull(vertex.z()) || qFuzzyCompare(vertex.z(), max.z()));
+        }
+    }
+
+    const QList<QVector3D> vertices = ModelMath::windingsToVertices<ArrayWinding3D>(windings);
+    QCOMPARE(vertices.count(), 8);
+
+    qDeleteAll(windings);
+}
+
+void TestWinding3D::testClipAway()
+{
+    ArrayWinding3D winding(Plane3D(QVector3D(0,0,1), 0));
+    winding.clip(Plane3D(QVector3D(0,0,1), -16.0f));
+    QCOMPARE(winding.vertexCount(), 0);
+    QVERIFY(!winding.isClosed());
+
+    // Clipping an empty winding does nothing.
+    winding.clip(Plane3D(QVector3D(1,0,0), 0));
+    QCOMPARE(winding.vertexCount(), 0);
+}
+
+void TestWinding3D::testClipNothing()
+{
+    const QList<Plane3D> planes = boxPlanes(QVector3D(-16,-16,-16), QVector3D(16,16,16));
+    ArrayWinding3D winding(planes.at(4));
+    winding.clip(planes.mid(0, 4));
+
+    const QList<QVector3D> before = winding.vertexList();
+    winding.clip(Plane3D(QVector3D(0,0,-1), 1024.0f));
+    winding.clip(Plane3D());
+
+    QCOMPARE(winding.vertexList(), before);
+    QVERIFY(winding.isClosed());
+}
+
+void TestWinding3D::testClipThroughVertices()
+{
+    const QList<Plane3D> planes = boxPlanes(QVector3D(-16,-16,-16), QVector3D(16,16,16));
+    ArrayWinding3D winding(planes.at(4));
+    winding.clip(planes.mid(0, 4));
+    QCOMPARE(winding.vertexCount(), 4);
+
+    // Cutting diagonally through two corners leaves a triangle.
+    winding.clip(Plane3D(QVector3D(1,1,0), 0));
+    QCOMPARE(winding.vertexCount(), 3);
+    QVERIFY(winding.isClosed());
+
+    foreach ( const QVector3D& vertex, winding.vertexList() )
+    {
+        QVERIFY(vertex.x() + vertex.y() <= 0.001f);
+    }
+}
+
+void TestWinding3D::testMatchesLinkedWinding()
+{
+    for ( int i = 0; i < m_Brushes.count(); ++i )
+    {
+        const QList<Plane3D>& planes = m_Brushes.at(i);
+
+        QList<Winding3D*> linked = createWindings<Winding3D>(planes);
+        QList<ArrayWinding3D*> array = createWindings<ArrayWinding3D>(planes);
+        ModelMath::clipWindingsWithEachOther<Winding3D>(linked);
+        ModelMath::clipWindingsWithEachOther<ArrayWinding3D>(array);
+
+        for ( int j = 0; j < planes.count(); ++j )
+        {
+            const QString message = QString("Brush %1, face %2").arg(i).arg(j);
+            QVERIFY2(sameVertices(linked.at(j)->vertexList(), array.at(j)->vertexList()), qPrintable(message));
+            QVERIFY2(linked.at(j)->isClosed() == array.at(j)->isClosed(), qPrintable(message));
+        }
+
+        qDeleteAll(linked);
+        qDeleteAll(array);
+    }
+}
+
+void TestWinding3D::testDoubleMatchesSingle()
+{
+    // Ordinary brushes should come out the same at either precision.
+    for ( int i = 0; i < m_Brushes.count(); ++i )
+    {
+        QList<DoublePlane3D> planes;
+        foreach ( const Plane3D& plane, m_Brushes.at(i) )
+        {
+            planes.append(DoublePlane3D(plane));
+        }
+
+        QList<ArrayWinding3D*> single = createWindings(planes, ArrayWinding3D::SinglePrecision);
+        QList<ArrayWinding3D*> precise = createWindings(planes, ArrayWinding3D::DoublePrecision);
+        ModelMath::clipWindingsWithEachOther<ArrayWinding3D>(single);
+        ModelMath::clipWindingsWithEachOther<ArrayWinding3D>(precise);
+
+        for ( int j = 0; j < planes.count(); ++j )
+        {
+            const QString message = QString("Brush %1, face %2").arg(i).arg(j);
+            QVERIFY2(sameVertices(single.at(j)->vertexList(), precise.at(j)->vertexList()), qPrintable(message));
+            QVERIFY2(single.at(j)->isClosed() == precise.at(j)->isClosed(), qPrintable(message));
+        }
+
+        qDeleteAll(single);
+        qDeleteAll(precise);
+    }
+}
+
+void TestWinding3D::testPathologicalBrushes_data()
+{
+    QTest::addColumn<int>("brush");
+
+    for ( int i = 0; i < m_PathologicalNames.count(); ++i )
+    {
+        QTest::newRow(qPrintable(m_PathologicalNames.at(i))) << i;
+    }
+}
+
+void TestWinding3D::testPathologicalBrushes()
+{
+    QFETCH(int, brush);
+
+    const QList<DoublePlane3D>& planes = m_PathologicalBrushes.at(brush);
+    QList<ArrayWinding3D*> windings = createWindings(planes, ArrayWinding3D::DoublePrecision);
+    ModelMath::clipWindingsWithEachOther<ArrayWinding3D>(windings);
+    const QList<QVector3D> vertices = ModelMath::windingsToVertices<ArrayWinding3D>(windings);
+
+    QVector<QSet<int> > facesUsingVertex(vertices.count());
+
+    for ( int i = 0; i < windings.count(); ++i )
+    {
+        const ArrayWinding3D* winding = windings.at(i);
+        const QString message = QString("Face %1").arg(i);
+        QVERIFY2(winding->isClosed(), qPrintable(message));
+
+        // Every face keeps all of its corners, with no slivers welded into duplicates.
+        const QList<int> indices = winding->vertexIndices();
+        const QSet<int> uniqueIndices = indices.toSet();
+        QVERIFY2(uniqueIndices.count() >= 3, qPrintable(message));
+        QCOMPARE(uniqueIndices.count(), indices.count());
+
+        foreach ( int index, uniqueIndices )
+        {
+            facesUsingVertex[index].insert(i);
+        }
+
+        // After rounding to float, vertices still lie on their own face and inside the brush.
+        foreach ( const QVector3D& vertex, winding->vertexList() )
+        {
+            for ( int j = 0; j < planes.count(); ++j )
+            {
+                const double distance = planes.at(j).signedDistance(DoubleVector3D(vertex));
+                QVERIFY2(distance < 0.01, qPrintable(message));
+                QVERIFY2(j != i || distance > -0.01, qPrintable(message));
+            }
+        }
+    }
+
+    // A closed convex brush has at least three faces meeting at every vertex.
+    for ( int i = 0; i < facesUsingVertex.count(); ++i )
+    {
+        QVERIFY2(facesUsingVertex.at(i).count() >= 3, qPrintable(QString("Vertex %1").arg(i)));
+    }
+
+    qDeleteAll(windings);
+}
+
+void TestWinding3D::testBrushGeometryCache()
+{
+    BrushGeometryCache cache;
+
+    // Copies of the same brush moved around the map, as when a prefab is placed many times.
+    const DoubleVector3D offsets[] =
+    {
+        DoubleVector3D(0, 0, 0),
+        DoubleVector3D(0, 0, 0),
+        DoubleVector3D(4096, -128, 64),
+        DoubleVector3D(-13000, 9000, 11000),
+        DoubleVector3D(3, 5, -7),
+    };
+
+    PreparedBrushGeometry first;
+
+    for ( int i = 0; i < 5; ++i )
+    {
+        const QList<DoublePlane3D> planes = cylinderBrush(DoubleVector3D(1000, 2000, 0) + offsets[i], 256, 24, 64);
+
+        QList<TexturedWinding*> cachedWindings = createTexturedWindings(planes);
+        const PreparedBrushGeometry cached = GenericBrushFactory::prepareBrushGeometry(cachedWindings, &cache);
+
+        QList<TexturedWinding*> windings = createTexturedWindings(planes);
+        const PreparedBrushGeometry expected = GenericBrushFactory::prepareBrushGeometry(windings);
+
+        QCOMPARE(cached.faceIndices.count(), expected.faceIndices.count());
+        QCOMPARE(cached.vertices.count(), expected.vertices.count());
+
+        for ( int face = 0; face < expected.faceIndices.count(); ++face )
+        {
+            QCOMPARE(cached.faceIndices.at(face), expected.faceIndices.at(face));
+        }
+
+        for ( int v = 0; v < expected.vertices.count(); ++v )
+        {
+            QVERIFY((cached.vertices.at(v) - expected.vertices.at(v)).length() < 0.01f);
+        }
+
+        if ( i == 0 )
+        {
+            first = cached;
+        }
+        else
+        {
+            // Topology is shared between all of the copies, and vertices
+            // too for the copy in the same place.
+            QVERIFY(cached.faceIndices.at(0).constData() == first.faceIndices.at(0).constData());
+            QCOMPARE(cached.vertices.constData() == first.vertices.constData(), i == 1);
+        }
+
+        qDeleteAll(cachedWindings);
+        qDeleteAll(windings);
+    }
+
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.missCount(), 1);
+    QCOMPARE(cache.hitCount(), 4);
+
+    // A different brush doesn't match.
+    QList<TexturedWinding*> windings = createTexturedWindings(cylinderBrush(DoubleVector3D(1000, 2000, 0), 256, 24, 65));
+    GenericBrushFactory::prepareBrushGeometry(windings, &cache);
+    QCOMPARE(cache.count(), 2);
+    qDeleteAll(windings);
+}
+
+void TestWinding3D::testBrushGeometryCacheOrder()
+{
+    BrushGeometryCache cache;
+
+    // The later copy is prepared first, as can happen when brushes are prepared concurrently.
+    const QList<DoublePlane3D> planes = cylinderBrush(DoubleVector3D(1000, 2000, 0), 256, 24, 64);
+    QList<TexturedWinding*> laterWindings = createTexturedWindings(planes);
+    int source = -1;
+    GenericBrushFactory::prepareBrushGeometry(laterWindings, &cache, 7, &source);
+    QCOMPARE(source, 7);
+
+    // Entries from later brushes aren't found.
+    QList<TexturedWinding*> earlierWindings = createTexturedWindings(planes);
+    GenericBrushFactory::prepareBrushGeometry(earlierWindings, &cache, 3, &source);
+    QCOMPARE(source, 3);
+    QCOMPARE(cache.count(), 1);
+
+    // The entry from the earlier brush replaced the later one.
+    PreparedBrushGeometry geometry;
+    const BrushGeometryCache::Key key = BrushGeometryCache::keyFor(laterWindings);
+    QVERIFY(cache.findFirst(key, geometry, 7, &source));
+    QCOMPARE(source, 3);
+    QVERIFY(!cache.findFirst(key, geometry, 2));
+
+    // Finding the first entry isn't counted.
+    QCOMPARE(cache.hitCount(), 0);
+    QCOMPARE(cache.missCount(), 2);
+
+    qDeleteAll(laterWindings);
+    qDeleteAll(earlierWindings);
+}
+
+void TestWinding3D::benchmarkLinkedWinding()
+{
+    int vertexCount = 0;
+
+    QBENCHMARK
+    {
+        foreach ( const QList<Plane3D>& planes, m_Brushes )
+        {
+            QList<Winding3D*> windings = createWindings<Winding3D>(planes);
+            ModelMath::clipWindingsWithEachOther<Winding3D>(windings);
+            vertexCount += windings.first()->vertexCount();
+            qDeleteAll(windings);
+        }
+    }
+
+    Q_UNUSED(vertexCount);
+}
+
+void TestWinding3D::benchmarkArrayWinding_data()
+{
+    QTest::addColumn<int>("precision");
+
+    QTest::newRow("Single precision") << static_cast<int>(ArrayWinding3D::SinglePrecision);
+    QTest::newRow("Double precision") << static_cast<int>(ArrayWinding3D::DoublePrecision);
+}
+
+void TestWinding3D::benchmarkArrayWinding()
+{
+    QFETCH(int, precision);
+
+    QList<QList<DoublePlane3D> > brushes;
+    foreach ( const QList<Plane3D>& planes, m_Brushes )
+    {
+        QList<DoublePlane3D> precisePlanes;
+        foreach ( const Plane3D& plane, planes )
+        {
+            precisePlanes.append(DoublePlane3D(plane));
+        }
+
+        brushes.append(precisePlanes);
+    }
+
+    int vertexCount = 0;
+
+    QBENCHMARK
+    {
+        foreach ( const QList<DoublePlane3D>& planes, brushes )
+        {
+            QList<ArrayWinding3D*> windings = createWindings(planes, static_cast<ArrayWinding3D::Precision>(precision));
+            ModelMath::clipWindingsWithEachOther<ArrayWinding3D>(windings);
+            vertexCount += windings.first()->vertexCount();
+            qDeleteAll(windings);
+        }
+    }
+
+    Q_UNUSED(vertexCount);
+}
+
+void TestWinding3D::benchmarkPathologicalBrushes_data()
+{
+    benchmarkArrayWinding_data();
+}
+
+void TestWinding3D::benchmarkPathologicalBrushes()
+{
+    QFETCH(int, precision);
+
+    int vertexCount = 0;
+
+    QBENCHMARK
+    {
+        foreach ( const QList<DoublePlane3D>& planes, m_PathologicalBrushes )
+        {
+            QList<ArrayWinding3D*> windings = createWindings(planes, static_cast<ArrayWinding3D::Precision>(precision));
+            ModelMath::clipWindingsWithEachOther<ArrayWinding3D>(windings);
+            vertexCount += ModelMath::windingsToVertices<ArrayWinding3D>(windings).count();
+            qDeleteAll(windings);
+        }
+    }
+
+    Q_UNUSED(vertexCount);
+}
+
+void TestWinding3D::benchmarkBrushGeometryCache_data()
+{
+    QTest::addColumn<bool>("useCache");
+
+    QTest::newRow("Uncached") << false;
+    QTest::newRow("Cached") << true;
+}
+
+void TestWinding3D::benchmarkBrushGeometryCache()
+{
+    QFETCH(bool, useCache);
+
+    // A handful of different brushes, each placed many times.
+    QList<QList<DoublePlane3D> > brushes;
+    for ( int i = 0; i < 400; ++i )
+    {
+        const DoubleVector3D base(((i / 4) % 20) * 512.0, (i / 80) * 512.0, 0);
+        brushes.append(cylinderBrush(base, 64 + ((i % 4) * 32), 12 + ((i % 4) * 4), 128));
+    }
+
+    QBENCHMARK
+    {
+        BrushGeometryCache cache;
+        foreach ( const QList<DoublePlane3D>& planes, brushes )
+        {
+            QList<TexturedWinding*> windings = createTexturedWindings(planes);
+            GenericBrushFactory::prepareBrushGeometry(windings, useCache ? &cache : Q_NULLPTR);
+            qDeleteAll(windings);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(TestWinding3D)
+
+#include "tst_testwinding3d.moc"
@@ -13,6 +13,8 @@
 #include "file-formats/vpk/vpkindextreerecord.h"
 #include "model-loaders/vtf/vtfloader.h"
 #include "model-loaders/filedataloaders/vmf/vmfdataloader.h"
+#include "model-loaders/filedataloaders/fileloadoperation.h"
+#include <QMessageBox>
 
 using namespace Model;
 using namespace Renderer;
@@ -29,7 +31,9 @@ namespace UserInterface
         m_pCameraController(Q_NULLPTR),
         m_pKeyMap(Q_NULLPTR),
         m_pMouseEventMap(Q_NULLPTR),
-        m_pFrameBuffer(Q_NULLPTR)
+        m_pFrameBuffer(Q_NULLPTR),
+        m_pMapLoad(Q_NULLPTR),
+        m_strWindowTitle()
     {
     }
 
@@ -40,6 +44,10 @@ namespace UserInterface
 
     void MapViewWindow::destroy()
     {
+        // Must go before the data model it populates.
+        delete m_pMapLoad;
+        m_pMapLoad = Q_NULLPTR;
+
         delete m_pMouseEventMap;
         m_pMouseEventMap = Q_NULLPTR;
 
@@ -189,8 +197,20 @@ namespace UserInterface
                 m_pCameraController, &CameraController::moveUp);
         connect(m_pKeyMap->addKeyMap(Qt::Key_Z), &KeySignalSender::keyEvent,
                 m_pCameraController, &CameraController::moveDown);
-        connect(m_pKeyMap->addKeyMap(Qt::Key_Escape), &KeySignalSender::keyEvent,
-                this, &MapViewWindow::close);
+        connect(m_pKeyMap->addKeyMap(Qt::Key_Escape), &KeySignalSender::keyEvent, this, [this](bool pressed)
+        {
+            if ( !pressed )
+                return;
+
+            if ( isLoadingMap() )
+            {
+                cancelMapLoad();
+            }
+            else
+            {
+                close();
+            }
+        });
 
         installEventFilter(m_pKeyMap);
     }
@@ -282,18 +302,72 @@ namespace UserInterface
             return;
         }
 
-        VmfDataLoader loader;
-        loader.setDataModel(m_pVmfData);
-        QString errorString;
+        if ( m_pMapLoad )
+        {
+            m_pMapLoad->disconnect(this);
+            delete m_pMapLoad;
+            m_pMapLoad = Q_NULLPTR;
+        }
+
+        VmfDataLoader* loader = new VmfDataLoader();
+        loader->setDataModel(m_pVmfData);
+
+        m_pMapLoad = new FileLoadOperation(m_strMapPath, loader);
+        connect(m_pMapLoad, &FileLoadOperation::progressChanged, this, &MapViewWindow::mapLoadProgressChanged);
+        connect(m_pMapLoad, &FileLoadOperation::finished, this, &MapViewWindow::mapLoadFinished);
+
+        m_strWindowTitle = title();
+        mapLoadProgressChanged(0.0f);
+        m_pMapLoad->start();
+    }
+
+    bool MapViewWindow::isLoadingMap() const
+    {
+        return m_pMapLoad && m_pMapLoad->isRunning();
+    }
+
+    void MapViewWindow::cancelMapLoad()
+    {
+        if ( m_pMapLoad )
+        {
+            m_pMapLoad->cancel();
+        }
+    }
+
+    void MapViewWindow::mapLoadProgressChanged(float progress)
+    {
+        setTitle(QString("%1 (loading %2%)")
+                 .arg(m_strWindowTitle.isEmpty() ? m_strMapPath : m_strWindowTitle)
+                 .arg(static_cast<int>(progress * 100.0f)));
+
+        update();
+    }
+
+    void MapViewWindow::mapLoadFinished(ModelLoaders::BaseFileLoader::SuccessCode result)
+    {
+        using namespace ModelLoaders;
 
-        if ( loader.load(m_strMapPath, &errorString) != BaseFileLoader::Success )
+        const QString errorString = m_pMapLoad->errorString();
+        m_pMapLoad->deleteLater();
+        m_pMapLoad = Q_NULLPTR;
+
+        setTitle(m_strWindowTitle);
+        update();
+
+        if ( result != BaseFileLoader::Success )
         {
-            QMessageBox msg(QMessageBox::Critical, "Error", "Unable to load VMF.", QMessageBox::Ok);
+            QMessageBox msg(QMessageBox::Critical, "Error",
+                            result == BaseFileLoader::PartialSuccess ? "VMF was only partially loaded." : "Unable to load VMF.",
+                            QMessageBox::Ok);
             if ( !errorString.isEmpty() )
             {
                 msg.setDetailedText(errorString);
             }
+
+            msg.exec();
         }
+
+        emit mapLoaded(result);
     }
 
     void MapViewWindow::loadVpks()
@@ -18,6 +18,12 @@
 #include "renderer/rendermodel/0-modellevel/rendermodel.h"
 
 #include "file-formats/vpk/vpkfilecollection.h"
+#include "model-loaders/filedataloaders/base/basefileloader.h"
+
+namespace ModelLoaders
+{
+    class FileLoadOperation;
+}
 
 namespace UserInterface
 {
@@ -43,11 +49,18 @@ namespace UserInterface
 
         const FileFormats::VPKFileCollection& vpkFileCollection() const;
 
+        // The map is loaded in the background, and its brushes appear
+        // in the scene as they are built.
         void loadMap();
         void loadVpks();
+        bool isLoadingMap() const;
+
+    public slots:
+        void cancelMapLoad();
 
     signals:
         void initialised();
+        void mapLoaded(ModelLoaders::BaseFileLoader::SuccessCode result);
 
     protected:
         virtual void initializeGL() override;
@@ -68,6 +81,8 @@ namespace UserInterface
         void initCameraController();
         void initKeyMap();
         void initMouseEventMap();
+        void mapLoadProgressChanged(float progress);
+        void mapLoadFinished(ModelLoaders::BaseFileLoader::SuccessCode result);
 
         QString m_strMapPath;
         QString m_strVpkPath;
@@ -83,6 +98,9 @@ namespace UserInterface
 
         FileFormats::VPKFileCollection m_VpkFiles;
         QOpenGLFramebufferObject* m_pFrameBuffer;
+
+        ModelLoaders::FileLoadOperation* m_pMapLoad;
+        QString m_strWindowTitle;
     };
 }
 